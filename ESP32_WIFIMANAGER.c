@@ -34,6 +34,11 @@
 *                    ADDRESS                   - SAVE WIFI CREDENTIAL TO FLASH/EEPROM
 *                                              - ON RESTART, AGAIN READ FLASH/EEPROM ADDRESS
 *                                                AND CONNECT TO READ SSID
+*
+*  MULTI             NOT ABLE TO CONNECT       - START SSID FRAMEWORK EITHER IN SMARTCONFIG
+*                    TO ANY KNOWN SSID           OR IN TCP WEBSERVER
+*                    FOUND IN ONE SCAN         - WIFI CONNECT SUCCESSFULL
+*                    (BEST RANKED FIRST)       - PROVISIONED SSID IS ADDED TO CREDENTIAL TABLE
 * REFERENCES
 * -----------
 *   (1) ONLINE HTML EDITOR
@@ -49,482 +54,4717 @@
 
 #include "ESP32_WIFIMANAGER.h"
 #include "ESP32_GPIO.h"
-#include "ESP32_TIMER.h"
-#include "esp_smartconfig.h"
-#include "esp_event_loop.h"
+#include "ESP32_WIFIMANAGER_TIMERWHEEL.h"
+#include "ESP32_WIFIMANAGER_WEBCONFIG.h"
+#include "ESP32_WIFIMANAGER_PARSER.h"
+#include "ESP32_WIFIMANAGER_CREDLOG.h"
+#include "ESP32_WIFIMANAGER_SCANCACHE.h"
+#include "ESP32_WIFIMANAGER_ROAM.h"
+#include "ESP32_WIFIMANAGER_LATENCY.h"
+#include "ESP32_WIFIMANAGER_LOG.h"
+#include "ESP32_WIFIMANAGER_FSM.h"
+#include "ESP32_WIFIMANAGER_NOTIFY.h"
+#include "ESP32_WIFIMANAGER_TRACE.h"
+#include "ESP32_WIFIMANAGER_POWER.h"
+#include "ESP32_WIFIMANAGER_PMK.h"
+#include "ESP32_WIFIMANAGER_HEALTH.h"
+#include "ESP32_WIFIMANAGER_DNS.h"
+#include "ESP32_WIFIMANAGER_DRIVER.h"
 #include "esp_event.h"
 #include "esp_wifi.h"
 #include "esp_smartconfig.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "nvs.h"
+#include "tcpip_adapter.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+//INTERNAL TYPES
+typedef enum
+{
+    ESP32_WIFIMANAGER_EVT_CONNECT_CHECK = 0,
+    ESP32_WIFIMANAGER_EVT_STA_START,
+    ESP32_WIFIMANAGER_EVT_STA_CONNECTED,
+    ESP32_WIFIMANAGER_EVT_STA_DISCONNECTED,
+    ESP32_WIFIMANAGER_EVT_STA_GOT_IP,
+    ESP32_WIFIMANAGER_EVT_SCAN_DONE,
+    ESP32_WIFIMANAGER_EVT_SC_LINK,
+    ESP32_WIFIMANAGER_EVT_WEB_CREDENTIALS,
+    ESP32_WIFIMANAGER_EVT_DHCP_RENEW,
+    ESP32_WIFIMANAGER_EVT_SC_LOCKED,
+    ESP32_WIFIMANAGER_EVT_AP_CLIENT,
+    ESP32_WIFIMANAGER_EVT_PROVISION_SLICE,
+    ESP32_WIFIMANAGER_EVT_SCAN_REFRESH,
+    ESP32_WIFIMANAGER_EVT_ROAM_CHECK,
+    ESP32_WIFIMANAGER_EVT_POWER_CHECK,
+    ESP32_WIFIMANAGER_EVT_POWER_HINT,           //ARG = BUSY MS
+    ESP32_WIFIMANAGER_EVT_APSTA_RETRY,
+    ESP32_WIFIMANAGER_EVT_HOLD_DOWN,
+    ESP32_WIFIMANAGER_EVT_HEALTH_CHECK,
+    ESP32_WIFIMANAGER_EVT_PMK_DERIVED,
+    ESP32_WIFIMANAGER_EVT_DHCP_CHECK
+}esp32_wifimanager_evt_type_t;
+
+typedef struct
+{
+    esp32_wifimanager_evt_type_t type;
+    uint32_t arg;
+    int64_t ts_us;      //WHEN POSTED, SO PHASE TIMES DO NOT INCLUDE QUEUEING
+}esp32_wifimanager_evt_t;
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_ROAM_STATE_IDLE = 0,
+    ESP32_WIFIMANAGER_ROAM_STATE_SCANNING,
+    ESP32_WIFIMANAGER_ROAM_STATE_LEAVING,      //DISCONNECT FROM OLD BSSID REQUESTED
+    ESP32_WIFIMANAGER_ROAM_STATE_JOINING       //CONNECTING TO NEW BSSID
+}esp32_wifimanager_roam_state_t;
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_DHCP_CHECK_NONE = 0,
+    ESP32_WIFIMANAGER_DHCP_CHECK_UNVERIFIED,    //CACHED LEASE SET AS STATIC IP, NOT PROBED YET
+    ESP32_WIFIMANAGER_DHCP_CHECK_PROBING,       //GOT_IP HELD, ARP FOR GATEWAY AND OUR ADDRESS OUT
+    ESP32_WIFIMANAGER_DHCP_CHECK_RENEWING       //INIT-REBOOT OUT, ADDRESS STAYS UP MEANWHILE
+}esp32_wifimanager_dhcp_check_t;
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_PROVISION_WINNER_NONE = 0,
+    ESP32_WIFIMANAGER_PROVISION_WINNER_SMARTCONFIG,
+    ESP32_WIFIMANAGER_PROVISION_WINNER_WEBCONFIG
+}esp32_wifimanager_provision_winner_t;
+
+typedef struct
+{
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t authmode;
+}esp32_wifimanager_fast_connect_t;
+
+typedef struct
+{
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+    uint32_t lease_s;
+    int64_t obtained_epoch;     //0 IF WALL CLOCK WAS NOT SET
+}esp32_wifimanager_dhcp_lease_t;
+
+typedef struct
+{
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    uint16_t success_count;
+    uint16_t fail_count;
+    int8_t last_rssi;
+    uint8_t used;
+}esp32_wifimanager_credential_entry_t;
+
+typedef struct
+{
+    uint8_t entry;
+    uint8_t channel;
+    uint8_t bssid[6];
+    int8_t rssi;
+    int16_t score;
+}esp32_wifimanager_candidate_t;
+
+//ONE MANAGER INSTANCE (ESP32_WIFIMANAGER_CTX_* API)
+//ALL PER MANAGER STATE LIVES HERE, INCLUDING ITS TIMER WHEEL, SCAN CACHE,
+//LATENCY RECORDER, TRACE RING, CREDENTIAL LOG AND WEBCONFIG PORTAL. THE
+//SUBMODULES (NOTIFY, LOG) ARE SHARED BY ALL INSTANCES
+struct esp32_wifimanager_s
+{
+    //DEBUG RELATED
+    bool debug_on;
+
+    //OPERATION RELATED
+    //STATE, LINK UP FLAG AND ATTEMPT COUNT. SEE ESP32_WIFIMANAGER_FSM.h
+    esp32_wifimanager_fsm_t fsm;
+
+    wifi_config_t station_config;
+
+    //RADIO RELATED. SEE ESP32_WIFIMANAGER_DRIVER.h
+    //DRIVER_BOUND IS SET BY SETPARAMETERS ONCE THE RADIO ROUTES ITS EVENTS HERE
+    const esp32_wifimanager_driver_t* driver;
+    void* driver_ctx;
+    bool driver_bound;
+
+    //NVS NAMESPACE OF EVERY KEY THIS INSTANCE KEEPS (ESP32_WIFIMANAGER_CTX_SetNamespace)
+    char nvs_namespace[ESP32_WIFIMANAGER_NVS_NAMESPACE_LEN];
+
+    //EVENT QUEUE & MANAGER TASK RELATED
+    //ALL STATE CHANGES HAPPEN IN THE QUEUE CONSUMER (MANAGER TASK OR MAINITER CALLER)
+    QueueHandle_t evt_queue;
+    TaskHandle_t task;
+    esp32_wifimanager_timerwheel_t timers;
+    wifi_config_t sc_config;                //SMARTCONFIG RESULT, WRITTEN UNDER drv_lock
+
+    //RECONNECT SCHEDULER RELATED
+    esp32_wifimanager_backoff_t backoff;
+    esp32_wifimanager_timer_t reconnect_timer;
+    uint8_t backoff_level;
+    bool link_lost;
+    uint8_t disconnect_reason;
+
+    //FLAP SUPPRESSION RELATED
+    //HOLD_ACTIVE = LINK IS DOWN BUT SUBSCRIBERS WERE NOT TOLD YET
+    esp32_wifimanager_timer_t hold_timer;
+    bool hold_active;
+    bool hold_resumed;           //NEXT GOT_IP IS NOT REPORTED EITHER
+    int64_t hold_start_us;
+    bool provisioning;
+
+    //PROVISIONING RELATED
+    //IN SMARTCONFIG_WEBCONFIG MODE, SC_SLICE TELLS WHICH METHOD HAS THE RADIO
+    esp32_wifimanager_provision_winner_t provision_winner;
+    int64_t provision_start_us;
+    esp32_wifimanager_timer_t slice_timer;
+    bool sc_running;
+    bool sc_slice;
+    bool sc_locked;
+    uint8_t ap_clients;
+    uint8_t ap_channel;
+
+    //APSTA RELATED
+    //WHILE THE SOFTAP IS UP, THE STATION KEEPS TRYING THE STORED NETWORK
+    esp32_wifimanager_timer_t apsta_timer;
+    uint16_t apsta_count;        //RETRIES THIS PROVISIONING ROUND
+
+    //FAST RECONNECT RELATED
+    esp32_wifimanager_fast_connect_t fast_connect;
+    portMUX_TYPE drv_lock;                              //GUARDS WHAT THE DRIVER EVENT / SMARTCONFIG CONTEXTS HAND TO THE MANAGER TASK
+    esp32_wifimanager_fast_connect_t fast_connect_pending;  //AP OF THE LAST STA_CONNECTED, WRITTEN UNDER drv_lock
+    bool fast_connect_active;
+
+    //DHCP LEASE CACHE RELATED
+    esp32_wifimanager_dhcp_cache_mode_t dhcp_cache_mode;
+    esp32_wifimanager_dhcp_lease_t dhcp_lease;
+    bool dhcp_lease_loaded;
+    int64_t dhcp_lease_obtained_us; //0 IF NOT OBTAINED THIS BOOT
+    bool dhcp_cache_active;
+    int64_t sta_connected_ts_us;
+    bool wifi_started;
+    esp32_wifimanager_timer_t dhcp_renew_timer;
+    esp32_wifimanager_dhcp_check_t dhcp_check;
+    esp32_wifimanager_timer_t dhcp_check_timer;     //ARP PROBE WINDOW / INIT-REBOOT ACK WAIT
+
+    //MULTI NETWORK CREDENTIAL TABLE RELATED
+    //INDEX IS AN OPEN ADDRESSING HASH OF SSID -> TABLE SLOT (-1 = EMPTY)
+    esp32_wifimanager_credential_entry_t cred_table[ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE];
+    uint32_t cred_hash[ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE];
+    int8_t cred_index[ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE];
+    bool cred_loaded;
+    bool cred_dirty;            //FAIL COUNTS NOT SAVED YET
+    wifi_ap_record_t scan_records[ESP32_WIFIMANAGER_SCAN_MAX_AP];
+    esp32_wifimanager_candidate_t candidates[ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE];
+    uint8_t candidate_count;
+    uint8_t candidate_next;
+    int8_t candidate_current;
+    bool multi_scan_pending;
+
+    //PMK CACHE RELATED
+    //PMK_JOB_* DESCRIBE THE KEY BEING DERIVED IN THE BACKGROUND
+    bool pmk_on;
+    bool pmk_loaded;
+    esp32_wifimanager_pmk_cache_t pmk_cache;
+    bool pmk_job;
+    esp32_wifimanager_pmk_job_t pmk_derive;
+    uint8_t pmk_job_tag[ESP32_WIFIMANAGER_PMK_TAG_LEN];
+    uint32_t pmk_job_ssid_hash;
+
+    //SCAN CACHE RELATED
+    //ONE SCAN AT A TIME. SCAN_CHANNEL IS THE CHANNEL BEING SCANNED (0 = ALL)
+    //SCAN_REFRESH_MS IS THE BACKGROUND REFRESH PERIOD (0 = OFF)
+    esp32_wifimanager_scancache_t scan_cache;
+    esp32_wifimanager_timer_t scan_timer;
+    uint32_t scan_refresh_ms;
+    bool scan_busy;
+    uint8_t scan_channel;
+    uint8_t scan_next_channel;
+    int64_t scan_start_us;
+    int64_t scan_channel_us[ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX + 1];
+
+    //ROAMING RELATED
+    esp32_wifimanager_roam_t roam;
+    bool roam_enabled;
+    esp32_wifimanager_timer_t roam_timer;
+    esp32_wifimanager_roam_state_t roam_state;
+    int16_t roam_rssi_q4;
+    int8_t roam_cur_rssi;
+    uint8_t roam_cur_bssid[6];
+    uint16_t roam_channels;       //STILL TO SCAN. BIT 0 = ALL CHANNELS
+    int64_t roam_scan_us;
+    int64_t roam_last_us;
+    int64_t roam_start_us;
+    bool roam_pinned;            //STA CONFIG LOCKED TO ROAM TARGET
+
+    //POWER POLICY RELATED
+    //POWER_LEVEL IS WHAT THE DRIVER RUNS (OR, IF NOT ENABLED, REPORTS) NOW
+    esp32_wifimanager_power_t power;
+    bool power_enabled;
+    esp32_wifimanager_timer_t power_timer;
+    esp32_wifimanager_power_policy_t power_level;
+    int64_t power_since_us;      //START OF CURRENT LEVEL. 0 = WIFI NOT STARTED
+    int64_t power_busy_until_us;
+    int16_t power_rssi_q4;
+
+    //HEALTH PROBE RELATED
+    //ONE ROUND AT A TIME. THE TIMER EITHER POLLS THE ROUND OR STARTS THE NEXT ONE
+    esp32_wifimanager_health_t health;
+    bool health_enabled;
+    esp32_wifimanager_timer_t health_timer;
+    esp32_wifimanager_health_probe_t health_probe;
+    esp32_wifimanager_health_state_t health_state;
+    uint8_t health_failed;          //CHECKS FAILED IN THE LAST ROUND
+    uint8_t health_fail_rounds;     //FAILED ROUNDS IN A ROW
+    uint32_t health_interval_ms;
+
+    //INPUT TRACE RELATED
+    //WHILE REPLAYING, HARDWARE READS ARE SERVED FROM THE REPLAY FIFO
+    bool trace_on;
+    esp32_wifimanager_trace_t trace;
+    bool replaying;
+    bool replay_pending;
+    uint32_t replay_value[ESP32_WIFIMANAGER_TRACE_REPLAY_INPUTS];
+    uint8_t replay_kind[ESP32_WIFIMANAGER_TRACE_REPLAY_INPUTS];
+    uint8_t replay_next;
+    uint8_t replay_count;
+
+    //STATISTICS RELATED
+    esp32_wifimanager_stats_t stats;
+    esp32_wifimanager_latency_recorder_t latency;
+    int64_t init_ts_us;
+    int64_t disconnect_ts_us;
+    uint32_t conn_start_ticks;
+    uint32_t conn_start_transitions;
+    int64_t stats_start_us;
+
+    //GPIO RELATED
+    uint8_t gpio_led;
+    bool led_status;
+    esp32_wifimanager_timer_t led_timer;
+    esp32_wifimanager_status_led_type_t led_idle_level;
+    uint8_t gpio_trigger_pin;
+    esp32_wifimanager_gpio_trigger_type_t gpio_trigger_type;
+
+    //CREDENTIAL SRC & CONFIG MODE RELATED
+    esp32_wifimanager_credential_src_t credential_src;
+    esp32_wifimanager_config_mode_t config_mode;
+
+    //SSID RELATED
+    esp32_wifimanager_credential_hardcoded_t ssid_hardcoded_details;
+    esp32_wifimanager_credential_external_storage_t eeprom_flash_details;
+    esp32_wifimanager_credlog_t credlog;
+
+    //CUSTOM FIELDS (WEBCONFIG) RELATED
+    char custom_field_names[ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT][ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1];
+    char custom_field_values[ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT][ESP32_WIFIMANAGER_CUSTOM_FIELD_VALUE_LEN + 1];
+    uint8_t custom_field_count;
+    bool custom_field_loaded;
+    esp32_wifimanager_webconfig_t webconfig;            //PORTAL AND ITS CAPTIVE DNS
+    portMUX_TYPE web_lock;                              //GUARDS web_result BETWEEN THE WEBCONFIG TASK AND THE MANAGER TASK
+    esp32_wifimanager_provision_data_t web_result;      //WRITTEN BY THE WEBCONFIG TASK UNDER web_lock
+    esp32_wifimanager_provision_data_t web_applied;     //MANAGER TASK SNAPSHOT OF web_result
+
+    //USER CB (LEGACY, SEE SetUserCbFunction)
+    void (*wifi_connected_user_cb)(char**, bool);
+};
 
 //INTERNAL VARIABLES
-//DEBUG RELATED
-static bool s_debug_on;
+//DEFAULT INSTANCE, USED BY THE ESP32_WIFIMANAGER_* (NON CTX) API
+static esp32_wifimanager_t s_esp32_wifimanager_default = {.backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT(),
+                                                            .roam = ESP32_WIFIMANAGER_ROAM_DEFAULT(),
+                                                            .power = ESP32_WIFIMANAGER_POWER_DEFAULT(),
+                                                            .health = ESP32_WIFIMANAGER_HEALTH_DEFAULT(),
+                                                            .pmk_on = true,
+                                                            .trace_on = true,
+                                                            .web_lock = portMUX_INITIALIZER_UNLOCKED,
+                                                            .drv_lock = portMUX_INITIALIZER_UNLOCKED,
+                                                            .nvs_namespace = ESP32_WIFIMANAGER_NVS_NAMESPACE};
+
+//INTERNAL FUNCTIONS
+static void s_esp32_wifimanager_set_state(esp32_wifimanager_t* wm, esp32_wifimanager_state_t state);
+static void s_esp32_wifimanager_notify(esp32_wifimanager_t* wm, esp32_wifimanager_notify_type_t type);
+static void s_esp32_wifimanager_user_cb_notify(const esp32_wifimanager_notify_t* notify, void* arg);
+static void s_esp32_wifimanager_run_state(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_post_evt(esp32_wifimanager_t* wm, esp32_wifimanager_evt_type_t type, uint32_t arg);
+static void s_esp32_wifimanager_process_evt(esp32_wifimanager_t* wm, const esp32_wifimanager_evt_t* evt);
+static void s_esp32_wifimanager_sta_got_ip(esp32_wifimanager_t* wm, int64_t ts_us);
+static uint32_t s_esp32_wifimanager_input(esp32_wifimanager_t* wm, esp32_wifimanager_trace_kind_t kind, uint32_t value);
+static void s_esp32_wifimanager_task_fn(void* pArg);
+static void s_esp32_wifimanager_timers_advance(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_fast_connect_apply(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_fast_connect_fallback(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_fast_connect_save(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_dhcp_lease_usable(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_cache_apply(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_dhcp_static_apply(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_cache_fallback(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_got_ip(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_lease_save(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_probe_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_renew(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_check(esp32_wifimanager_t* wm, int64_t ts_us);
+static void s_esp32_wifimanager_dhcp_check_abort(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_dhcp_renew_cb(void* pArg);
+static void s_esp32_wifimanager_dhcp_check_cb(void* pArg);
+static void s_esp32_wifimanager_slice_cb(void* pArg);
+static void s_esp32_wifimanager_apsta_cb(void* pArg);
+static void s_esp32_wifimanager_hold_cb(void* pArg);
+static void s_esp32_wifimanager_scan_refresh_cb(void* pArg);
+static void s_esp32_wifimanager_roam_timer_cb(void* pArg);
+static void s_esp32_wifimanager_power_timer_cb(void* pArg);
+static void s_esp32_wifimanager_health_timer_cb(void* pArg);
+static uint32_t s_esp32_wifimanager_ssid_hash(const uint8_t* ssid);
+static void s_esp32_wifimanager_cred_load(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_cred_save(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_cred_pwd_valid(const char* pwd);
+static bool s_esp32_wifimanager_pmk_apply(esp32_wifimanager_t* wm, wifi_config_t* config);
+static bool s_esp32_wifimanager_pmk_psk_ap(esp32_wifimanager_t* wm, const wifi_config_t* config);
+static void s_esp32_wifimanager_pmk_derived(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_pmk_done_cb(void* arg);
+static void s_esp32_wifimanager_pmk_load(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_pmk_save(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_cred_reindex(esp32_wifimanager_t* wm);
+static int8_t s_esp32_wifimanager_cred_lookup(esp32_wifimanager_t* wm, const uint8_t* ssid);
+static bool s_esp32_wifimanager_multi_connecting(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_multi_scan_done(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_multi_rank(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_multi_got_ip(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_scan_start(esp32_wifimanager_t* wm, uint8_t channel, bool passive);
+static void s_esp32_wifimanager_scan_done(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_scan_abort(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_scan_refresh(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_scan_refresh_arm(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_scan_cache_complete(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_check(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_scan_next(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_scan_done(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_switch(esp32_wifimanager_t* wm, const esp32_wifimanager_scan_entry_t* target);
+static void s_esp32_wifimanager_roam_done(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_failed(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_roam_unpin(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_power_check(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_power_update(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_power_level(esp32_wifimanager_t* wm, esp32_wifimanager_power_policy_t level);
+static bool s_esp32_wifimanager_credlog_load(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_credlog_got_ip(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_stats_conn_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_stats_got_ip(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_wifi_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_wifi_connect(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_storage_is_flash(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_intialize(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_connecting(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_connected(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_disconnected(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_connection_failed(esp32_wifimanager_t* wm);
+
+static esp32_wifimanager_disconnect_class_t s_esp32_wifimanager_reason_class(uint8_t reason);
+static void s_esp32_wifimanager_hold_down_end(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_health_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_health_stop(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_health_check(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_health_round(esp32_wifimanager_t* wm);
+static uint32_t s_esp32_wifimanager_backoff_next_ms(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_reconnect_schedule(esp32_wifimanager_t* wm, uint32_t delay_ms);
+static void s_esp32_wifimanager_reconnect_cancel(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_provisioning_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_provisioning_stop(esp32_wifimanager_t* wm);
+static bool s_esp32_wifimanager_provisioning_won(esp32_wifimanager_t* wm, esp32_wifimanager_provision_winner_t winner);
+static void s_esp32_wifimanager_provision_slice(esp32_wifimanager_t* wm);
+static uint8_t s_esp32_wifimanager_apsta_channel(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_apsta_retry(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_smartconfig_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_smartconfig_stop(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_webconfig_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_softap_start(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_custom_field_load(esp32_wifimanager_t* wm);
+static void s_esp32_wifimanager_web_result_cb(const esp32_wifimanager_provision_data_t* result, void* arg);
+static void s_esp32_wifimanager_web_credentials(esp32_wifimanager_t* wm);
+
+static void s_esp32_wifimanager_led_toggle_cb(void* pArg);
+static void s_esp32_wifimanager_wifi_connect_check_cb(void* pArg);
+
+void ESP32_WIFIMANAGER_SetDebug(uint8_t debug)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetDebug(&s_esp32_wifimanager_default, debug);
+}
+
+void ESP32_WIFIMANAGER_SetParameters(esp32_wifimanager_credential_src_t input_mode,
+                                        esp32_wifimanager_config_mode_t config_mode,
+                                        void* user_data,
+                                        uint8_t gpio_led_pin,
+                                        char* project_name)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetParameters(&s_esp32_wifimanager_default, input_mode,
+                                            config_mode,
+                                            user_data,
+                                            gpio_led_pin,
+                                            project_name);
+}
+
+void ESP32_WIFIMANAGER_SetStatusLedType(esp32_wifimanager_status_led_type_t led_type)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetStatusLedType(&s_esp32_wifimanager_default, led_type);
+}
+
+void ESP32_WIFIMANAGER_SetGpioTriggerLevel(esp32_wifimanager_gpio_trigger_type_t level)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetGpioTriggerLevel(&s_esp32_wifimanager_default, level);
+}
+
+esp_err_t ESP32_WIFIMANAGER_AddCustomField(const char* name)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_AddCustomField(&s_esp32_wifimanager_default, name);
+}
+
+esp_err_t ESP32_WIFIMANAGER_GetCustomFieldValue(const char* name, char* value, size_t len)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_GetCustomFieldValue(&s_esp32_wifimanager_default, name, value, len);
+}
+
+esp_err_t ESP32_WIFIMANAGER_AddCredential(const char* ssid, const char* pwd)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_AddCredential(&s_esp32_wifimanager_default, ssid, pwd);
+}
+
+esp_err_t ESP32_WIFIMANAGER_RemoveCredential(const char* ssid)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_RemoveCredential(&s_esp32_wifimanager_default, ssid);
+}
+
+void ESP32_WIFIMANAGER_SetBackoff(const esp32_wifimanager_backoff_t* backoff)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetBackoff(&s_esp32_wifimanager_default, backoff);
+}
+
+void ESP32_WIFIMANAGER_SetDhcpCacheMode(esp32_wifimanager_dhcp_cache_mode_t mode)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetDhcpCacheMode(&s_esp32_wifimanager_default, mode);
+}
+
+void ESP32_WIFIMANAGER_SetRoaming(const esp32_wifimanager_roam_t* roam)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetRoaming(&s_esp32_wifimanager_default, roam);
+}
+
+void ESP32_WIFIMANAGER_SetPower(const esp32_wifimanager_power_t* power)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetPower(&s_esp32_wifimanager_default, power);
+}
+
+void ESP32_WIFIMANAGER_SetHealth(const esp32_wifimanager_health_t* health)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetHealth(&s_esp32_wifimanager_default, health);
+}
+
+esp32_wifimanager_health_state_t ESP32_WIFIMANAGER_GetHealth(void)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_GetHealth(&s_esp32_wifimanager_default);
+}
+
+void ESP32_WIFIMANAGER_SetPmkCache(bool on)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(&s_esp32_wifimanager_default, on);
+}
+
+void ESP32_WIFIMANAGER_SetScanRefresh(uint32_t period_ms)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetScanRefresh(&s_esp32_wifimanager_default, period_ms);
+}
+
+void ESP32_WIFIMANAGER_PowerHint(uint32_t busy_ms)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_PowerHint(&s_esp32_wifimanager_default, busy_ms);
+}
 
-//OPERATION RELATED
-static esp32_wifimanager_state_t s_state;
-static volatile bool s_wifi_connected;
-static volatile uint8_t s_wifi_attempt_count;
+esp32_wifimanager_disconnect_class_t ESP32_WIFIMANAGER_DisconnectClass(uint8_t reason)
+{
+    //TABLE ONLY. NO DRIVER OR INSTANCE STATE
+
+    return s_esp32_wifimanager_reason_class(reason);
+}
+
+uint32_t ESP32_WIFIMANAGER_PowerEstimate(const esp32_wifimanager_power_t* power,
+                                            esp32_wifimanager_power_policy_t policy)
+{
+    //MODEL ONLY. NO DRIVER OR INSTANCE STATE
+
+    esp32_wifimanager_power_t defaults = ESP32_WIFIMANAGER_POWER_DEFAULT();
+
+    if(power == NULL)
+    {
+        power = &defaults;
+    }
+    return ESP32_WIFIMANAGER_POWER_AvgMw(ESP32_WIFIMANAGER_POWER_DutyPermille(power, policy));
+}
+
+uint32_t ESP32_WIFIMANAGER_ProvisionPercentile(const esp32_wifimanager_stats_t* stats, uint8_t pct)
+{
+    //STATS ONLY. SORTS A COPY OF THE SAMPLE RING
+
+    uint32_t sorted[ESP32_WIFIMANAGER_PROVISION_SAMPLES];
+    uint32_t n = stats->provision_samples;
+    uint32_t rank;
+    uint32_t v;
+    uint32_t i;
+    uint32_t j;
+
+    if(n > ESP32_WIFIMANAGER_PROVISION_SAMPLES)
+    {
+        n = ESP32_WIFIMANAGER_PROVISION_SAMPLES;
+    }
+    if(n == 0)
+    {
+        return 0;
+    }
+    if(pct > 100)
+    {
+        pct = 100;
+    }
+
+    //INSERTION SORT, AT MOST PROVISION_SAMPLES ENTRIES
+    for(i = 0; i < n; i++)
+    {
+        v = stats->provision_ms[i];
+        for(j = i; j > 0 && sorted[j - 1] > v; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+
+    rank = (pct * n + 99) / 100;
+    return sorted[(rank == 0) ? 0 : rank - 1];
+}
+
+void ESP32_WIFIMANAGER_SetUserCbFunction(void (*wifi_connected_cb)(char**, bool))
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetUserCbFunction(&s_esp32_wifimanager_default, wifi_connected_cb);
+}
+
+esp_err_t ESP32_WIFIMANAGER_StartTask(uint8_t priority)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_StartTask(&s_esp32_wifimanager_default, priority);
+}
+
+void ESP32_WIFIMANAGER_Mainiter(void)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_Mainiter(&s_esp32_wifimanager_default);
+}
+
+void ESP32_WIFIMANAGER_GetStats(esp32_wifimanager_stats_t* stats)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_GetStats(&s_esp32_wifimanager_default, stats);
+}
+
+void ESP32_WIFIMANAGER_ResetStats(void)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_ResetStats(&s_esp32_wifimanager_default);
+}
+
+void ESP32_WIFIMANAGER_SetTrace(bool on)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_SetTrace(&s_esp32_wifimanager_default, on);
+}
+
+uint16_t ESP32_WIFIMANAGER_GetTrace(esp32_wifimanager_trace_record_t* records, uint16_t max)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_GetTrace(&s_esp32_wifimanager_default, records, max);
+}
+
+void ESP32_WIFIMANAGER_DumpTrace(void)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_DumpTrace(&s_esp32_wifimanager_default);
+}
+
+esp32_wifimanager_t* ESP32_WIFIMANAGER_CTX_Create(void)
+{
+    //NEW INSTANCE WITH DEFAULT SETTINGS. NULL IF OUT OF MEMORY
+
+    esp32_wifimanager_t* wm = calloc(1, sizeof(esp32_wifimanager_t));
 
-static wifi_config_t s_station_config;
+    if(wm != NULL)
+    {
+        wm->backoff = (esp32_wifimanager_backoff_t)ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+        wm->roam = (esp32_wifimanager_roam_t)ESP32_WIFIMANAGER_ROAM_DEFAULT();
+        wm->power = (esp32_wifimanager_power_t)ESP32_WIFIMANAGER_POWER_DEFAULT();
+        wm->health = (esp32_wifimanager_health_t)ESP32_WIFIMANAGER_HEALTH_DEFAULT();
+        wm->pmk_on = true;
+        wm->web_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+        wm->drv_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+        wm->driver = ESP32_WIFIMANAGER_DRIVER_Idf();
+        strcpy(wm->nvs_namespace, ESP32_WIFIMANAGER_NVS_NAMESPACE);
+    }
+    return wm;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_Destroy(esp32_wifimanager_t* wm)
+{
+    //FREE AN INSTANCE FROM ESP32_WIFIMANAGER_CTX_Create
+    //AN INSTANCE WITH A MANAGER TASK, A PORTAL OR A PMK JOB STILL RUNNING STAYS.
+    //OTHERWISE ITS RADIO IS RELEASED (NO EVENT IN FLIGHT AFTER UNBIND), ITS LEGACY
+    //CB SUBSCRIPTION DROPPED (UNSUBSCRIBE WAITS FOR A CALL IN FLIGHT) AND IT IS FREED.
+    //ITS TIMERS LIVE IN ITS OWN WHEEL, SO NOTHING ELSE POINTS AT IT
+
+    if(wm == NULL || wm == &s_esp32_wifimanager_default)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(wm->task != NULL || wm->webconfig.task != NULL || wm->webconfig.dns.task != NULL || wm->pmk_job)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(wm->driver_bound)
+    {
+        wm->driver->unbind(wm->driver_ctx, wm);
+        wm->driver_bound = false;
+    }
+    ESP32_WIFIMANAGER_NOTIFY_Unsubscribe(s_esp32_wifimanager_user_cb_notify, wm);
+    if(wm->evt_queue != NULL)
+    {
+        vQueueDelete(wm->evt_queue);
+    }
+    free(wm);
+    return ESP_OK;
+}
+
+esp32_wifimanager_t* ESP32_WIFIMANAGER_CTX_Default(void)
+{
+    //INSTANCE BEHIND THE ESP32_WIFIMANAGER_* API
+
+    return &s_esp32_wifimanager_default;
+}
+
+size_t ESP32_WIFIMANAGER_CTX_Size(void)
+{
+    //MEMORY PER INSTANCE (EXCLUDING ITS EVENT QUEUE AND TASK)
+
+    return sizeof(esp32_wifimanager_t);
+}
+
+void ESP32_WIFIMANAGER_CTX_SetDebug(esp32_wifimanager_t* wm, uint8_t debug)
+{
+    //SET MODULE DEBUG FLAG
+    
+    wm->debug_on = debug;
+
+    ets_printf(ESP32_WIFIMANAGER_TAG" : Debug = %u\n", wm->debug_on);
+}
+
+void ESP32_WIFIMANAGER_CTX_SetTrace(esp32_wifimanager_t* wm, bool on)
+{
+    //RECORD EVENTS AND HARDWARE READS OF THIS INSTANCE INTO ITS TRACE RING
+
+    wm->trace_on = on;
+}
+
+uint16_t ESP32_WIFIMANAGER_CTX_GetTrace(esp32_wifimanager_t* wm, esp32_wifimanager_trace_record_t* records, uint16_t max)
+{
+    //COPY OF THE INSTANCE'S TRACE RING
+
+    if(records == NULL)
+    {
+        return 0;
+    }
+    return ESP32_WIFIMANAGER_TRACE_Export(&wm->trace, records, max);
+}
+
+void ESP32_WIFIMANAGER_CTX_DumpTrace(esp32_wifimanager_t* wm)
+{
+    //PRINT THE INSTANCE'S TRACE RING FOR tools/tracedecode.py
+
+    ESP32_WIFIMANAGER_TRACE_Dump(&wm->trace);
+}
+
+void ESP32_WIFIMANAGER_CTX_SetParameters(esp32_wifimanager_t* wm,
+                                            esp32_wifimanager_credential_src_t input_mode,
+                                            esp32_wifimanager_config_mode_t config_mode,
+                                            void* user_data,
+                                            uint8_t gpio_led_pin,
+                                            char* project_name)
+{
+    //ESP32 WIFIMANAGER SET PARAMETERS
+    //BINDS wm TO ITS RADIO. REFUSED IF ANOTHER INSTANCE HOLDS THAT RADIO
 
-//GPIO RELATED
-static uint8_t s_esp32_wifimanager_gpio_led;
-static volatile bool s_esp32_wifimanager_led_status;
-static esp32_wifimanager_status_led_type_t s_esp32_wifimanager_led_idle_level;
-static uint8_t s_esp32_wifimanager_gpio_trigger_pin;
-static esp32_wifimanager_gpio_trigger_type_t s_esp32_wifimanager_gpio_trigger_type;
+    if(wm->driver == NULL)
+    {
+        wm->driver = ESP32_WIFIMANAGER_DRIVER_Idf();
+    }
+    if(wm->driver->bind(wm->driver_ctx, wm) != ESP_OK)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Radio is bound to another instance\n");
+        return;
+    }
+    wm->driver_bound = true;
+
+    ESP32_WIFIMANAGER_FSM_Reset(&wm->fsm, ESP32_WIFIMANAGER_STATE_INITIALIZE);
+    if(wm->webconfig.port == 0)
+    {
+        //NOT SET BY CTX_SetPortalPorts. STANDARD PORTS
+        ESP32_WIFIMANAGER_WEBCONFIG_Init(&wm->webconfig, 0, 0);
+    }
+
+    wm->credential_src = input_mode;
+    wm->config_mode = config_mode;
+    wm->gpio_led = gpio_led_pin;
+
+    //INIT OPERATIONAL PARAMETERS
+
+    //CREATE EVENT QUEUE
+    if(wm->evt_queue == NULL)
+    {
+        wm->evt_queue = xQueueCreate(ESP32_WIFIMANAGER_EVT_QUEUE_LEN,
+                                                        sizeof(esp32_wifimanager_evt_t));
+    }
+
+    switch(wm->credential_src)
+    { 
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = GPIO\n");
+            wm->gpio_trigger_pin = *(uint8_t*)user_data;
+            ets_printf(ESP32_WIFIMANAGER_TAG" : GPIO pin = %u\n", wm->gpio_trigger_pin);
+            //SET TRIGGER GPIO AS INPUT
+            ESP32_GPIO_SetDirection(wm->gpio_trigger_pin,
+                                        GPIO_DIRECTION_INPUT);
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = HARDCODED\n");
+            wm->ssid_hardcoded_details.ssid_name= 
+                ((esp32_wifimanager_credential_hardcoded_t*)user_data)->ssid_name;
+            wm->ssid_hardcoded_details.ssid_pwd= 
+                ((esp32_wifimanager_credential_hardcoded_t*)user_data)->ssid_pwd;
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = INTERNAL\n");
+            //DO NOTHING. WILL TAKE CARE OF IT LATER ON
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = EXTERNAL FLASH\n");
+            wm->eeprom_flash_details.ssid_name_addr = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_name_addr;
+            wm->eeprom_flash_details.ssid_pwd_addr = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_pwd_addr;
+            wm->eeprom_flash_details.ops = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ops;
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = EXTERNAL EEPROM\n");
+            wm->eeprom_flash_details.ssid_name_addr = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_name_addr;
+            wm->eeprom_flash_details.ssid_pwd_addr = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_pwd_addr;
+            wm->eeprom_flash_details.ops = 
+                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ops;
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = MULTI\n");
+            //TABLE IS FILLED WITH ESP32_WIFIMANAGER_AddCredential
+            break;
+
+        default:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = INVALID\n");
+            break;
+    }
+
+    switch(wm->config_mode)
+    {
+        case ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = SMARTCONFIG\n");
+            break;
+        
+        case ESP32_WIFIMANAGER_CONFIG_WEBCONFIG:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = WEBCONFIG\n");
+            s_esp32_wifimanager_custom_field_load(wm);
+            break;
+        
+        case ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = SMARTCONFIG + WEBCONFIG\n");
+            s_esp32_wifimanager_custom_field_load(wm);
+            break;
+        
+        case ESP32_WIFIMANAGER_CONFIG_BLE:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = BLE\n");
+            break;
+        
+        default:
+            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = INVALID\n");
+            break;
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetStatusLedType(esp32_wifimanager_t* wm, esp32_wifimanager_status_led_type_t led_type)
+{
+    //SET STATUS LED TYPE
+
+    wm->led_idle_level = led_type;
+
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Status LED idle level = %u\n", led_type);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetGpioTriggerLevel(esp32_wifimanager_t* wm, esp32_wifimanager_gpio_trigger_type_t level)
+{
+    //SET GPIO TRIGGER LEVEL TYPE
+
+    wm->gpio_trigger_type = level;
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : GPIO trigger type = %u\n", level);
+    }
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_AddCustomField(esp32_wifimanager_t* wm, const char* name)
+{
+    //ADD A CUSTOM FIELD TO THE WEBCONFIG PAGE
+    //NAME IS SHOWN AS THE FIELD LABEL AND USED AS KEY FOR GetCustomFieldValue
+
+    size_t i;
+    size_t len;
+
+    if(name == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    len = strlen(name);
+    if(len == 0 || len > ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for(i = 0; i < len; i++)
+    {
+        //NAME GOES INTO A JSON STRING AS IS
+        if(name[i] == '"' || name[i] == '\\' || (uint8_t)name[i] < 0x20)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if(wm->custom_field_count >= ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    strcpy(wm->custom_field_names[wm->custom_field_count], name);
+    wm->custom_field_count++;
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_GetCustomFieldValue(esp32_wifimanager_t* wm, const char* name, char* value, size_t len)
+{
+    //GET LAST VALUE SUBMITTED FOR A CUSTOM FIELD (PERSISTED IN NVS)
+
+    uint8_t i;
+
+    if(name == NULL || value == NULL || len == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_esp32_wifimanager_custom_field_load(wm);
+
+    for(i = 0; i < wm->custom_field_count; i++)
+    {
+        if(strcmp(wm->custom_field_names[i], name) == 0)
+        {
+            if(strlen(wm->custom_field_values[i]) >= len)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            strcpy(value, wm->custom_field_values[i]);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_AddCredential(esp32_wifimanager_t* wm, const char* ssid, const char* pwd)
+{
+    //ADD (OR UPDATE) A NETWORK IN THE MULTI NETWORK CREDENTIAL TABLE
+    //IF TABLE IS FULL, THE ENTRY WITH THE WORST HISTORY IS REPLACED (LOGGED)
+    //pwd IS A PASSPHRASE (0..63) OR A 64 HEX DIGIT PSK
+
+    uint8_t key[ESP32_WIFIMANAGER_SSID_LEN] = {0};
+    int8_t slot;
+    uint8_t i;
+    int32_t worst_score = INT32_MAX;
+    int32_t score;
+
+    if(ssid == NULL || pwd == NULL ||
+        strlen(ssid) == 0 || strlen(ssid) > ESP32_WIFIMANAGER_SSID_LEN ||
+        !s_esp32_wifimanager_cred_pwd_valid(pwd))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_esp32_wifimanager_cred_load(wm);
+
+    memcpy(key, ssid, strlen(ssid));
+    slot = s_esp32_wifimanager_cred_lookup(wm, key);
+    if(slot < 0)
+    {
+        //FIND FREE SLOT, ELSE EVICT WORST
+        for(i = 0; i < ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE; i++)
+        {
+            if(!wm->cred_table[i].used)
+            {
+                slot = i;
+                break;
+            }
+            score = (int32_t)wm->cred_table[i].success_count -
+                        (int32_t)wm->cred_table[i].fail_count;
+            if(score < worst_score)
+            {
+                worst_score = score;
+                slot = i;
+            }
+        }
+        if(wm->cred_table[slot].used)
+        {
+            ESP32_WIFIMANAGER_LOGW(CREDENTIAL_EVICTED,
+                                    ESP32_WIFIMANAGER_LOG_Hash(wm->cred_table[slot].ssid, ESP32_WIFIMANAGER_SSID_LEN),
+                                    slot);
+        }
+        memset(&wm->cred_table[slot], 0, sizeof(esp32_wifimanager_credential_entry_t));
+        memcpy(wm->cred_table[slot].ssid, key, ESP32_WIFIMANAGER_SSID_LEN);
+        wm->cred_table[slot].used = true;
+    }
+    else if(strncmp((char*)wm->cred_table[slot].pwd, pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN) != 0)
+    {
+        //NEW PASSWORD. OLD HISTORY DOES NOT APPLY
+        wm->cred_table[slot].success_count = 0;
+        wm->cred_table[slot].fail_count = 0;
+    }
+
+    memset(wm->cred_table[slot].pwd, 0, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+    memcpy(wm->cred_table[slot].pwd, pwd, strlen(pwd));
+
+    s_esp32_wifimanager_cred_reindex(wm);
+    s_esp32_wifimanager_cred_save(wm);
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(CREDENTIAL_ADDED, ESP32_WIFIMANAGER_LOG_Hash((const uint8_t*)ssid, ESP32_WIFIMANAGER_SSID_LEN), slot);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_RemoveCredential(esp32_wifimanager_t* wm, const char* ssid)
+{
+    //REMOVE A NETWORK FROM THE MULTI NETWORK CREDENTIAL TABLE
+
+    uint8_t key[ESP32_WIFIMANAGER_SSID_LEN] = {0};
+    int8_t slot;
+
+    if(ssid == NULL || strlen(ssid) == 0 || strlen(ssid) > ESP32_WIFIMANAGER_SSID_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_esp32_wifimanager_cred_load(wm);
+
+    memcpy(key, ssid, strlen(ssid));
+    slot = s_esp32_wifimanager_cred_lookup(wm, key);
+    if(slot < 0)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memset(&wm->cred_table[slot], 0, sizeof(esp32_wifimanager_credential_entry_t));
+    s_esp32_wifimanager_cred_reindex(wm);
+    s_esp32_wifimanager_cred_save(wm);
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_CTX_SetBackoff(esp32_wifimanager_t* wm, const esp32_wifimanager_backoff_t* backoff)
+{
+    //SET RECONNECT SCHEDULER PARAMETERS
+
+    if(backoff == NULL || backoff->initial_ms == 0 || backoff->multiplier == 0)
+    {
+        return;
+    }
+
+    wm->backoff = *backoff;
+    if(wm->backoff.initial_ms < ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS)
+    {
+        //FIRST RETRY IS ALSO THE CONNECT TIMEOUT. SHORTER CUTS CONNECTS OFF
+        wm->backoff.initial_ms = ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS;
+    }
+    if(wm->backoff.max_ms < wm->backoff.initial_ms)
+    {
+        wm->backoff.max_ms = wm->backoff.initial_ms;
+    }
+    if(wm->backoff.jitter_pct > 100)
+    {
+        wm->backoff.jitter_pct = 100;
+    }
+
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Backoff %u..%u ms x%u +/-%u%%\n",
+                                            wm->backoff.initial_ms,
+                                            wm->backoff.max_ms,
+                                            wm->backoff.multiplier,
+                                            wm->backoff.jitter_pct);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetDhcpCacheMode(esp32_wifimanager_t* wm, esp32_wifimanager_dhcp_cache_mode_t mode)
+{
+    //SET DHCP LEASE CACHE MODE
+    //CALL BEFORE MAINITER / STARTTASK
+
+    wm->dhcp_cache_mode = mode;
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : DHCP cache mode = %u\n", mode);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetRoaming(esp32_wifimanager_t* wm, const esp32_wifimanager_roam_t* roam)
+{
+    //ENABLE ROAMING WITH GIVEN PARAMETERS. NULL DISABLES IT
+    //CALL BEFORE MAINITER / STARTTASK
+
+    wm->roam_enabled = (roam != NULL);
+    if(roam != NULL)
+    {
+        wm->roam = *roam;
+        if(wm->roam.check_ms < ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS)
+        {
+            wm->roam.check_ms = ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+        }
+    }
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Roaming = %u\n", wm->roam_enabled);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetPower(esp32_wifimanager_t* wm, const esp32_wifimanager_power_t* power)
+{
+    //ENABLE POWER POLICY WITH GIVEN PARAMETERS. NULL LEAVES THE DRIVER DEFAULT
+    //CALL BEFORE MAINITER / STARTTASK
+
+    wm->power_enabled = (power != NULL);
+    if(power != NULL)
+    {
+        wm->power = *power;
+        if(wm->power.policy >= ESP32_WIFIMANAGER_POWER_MAX)
+        {
+            wm->power.policy = ESP32_WIFIMANAGER_POWER_MAX_SAVE;
+        }
+        if(wm->power.check_ms < ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS)
+        {
+            wm->power.check_ms = ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+        }
+    }
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Power policy = %d\n", wm->power_enabled ? (int)wm->power.policy : -1);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetHealth(esp32_wifimanager_t* wm, const esp32_wifimanager_health_t* health)
+{
+    //ENABLE HEALTH PROBING WITH GIVEN PARAMETERS. NULL DISABLES IT
+    //CALL BEFORE MAINITER / STARTTASK
+
+    wm->health_enabled = (health != NULL && health->checks != 0);
+    if(health != NULL)
+    {
+        wm->health = *health;
+        wm->health.dns_name[ESP32_WIFIMANAGER_HEALTH_NAME_LEN] = 0;
+        if(wm->health.fail_threshold == 0)
+        {
+            wm->health.fail_threshold = 1;
+        }
+        if(wm->health.timeout_ms < ESP32_WIFIMANAGER_HEALTH_POLL_MS)
+        {
+            wm->health.timeout_ms = ESP32_WIFIMANAGER_HEALTH_POLL_MS;
+        }
+        if(wm->health.interval_ms < wm->health.timeout_ms)
+        {
+            wm->health.interval_ms = wm->health.timeout_ms;
+        }
+        if(wm->health.max_interval_ms < wm->health.interval_ms)
+        {
+            wm->health.max_interval_ms = wm->health.interval_ms;
+        }
+        if(wm->health.suspect_interval_ms < ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS)
+        {
+            wm->health.suspect_interval_ms = ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+        }
+    }
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Health checks = 0x%02x\n", wm->health_enabled ? wm->health.checks : 0);
+    }
+}
+
+esp32_wifimanager_health_state_t ESP32_WIFIMANAGER_CTX_GetHealth(esp32_wifimanager_t* wm)
+{
+    //LAST VERDICT, WHILE THE LINK IS UP
+
+    if(!ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+    {
+        return ESP32_WIFIMANAGER_HEALTH_UNKNOWN;
+    }
+    return wm->health_state;
+}
+
+void ESP32_WIFIMANAGER_CTX_SetPmkCache(esp32_wifimanager_t* wm, bool on)
+{
+    //CONNECT WITH CACHED WPA2 PMK (ON) OR LET THE SUPPLICANT DERIVE IT EVERY TIME (OFF)
+    //CALL BEFORE MAINITER / STARTTASK
+
+    wm->pmk_on = on;
+}
+
+void ESP32_WIFIMANAGER_CTX_PowerHint(esp32_wifimanager_t* wm, uint32_t busy_ms)
+{
+    //APP ACTIVITY HINT. APPLIED BY THE MANAGER CONTEXT
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_POWER_HINT, busy_ms);
+}
+
+uint8_t ESP32_WIFIMANAGER_GetScanResults(const esp32_wifimanager_scan_entry_t** results, uint8_t max)
+{
+    //DEFAULT INSTANCE
+
+    return ESP32_WIFIMANAGER_CTX_GetScanResults(&s_esp32_wifimanager_default, results, max);
+}
+
+uint8_t ESP32_WIFIMANAGER_CTX_GetScanResults(esp32_wifimanager_t* wm,
+                                                const esp32_wifimanager_scan_entry_t** results,
+                                                uint8_t max)
+{
+    //NEARBY NETWORKS FROM THE SCAN CACHE, STRONGEST FIRST
+
+    if(results == NULL)
+    {
+        return 0;
+    }
+    return ESP32_WIFIMANAGER_SCANCACHE_Sorted(&wm->scan_cache, results, max);
+}
+
+esp_err_t ESP32_WIFIMANAGER_Subscribe(esp32_wifimanager_notify_cb_t cb, void* arg, uint32_t mask)
+{
+    //SUBSCRIBE TO MANAGER EVENTS OF EVERY INSTANCE
+
+    return ESP32_WIFIMANAGER_NOTIFY_Subscribe(cb, arg, mask, NULL);
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_Subscribe(esp32_wifimanager_t* wm,
+                                            esp32_wifimanager_notify_cb_t cb,
+                                            void* arg,
+                                            uint32_t mask)
+{
+    //SUBSCRIBE TO THE EVENTS OF ONE INSTANCE ONLY
+
+    return ESP32_WIFIMANAGER_NOTIFY_Subscribe(cb, arg, mask, wm);
+}
+
+esp_err_t ESP32_WIFIMANAGER_Unsubscribe(esp32_wifimanager_notify_cb_t cb, void* arg)
+{
+    //STOP RECEIVING MANAGER EVENTS
+
+    return ESP32_WIFIMANAGER_NOTIFY_Unsubscribe(cb, arg);
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_SetPortalPorts(esp32_wifimanager_t* wm, uint16_t http_port, uint16_t dns_port)
+{
+    //PORTS OF THIS INSTANCE'S WEBCONFIG PORTAL AND CAPTIVE DNS. 0 = STANDARD PORT
+    //INSTANCES SHARING A NETWORK STACK NEED DIFFERENT PORTS. CALL BEFORE SETPARAMETERS
+
+    if(wm->webconfig.task != NULL || wm->webconfig.dns.task != NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP32_WIFIMANAGER_WEBCONFIG_Init(&wm->webconfig, http_port, dns_port);
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_SetDriver(esp32_wifimanager_t* wm,
+                                            const esp32_wifimanager_driver_t* driver,
+                                            void* ctx)
+{
+    //RADIO THIS INSTANCE DRIVES. NULL = THE ESP32'S OWN (DEFAULT)
+    //CALL BEFORE SETPARAMETERS. A BOUND RADIO IS NOT SWAPPED UNDER A RUNNING INSTANCE
+
+    if(wm->driver_bound)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    wm->driver = (driver != NULL) ? driver : ESP32_WIFIMANAGER_DRIVER_Idf();
+    wm->driver_ctx = (driver != NULL) ? ctx : NULL;
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_SetNamespace(esp32_wifimanager_t* wm, const char* name)
+{
+    //NVS NAMESPACE OF THIS INSTANCE. NULL = ESP32_WIFIMANAGER_NVS_NAMESPACE
+    //CALL BEFORE SETPARAMETERS, WHICH LOADS THE STORED CREDENTIALS FROM IT
+
+    if(name == NULL)
+    {
+        name = ESP32_WIFIMANAGER_NVS_NAMESPACE;
+    }
+    if(name[0] == '\0' || strlen(name) >= ESP32_WIFIMANAGER_NVS_NAMESPACE_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(wm->driver_bound)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    strcpy(wm->nvs_namespace, name);
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_CTX_SetScanRefresh(esp32_wifimanager_t* wm, uint32_t period_ms)
+{
+    //BACKGROUND SCAN CACHE REFRESH PERIOD. 0 DISABLES IT
+    //CALL BEFORE MAINITER / STARTTASK
+
+    if(period_ms != 0 && period_ms < ESP32_WIFIMANAGER_SCAN_REFRESH_MIN_MS)
+    {
+        period_ms = ESP32_WIFIMANAGER_SCAN_REFRESH_MIN_MS;
+    }
+    wm->scan_refresh_ms = period_ms;
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Scan refresh = %u ms\n", period_ms);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_SetUserCbFunction(esp32_wifimanager_t* wm, void (*wifi_connected_cb)(char**, bool))
+{
+    //SET WIFI CONNECT CB FN
+    //DELIVERED THROUGH AN ORDINARY SUBSCRIPTION
+
+    if(wifi_connected_cb != NULL)
+    {
+        wm->wifi_connected_user_cb = wifi_connected_cb;
+        ESP32_WIFIMANAGER_NOTIFY_Subscribe(s_esp32_wifimanager_user_cb_notify,
+                                            wm,
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_CONNECTED) |
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED) |
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_CONNECTION_FAILED),
+                                            wm);
+    }
+}
+
+
+esp_err_t ESP32_WIFIMANAGER_CTX_StartTask(esp32_wifimanager_t* wm, uint8_t priority)
+{
+    //START SELF CONTAINED MANAGER TASK
+    //TASK BLOCKS ON THE EVENT QUEUE. NO NEED TO CALL MAINITER AFTER THIS
+
+    if(wm->evt_queue == NULL || !wm->driver_bound)
+    {
+        //SETPARAMETERS NOT CALLED YET, OR IT WAS REFUSED THE RADIO
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(wm->task != NULL)
+    {
+        return ESP_OK;
+    }
+
+    if(xTaskCreate(s_esp32_wifimanager_task_fn,
+                    "wifimanager",
+                    ESP32_WIFIMANAGER_TASK_STACK_SIZE,
+                    wm,
+                    priority,
+                    &wm->task) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if(wm->debug_on)
+    {
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Manager task started (prio %u)\n", priority);
+    }
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_CTX_Mainiter(esp32_wifimanager_t* wm)
+{
+    //POLLED MODE
+    //HANDLES AT MOST ONE QUEUED EVENT PER CALL
+    //DOES NOTHING IF THE MANAGER TASK IS RUNNING OR wm HAS NO RADIO
+
+    esp32_wifimanager_evt_t evt;
+
+    if(wm->task != NULL || !wm->driver_bound)
+    {
+        return;
+    }
+
+    wm->stats.wakeups++;
+    s_esp32_wifimanager_timers_advance(wm);
+
+    if(ESP32_WIFIMANAGER_FSM_State(&wm->fsm) == ESP32_WIFIMANAGER_STATE_IDLE)
+    {
+        if(wm->evt_queue == NULL ||
+            xQueueReceive(wm->evt_queue, &evt, 0) != pdTRUE)
+        {
+            return;
+        }
+        s_esp32_wifimanager_process_evt(wm, &evt);
+    }
+
+    s_esp32_wifimanager_run_state(wm);
+}
+
+static void s_esp32_wifimanager_run_state(esp32_wifimanager_t* wm)
+{
+    //RUN ONE STEP OF THE STATE MACHINE
+
+    wm->stats.mainiter_ticks++;
+
+    switch (ESP32_WIFIMANAGER_FSM_State(&wm->fsm))
+    {
+        case  ESP32_WIFIMANAGER_STATE_INITIALIZE:
+            ESP32_WIFIMANAGER_LOGI(STATE, ESP32_WIFIMANAGER_STATE_INITIALIZE, 0);
+            s_esp32_wifimanager_stats_conn_start(wm);
+            s_esp32_wifimanager_intialize(wm);
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTING);
+            break;
+
+        case ESP32_WIFIMANAGER_STATE_CONNECTING:
+            ESP32_WIFIMANAGER_LOGI(STATE, ESP32_WIFIMANAGER_STATE_CONNECTING, 0);
+            if(!s_esp32_wifimanager_connecting(wm))
+            {
+                s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED);
+                break;
+            }
+            //CHECK RESULT (AND RETRY IF NEEDED) AFTER BACKOFF DELAY
+            s_esp32_wifimanager_reconnect_schedule(wm, s_esp32_wifimanager_backoff_next_ms(wm));
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_IDLE);
+            break;
+
+        case ESP32_WIFIMANAGER_STATE_CONNECTED:
+            ESP32_WIFIMANAGER_LOGI(STATE, ESP32_WIFIMANAGER_STATE_CONNECTED, 0);
+            s_esp32_wifimanager_connected(wm);
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_IDLE);
+            break;
+
+        case ESP32_WIFIMANAGER_STATE_DISCONNECTED:
+            ESP32_WIFIMANAGER_LOGI(STATE, ESP32_WIFIMANAGER_STATE_DISCONNECTED, 0);
+            s_esp32_wifimanager_disconnected(wm);
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_IDLE);
+            break;
+
+        case ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED:
+            ESP32_WIFIMANAGER_LOGI(STATE, ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED, 0);
+            s_esp32_wifimanager_connection_failed(wm);
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_IDLE);
+            break;
+        
+        case ESP32_WIFIMANAGER_STATE_IDLE:
+            //DO NOTHING
+            break;
+        
+        default:
+            break;
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_GetStats(esp32_wifimanager_t* wm, esp32_wifimanager_stats_t* stats)
+{
+    //GET A COPY OF THE MODULE STATISTICS
+
+    if(stats == NULL)
+    {
+        return;
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - wm->stats_start_us;
+    int64_t power_us = 0;
+    uint8_t i;
+
+    *stats = wm->stats;
+    stats->credential_src = wm->credential_src;
+    stats->log_dropped = ESP32_WIFIMANAGER_LOG_Dropped();
+    stats->state_illegal = __atomic_load_n(&wm->fsm.illegal, __ATOMIC_RELAXED);
+    stats->state_cas_retries = __atomic_load_n(&wm->fsm.cas_retries, __ATOMIC_RELAXED);
+    ESP32_WIFIMANAGER_WEBCONFIG_GetStats(&wm->webconfig, &stats->webconfig);
+    ESP32_WIFIMANAGER_DNS_GetStats(&wm->webconfig.dns, &stats->dns);
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&wm->credlog, &stats->credlog);
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&stats->notify);
+
+    //RADIO ON TIME: DUTY CYCLE MODEL OVER THE TIME AT EACH LEVEL (CURRENT ONE STILL OPEN)
+    if(wm->power_since_us != 0)
+    {
+        stats->power_level_us[wm->power_level] += esp_timer_get_time() - wm->power_since_us;
+    }
+    stats->radio_on_us = 0;
+    for(i = 0; i < ESP32_WIFIMANAGER_POWER_MAX; i++)
+    {
+        power_us += stats->power_level_us[i];
+        stats->radio_on_us += (stats->power_level_us[i] *
+                                ESP32_WIFIMANAGER_POWER_DutyPermille(&wm->power, (esp32_wifimanager_power_policy_t)i)) / 1000;
+    }
+    if(power_us > 0)
+    {
+        stats->radio_duty_permille = (uint16_t)((stats->radio_on_us * 1000) / power_us);
+        stats->power_avg_mw = ESP32_WIFIMANAGER_POWER_AvgMw(stats->radio_duty_permille);
+    }
+    if(wm->stats_start_us != 0 && elapsed_us > 0)
+    {
+        stats->wakeups_per_hour = (uint32_t)(((int64_t)wm->stats.wakeups * 3600000000LL) / elapsed_us);
+        stats->scan_busy_ms_per_min = (uint32_t)(((wm->stats.scan_full_busy_us + wm->stats.scan_channel_busy_us) * 60LL) /
+                                                    elapsed_us);
+    }
+}
+
+void ESP32_WIFIMANAGER_CTX_ResetStats(esp32_wifimanager_t* wm)
+{
+    //CLEAR MODULE STATISTICS
+    //CONNECTION IN PROGRESS (IF ANY) KEEPS ITS START POINT
+
+    //REBASE THE START POINT ON THE CLEARED COUNTERS (UNSIGNED WRAP KEEPS THE DELTA)
+    wm->conn_start_ticks -= wm->stats.mainiter_ticks;
+    wm->conn_start_transitions -= wm->stats.state_transitions;
+
+    memset(&wm->stats, 0, sizeof(wm->stats));
+    __atomic_store_n(&wm->fsm.illegal, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&wm->fsm.cas_retries, 0, __ATOMIC_RELAXED);
+    wm->stats_start_us = esp_timer_get_time();
+    if(wm->power_since_us != 0)
+    {
+        wm->power_since_us = wm->stats_start_us;
+    }
+    ESP32_WIFIMANAGER_LATENCY_Reset(&wm->latency);
+}
+
+void ESP32_WIFIMANAGER_GetLatency(esp32_wifimanager_latency_t* snapshot)
+{
+    //DEFAULT INSTANCE
+
+    ESP32_WIFIMANAGER_CTX_GetLatency(&s_esp32_wifimanager_default, snapshot);
+}
+
+void ESP32_WIFIMANAGER_CTX_GetLatency(esp32_wifimanager_t* wm, esp32_wifimanager_latency_t* snapshot)
+{
+    //GET A CONSISTENT COPY OF THE PHASE TIMESTAMPS AND HISTOGRAMS
+
+    if(snapshot == NULL)
+    {
+        return;
+    }
+    ESP32_WIFIMANAGER_LATENCY_Snapshot(&wm->latency, snapshot);
+}
+
+esp_err_t ESP32_WIFIMANAGER_CTX_Replay(esp32_wifimanager_t* wm,
+                                        const esp32_wifimanager_trace_record_t* records,
+                                        uint32_t count,
+                                        void (*set_time)(int64_t ts_us))
+{
+    //FEED A RECORDED TRACE BACK THROUGH THE STATE MACHINE
+    //RECORDS ARE TAKEN IN GROUPS: AN EVENT FOLLOWED BY THE HARDWARE READS MADE
+    //WHILE HANDLING IT (OR JUST READS, FOR THE STEPS BEFORE THE FIRST EVENT)
+
+    esp32_wifimanager_evt_t evt;
+    uint32_t i = 0;
+    uint32_t last_ts;
+    int64_t now_us;
+    bool has_evt;
+    uint8_t steps;
+
+    if(records == NULL || set_time == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(wm->task != NULL || wm->evt_queue == NULL || !wm->driver_bound)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(count == 0)
+    {
+        return ESP_OK;
+    }
+
+    xQueueReset(wm->evt_queue);
+    wm->replaying = true;
+    last_ts = records[0].ts_us;
+    now_us = last_ts;
+
+    while(i < count)
+    {
+        //TIMESTAMPS ARE 32 BIT. UNWRAP BY ADDING DELTAS
+        now_us += (uint32_t)(records[i].ts_us - last_ts);
+        last_ts = records[i].ts_us;
+        set_time(now_us);
+
+        has_evt = (records[i].kind == ESP32_WIFIMANAGER_TRACE_EVT);
+        if(has_evt)
+        {
+            evt.type = (esp32_wifimanager_evt_type_t)records[i].type;
+            evt.arg = records[i].arg;
+            evt.ts_us = now_us - records[i].lag_us;
+            i++;
+        }
+
+        wm->replay_next = 0;
+        wm->replay_count = 0;
+        while(i < count &&
+                records[i].kind != ESP32_WIFIMANAGER_TRACE_EVT &&
+                wm->replay_count < ESP32_WIFIMANAGER_TRACE_REPLAY_INPUTS)
+        {
+            wm->replay_kind[wm->replay_count] = records[i].kind;
+            wm->replay_value[wm->replay_count] = records[i].arg;
+            wm->replay_count++;
+            i++;
+        }
+
+        if(has_evt)
+        {
+            xQueueSend(wm->evt_queue, &evt, 0);
+            wm->replay_pending = true;
+        }
+        for(steps = 0; steps < ESP32_WIFIMANAGER_TRACE_REPLAY_STEPS; steps++)
+        {
+            ESP32_WIFIMANAGER_CTX_Mainiter(wm);
+            if(!wm->replay_pending && ESP32_WIFIMANAGER_FSM_State(&wm->fsm) == ESP32_WIFIMANAGER_STATE_IDLE)
+            {
+                break;
+            }
+        }
+
+        //RECORDED READS THE STATE MACHINE NEVER ASKED FOR
+        wm->stats.replay_diverged += wm->replay_count - wm->replay_next;
+    }
+
+    wm->replaying = false;
+    wm->replay_pending = false;
+    return ESP_OK;
+}
+
+static void s_esp32_wifimanager_post_evt(esp32_wifimanager_t* wm, esp32_wifimanager_evt_type_t type, uint32_t arg)
+{
+    //QUEUE AN EVENT FOR THE STATE MACHINE (TASK CONTEXT)
+    //WHILE REPLAYING, ONLY THE REPLAY HARNESS FEEDS THE QUEUE
+
+    esp32_wifimanager_evt_t evt = {.type = type, .arg = arg, .ts_us = esp_timer_get_time()};
+
+    if(wm->replaying)
+    {
+        return;
+    }
+    if(wm->evt_queue == NULL ||
+        xQueueSend(wm->evt_queue, &evt, 0) != pdTRUE)
+    {
+        wm->stats.evt_dropped++;
+    }
+}
+
+static void s_esp32_wifimanager_process_evt(esp32_wifimanager_t* wm, const esp32_wifimanager_evt_t* evt)
+{
+    //APPLY A QUEUED EVENT TO THE STATE MACHINE
+
+    int64_t lag_us = esp_timer_get_time() - evt->ts_us;
+
+    if(wm->trace_on)
+    {
+        ESP32_WIFIMANAGER_TRACE_Record(&wm->trace,
+                                        ESP32_WIFIMANAGER_TRACE_EVT,
+                                        (uint8_t)evt->type,
+                                        evt->arg,
+                                        (lag_us > 0xFFFF) ? 0xFFFF : (uint16_t)lag_us);
+    }
+    wm->replay_pending = false;
+
+    switch(evt->type)
+    {
+        case ESP32_WIFIMANAGER_EVT_CONNECT_CHECK:
+            if(ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+            {
+                break;
+            }
+            if(wm->provisioning)
+            {
+                //PROVISIONING WINDOW OVER. GO BACK TO THE STORED NETWORK
+                ESP32_WIFIMANAGER_LOGI(PROVISION_WINDOW, 0, 0);
+                s_esp32_wifimanager_provisioning_stop(wm);
+                ESP32_WIFIMANAGER_FSM_AttemptsReset(&wm->fsm);
+            }
+            wm->stats.reconnect_attempts++;
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTING);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_STA_START:
+            ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_STA_START, evt->ts_us, 0);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_STA_CONNECTED:
+            ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_STA_CONNECTED, evt->ts_us, 0);
+            wm->sta_connected_ts_us = evt->ts_us;
+            s_esp32_wifimanager_fast_connect_save(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_STA_DISCONNECTED:
+            wm->disconnect_reason = (uint8_t)evt->arg;
+            ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_DISCONNECTED,
+                                                evt->ts_us,
+                                                wm->disconnect_reason);
+            if(wm->roam_state == ESP32_WIFIMANAGER_ROAM_STATE_LEAVING)
+            {
+                //OUR OWN DISCONNECT FROM THE OLD BSSID. JOIN THE NEW ONE
+                wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_JOINING;
+                wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+                s_esp32_wifimanager_wifi_connect(wm);
+                break;
+            }
+            if(wm->roam_state == ESP32_WIFIMANAGER_ROAM_STATE_JOINING)
+            {
+                //NEW BSSID DID NOT TAKE US. HANDLE AS A LOST LINK
+                s_esp32_wifimanager_roam_failed(wm);
+            }
+            s_esp32_wifimanager_dhcp_check_abort(wm);
+            if(ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+            {
+                //LINK LOST. START MEASURING RECOVERY
+                wm->link_lost = true;
+                ESP32_WIFIMANAGER_FSM_SetConnected(&wm->fsm, false);
+                wm->stats.disconnections++;
+                wm->stats.link_loss_class[s_esp32_wifimanager_reason_class(wm->disconnect_reason)]++;
+                s_esp32_wifimanager_stats_conn_start(wm);
+                ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->scan_timer);
+                ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->roam_timer);
+                ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->power_timer);
+                s_esp32_wifimanager_health_stop(wm);
+                s_esp32_wifimanager_power_update(wm);
+                wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_IDLE;
+                s_esp32_wifimanager_roam_unpin(wm);
+                s_esp32_wifimanager_scan_abort(wm);
+                wm->disconnect_ts_us = esp_timer_get_time();
+            }
+            else if(wm->hold_active)
+            {
+                if(s_esp32_wifimanager_reason_class(wm->disconnect_reason) == ESP32_WIFIMANAGER_DISCONNECT_AUTH)
+                {
+                    //SILENT RETRY HAD ITS KEY REJECTED. NOT A BLIP AFTER ALL
+                    s_esp32_wifimanager_hold_down_end(wm);
+                }
+                else
+                {
+                    //SILENT RETRY ENDED EARLY (AP NOT BACK YET). GO AGAIN SOON
+                    //RATHER THAN AT THE BACKOFF CHECK, THE HOLD DOWN IS TICKING
+                    wm->stats.fast_retries++;
+                    s_esp32_wifimanager_reconnect_schedule(wm, wm->backoff.fast_retry_ms);
+                }
+            }
+            s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_DISCONNECTED);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_STA_GOT_IP:
+            if(wm->dhcp_check == ESP32_WIFIMANAGER_DHCP_CHECK_UNVERIFIED)
+            {
+                //CACHED LEASE. NOT UP UNTIL THE ARP PROBE PASSES
+                s_esp32_wifimanager_dhcp_probe_start(wm);
+                break;
+            }
+            s_esp32_wifimanager_sta_got_ip(wm, evt->ts_us);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_SCAN_DONE:
+            s_esp32_wifimanager_scan_done(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_SCAN_REFRESH:
+            s_esp32_wifimanager_scan_refresh(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_ROAM_CHECK:
+            s_esp32_wifimanager_roam_check(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_POWER_CHECK:
+            s_esp32_wifimanager_power_check(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_POWER_HINT:
+            wm->power_busy_until_us = (evt->arg == 0) ? 0 : evt->ts_us + (int64_t)evt->arg * 1000;
+            s_esp32_wifimanager_power_update(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_SC_LINK:
+            if(!s_esp32_wifimanager_provisioning_won(wm, ESP32_WIFIMANAGER_PROVISION_WINNER_SMARTCONFIG))
+            {
+                break;
+            }
+            //PORTAL LOST THE RACE. SMARTCONFIG KEEPS RUNNING UNTIL GOT_IP
+            //SO THE PHONE GETS ITS ACKNOWLEDGEMENT
+            if(wm->config_mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG)
+            {
+                ESP32_WIFIMANAGER_WEBCONFIG_Stop(&wm->webconfig);
+            }
+            //NEW NETWORK. FAST CONNECT RECORD DOES NOT APPLY
+            //A LATER LINK MAY BE OVERWRITING sc_config, SO TAKE IT IN WHOLE ONCE
+            wm->fast_connect_active = false;
+            portENTER_CRITICAL(&wm->drv_lock);
+            memcpy(&wm->station_config, &wm->sc_config, sizeof(wifi_config_t));
+            portEXIT_CRITICAL(&wm->drv_lock);
+            if(wm->credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI)
+            {
+                char ssid[ESP32_WIFIMANAGER_SSID_LEN + 1] = {0};
+                char pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN + 1] = {0};
+
+                memcpy(ssid, wm->station_config.sta.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+                memcpy(pwd, wm->station_config.sta.password, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+                ESP32_WIFIMANAGER_CTX_AddCredential(wm, ssid, pwd);
+            }
+            wm->driver->disconnect(wm->driver_ctx);
+            wm->driver->set_config(wm->driver_ctx, ESP_IF_WIFI_STA, &wm->station_config);
+            s_esp32_wifimanager_dhcp_cache_fallback(wm);
+            s_esp32_wifimanager_wifi_connect(wm);
+            //RETRY WITH THE NEW NETWORK IF THIS CONNECT DOES NOT WORK
+            s_esp32_wifimanager_reconnect_schedule(wm, wm->backoff.initial_ms);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_WEB_CREDENTIALS:
+            if(s_esp32_wifimanager_provisioning_won(wm, ESP32_WIFIMANAGER_PROVISION_WINNER_WEBCONFIG))
+            {
+                s_esp32_wifimanager_web_credentials(wm);
+            }
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_SC_LOCKED:
+            wm->sc_locked = true;
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_AP_CLIENT:
+            if(evt->arg != 0)
+            {
+                wm->ap_clients++;
+            }
+            else if(wm->ap_clients > 0)
+            {
+                wm->ap_clients--;
+            }
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_PROVISION_SLICE:
+            s_esp32_wifimanager_provision_slice(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_APSTA_RETRY:
+            s_esp32_wifimanager_apsta_retry(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_HEALTH_CHECK:
+            s_esp32_wifimanager_health_check(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_PMK_DERIVED:
+            s_esp32_wifimanager_pmk_derived(wm);
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_HOLD_DOWN:
+            if(wm->hold_active && !ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+            {
+                wm->stats.hold_down_expired++;
+                s_esp32_wifimanager_hold_down_end(wm);
+            }
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_DHCP_RENEW:
+            //CACHED LEASE HALF WAY THROUGH. HAVE THE SERVER EXTEND IT IN PLACE
+            if(wm->dhcp_cache_active)
+            {
+                s_esp32_wifimanager_dhcp_renew(wm);
+            }
+            break;
+
+        case ESP32_WIFIMANAGER_EVT_DHCP_CHECK:
+            s_esp32_wifimanager_dhcp_check(wm, evt->ts_us);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void s_esp32_wifimanager_sta_got_ip(esp32_wifimanager_t* wm, int64_t ts_us)
+{
+    //LINK UP WITH AN ADDRESS. ts_us = WHEN IT WAS GOT (OR CONFIRMED)
+
+    ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_GOT_IP, ts_us, 0);
+    if(wm->roam_state == ESP32_WIFIMANAGER_ROAM_STATE_JOINING)
+    {
+        //HANDOVER DONE. LINK WAS NEVER REPORTED DOWN
+        s_esp32_wifimanager_dhcp_got_ip(wm);
+        s_esp32_wifimanager_roam_done(wm);
+        return;
+    }
+    ESP32_WIFIMANAGER_FSM_SetConnected(&wm->fsm, true);
+    ESP32_WIFIMANAGER_FSM_AttemptsReset(&wm->fsm);
+    wm->backoff_level = 0;
+    if(wm->hold_active)
+    {
+        //BACK WITHIN THE HOLD DOWN. SUBSCRIBERS NEVER HEAR OF IT
+        ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->hold_timer);
+        wm->hold_active = false;
+        wm->hold_resumed = true;
+        wm->stats.flaps_suppressed++;
+        wm->stats.last_flap_us = ts_us - wm->hold_start_us;
+        if(wm->stats.last_flap_us > wm->stats.max_flap_us)
+        {
+            wm->stats.max_flap_us = wm->stats.last_flap_us;
+        }
+        if(wm->debug_on)
+        {
+            ESP32_WIFIMANAGER_LOGD(FLAP_SUPPRESSED,
+                                    wm->stats.flaps_suppressed,
+                                    (uint32_t)(wm->stats.last_flap_us / 1000));
+        }
+    }
+    if(wm->provisioning &&
+        wm->provision_winner == ESP32_WIFIMANAGER_PROVISION_WINNER_NONE)
+    {
+        //STORED NETWORK CAME BACK BEFORE ANYONE PROVISIONED. PORTAL GOES DOWN
+        wm->stats.apsta_recoveries++;
+        ESP32_WIFIMANAGER_LOGI(APSTA_RECOVERED, wm->apsta_count, 0);
+    }
+    s_esp32_wifimanager_provisioning_stop(wm);
+    s_esp32_wifimanager_multi_got_ip(wm);
+    s_esp32_wifimanager_credlog_got_ip(wm);
+    s_esp32_wifimanager_dhcp_got_ip(wm);
+    s_esp32_wifimanager_stats_got_ip(wm);
+    if(wm->roam_enabled)
+    {
+        wm->roam_rssi_q4 = 0;
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->roam_timer,
+                                            wm->roam.check_ms,
+                                            true);
+    }
+    wm->power_rssi_q4 = 0;
+    if(wm->power_enabled)
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->power_timer,
+                                            wm->power.check_ms,
+                                            true);
+    }
+    s_esp32_wifimanager_power_update(wm);
+    s_esp32_wifimanager_scan_refresh_arm(wm);
+    s_esp32_wifimanager_health_start(wm);
+    s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTED);
+}
+
+static uint32_t s_esp32_wifimanager_input(esp32_wifimanager_t* wm, esp32_wifimanager_trace_kind_t kind, uint32_t value)
+{
+    //HARDWARE READ THE STATE MACHINE DEPENDS ON
+    //RECORDED INTO THE TRACE, OR TAKEN FROM IT WHEN REPLAYING
+
+    if(wm->replaying)
+    {
+        if(wm->replay_next < wm->replay_count && wm->replay_kind[wm->replay_next] == kind)
+        {
+            value = wm->replay_value[wm->replay_next++];
+        }
+        else
+        {
+            wm->stats.replay_diverged++;
+        }
+    }
+    if(wm->trace_on)
+    {
+        ESP32_WIFIMANAGER_TRACE_Record(&wm->trace, kind, 0, value, 0);
+    }
+    return value;
+}
+
+static void s_esp32_wifimanager_task_fn(void* pArg)
+{
+    //MANAGER TASK
+    //RUN STATE MACHINE UNTIL IDLE, THEN SLEEP ON THE EVENT QUEUE
+    //UNTIL AN EVENT ARRIVES OR THE NEXT SOFTWARE TIMER IS DUE
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+    esp32_wifimanager_evt_t evt;
+    uint32_t wait_ms;
+    TickType_t wait_ticks;
+
+    for(;;)
+    {
+        s_esp32_wifimanager_timers_advance(wm);
+
+        while(ESP32_WIFIMANAGER_FSM_State(&wm->fsm) != ESP32_WIFIMANAGER_STATE_IDLE)
+        {
+            s_esp32_wifimanager_run_state(wm);
+        }
+
+        wait_ms = ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&wm->timers);
+        if(wait_ms == ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER)
+        {
+            wait_ticks = portMAX_DELAY;
+        }
+        else
+        {
+            wait_ticks = (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        }
+
+        wm->stats.wakeups++;
+        if(xQueueReceive(wm->evt_queue, &evt, wait_ticks) == pdTRUE)
+        {
+            //MAY HAVE SLEPT PAST DUE TIMERS. FIRE THEM BEFORE THE EVENT RE ARMS ANY
+            s_esp32_wifimanager_timers_advance(wm);
+            s_esp32_wifimanager_process_evt(wm, &evt);
+        }
+    }
+}
+
+static void s_esp32_wifimanager_timers_advance(esp32_wifimanager_t* wm)
+{
+    //FIRE DUE SOFTWARE TIMERS, ACCOUNTING THE TIME SPENT
+
+    int64_t start = esp_timer_get_time();
+    uint32_t fired = ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&wm->timers);
+
+    if(fired != 0)
+    {
+        wm->stats.timer_fires += fired;
+        wm->stats.timer_cpu_us += (uint32_t)(esp_timer_get_time() - start);
+    }
+}
+
+static void s_esp32_wifimanager_set_state(esp32_wifimanager_t* wm, esp32_wifimanager_state_t state)
+{
+    //SET STATE MACHINE STATE
+    //COUNT ACTUAL TRANSITIONS ONLY. ILLEGAL ONES ARE DROPPED (COUNTED IN THE CORE)
+
+    switch(ESP32_WIFIMANAGER_FSM_Transition(&wm->fsm, state))
+    {
+        case ESP32_WIFIMANAGER_FSM_OK:
+            wm->stats.state_transitions++;
+            break;
+
+        case ESP32_WIFIMANAGER_FSM_ILLEGAL:
+            ESP32_WIFIMANAGER_LOGW(STATE_ILLEGAL, ESP32_WIFIMANAGER_FSM_State(&wm->fsm), state);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void s_esp32_wifimanager_notify(esp32_wifimanager_t* wm, esp32_wifimanager_notify_type_t type)
+{
+    //POST EVENT TO SUBSCRIBERS WITH THE CURRENT LINK DETAILS
+
+    esp32_wifimanager_notify_t notify;
+    tcpip_adapter_ip_info_t ip_info;
+    wifi_ap_record_t ap;
+
+    memset(&notify, 0, sizeof(notify));
+    notify.type = type;
+    notify.source = wm;
+
+    if(type == ESP32_WIFIMANAGER_NOTIFY_CONNECTED || type == ESP32_WIFIMANAGER_NOTIFY_ROAMED)
+    {
+        if(wm->driver->get_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, &ip_info) == ESP_OK)
+        {
+            notify.ip = ip_info.ip.addr;
+            notify.netmask = ip_info.netmask.addr;
+            notify.gw = ip_info.gw.addr;
+        }
+        if(wm->driver->sta_get_ap_info(wm->driver_ctx, &ap) == ESP_OK)
+        {
+            memcpy(notify.ssid, ap.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+            memcpy(notify.bssid, ap.bssid, sizeof(notify.bssid));
+            notify.rssi = ap.rssi;
+            notify.channel = ap.primary;
+        }
+    }
+    else
+    {
+        memcpy(notify.ssid, wm->station_config.sta.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+        notify.reason = wm->disconnect_reason;
+    }
+    if(type == ESP32_WIFIMANAGER_NOTIFY_DEGRADED)
+    {
+        notify.health = wm->health_failed;
+    }
+
+    ESP32_WIFIMANAGER_NOTIFY_Post(&notify);
+}
+
+static void s_esp32_wifimanager_user_cb_notify(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //LEGACY USER CB AS A SUBSCRIBER (SOURCE FILTERED TO ITS INSTANCE)
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)arg;
+
+    (*wm->wifi_connected_user_cb)(NULL, notify->type == ESP32_WIFIMANAGER_NOTIFY_CONNECTED);
+}
+
+static void s_esp32_wifimanager_stats_conn_start(esp32_wifimanager_t* wm)
+{
+    //MARK START OF A CONNECTION (BOOT OR LINK LOSS)
+
+    wm->conn_start_ticks = wm->stats.mainiter_ticks;
+    wm->conn_start_transitions = wm->stats.state_transitions;
+    if(wm->init_ts_us == 0)
+    {
+        wm->init_ts_us = esp_timer_get_time();
+        wm->stats_start_us = wm->init_ts_us;
+    }
+}
+
+static void s_esp32_wifimanager_stats_got_ip(esp32_wifimanager_t* wm)
+{
+    //MARK END OF A CONNECTION
+
+    int64_t now = esp_timer_get_time();
+
+    wm->stats.connections++;
+    wm->stats.last_conn_mainiter_ticks = wm->stats.mainiter_ticks - wm->conn_start_ticks;
+    wm->stats.last_conn_state_transitions = wm->stats.state_transitions - wm->conn_start_transitions;
+
+    if(wm->stats.boot_to_got_ip_us == 0)
+    {
+        wm->stats.boot_to_got_ip_us = now - wm->init_ts_us;
+    }
+
+    if(wm->disconnect_ts_us != 0)
+    {
+        wm->stats.last_recovery_us = now - wm->disconnect_ts_us;
+        wm->stats.total_recovery_us += wm->stats.last_recovery_us;
+        wm->stats.recoveries++;
+        if(wm->stats.last_recovery_us > wm->stats.max_recovery_us)
+        {
+            wm->stats.max_recovery_us = wm->stats.last_recovery_us;
+        }
+        wm->disconnect_ts_us = 0;
+    }
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(CONN_DONE,
+                                wm->stats.connections,
+                                (ESP32_WIFIMANAGER_LOG_U16(wm->stats.last_conn_mainiter_ticks) << 16) |
+                                    ESP32_WIFIMANAGER_LOG_U16(wm->stats.last_conn_state_transitions));
+    }
+}
+
+static void s_esp32_wifimanager_wifi_start(esp32_wifimanager_t* wm)
+{
+    //START WIFI DRIVER. ONLY THE FIRST CALL IS A PHASE (LATER ONES ARE NO-OPS)
+
+    if(!wm->wifi_started)
+    {
+        wm->wifi_started = true;
+        ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_WIFI_START, esp_timer_get_time(), 0);
+    }
+    wm->driver->start(wm->driver_ctx);
+}
+
+static void s_esp32_wifimanager_wifi_connect(esp32_wifimanager_t* wm)
+{
+    //START A CONNECT ATTEMPT WITH THE CURRENT STA CONFIG
+
+    wifi_config_t config;
+    uint8_t listen_interval;
+    bool changed = false;
+
+    if(wm->driver->get_config(wm->driver_ctx, WIFI_IF_STA, &config) == ESP_OK)
+    {
+        //MAX SAVE WAKES EVERY LISTEN INTERVAL. THE AP LEARNS IT AT ASSOCIATION
+        listen_interval = ESP32_WIFIMANAGER_POWER_ListenInterval(&wm->power);
+        if(wm->power_enabled && config.sta.listen_interval != listen_interval)
+        {
+            config.sta.listen_interval = listen_interval;
+            changed = true;
+        }
+        //CACHED PMK, SO THE SUPPLICANT SKIPS PBKDF2
+        if(s_esp32_wifimanager_pmk_apply(wm, &config))
+        {
+            changed = true;
+        }
+        //CONNECT TIME CHANGES ONLY GO TO THE DRIVER'S RAM COPY
+        //FLASH KEEPS THE PROVISIONED CONFIG (AND THE PASSPHRASE)
+        if(changed)
+        {
+            wm->driver->set_storage(wm->driver_ctx, WIFI_STORAGE_RAM);
+            wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &config);
+            if(s_esp32_wifimanager_storage_is_flash(wm))
+            {
+                wm->driver->set_storage(wm->driver_ctx, WIFI_STORAGE_FLASH);
+            }
+        }
+    }
+
+    ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_CONNECT, esp_timer_get_time(), 0);
+    wm->driver->connect(wm->driver_ctx);
+}
+
+static bool s_esp32_wifimanager_storage_is_flash(esp32_wifimanager_t* wm)
+{
+    //DRIVER CONFIG STORAGE AS PICKED IN INTIALIZE. HARDCODED KEEPS THE IDF DEFAULT
+
+    switch(wm->credential_src)
+    {
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI:
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM:
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH:
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+static void s_esp32_wifimanager_intialize(esp32_wifimanager_t* wm)
+{
+    //INTIALIZE ESP32 WIFIMANAGER MODULE
+
+    //LOG RECORDS WRITTEN SO FAR ARE WAITING IN THE RING
+    ESP32_WIFIMANAGER_LOG_Start();
+    ESP32_WIFIMANAGER_NOTIFY_Start();
+
+    //SET LED GPIO AS OUTPUT
+    ESP32_GPIO_SetDirection(wm->gpio_led, GPIO_DIRECTION_OUTPUT);
+
+    //SET UP MODULE TIMERS (SOFTWARE TIMER WHEEL)
+    //RECONNECT TIMER IS ONE SHOT, ARMED BY EVERY CONNECT ATTEMPT
+    wm->led_status = true;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->led_timer,
+                                        s_esp32_wifimanager_led_toggle_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->reconnect_timer,
+                                        s_esp32_wifimanager_wifi_connect_check_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->dhcp_renew_timer,
+                                        s_esp32_wifimanager_dhcp_renew_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->dhcp_check_timer,
+                                        s_esp32_wifimanager_dhcp_check_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->slice_timer,
+                                        s_esp32_wifimanager_slice_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->apsta_timer,
+                                        s_esp32_wifimanager_apsta_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->hold_timer,
+                                        s_esp32_wifimanager_hold_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->scan_timer,
+                                        s_esp32_wifimanager_scan_refresh_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->roam_timer,
+                                        s_esp32_wifimanager_roam_timer_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->power_timer,
+                                        s_esp32_wifimanager_power_timer_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&wm->timers, &wm->health_timer,
+                                        s_esp32_wifimanager_health_timer_cb,
+                                        wm);
+    ESP32_WIFIMANAGER_HEALTH_Init(&wm->health_probe);
+    wm->backoff_level = 0;
+
+    //START LED FLASHING TIMER
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->led_timer,
+                                        ESP32_WIFIMANAGER_STATUS_LED_TOGGLE_MS,
+                                        true);
+
+    //INITIALIZE THE RADIO (ONCE PER RADIO). ITS EVENTS ARE ROUTED HERE SINCE SETPARAMETERS
+    wm->driver->init(wm->driver_ctx);
+
+    //RADIO ON FROM HERE. NO MODEM SLEEP UNTIL CONNECTED
+    wm->power_level = ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    wm->power_since_us = esp_timer_get_time();
+    if(wm->power_enabled)
+    {
+        wm->driver->set_ps(wm->driver_ctx, WIFI_PS_NONE);
+    }
+  
+    switch(wm->credential_src)
+    {
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO:
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL:
+            //USED INTERNALLY SAVED WIFI CREDENTIALS
+            //SET AUTOCONNECT STORAGE TO FLASH
+            wm->driver->set_storage(wm->driver_ctx, WIFI_STORAGE_FLASH);
+            //SET WIFI AUTOCONNECT TO TRUE
+            wm->driver->set_auto_connect(wm->driver_ctx, true);
+            wm->driver->get_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED:
+            //USE HARDCODED SUPPLIED WIFI CREDENTIALS
+            //SET WIFI AUTOCONNECT TO FALSE
+            //SSID / PASSWORD LONGER THAN THE DRIVER FIELDS ARE REJECTED, NOT TRUNCATED
+            wm->driver->set_auto_connect(wm->driver_ctx, false);
+            {
+                char ssid[ESP32_WIFIMANAGER_SSID_LEN + 1] = {0};
+                char pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN + 1] = {0};
+
+                if(!ESP32_WIFIMANAGER_PARSER_CopyString(ssid, sizeof(ssid),
+                        wm->ssid_hardcoded_details.ssid_name) ||
+                    !ESP32_WIFIMANAGER_PARSER_CopyString(pwd, sizeof(pwd),
+                        wm->ssid_hardcoded_details.ssid_pwd))
+                {
+                    ESP32_WIFIMANAGER_LOGE(HARDCODED_TOO_LONG, 0, 0);
+                    memset(ssid, 0, sizeof(ssid));
+                    memset(pwd, 0, sizeof(pwd));
+                }
+                memcpy(wm->station_config.sta.ssid, ssid, ESP32_WIFIMANAGER_SSID_LEN);
+                memcpy(wm->station_config.sta.password, pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+            }
+            wm->station_config.sta.bssid_set = false;
+            break;
+        
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI:
+            //NETWORK IS PICKED PER ATTEMPT FROM SCAN RESULTS
+            wm->driver->set_storage(wm->driver_ctx, WIFI_STORAGE_RAM);
+            wm->driver->set_auto_connect(wm->driver_ctx, false);
+            s_esp32_wifimanager_cred_load(wm);
+            wm->candidate_count = 0;
+            wm->candidate_next = 0;
+            wm->candidate_current = -1;
+            wm->multi_scan_pending = false;
+            return;
+            break;
+
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM:
+        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH:
+            //LATEST RECORD FROM THE CREDENTIAL LOG
+            wm->driver->set_storage(wm->driver_ctx, WIFI_STORAGE_RAM);
+            wm->driver->set_auto_connect(wm->driver_ctx, false);
+            if(!s_esp32_wifimanager_credlog_load(wm))
+            {
+                return;
+            }
+            break;
+        
+        default:
+            return;
+            break;
+    }
+
+    //USE LAST KNOWN BSSID/CHANNEL IF IT IS FOR THIS SSID
+    s_esp32_wifimanager_fast_connect_apply(wm);
+
+    //SET CONFIGURATION
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, (wifi_config_t*)&wm->station_config);
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(INITIALIZED,
+                                wm->credential_src | (wm->config_mode << 8),
+                                wm->gpio_led);
+    }
+}
+
+static bool s_esp32_wifimanager_connecting(esp32_wifimanager_t* wm)
+{
+    //CONNECT TO WIFI
+
+    //CHECK FOR TRIGGER
+    //IF TRIGGER = GPIO DO CHECK RIGHT NOW
+    //IF TRIGGER = NOCONNECTION, LET IT PROCEED TO CONNECT TO WIFI
+    if(wm->credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO)
+    {
+        //CHECK IF GPIO ACTIVATED
+        ESP32_WIFIMANAGER_LOGI(GPIO_CHECK, 0, 0);
+        uint8_t retval = 0xFF;
+        ESP32_GPIO_GetValue(wm->gpio_trigger_pin, &retval);
+        retval = (uint8_t)s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_GPIO, retval);
+        if(retval == wm->gpio_trigger_type)
+        {
+            //START CONFIGURATION PROCESS
+            //RETURN FALSE TO GO INTO FAILED STATE AND START CONFIGURATION
+            //MANUALLY START WIFI AS WIFI IS NOT STARTED YET 
+            //AND SMARTCONFIG NEEDS IT TO BE STARTED
+            ESP32_WIFIMANAGER_LOGI(GPIO_TRIGGERED, 0, 0);
+            s_esp32_wifimanager_wifi_start(wm);
+            return false;
+        }
+    }
+
+    if(wm->credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI)
+    {
+        return s_esp32_wifimanager_multi_connecting(wm);
+    }
+
+    //CHECK FOR CONNECTION ATTEMPTS
+    if(ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm) >= ESP32_WIFIMANAGER_WIFI_RETRY_COUNT)
+    {
+        //MAX ATTEMPT REACHED
+        ESP32_WIFIMANAGER_LOGW(MAX_ATTEMPTS, 0, 0);
+        return false;
+    }
+
+    ESP32_WIFIMANAGER_LOGI(CONNECT_ATTEMPT, ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm), 0);
+
+    //FAST CONNECT AND CACHED LEASE GET ONE ATTEMPT
+    //AFTER THAT DO A FULL SCAN AND A FULL DHCP
+    if(ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm) > 0)
+    {
+        s_esp32_wifimanager_fast_connect_fallback(wm);
+        s_esp32_wifimanager_dhcp_cache_fallback(wm);
+    }
+    else
+    {
+        s_esp32_wifimanager_dhcp_cache_apply(wm);
+    }
+    if(wm->fast_connect_active)
+    {
+        wm->stats.scan_skipped++;
+    }
+    else
+    {
+        wm->stats.scan_needed++;
+    }
+    ESP32_WIFIMANAGER_FSM_AttemptsInc(&wm->fsm);
+
+    //START WIFI
+    s_esp32_wifimanager_wifi_start(wm);
+
+    //CONNECT TO WIFI
+    s_esp32_wifimanager_wifi_connect(wm);
+
+    return true;
+}
+
+static void s_esp32_wifimanager_connected(esp32_wifimanager_t* wm)
+{
+    //WIFI CONNECTION OK
+
+    //STOP ALL TIMERS
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->led_timer);
+    s_esp32_wifimanager_reconnect_cancel(wm);
+    //TURN LED ON
+    ESP32_GPIO_SetValue(wm->gpio_led, true);
+    //NOTIFY SUBSCRIBERS, UNLESS THE DROP WAS NEVER REPORTED
+    if(wm->hold_resumed)
+    {
+        wm->hold_resumed = false;
+        return;
+    }
+    s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_CONNECTED);
+}
+
+static void s_esp32_wifimanager_disconnected(esp32_wifimanager_t* wm)
+{
+    //WIFI DISCONNECTED
+    //FAILED ATTEMPTS ARE RETRIED BY THE ALREADY ARMED RECONNECT TIMER
+    //A LOST LINK STARTS A NEW ROUND OF RETRIES
+
+    if(!wm->link_lost)
+    {
+        return;
+    }
+    wm->link_lost = false;
+    ESP32_WIFIMANAGER_FSM_AttemptsReset(&wm->fsm);
+
+    //BLINK LED WHILE RECONNECTING
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->led_timer,
+                                        ESP32_WIFIMANAGER_STATUS_LED_TOGGLE_MS,
+                                        true);
+
+    if(s_esp32_wifimanager_reason_class(wm->disconnect_reason) == ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT)
+    {
+        //NOTIFY SUBSCRIBERS ONLY IF NOT BACK WITHIN THE HOLD DOWN
+        if(wm->backoff.hold_down_ms != 0)
+        {
+            wm->hold_active = true;
+            wm->hold_start_us = wm->disconnect_ts_us;
+            ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->hold_timer,
+                                                wm->backoff.hold_down_ms,
+                                                false);
+        }
+        else
+        {
+            s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED);
+        }
+        wm->stats.fast_retries++;
+        s_esp32_wifimanager_reconnect_schedule(wm, wm->backoff.fast_retry_ms);
+    }
+    else
+    {
+        //NOTIFY SUBSCRIBERS
+        s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED);
+        s_esp32_wifimanager_reconnect_schedule(wm, s_esp32_wifimanager_backoff_next_ms(wm));
+    }
+}
+
+static void s_esp32_wifimanager_connection_failed(esp32_wifimanager_t* wm)
+{
+    //WIFI CONNECTION FAILED
+
+    //STOP ALL TIMERS
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->led_timer);
+    s_esp32_wifimanager_reconnect_cancel(wm);
+    
+    //TURN LED OFF
+    ESP32_GPIO_SetValue(wm->gpio_led, false);
+    
+    //NOTIFY SUBSCRIBERS. A HIDDEN DROP IS REPORTED FIRST
+    s_esp32_wifimanager_hold_down_end(wm);
+    s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_CONNECTION_FAILED);
+
+    //START CONFIGURATION PROCES
+    //IF A WINDOW IS SET, GO BACK TO RETRYING THE STORED NETWORK AFTER IT
+    if(wm->backoff.provision_window_ms != 0)
+    {
+        s_esp32_wifimanager_reconnect_schedule(wm, wm->backoff.provision_window_ms);
+    }
+
+    s_esp32_wifimanager_provisioning_start(wm);
+}
+
+static void s_esp32_wifimanager_fast_connect_apply(esp32_wifimanager_t* wm)
+{
+    //LOAD FAST CONNECT RECORD FROM NVS AND APPLY IT TO THE STATION CONFIG
+    //IF IT WAS SAVED FOR THE SAME SSID
+
+    nvs_handle handle;
+    size_t len = sizeof(esp32_wifimanager_fast_connect_t);
+
+    wm->fast_connect_active = false;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if(nvs_get_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_FAST_CONNECT,
+                    &wm->fast_connect, &len) != ESP_OK ||
+        len != sizeof(esp32_wifimanager_fast_connect_t))
+    {
+        memset(&wm->fast_connect, 0, sizeof(esp32_wifimanager_fast_connect_t));
+        nvs_close(handle);
+        return;
+    }
+    nvs_close(handle);
+
+    if(wm->fast_connect.channel == 0 ||
+        strncmp((char*)wm->fast_connect.ssid,
+                (char*)wm->station_config.sta.ssid,
+                ESP32_WIFIMANAGER_SSID_LEN) != 0)
+    {
+        return;
+    }
+
+    wm->station_config.sta.bssid_set = true;
+    memcpy(wm->station_config.sta.bssid, wm->fast_connect.bssid, 6);
+    wm->station_config.sta.channel = wm->fast_connect.channel;
+    wm->station_config.sta.scan_method = WIFI_FAST_SCAN;
+    wm->fast_connect_active = true;
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(FAST_CONNECT, wm->fast_connect.channel, 0);
+    }
+}
+
+static void s_esp32_wifimanager_fast_connect_fallback(esp32_wifimanager_t* wm)
+{
+    //FAST CONNECT FAILED. GO BACK TO A FULL ALL CHANNEL SCAN
+
+    if(!wm->fast_connect_active)
+    {
+        return;
+    }
+
+    wm->fast_connect_active = false;
+    wm->station_config.sta.bssid_set = false;
+    wm->station_config.sta.channel = 0;
+    wm->station_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(FAST_CONNECT_FAILED, 0, 0);
+    }
+}
+
+static void s_esp32_wifimanager_fast_connect_save(esp32_wifimanager_t* wm)
+{
+    //SAVE AP DETAILS OF A SUCCESSFUL CONNECT
+    //ONLY WRITE NVS IF SOMETHING CHANGED
+
+    esp32_wifimanager_fast_connect_t ap;
+    nvs_handle handle;
+
+    portENTER_CRITICAL(&wm->drv_lock);
+    memcpy(&ap, &wm->fast_connect_pending, sizeof(esp32_wifimanager_fast_connect_t));
+    portEXIT_CRITICAL(&wm->drv_lock);
+
+    if(memcmp(&wm->fast_connect, &ap, sizeof(esp32_wifimanager_fast_connect_t)) == 0)
+    {
+        return;
+    }
+
+    if(nvs_open(wm->nvs_namespace, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if(nvs_set_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_FAST_CONNECT,
+                    &ap,
+                    sizeof(esp32_wifimanager_fast_connect_t)) == ESP_OK &&
+        nvs_commit(handle) == ESP_OK)
+    {
+        memcpy(&wm->fast_connect, &ap, sizeof(esp32_wifimanager_fast_connect_t));
+    }
+    nvs_close(handle);
+}
+
+static bool s_esp32_wifimanager_dhcp_lease_usable(esp32_wifimanager_t* wm)
+{
+    //CHECK CACHED LEASE IS FOR THE CONFIGURED SSID AND NOT EXPIRED
+    //EXPIRY IS CHECKED AGAINST THE WALL CLOCK IF SET, ELSE AGAINST
+    //UPTIME (LEASE MUST THEN HAVE BEEN OBTAINED IN THIS BOOT)
+
+    nvs_handle handle;
+    size_t len = sizeof(esp32_wifimanager_dhcp_lease_t);
+    time_t now_epoch = time(NULL);
+
+    if(!wm->dhcp_lease_loaded)
+    {
+        wm->dhcp_lease_loaded = true;
+        if(nvs_open(wm->nvs_namespace, NVS_READONLY, &handle) == ESP_OK)
+        {
+            if(nvs_get_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_DHCP_LEASE,
+                            &wm->dhcp_lease, &len) != ESP_OK ||
+                len != sizeof(esp32_wifimanager_dhcp_lease_t))
+            {
+                memset(&wm->dhcp_lease, 0, sizeof(esp32_wifimanager_dhcp_lease_t));
+            }
+            nvs_close(handle);
+        }
+    }
+
+    if(wm->dhcp_lease.ip == 0 ||
+        wm->dhcp_lease.lease_s < ESP32_WIFIMANAGER_DHCP_CACHE_MIN_LEASE_S ||
+        strncmp((char*)wm->dhcp_lease.ssid,
+                (char*)wm->station_config.sta.ssid,
+                ESP32_WIFIMANAGER_SSID_LEN) != 0)
+    {
+        return false;
+    }
+
+    if(wm->dhcp_lease_obtained_us != 0)
+    {
+        return ((esp_timer_get_time() - wm->dhcp_lease_obtained_us) / 1000000) <
+                    (int64_t)wm->dhcp_lease.lease_s;
+    }
+
+    if(now_epoch >= ESP32_WIFIMANAGER_VALID_EPOCH && wm->dhcp_lease.obtained_epoch != 0)
+    {
+        return (int64_t)now_epoch < wm->dhcp_lease.obtained_epoch +
+                                        (int64_t)wm->dhcp_lease.lease_s;
+    }
+
+    return false;
+}
+
+static void s_esp32_wifimanager_dhcp_cache_apply(esp32_wifimanager_t* wm)
+{
+    //USE CACHED LEASE AS STATIC CONFIGURATION FOR THE NEXT CONNECT
+
+    if(wm->dhcp_cache_mode != ESP32_WIFIMANAGER_DHCP_CACHE_STATIC ||
+        wm->dhcp_cache_active)
+    {
+        return;
+    }
+
+    if(!s_esp32_wifimanager_dhcp_lease_usable(wm) || !s_esp32_wifimanager_dhcp_static_apply(wm))
+    {
+        wm->stats.dhcp_cache_misses++;
+        return;
+    }
+    wm->stats.dhcp_cache_hits++;
+    wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_UNVERIFIED;
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(DHCP_CACHE_USED, 0, 0);
+    }
+}
+
+static bool s_esp32_wifimanager_dhcp_static_apply(esp32_wifimanager_t* wm)
+{
+    //CONFIGURE LEASE IN RAM AS STATIC IP AND STOP THE DHCP CLIENT
+    //RENEW IS SCHEDULED ON GOT_IP
+
+    tcpip_adapter_ip_info_t ip_info;
+    tcpip_adapter_dns_info_t dns_info;
+
+    ip_info.ip.addr = wm->dhcp_lease.ip;
+    ip_info.netmask.addr = wm->dhcp_lease.netmask;
+    ip_info.gw.addr = wm->dhcp_lease.gw;
+
+    wm->driver->dhcpc_stop(wm->driver_ctx, TCPIP_ADAPTER_IF_STA);
+    if(wm->driver->set_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, &ip_info) != ESP_OK)
+    {
+        wm->driver->dhcpc_start(wm->driver_ctx, TCPIP_ADAPTER_IF_STA);
+        return false;
+    }
+    if(wm->dhcp_lease.dns != 0)
+    {
+        memset(&dns_info, 0, sizeof(dns_info));
+        dns_info.ip.u_addr.ip4.addr = wm->dhcp_lease.dns;
+        wm->driver->set_dns_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, TCPIP_ADAPTER_DNS_MAIN, &dns_info);
+    }
+
+    wm->dhcp_cache_active = true;
+    return true;
+}
+
+static void s_esp32_wifimanager_dhcp_cache_fallback(esp32_wifimanager_t* wm)
+{
+    //STOP USING CACHED LEASE. RESTART DHCP CLIENT
+
+    if(!wm->dhcp_cache_active)
+    {
+        return;
+    }
+
+    wm->dhcp_cache_active = false;
+    wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_NONE;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->dhcp_renew_timer);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->dhcp_check_timer);
+    wm->driver->dhcpc_start(wm->driver_ctx, TCPIP_ADAPTER_IF_STA);
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(DHCP_RESTARTED, 0, 0);
+    }
+}
+
+static void s_esp32_wifimanager_dhcp_got_ip(esp32_wifimanager_t* wm)
+{
+    //RECORD DHCP LATENCY. SAVE NEW LEASE OR SCHEDULE RENEW OF CACHED ONE
+
+    int64_t now = esp_timer_get_time();
+    int64_t remaining_s;
+    time_t now_epoch = time(NULL);
+
+    if(wm->sta_connected_ts_us != 0)
+    {
+        wm->stats.last_dhcp_us = now - wm->sta_connected_ts_us;
+        wm->stats.total_dhcp_us += wm->stats.last_dhcp_us;
+        wm->stats.dhcp_count++;
+        wm->sta_connected_ts_us = 0;
+    }
+
+    if(wm->dhcp_cache_active)
+    {
+        //STATIC FROM CACHE OR HELD OVER A ROAM
+        //RENEW AT HALF THE REMAINING LEASE TIME
+        if(wm->dhcp_lease_obtained_us != 0)
+        {
+            remaining_s = (int64_t)wm->dhcp_lease.lease_s -
+                            (now - wm->dhcp_lease_obtained_us) / 1000000;
+        }
+        else
+        {
+            remaining_s = wm->dhcp_lease.obtained_epoch +
+                            (int64_t)wm->dhcp_lease.lease_s - (int64_t)now_epoch;
+        }
+        if(remaining_s < 2)
+        {
+            remaining_s = 2;
+        }
+        if(remaining_s > 2 * (INT32_MAX / 1000))
+        {
+            remaining_s = 2 * (INT32_MAX / 1000);
+        }
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->dhcp_renew_timer,
+                                            (uint32_t)(remaining_s / 2) * 1000,
+                                            false);
+        return;
+    }
+
+    s_esp32_wifimanager_dhcp_lease_save(wm);
+}
+
+static void s_esp32_wifimanager_dhcp_lease_save(esp32_wifimanager_t* wm)
+{
+    //FRESH LEASE FROM DHCP SERVER. KEPT IN RAM IN EVERY MODE (ROAMING HOLDS IT)
+    //AND IN NVS WHEN CACHING
+
+    nvs_handle handle;
+    uint32_t lease_s;
+    tcpip_adapter_ip_info_t ip_info;
+    tcpip_adapter_dns_info_t dns_info;
+    esp32_wifimanager_dhcp_lease_t lease;
+    time_t now_epoch = time(NULL);
+
+    memset(&lease, 0, sizeof(lease));
+    memcpy(lease.ssid, wm->station_config.sta.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+    if(wm->driver->get_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, &ip_info) != ESP_OK)
+    {
+        return;
+    }
+    lease.ip = ip_info.ip.addr;
+    lease.netmask = ip_info.netmask.addr;
+    lease.gw = ip_info.gw.addr;
+    if(wm->driver->get_dns_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, TCPIP_ADAPTER_DNS_MAIN, &dns_info) == ESP_OK)
+    {
+        lease.dns = dns_info.ip.u_addr.ip4.addr;
+    }
+    lease.lease_s = ESP32_WIFIMANAGER_DHCP_CACHE_DEFAULT_LEASE_S;
+    lease_s = wm->driver->dhcp_lease_s(wm->driver_ctx, TCPIP_ADAPTER_IF_STA);
+    if(lease_s != 0)
+    {
+        lease.lease_s = lease_s;
+    }
+    if(now_epoch >= ESP32_WIFIMANAGER_VALID_EPOCH)
+    {
+        lease.obtained_epoch = (int64_t)now_epoch;
+    }
+
+    wm->dhcp_lease_obtained_us = esp_timer_get_time();
+    wm->dhcp_lease_loaded = true;
+    memcpy(&wm->dhcp_lease, &lease, sizeof(lease));
+
+    if(wm->dhcp_cache_mode != ESP32_WIFIMANAGER_DHCP_CACHE_STATIC)
+    {
+        return;
+    }
+    if(nvs_open(wm->nvs_namespace, NVS_READWRITE, &handle) == ESP_OK)
+    {
+        if(nvs_set_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_DHCP_LEASE, &lease, sizeof(lease)) == ESP_OK)
+        {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+}
+
+static void s_esp32_wifimanager_dhcp_renew_cb(void* pArg)
+{
+    //CACHED LEASE RENEW TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_DHCP_RENEW, 0);
+}
+
+static void s_esp32_wifimanager_dhcp_check_cb(void* pArg)
+{
+    //CACHED LEASE PROBE / RENEW WAIT TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_DHCP_CHECK, 0);
+}
+
+static void s_esp32_wifimanager_dhcp_probe_start(esp32_wifimanager_t* wm)
+{
+    //CACHED LEASE IS UP AS STATIC IP. BEFORE REPORTING IT, CHECK THE GATEWAY
+    //STILL ANSWERS AND NOBODY TOOK OUR ADDRESS WHILE WE WERE AWAY
+    //ANSWERS ARE READ BACK AT EVT_DHCP_CHECK
+
+    wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_PROBING;
+    wm->driver->arp_probe(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, wm->dhcp_lease.gw);
+    wm->driver->arp_probe(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, wm->dhcp_lease.ip);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->dhcp_check_timer,
+                                        ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS,
+                                        false);
+}
+
+static void s_esp32_wifimanager_dhcp_renew(esp32_wifimanager_t* wm)
+{
+    //INIT-REBOOT THE CACHED ADDRESS. IT STAYS UP WHILE THE SERVER ANSWERS
+    //ONLY A NAK OR NO ANSWER ENDS IN A FULL DISCOVER
+
+    if(wm->driver->dhcp_renew(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, wm->dhcp_lease.ip) != ESP_OK)
+    {
+        wm->stats.dhcp_renew_failed++;
+        s_esp32_wifimanager_dhcp_cache_fallback(wm);
+        return;
+    }
+    wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_RENEWING;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->dhcp_check_timer,
+                                        ESP32_WIFIMANAGER_DHCP_RENEW_WAIT_MS,
+                                        false);
+}
+
+static void s_esp32_wifimanager_dhcp_check(esp32_wifimanager_t* wm, int64_t ts_us)
+{
+    //ARP PROBE WINDOW OR INIT-REBOOT WAIT OVER
+
+    tcpip_adapter_ip_info_t ip_info;
+    uint32_t arp;
+
+    if(wm->dhcp_check == ESP32_WIFIMANAGER_DHCP_CHECK_PROBING)
+    {
+        //BIT 0 = GATEWAY ANSWERED, BIT 1 = ANOTHER HOST HAS OUR ADDRESS
+        arp = (wm->driver->arp_lookup(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, wm->dhcp_lease.gw) ? 0x01 : 0) |
+                (wm->driver->arp_lookup(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, wm->dhcp_lease.ip) ? 0x02 : 0);
+        arp = s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_ARP, arp);
+        if(arp == 0x01)
+        {
+            wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_NONE;
+            s_esp32_wifimanager_sta_got_ip(wm, ts_us);
+            return;
+        }
+
+        //WRONG NETWORK OR ADDRESS REUSED. FORGET THE LEASE, IT WOULD FAIL
+        //THE SAME WAY NEXT TIME, AND GET A NEW ONE
+        wm->stats.dhcp_cache_rejected++;
+        ESP32_WIFIMANAGER_LOGW(DHCP_CACHE_REJECTED, wm->dhcp_lease.ip, arp);
+        wm->dhcp_lease.ip = 0;
+        s_esp32_wifimanager_dhcp_cache_fallback(wm);
+        return;
+    }
+
+    if(wm->dhcp_check != ESP32_WIFIMANAGER_DHCP_CHECK_RENEWING)
+    {
+        return;
+    }
+    wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_NONE;
+    if(wm->driver->dhcp_lease_s(wm->driver_ctx, TCPIP_ADAPTER_IF_STA) != 0 &&
+        wm->driver->get_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, &ip_info) == ESP_OK &&
+        ip_info.ip.addr == wm->dhcp_lease.ip)
+    {
+        //ACKED. THE CLIENT OWNS THE LEASE AND RENEWS IT FROM HERE ON
+        wm->dhcp_cache_active = false;
+        wm->stats.dhcp_renewed++;
+        s_esp32_wifimanager_dhcp_lease_save(wm);
+        if(wm->debug_on)
+        {
+            ESP32_WIFIMANAGER_LOGD(DHCP_RENEWED, wm->dhcp_lease.ip, 0);
+        }
+        return;
+    }
+    wm->stats.dhcp_renew_failed++;
+    s_esp32_wifimanager_dhcp_cache_fallback(wm);
+}
+
+static void s_esp32_wifimanager_dhcp_check_abort(esp32_wifimanager_t* wm)
+{
+    //LINK LOST MID CHECK. THE PROBE IS REDONE ON THE NEXT GOT_IP
+    //A RENEW ALREADY STARTED THE CLIENT, SO LEAVE THE LEASE TO IT
+
+    if(wm->dhcp_check == ESP32_WIFIMANAGER_DHCP_CHECK_PROBING)
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->dhcp_check_timer);
+        wm->dhcp_check = ESP32_WIFIMANAGER_DHCP_CHECK_UNVERIFIED;
+    }
+    else if(wm->dhcp_check == ESP32_WIFIMANAGER_DHCP_CHECK_RENEWING)
+    {
+        s_esp32_wifimanager_dhcp_cache_fallback(wm);
+    }
+}
+
+static void s_esp32_wifimanager_roam_timer_cb(void* pArg)
+{
+    //ROAM RSSI CHECK TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_ROAM_CHECK, 0);
+}
+
+static void s_esp32_wifimanager_power_timer_cb(void* pArg)
+{
+    //POWER POLICY CHECK TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_POWER_CHECK, 0);
+}
+
+static void s_esp32_wifimanager_health_timer_cb(void* pArg)
+{
+    //HEALTH PROBE TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_HEALTH_CHECK, 0);
+}
+
+static void s_esp32_wifimanager_scan_refresh_cb(void* pArg)
+{
+    //BACKGROUND SCAN TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_SCAN_REFRESH, 0);
+}
+
+static void s_esp32_wifimanager_slice_cb(void* pArg)
+{
+    //PROVISIONING SLICE TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_PROVISION_SLICE, 0);
+}
+
+static void s_esp32_wifimanager_apsta_cb(void* pArg)
+{
+    //APSTA RETRY TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_APSTA_RETRY, 0);
+}
+
+static void s_esp32_wifimanager_hold_cb(void* pArg)
+{
+    //FLAP HOLD DOWN TIMER CB
+
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_HOLD_DOWN, 0);
+}
+
+static uint32_t s_esp32_wifimanager_ssid_hash(const uint8_t* ssid)
+{
+    //FNV-1A HASH OF A (POSSIBLY NOT NULL TERMINATED) SSID
+
+    uint32_t hash = 2166136261UL;
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_SSID_LEN && ssid[i] != 0; i++)
+    {
+        hash ^= ssid[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static void s_esp32_wifimanager_cred_load(esp32_wifimanager_t* wm)
+{
+    //LOAD CREDENTIAL TABLE FROM NVS (ONCE)
+
+    nvs_handle handle;
+    size_t len = sizeof(wm->cred_table);
+
+    if(wm->cred_loaded)
+    {
+        return;
+    }
+    wm->cred_loaded = true;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READONLY, &handle) == ESP_OK)
+    {
+        if(nvs_get_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_CREDENTIALS,
+                        wm->cred_table, &len) != ESP_OK ||
+            len != sizeof(wm->cred_table))
+        {
+            memset(wm->cred_table, 0, sizeof(wm->cred_table));
+        }
+        nvs_close(handle);
+    }
+    s_esp32_wifimanager_cred_reindex(wm);
+}
+
+static void s_esp32_wifimanager_cred_save(esp32_wifimanager_t* wm)
+{
+    //SAVE CREDENTIAL TABLE TO NVS
+
+    nvs_handle handle;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if(nvs_set_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_CREDENTIALS,
+                    wm->cred_table, sizeof(wm->cred_table)) == ESP_OK)
+    {
+        nvs_commit(handle);
+        wm->cred_dirty = false;
+    }
+    nvs_close(handle);
+}
+
+static bool s_esp32_wifimanager_cred_pwd_valid(const char* pwd)
+{
+    //PASSPHRASE SHORTER THAN THE FIELD, OR EXACTLY 64 HEX DIGITS (RAW PSK)
+
+    size_t len = strnlen(pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN + 1);
+    size_t i;
+
+    if(len < ESP32_WIFIMANAGER_SSID_PWD_LEN)
+    {
+        return true;
+    }
+    if(len > ESP32_WIFIMANAGER_SSID_PWD_LEN)
+    {
+        return false;
+    }
+    for(i = 0; i < len; i++)
+    {
+        if(!isxdigit((unsigned char)pwd[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool s_esp32_wifimanager_pmk_apply(esp32_wifimanager_t* wm, wifi_config_t* config)
+{
+    //SWAP THE PASSPHRASE IN A DRIVER STA CONFIG FOR ITS PMK (64 HEX DIGITS)
+    //ON A MISS CONNECT WITH THE PASSPHRASE AND DERIVE THE PMK IN THE BACKGROUND
+    //THE MANAGER'S OWN COPY OF THE CONFIG KEEPS THE PASSPHRASE
+
+    uint8_t tag[ESP32_WIFIMANAGER_PMK_TAG_LEN];
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    size_t ssid_len = strnlen((char*)config->sta.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+    size_t pwd_len = strnlen((char*)config->sta.password, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+
+    if(!wm->pmk_on || ssid_len == 0 ||
+        !ESP32_WIFIMANAGER_PMK_IsPassphrase(config->sta.password, ESP32_WIFIMANAGER_SSID_PWD_LEN) ||
+        !s_esp32_wifimanager_pmk_psk_ap(wm, config))
+    {
+        return false;
+    }
+
+    s_esp32_wifimanager_pmk_load(wm);
+    s_esp32_wifimanager_pmk_derived(wm);
+    ESP32_WIFIMANAGER_PMK_Tag(config->sta.ssid, ssid_len, config->sta.password, pwd_len, tag);
+    if(!ESP32_WIFIMANAGER_PMK_Lookup(&wm->pmk_cache, tag, pmk))
+    {
+        if(!wm->pmk_job &&
+            ESP32_WIFIMANAGER_PMK_DeriveStart(&wm->pmk_derive, config->sta.ssid, ssid_len,
+                                                config->sta.password, pwd_len,
+                                                s_esp32_wifimanager_pmk_done_cb, wm) == ESP_OK)
+        {
+            wm->pmk_job = true;
+            memcpy(wm->pmk_job_tag, tag, ESP32_WIFIMANAGER_PMK_TAG_LEN);
+            wm->pmk_job_ssid_hash = s_esp32_wifimanager_ssid_hash(config->sta.ssid);
+        }
+        return false;
+    }
+
+    wm->stats.pmk_hits++;
+    ESP32_WIFIMANAGER_PMK_ToHex(pmk, config->sta.password);
+    memset(pmk, 0, sizeof(pmk));
+    return true;
+}
+
+static bool s_esp32_wifimanager_pmk_psk_ap(esp32_wifimanager_t* wm, const wifi_config_t* config)
+{
+    //TRUE IF THE TARGET AP WAS SEEN WITH WPA / WPA2-PSK (SCAN CACHE OR LAST CONNECTION)
+    //UNKNOWN, OPEN, WEP AND ENTERPRISE KEEP THE CONFIG AS IS
+
+    const esp32_wifimanager_scan_entry_t* aps[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    const esp32_wifimanager_scan_entry_t* entry = NULL;
+    uint8_t authmode = WIFI_AUTH_MAX;
+    uint8_t count;
+    uint8_t i;
+
+    if(config->sta.bssid_set)
+    {
+        entry = ESP32_WIFIMANAGER_SCANCACHE_Find(&wm->scan_cache, config->sta.bssid);
+    }
+    else
+    {
+        count = ESP32_WIFIMANAGER_SCANCACHE_Sorted(&wm->scan_cache, aps, ESP32_WIFIMANAGER_SCAN_CACHE_SIZE);
+        for(i = 0; i < count && entry == NULL; i++)
+        {
+            if(strncmp((char*)aps[i]->ssid, (char*)config->sta.ssid, ESP32_WIFIMANAGER_SSID_LEN) == 0)
+            {
+                entry = aps[i];
+            }
+        }
+    }
+    if(entry != NULL &&
+        strncmp((char*)entry->ssid, (char*)config->sta.ssid, ESP32_WIFIMANAGER_SSID_LEN) == 0)
+    {
+        authmode = entry->authmode;
+    }
+    else if(wm->fast_connect.channel != 0 &&
+        strncmp((char*)wm->fast_connect.ssid, (char*)config->sta.ssid, ESP32_WIFIMANAGER_SSID_LEN) == 0)
+    {
+        authmode = wm->fast_connect.authmode;
+    }
+
+    return (authmode == WIFI_AUTH_WPA_PSK ||
+            authmode == WIFI_AUTH_WPA2_PSK ||
+            authmode == WIFI_AUTH_WPA_WPA2_PSK);
+}
+
+static void s_esp32_wifimanager_pmk_derived(esp32_wifimanager_t* wm)
+{
+    //CACHE (AND SAVE) THE KEY OF A FINISHED BACKGROUND JOB
+    //THE NEXT CONNECT TO THAT SSID USES IT
+
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    int64_t derive_us;
+    esp_err_t err;
+
+    if(!wm->pmk_job)
+    {
+        return;
+    }
+    err = ESP32_WIFIMANAGER_PMK_DeriveTake(&wm->pmk_derive, pmk, &derive_us);
+    if(err == ESP_ERR_INVALID_STATE)
+    {
+        return;
+    }
+    wm->pmk_job = false;
+    if(err == ESP_OK)
+    {
+        wm->stats.pmk_derived++;
+        wm->stats.pmk_derive_us += derive_us;
+        s_esp32_wifimanager_pmk_load(wm);
+        ESP32_WIFIMANAGER_PMK_Insert(&wm->pmk_cache, wm->pmk_job_tag, wm->pmk_job_ssid_hash, pmk);
+        s_esp32_wifimanager_pmk_save(wm);
+        memset(pmk, 0, sizeof(pmk));
+    }
+}
+
+static void s_esp32_wifimanager_pmk_done_cb(void* arg)
+{
+    //PMK JOB TASK CONTEXT. HAND THE RESULT TO THE MANAGER
+
+    s_esp32_wifimanager_post_evt((esp32_wifimanager_t*)arg, ESP32_WIFIMANAGER_EVT_PMK_DERIVED, 0);
+}
+
+static void s_esp32_wifimanager_pmk_load(esp32_wifimanager_t* wm)
+{
+    //LOAD PMK CACHE FROM NVS (ONCE)
+
+    nvs_handle handle;
+    size_t len = sizeof(wm->pmk_cache);
+
+    if(wm->pmk_loaded)
+    {
+        return;
+    }
+    wm->pmk_loaded = true;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READONLY, &handle) == ESP_OK)
+    {
+        if(nvs_get_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_PMK_CACHE,
+                        &wm->pmk_cache, &len) != ESP_OK ||
+            len != sizeof(wm->pmk_cache))
+        {
+            memset(&wm->pmk_cache, 0, sizeof(wm->pmk_cache));
+        }
+        nvs_close(handle);
+    }
+}
+
+static void s_esp32_wifimanager_pmk_save(esp32_wifimanager_t* wm)
+{
+    //SAVE PMK CACHE TO NVS. ONLY WHEN A KEY WAS ADDED, NOT ON EVERY HIT
+
+    nvs_handle handle;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if(nvs_set_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_PMK_CACHE,
+                    &wm->pmk_cache, sizeof(wm->pmk_cache)) == ESP_OK)
+    {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+static void s_esp32_wifimanager_cred_reindex(esp32_wifimanager_t* wm)
+{
+    //REBUILD SSID HASH INDEX
+
+    uint8_t i;
+    uint32_t pos;
+
+    memset(wm->cred_index, -1, sizeof(wm->cred_index));
+    for(i = 0; i < ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE; i++)
+    {
+        if(!wm->cred_table[i].used)
+        {
+            continue;
+        }
+        wm->cred_hash[i] = s_esp32_wifimanager_ssid_hash(wm->cred_table[i].ssid);
+        pos = wm->cred_hash[i] & (ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE - 1);
+        while(wm->cred_index[pos] >= 0)
+        {
+            pos = (pos + 1) & (ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE - 1);
+        }
+        wm->cred_index[pos] = i;
+    }
+}
+
+static int8_t s_esp32_wifimanager_cred_lookup(esp32_wifimanager_t* wm, const uint8_t* ssid)
+{
+    //FIND TABLE SLOT FOR SSID. -1 IF NOT FOUND
+    //INDEX IS AT MOST HALF FULL SO PROBES STAY SHORT
+
+    uint32_t hash = s_esp32_wifimanager_ssid_hash(ssid);
+    uint32_t pos = hash & (ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE - 1);
+    int8_t slot;
+
+    while((slot = wm->cred_index[pos]) >= 0)
+    {
+        if(wm->cred_hash[slot] == hash &&
+            strncmp((char*)wm->cred_table[slot].ssid,
+                    (char*)ssid,
+                    ESP32_WIFIMANAGER_SSID_LEN) == 0)
+        {
+            return slot;
+        }
+        pos = (pos + 1) & (ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE - 1);
+    }
+    return -1;
+}
+
+static bool s_esp32_wifimanager_multi_connecting(esp32_wifimanager_t* wm)
+{
+    //MULTI NETWORK CONNECT STEP
+    //ONE SCAN PER ATTEMPT, THEN TRY MATCHING NETWORKS BEST FIRST
+
+    esp32_wifimanager_candidate_t* candidate;
+    esp32_wifimanager_credential_entry_t* entry;
+
+    //PREVIOUS CANDIDATE DID NOT CONNECT
+    if(wm->candidate_current >= 0)
+    {
+        entry = &wm->cred_table[wm->candidate_current];
+        if(entry->fail_count < UINT16_MAX)
+        {
+            entry->fail_count++;
+            wm->cred_dirty = true;
+        }
+        wm->candidate_current = -1;
+    }
+
+    if(wm->multi_scan_pending)
+    {
+        //WAIT FOR SCAN_DONE
+        return true;
+    }
+
+    if(wm->candidate_next < wm->candidate_count)
+    {
+        candidate = &wm->candidates[wm->candidate_next++];
+        entry = &wm->cred_table[candidate->entry];
+
+        memset(&wm->station_config, 0, sizeof(wm->station_config));
+        memcpy(wm->station_config.sta.ssid, entry->ssid, ESP32_WIFIMANAGER_SSID_LEN);
+        memcpy(wm->station_config.sta.password, entry->pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+        memcpy(wm->station_config.sta.bssid, candidate->bssid, 6);
+        wm->station_config.sta.bssid_set = true;
+        wm->station_config.sta.channel = candidate->channel;
+        wm->station_config.sta.scan_method = WIFI_FAST_SCAN;
+        wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+
+        wm->candidate_current = candidate->entry;
+        ESP32_WIFIMANAGER_LOGI(MULTI_TRY,
+                                ESP32_WIFIMANAGER_LOG_Hash(entry->ssid, ESP32_WIFIMANAGER_SSID_LEN),
+                                candidate->rssi);
+        s_esp32_wifimanager_wifi_connect(wm);
+        return true;
+    }
+
+    //ALL CANDIDATES TRIED. THEIR FAILURES ARE SAVED ONCE PER ROUND, NOT PER TRY
+    if(wm->cred_dirty)
+    {
+        s_esp32_wifimanager_cred_save(wm);
+    }
+
+    //NEED A NEW SCAN
+    if(ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm) >= ESP32_WIFIMANAGER_WIFI_RETRY_COUNT)
+    {
+        ESP32_WIFIMANAGER_LOGW(MAX_ATTEMPTS, 0, 0);
+        return false;
+    }
+
+    //FIRST ATTEMPT. IF BACKGROUND SCANS COVERED EVERY CHANNEL RECENTLY
+    //RANK FROM THE CACHE INSTEAD OF SCANNING
+    if(ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm) == 0 && s_esp32_wifimanager_scan_cache_complete(wm))
+    {
+        ESP32_WIFIMANAGER_FSM_AttemptsInc(&wm->fsm);
+        s_esp32_wifimanager_multi_rank(wm);
+        if(wm->candidate_count > 0)
+        {
+            wm->stats.scan_skipped++;
+            return s_esp32_wifimanager_multi_connecting(wm);
+        }
+    }
+
+    ESP32_WIFIMANAGER_LOGI(SCAN_ATTEMPT, ESP32_WIFIMANAGER_FSM_Attempts(&wm->fsm), 0);
+    ESP32_WIFIMANAGER_FSM_AttemptsInc(&wm->fsm);
+    wm->stats.scan_needed++;
+
+    s_esp32_wifimanager_wifi_start(wm);
+    wm->multi_scan_pending = s_esp32_wifimanager_scan_start(wm, ESP32_WIFIMANAGER_SCANCACHE_ALL_CHANNELS,
+                                                                            false);
+    return true;
+}
+
+static void s_esp32_wifimanager_multi_scan_done(esp32_wifimanager_t* wm)
+{
+    //FULL SCAN FOR CANDIDATE SELECTION DONE (CACHE ALREADY UPDATED)
+
+    if(!wm->multi_scan_pending)
+    {
+        return;
+    }
+    wm->multi_scan_pending = false;
+    s_esp32_wifimanager_multi_rank(wm);
+
+    if(wm->candidate_count > 0)
+    {
+        //TRY BEST CANDIDATE RIGHT AWAY
+        s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTING);
+    }
+}
+
+static void s_esp32_wifimanager_multi_rank(esp32_wifimanager_t* wm)
+{
+    //MATCH SCAN CACHE AGAINST CREDENTIAL TABLE AND RANK THEM
+    //STRONGEST BSSID PER NETWORK IS KEPT
+
+    const esp32_wifimanager_scan_entry_t* aps[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    uint8_t count;
+    uint8_t i;
+    int8_t slot;
+    uint8_t j;
+    esp32_wifimanager_candidate_t candidate;
+    esp32_wifimanager_credential_entry_t* entry;
+
+    wm->candidate_count = 0;
+    wm->candidate_next = 0;
+
+    count = ESP32_WIFIMANAGER_SCANCACHE_Sorted(&wm->scan_cache, aps, ESP32_WIFIMANAGER_SCAN_CACHE_SIZE);
+    for(i = 0; i < count; i++)
+    {
+        slot = s_esp32_wifimanager_cred_lookup(wm, aps[i]->ssid);
+        if(slot < 0)
+        {
+            continue;
+        }
+        entry = &wm->cred_table[slot];
+        entry->last_rssi = aps[i]->rssi;
+
+        //SCORE = RSSI + UP TO 20 FOR A GOOD SUCCESS HISTORY
+        candidate.entry = slot;
+        candidate.channel = aps[i]->channel;
+        memcpy(candidate.bssid, aps[i]->bssid, 6);
+        candidate.rssi = aps[i]->rssi;
+        candidate.score = candidate.rssi +
+                            (int16_t)((20 * (uint32_t)entry->success_count) /
+                                        ((uint32_t)entry->success_count + entry->fail_count + 1));
+
+        //ALREADY HAVE THIS NETWORK ?
+        for(j = 0; j < wm->candidate_count; j++)
+        {
+            if(wm->candidates[j].entry == slot)
+            {
+                break;
+            }
+        }
+        if(j < wm->candidate_count)
+        {
+            if(candidate.score <= wm->candidates[j].score)
+            {
+                continue;
+            }
+            //REMOVE WEAKER BSSID, RE INSERT BELOW
+            memmove(&wm->candidates[j],
+                    &wm->candidates[j + 1],
+                    (wm->candidate_count - j - 1) * sizeof(esp32_wifimanager_candidate_t));
+            wm->candidate_count--;
+        }
+
+        //SORTED INSERT (BEST FIRST)
+        j = wm->candidate_count;
+        while(j > 0 && wm->candidates[j - 1].score < candidate.score)
+        {
+            wm->candidates[j] = wm->candidates[j - 1];
+            j--;
+        }
+        wm->candidates[j] = candidate;
+        wm->candidate_count++;
+    }
+
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(SCAN_RESULT, count, wm->candidate_count);
+    }
+}
+
+static void s_esp32_wifimanager_multi_got_ip(esp32_wifimanager_t* wm)
+{
+    //RECORD SUCCESS FOR CONNECTED NETWORK
+
+    esp32_wifimanager_credential_entry_t* entry;
+
+    if(wm->credential_src != ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI ||
+        wm->candidate_current < 0)
+    {
+        return;
+    }
+
+    entry = &wm->cred_table[wm->candidate_current];
+    if(entry->success_count < UINT16_MAX)
+    {
+        entry->success_count++;
+    }
+    wm->candidate_current = -1;
+    wm->candidate_next = wm->candidate_count;
+    s_esp32_wifimanager_cred_save(wm);
+}
+
+static bool s_esp32_wifimanager_scan_start(esp32_wifimanager_t* wm, uint8_t channel, bool passive)
+{
+    //START A NON BLOCKING SCAN OF ONE CHANNEL (0 = ALL). FALSE IF NOT STARTED
+
+    wifi_scan_config_t config;
+
+    if(wm->scan_busy)
+    {
+        return false;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.channel = channel;
+    if(passive)
+    {
+        config.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+        config.scan_time.passive = ESP32_WIFIMANAGER_SCAN_PASSIVE_MS;
+    }
+    if(wm->driver->scan_start(wm->driver_ctx, &config, false) != ESP_OK)
+    {
+        return false;
+    }
+    wm->scan_busy = true;
+    wm->scan_channel = channel;
+    wm->scan_start_us = esp_timer_get_time();
+    return true;
+}
+
+static void s_esp32_wifimanager_scan_done(esp32_wifimanager_t* wm)
+{
+    //SCAN FINISHED. ACCOUNT RADIO TIME, UPDATE CACHE, HAND TO MULTI NETWORK
+
+    uint16_t count = ESP32_WIFIMANAGER_SCAN_MAX_AP;
+    int64_t now_us = esp_timer_get_time();
+    uint8_t ch;
+
+    if(!wm->scan_busy)
+    {
+        return;
+    }
+    wm->scan_busy = false;
+
+    if(wm->scan_channel == ESP32_WIFIMANAGER_SCANCACHE_ALL_CHANNELS)
+    {
+        wm->stats.scans_full++;
+        wm->stats.scan_full_busy_us += now_us - wm->scan_start_us;
+        for(ch = 1; ch <= ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX; ch++)
+        {
+            wm->scan_channel_us[ch] = now_us;
+        }
+    }
+    else
+    {
+        wm->stats.scans_channel++;
+        wm->stats.scan_channel_busy_us += now_us - wm->scan_start_us;
+        if(wm->scan_channel <= ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX)
+        {
+            wm->scan_channel_us[wm->scan_channel] = now_us;
+        }
+    }
+
+    if(wm->driver->scan_get_ap_records(wm->driver_ctx, &count, wm->scan_records) != ESP_OK)
+    {
+        count = 0;
+    }
+    ESP32_WIFIMANAGER_SCANCACHE_Update(&wm->scan_cache, wm->scan_records,
+                                        count,
+                                        wm->scan_channel,
+                                        now_us);
+
+    s_esp32_wifimanager_multi_scan_done(wm);
+    s_esp32_wifimanager_roam_scan_done(wm);
+}
+
+static void s_esp32_wifimanager_scan_abort(esp32_wifimanager_t* wm)
+{
+    //STOP A BACKGROUND SCAN (LINK LOST, RADIO NEEDED FOR RECONNECT)
+
+    if(!wm->scan_busy)
+    {
+        return;
+    }
+    wm->driver->scan_stop(wm->driver_ctx);
+    wm->scan_busy = false;
+    wm->stats.scan_channel_busy_us += esp_timer_get_time() - wm->scan_start_us;
+}
+
+static void s_esp32_wifimanager_scan_refresh(esp32_wifimanager_t* wm)
+{
+    //BACKGROUND REFRESH. PASSIVE SCAN OF THE NEXT CHANNEL IN ROTATION
+    //ONLY WHILE CONNECTED, NOT PROVISIONING AND NOT IN MAX_SAVE
+
+    if(!ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm) || wm->provisioning || wm->scan_busy ||
+        wm->roam_state != ESP32_WIFIMANAGER_ROAM_STATE_IDLE ||
+        wm->power_level == ESP32_WIFIMANAGER_POWER_MAX_SAVE)
+    {
+        return;
+    }
+
+    if(wm->scan_next_channel == 0 ||
+        wm->scan_next_channel > ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX)
+    {
+        wm->scan_next_channel = 1;
+    }
+    if(s_esp32_wifimanager_scan_start(wm, wm->scan_next_channel, true))
+    {
+        wm->scan_next_channel++;
+    }
+    ESP32_WIFIMANAGER_SCANCACHE_Expire(&wm->scan_cache, esp_timer_get_time());
+}
+
+static void s_esp32_wifimanager_scan_refresh_arm(esp32_wifimanager_t* wm)
+{
+    //RUN THE REFRESH TIMER ONLY IF ENABLED, CONNECTED AND NOT IN MAX_SAVE
+    //A RUNNING TIMER KEEPS ITS PHASE
+
+    if(wm->scan_refresh_ms == 0 || !ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm) ||
+        wm->power_level == ESP32_WIFIMANAGER_POWER_MAX_SAVE)
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->scan_timer);
+        return;
+    }
+    if(!ESP32_WIFIMANAGER_TIMERWHEEL_IsArmed(&wm->scan_timer))
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->scan_timer, wm->scan_refresh_ms, true);
+    }
+}
+
+static bool s_esp32_wifimanager_scan_cache_complete(esp32_wifimanager_t* wm)
+{
+    //TRUE IF EVERY CHANNEL WAS SCANNED WITHIN THE CACHE MAX AGE
+
+    int64_t now_us = esp_timer_get_time();
+    uint8_t ch;
+
+    for(ch = 1; ch <= ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX; ch++)
+    {
+        if(wm->scan_channel_us[ch] == 0 ||
+            (now_us - wm->scan_channel_us[ch]) > (int64_t)ESP32_WIFIMANAGER_SCAN_CACHE_MAX_AGE_MS * 1000)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void s_esp32_wifimanager_roam_check(esp32_wifimanager_t* wm)
+{
+    //SAMPLE RSSI OF CURRENT AP. START A ROAM SCAN WHEN IT STAYS WEAK
+
+    wifi_ap_record_t ap;
+    const esp32_wifimanager_scan_entry_t* aps[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    uint8_t count;
+    int64_t now_us = esp_timer_get_time();
+
+    if(!ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm) || wm->provisioning ||
+        wm->roam_state != ESP32_WIFIMANAGER_ROAM_STATE_IDLE ||
+        wm->driver->sta_get_ap_info(wm->driver_ctx, &ap) != ESP_OK)
+    {
+        return;
+    }
+
+    ap.rssi = (int8_t)s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_RSSI, (uint8_t)ap.rssi);
+    wm->roam_rssi_q4 = ESP32_WIFIMANAGER_ROAM_Smooth(wm->roam_rssi_q4, ap.rssi);
+    if(!ESP32_WIFIMANAGER_ROAM_ShouldScan(&wm->roam,
+                                            wm->roam_rssi_q4,
+                                            now_us,
+                                            wm->roam_last_us))
+    {
+        return;
+    }
+
+    memcpy(wm->roam_cur_bssid, ap.bssid, 6);
+    count = ESP32_WIFIMANAGER_SCANCACHE_Sorted(&wm->scan_cache, aps, ESP32_WIFIMANAGER_SCAN_CACHE_SIZE);
+    wm->roam_channels = ESP32_WIFIMANAGER_ROAM_Channels(aps, count, ap.ssid, ap.bssid);
+    if(wm->roam_channels == 0)
+    {
+        //NO OTHER BSSID KNOWN. ONE FULL SCAN
+        wm->roam_channels = 1;
+    }
+
+    wm->stats.roam_scans++;
+    wm->roam_last_us = now_us;
+    wm->roam_scan_us = now_us;
+    wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_SCANNING;
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(ROAM_SCAN, wm->roam_rssi_q4 / 16, wm->roam_channels);
+    }
+    s_esp32_wifimanager_roam_scan_next(wm);
+}
+
+static void s_esp32_wifimanager_roam_scan_next(esp32_wifimanager_t* wm)
+{
+    //SCAN NEXT CHANNEL ON THE ROAM LIST
+    //IF A BACKGROUND SCAN IS RUNNING, ITS SCAN_DONE CALLS BACK HERE
+    //IF THE DRIVER REFUSES THE SCAN, THE ROAM IS DROPPED AND THE TIMER TRIES AGAIN LATER
+
+    uint8_t ch;
+
+    for(ch = 0; ch <= ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX; ch++)
+    {
+        if(wm->roam_channels & (1 << ch))
+        {
+            break;
+        }
+    }
+    if(s_esp32_wifimanager_scan_start(wm, ch, false))
+    {
+        wm->roam_channels &= ~(1 << ch);
+    }
+    else if(!wm->scan_busy)
+    {
+        wm->roam_channels = 0;
+        wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_IDLE;
+        wm->stats.roam_scan_failures++;
+    }
+}
+
+static void s_esp32_wifimanager_roam_scan_done(esp32_wifimanager_t* wm)
+{
+    //ROAM SCAN STEP DONE. SCAN MORE OR DECIDE
+
+    const esp32_wifimanager_scan_entry_t* aps[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    uint8_t count;
+    int8_t pick;
+    wifi_ap_record_t ap;
+
+    if(wm->roam_state != ESP32_WIFIMANAGER_ROAM_STATE_SCANNING)
+    {
+        return;
+    }
+    if(wm->roam_channels != 0)
+    {
+        s_esp32_wifimanager_roam_scan_next(wm);
+        return;
+    }
+
+    //COMPARE AGAINST A FRESH SAMPLE OF THE CURRENT AP
+    wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_IDLE;
+    if(!ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm) || wm->driver->sta_get_ap_info(wm->driver_ctx, &ap) != ESP_OK)
+    {
+        return;
+    }
+    ap.rssi = (int8_t)s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_RSSI, (uint8_t)ap.rssi);
+    wm->roam_cur_rssi = ap.rssi;
+
+    count = ESP32_WIFIMANAGER_SCANCACHE_Sorted(&wm->scan_cache, aps, ESP32_WIFIMANAGER_SCAN_CACHE_SIZE);
+    pick = ESP32_WIFIMANAGER_ROAM_Pick(aps, count, ap.ssid, ap.bssid, ap.rssi,
+                                        wm->roam.hysteresis_db,
+                                        wm->roam_scan_us);
+    if(pick >= 0)
+    {
+        s_esp32_wifimanager_roam_switch(wm, aps[pick]);
+    }
+}
+
+static void s_esp32_wifimanager_roam_switch(esp32_wifimanager_t* wm, const esp32_wifimanager_scan_entry_t* target)
+{
+    //LEAVE CURRENT BSSID FOR TARGET
+    //NEW BSSID, CHANNEL AND THE CURRENT LEASE (AS STATIC IP) ARE ALL SET UP
+    //BEFORE LEAVING, SO THE LINK IS DOWN ONLY FOR AUTH + ASSOC
+
+    ESP32_WIFIMANAGER_LOGI(ROAM_FROM,
+                            ESP32_WIFIMANAGER_LOG_BSSID(wm->roam_cur_bssid),
+                            wm->roam_cur_rssi);
+    ESP32_WIFIMANAGER_LOGI(ROAM_TO,
+                            ESP32_WIFIMANAGER_LOG_BSSID(target->bssid),
+                            (uint8_t)target->last_rssi | (target->channel << 8));
+
+    if(!wm->dhcp_cache_active && s_esp32_wifimanager_dhcp_lease_usable(wm))
+    {
+        s_esp32_wifimanager_dhcp_static_apply(wm);
+    }
+
+    memcpy(wm->station_config.sta.bssid, target->bssid, 6);
+    wm->station_config.sta.bssid_set = true;
+    wm->station_config.sta.channel = target->channel;
+    wm->station_config.sta.scan_method = WIFI_FAST_SCAN;
+    wm->roam_pinned = true;
+
+    wm->roam_start_us = esp_timer_get_time();
+    wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_LEAVING;
+    wm->driver->disconnect(wm->driver_ctx);
+}
+
+static void s_esp32_wifimanager_roam_done(esp32_wifimanager_t* wm)
+{
+    //HANDOVER COMPLETE
+
+    wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_IDLE;
+    wm->roam_rssi_q4 = 0;
+    wm->roam_last_us = esp_timer_get_time();
+
+    wm->stats.roam_handovers++;
+    wm->stats.last_handover_us = wm->roam_last_us - wm->roam_start_us;
+    if(wm->stats.last_handover_us > wm->stats.max_handover_us)
+    {
+        wm->stats.max_handover_us = wm->stats.last_handover_us;
+    }
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(ROAMED, (uint32_t)(wm->stats.last_handover_us / 1000), 0);
+    }
+    s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_ROAMED);
+}
+
+static void s_esp32_wifimanager_roam_failed(esp32_wifimanager_t* wm)
+{
+    //TARGET BSSID REFUSED. LINK LOSS HANDLING TAKES OVER
+
+    wm->roam_state = ESP32_WIFIMANAGER_ROAM_STATE_IDLE;
+    wm->stats.roam_failures++;
+    s_esp32_wifimanager_roam_unpin(wm);
+}
+
+static void s_esp32_wifimanager_roam_unpin(esp32_wifimanager_t* wm)
+{
+    //RELEASE BSSID / CHANNEL SET BY A ROAM SO THE NORMAL RECONNECT CAN USE ANY BSSID
+    //MULTI MODE SETS ITS OWN PIN PER ATTEMPT
+
+    if(!wm->roam_pinned)
+    {
+        return;
+    }
+    wm->roam_pinned = false;
+    wm->station_config.sta.bssid_set = false;
+    wm->station_config.sta.channel = 0;
+    wm->station_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+}
+
+static void s_esp32_wifimanager_power_check(esp32_wifimanager_t* wm)
+{
+    //SAMPLE RSSI OF CURRENT AP, THEN RE-EVALUATE THE POWER LEVEL
+    //ALSO CATCHES THE END OF AN ACTIVITY HINT
+
+    wifi_ap_record_t ap;
+
+    if(ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm) && wm->driver->sta_get_ap_info(wm->driver_ctx, &ap) == ESP_OK)
+    {
+        ap.rssi = (int8_t)s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_RSSI, (uint8_t)ap.rssi);
+        wm->power_rssi_q4 = ESP32_WIFIMANAGER_ROAM_Smooth(wm->power_rssi_q4, ap.rssi);
+    }
+    s_esp32_wifimanager_power_update(wm);
+}
+
+static void s_esp32_wifimanager_power_update(esp32_wifimanager_t* wm)
+{
+    //PICK THE LEVEL FOR THE LINK STATE, LINK QUALITY AND ACTIVITY HINT
+    //WITHOUT A POLICY THE DRIVER KEEPS ITS OWN MODE, WHICH IS ONLY ACCOUNTED
+
+    esp32_wifimanager_power_policy_t level = ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    wifi_ps_type_t ps = WIFI_PS_NONE;
+
+    if(wm->power_since_us == 0)
+    {
+        return;
+    }
+    if(!ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+    {
+        level = ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    }
+    else if(wm->power_enabled)
+    {
+        level = ESP32_WIFIMANAGER_POWER_Effective(&wm->power,
+                                                    wm->power_rssi_q4,
+                                                    wm->power_busy_until_us > esp_timer_get_time());
+    }
+    else if(wm->driver->get_ps(wm->driver_ctx, &ps) == ESP_OK)
+    {
+        level = (ps == WIFI_PS_MAX_MODEM) ? ESP32_WIFIMANAGER_POWER_MAX_SAVE :
+                (ps == WIFI_PS_MIN_MODEM) ? ESP32_WIFIMANAGER_POWER_BALANCED :
+                                            ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    }
+
+    if(level == wm->power_level)
+    {
+        return;
+    }
+    s_esp32_wifimanager_power_level(wm, level);
+    if(wm->power_enabled)
+    {
+        wm->driver->set_ps(wm->driver_ctx, ESP32_WIFIMANAGER_POWER_PsType(level));
+        ESP32_WIFIMANAGER_LOGI(POWER_LEVEL, level, wm->power_rssi_q4 / 16);
+    }
+    s_esp32_wifimanager_scan_refresh_arm(wm);
+}
+
+static void s_esp32_wifimanager_power_level(esp32_wifimanager_t* wm, esp32_wifimanager_power_policy_t level)
+{
+    //CLOSE THE TIME SEGMENT OF THE CURRENT LEVEL AND START ONE AT THE NEW LEVEL
+
+    int64_t now_us = esp_timer_get_time();
+
+    wm->stats.power_level_us[wm->power_level] += now_us - wm->power_since_us;
+    wm->power_since_us = now_us;
+    wm->power_level = level;
+    wm->stats.power_switches++;
+}
+
+static bool s_esp32_wifimanager_credlog_load(esp32_wifimanager_t* wm)
+{
+    //OPEN FLASH / EEPROM CREDENTIAL LOG AND LOAD LATEST CREDENTIALS
+    //AN EMPTY LOG LEAVES THE STATION CONFIG EMPTY, SO PROVISIONING STARTS
+
+    const esp32_wifimanager_storage_ops_t* ops = wm->eeprom_flash_details.ops;
+    esp_err_t err;
+
+    if(ops == NULL && wm->credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH)
+    {
+        ops = ESP32_WIFIMANAGER_CREDLOG_SpiFlashOps();
+    }
+
+    err = ESP32_WIFIMANAGER_CREDLOG_Open(&wm->credlog,
+                                            ops,
+                                            wm->eeprom_flash_details.ssid_name_addr,
+                                            wm->eeprom_flash_details.ssid_pwd_addr);
+    if(err != ESP_OK)
+    {
+        ESP32_WIFIMANAGER_LOGE(CREDLOG_OPEN_FAILED, err, 0);
+        return false;
+    }
+
+    memset(&wm->station_config, 0, sizeof(wm->station_config));
+    if(ESP32_WIFIMANAGER_CREDLOG_Read(&wm->credlog, wm->station_config.sta.ssid, wm->station_config.sta.password) != ESP_OK)
+    {
+        ESP32_WIFIMANAGER_LOGW(CREDLOG_EMPTY, 0, 0);
+    }
+    wm->station_config.sta.bssid_set = false;
+    return true;
+}
+
+static void s_esp32_wifimanager_credlog_got_ip(esp32_wifimanager_t* wm)
+{
+    //SAVE CONNECTED NETWORK TO FLASH / EEPROM CREDENTIAL LOG
+    //UNCHANGED CREDENTIALS ARE NOT WRITTEN AGAIN
+
+    if(wm->credential_src != ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH &&
+        wm->credential_src != ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM)
+    {
+        return;
+    }
+
+    if(ESP32_WIFIMANAGER_CREDLOG_Save(&wm->credlog,
+                                        wm->station_config.sta.ssid,
+                                        wm->station_config.sta.password) != ESP_OK)
+    {
+        ESP32_WIFIMANAGER_LOGE(CREDLOG_SAVE_FAILED, 0, 0);
+    }
+}
+
+static esp32_wifimanager_disconnect_class_t s_esp32_wifimanager_reason_class(uint8_t reason)
+{
+    //TRANSIENT REASONS ARE WORTH AN IMMEDIATE (SILENT) RETRY
+    //AUTH REASONS MEAN THE KEY WAS REJECTED, EVERYTHING ELSE THAT THE AP
+    //IS GONE OR WILL NOT HAVE US. BOTH GO THROUGH THE BACKOFF
+
+    switch(reason)
+    {
+        case WIFI_REASON_UNSPECIFIED:
+        case WIFI_REASON_AUTH_EXPIRE:
+        case WIFI_REASON_ASSOC_EXPIRE:
+        case WIFI_REASON_NOT_AUTHED:
+        case WIFI_REASON_NOT_ASSOCED:
+        case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+        case WIFI_REASON_GROUP_KEY_UPDATE_TIMEOUT:
+        case WIFI_REASON_BEACON_TIMEOUT:
+        case WIFI_REASON_HANDSHAKE_TIMEOUT:
+            return ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT;
+
+        case WIFI_REASON_MIC_FAILURE:
+        case WIFI_REASON_IE_IN_4WAY_DIFFERS:
+        case WIFI_REASON_GROUP_CIPHER_INVALID:
+        case WIFI_REASON_PAIRWISE_CIPHER_INVALID:
+        case WIFI_REASON_AKMP_INVALID:
+        case WIFI_REASON_UNSUPP_RSN_IE_VERSION:
+        case WIFI_REASON_INVALID_RSN_IE_CAP:
+        case WIFI_REASON_802_1X_AUTH_FAILED:
+        case WIFI_REASON_CIPHER_SUITE_REJECTED:
+        case WIFI_REASON_AUTH_FAIL:
+            return ESP32_WIFIMANAGER_DISCONNECT_AUTH;
+
+        default:
+            return ESP32_WIFIMANAGER_DISCONNECT_AP_GONE;
+    }
+}
+
+static void s_esp32_wifimanager_hold_down_end(esp32_wifimanager_t* wm)
+{
+    //REPORT A DROP THAT WAS HELD BACK. NO-OP IF NONE
+
+    if(!wm->hold_active)
+    {
+        return;
+    }
+    wm->hold_active = false;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->hold_timer);
+    s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED);
+}
+
+static void s_esp32_wifimanager_health_start(esp32_wifimanager_t* wm)
+{
+    //GOT IP. FIRST ROUND AFTER ONE BASE INTERVAL
+    //STATE IS KEPT, SO A LINK THAT COMES BACK DEGRADED -> HEALTHY IS REPORTED
+
+    if(!wm->health_enabled)
+    {
+        return;
+    }
+    wm->health_fail_rounds = 0;
+    wm->health_interval_ms = wm->health.interval_ms;
+    wm->stats.health_interval_ms = wm->health_interval_ms;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->health_timer, wm->health_interval_ms, false);
+}
+
+static void s_esp32_wifimanager_health_stop(esp32_wifimanager_t* wm)
+{
+    //LINK GONE. DROP ANY ROUND IN FLIGHT
+
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->health_timer);
+    if(ESP32_WIFIMANAGER_HEALTH_Running(&wm->health_probe))
+    {
+        ESP32_WIFIMANAGER_HEALTH_Abort(&wm->health_probe);
+    }
+}
+
+static void s_esp32_wifimanager_health_check(esp32_wifimanager_t* wm)
+{
+    //HEALTH TIMER. START A ROUND OR POLL THE ONE RUNNING
+
+    tcpip_adapter_ip_info_t ip_info;
+    tcpip_adapter_dns_info_t dns_info;
+    uint32_t gw = 0;
+    uint32_t dns = 0;
+    uint16_t id;
+
+    if(!wm->health_enabled || !ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+    {
+        s_esp32_wifimanager_health_stop(wm);
+        return;
+    }
+
+    if(!ESP32_WIFIMANAGER_HEALTH_Running(&wm->health_probe))
+    {
+        if(wm->driver->get_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, &ip_info) == ESP_OK)
+        {
+            gw = ip_info.gw.addr;
+        }
+        if(wm->driver->get_dns_info(wm->driver_ctx, TCPIP_ADAPTER_IF_STA, TCPIP_ADAPTER_DNS_MAIN, &dns_info) == ESP_OK)
+        {
+            dns = dns_info.ip.u_addr.ip4.addr;
+        }
+        id = (uint16_t)s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_RANDOM, esp_random());
+        ESP32_WIFIMANAGER_HEALTH_Start(&wm->health_probe, &wm->health, gw, dns, id, esp_timer_get_time());
+    }
+
+    if(!ESP32_WIFIMANAGER_HEALTH_Poll(&wm->health_probe, esp_timer_get_time()))
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->health_timer, ESP32_WIFIMANAGER_HEALTH_POLL_MS, false);
+        return;
+    }
+    s_esp32_wifimanager_health_round(wm);
+}
+
+static void s_esp32_wifimanager_health_round(esp32_wifimanager_t* wm)
+{
+    //ROUND OVER. ADAPT THE INTERVAL AND REPORT STATE CHANGES
+    //QUIET LINK : INTERVAL DOUBLES UP TO MAX
+    //FAILED ROUND : RE-CHECK AT SUSPECT INTERVAL UNTIL THRESHOLD, THEN BASE INTERVAL
+
+    bool was_degraded;
+    uint8_t i;
+
+    wm->health_failed = wm->health_probe.failed;
+    wm->stats.health_rounds++;
+    for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+    {
+        if(wm->health_failed & (1 << i))
+        {
+            wm->stats.health_fail[i]++;
+        }
+        else if(wm->health.checks & (1 << i))
+        {
+            wm->stats.health_rtt_us[i] = wm->health_probe.rtt_us[i];
+        }
+    }
+
+    if(wm->health_failed == 0)
+    {
+        wm->health_fail_rounds = 0;
+        was_degraded = (wm->health_state == ESP32_WIFIMANAGER_HEALTH_DEGRADED);
+        wm->health_state = ESP32_WIFIMANAGER_HEALTH_HEALTHY;
+        if(was_degraded)
+        {
+            ESP32_WIFIMANAGER_LOGI(HEALTH_HEALTHY, wm->stats.health_rtt_us[0] / 1000, 0);
+            s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_HEALTHY);
+        }
+        if(wm->health_interval_ms < wm->health.max_interval_ms / 2)
+        {
+            wm->health_interval_ms *= 2;
+        }
+        else
+        {
+            wm->health_interval_ms = wm->health.max_interval_ms;
+        }
+    }
+    else
+    {
+        wm->stats.health_failed_rounds++;
+        wm->health_interval_ms = wm->health.interval_ms;
+        if(wm->health_fail_rounds < UINT8_MAX)
+        {
+            wm->health_fail_rounds++;
+        }
+        if(wm->health_fail_rounds >= wm->health.fail_threshold &&
+            wm->health_state != ESP32_WIFIMANAGER_HEALTH_DEGRADED)
+        {
+            ESP32_WIFIMANAGER_LOGW(HEALTH_DEGRADED, wm->health_failed, wm->health_fail_rounds);
+            wm->health_state = ESP32_WIFIMANAGER_HEALTH_DEGRADED;
+            wm->stats.health_degraded++;
+            s_esp32_wifimanager_notify(wm, ESP32_WIFIMANAGER_NOTIFY_DEGRADED);
+        }
+    }
+    wm->stats.health_interval_ms = wm->health_interval_ms;
+
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->health_timer,
+                                        (wm->health_failed != 0 && wm->health_state != ESP32_WIFIMANAGER_HEALTH_DEGRADED) ?
+                                            wm->health.suspect_interval_ms : wm->health_interval_ms,
+                                        false);
+}
+
+static uint32_t s_esp32_wifimanager_backoff_next_ms(esp32_wifimanager_t* wm)
+{
+    //NEXT RETRY DELAY = INITIAL x MULTIPLIER^LEVEL, CAPPED, +/- JITTER
+    //JITTER KEEPS A FLEET FROM RETRYING IN LOCKSTEP
+
+    uint64_t delay_ms = wm->backoff.initial_ms;
+    uint64_t low_ms;
+    uint32_t spread;
+    uint8_t i;
+
+    for(i = 0; i < wm->backoff_level && delay_ms < wm->backoff.max_ms; i++)
+    {
+        delay_ms *= wm->backoff.multiplier;
+    }
+    if(delay_ms > wm->backoff.max_ms)
+    {
+        delay_ms = wm->backoff.max_ms;
+    }
+    else
+    {
+        wm->backoff_level++;
+    }
 
-//CREDENTIAL SRC & CONFIG MODE RELATED
-static esp32_wifimanager_credential_src_t s_esp32_wifimanager_credential_src;
-static esp32_wifimanager_config_mode_t s_esp32_wifimanager_config_mode;
+    //DRAW FROM [DELAY - SPREAD, DELAY + SPREAD]. THE LOW EDGE IS RAISED TO THE
+    //TIME A CONNECT NEEDS, SO DRAWS STAY SPREAD INSTEAD OF PILING UP ON THE FLOOR
+    spread = (uint32_t)((delay_ms * wm->backoff.jitter_pct) / 100);
+    low_ms = delay_ms - spread;
+    if(low_ms < ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS)
+    {
+        low_ms = ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS;
+    }
+    if(delay_ms + spread > low_ms)
+    {
+        delay_ms = low_ms +
+                    (s_esp32_wifimanager_input(wm, ESP32_WIFIMANAGER_TRACE_RANDOM, esp_random()) %
+                        (uint32_t)(delay_ms + spread - low_ms + 1));
+    }
+    else
+    {
+        delay_ms = low_ms;
+    }
 
-//SSID RELATED
-static esp32_wifimanager_credential_hardcoded_t s_esp32_wifimanager_ssid_hardcoded_details;
-static esp32_wifimanager_credential_external_storage_t s_esp32_wifimanager_eeprom_flash_details;
+    wm->stats.last_backoff_ms = (uint32_t)delay_ms;
+    return (uint32_t)delay_ms;
+}
 
-//CB FUNCTIONS
-static void (*s_esp32_wifimanager_wifi_connected_user_cb)(char**, bool);
+static void s_esp32_wifimanager_reconnect_schedule(esp32_wifimanager_t* wm, uint32_t delay_ms)
+{
+    //(RE)ARM ONE SHOT RECONNECT TIMER
 
-//INTERNAL FUNCTIONS
-static void s_esp32_wifimanager_intialize(void);
-static bool s_esp32_wifimanager_connecting(void);
-static void s_esp32_wifimanager_connected(void);
-static void s_esp32_wifimanager_disconnected(void);
-static void s_esp32_wifimanager_connection_failed(void);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->reconnect_timer, delay_ms, false);
 
-static void s_esp32_wifimanager_led_toggle_cb(void* pArg);
-static void s_esp32_wifimanager_wifi_connect_check_cb(void* pArg);
-static esp_err_t s_esp32_wifimanager_wifi_evt_handler(void* ctx, system_event_t* evt);
-static void s_esp32_wifimanager_smartconfig_cb(smartconfig_status_t status, void *pdata);
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(NEXT_CHECK, delay_ms, 0);
+    }
+}
 
-void ESP32_WIFIMANAGER_SetDebug(uint8_t debug)
+static void s_esp32_wifimanager_reconnect_cancel(esp32_wifimanager_t* wm)
 {
-    //SET MODULE DEBUG FLAG
-    
-    s_debug_on = debug;
+    //STOP RECONNECT TIMER
 
-    ets_printf(ESP32_WIFIMANAGER_TAG" : Debug = %u\n", s_debug_on);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->reconnect_timer);
 }
 
-void ESP32_WIFIMANAGER_SetParameters(esp32_wifimanager_credential_src_t input_mode,
-                                        esp32_wifimanager_config_mode_t config_mode,
-                                        void* user_data,
-                                        uint8_t gpio_led_pin,
-                                        char* project_name)
+static void s_esp32_wifimanager_provisioning_start(esp32_wifimanager_t* wm)
 {
-    //ESP32 WIFIMANAGER SET PARAMETERS
+    //START PROVISIONING METHOD(S) FOR THE CONFIG MODE
 
-    s_state = ESP32_WIFIMANAGER_STATE_INITIALIZE;
-
-    s_esp32_wifimanager_credential_src = input_mode;
-    s_esp32_wifimanager_config_mode = config_mode;
-    s_esp32_wifimanager_gpio_led = gpio_led_pin;
-
-    //INIT OPERATIONAL PARAMETERS
-    s_wifi_attempt_count = 0;
-    s_wifi_connected = false;
-
-    switch(s_esp32_wifimanager_credential_src)
-    { 
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = GPIO\n");
-            s_esp32_wifimanager_gpio_trigger_pin = *(uint8_t*)user_data;
-            ets_printf(ESP32_WIFIMANAGER_TAG" : GPIO pin = %u\n", s_esp32_wifimanager_gpio_trigger_pin);
-            //SET TRIGGER GPIO AS INPUT
-            ESP32_GPIO_SetDirection(s_esp32_wifimanager_gpio_trigger_pin,
-                                        GPIO_DIRECTION_INPUT);
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = HARDCODED\n");
-            s_esp32_wifimanager_ssid_hardcoded_details.ssid_name= 
-                ((esp32_wifimanager_credential_hardcoded_t*)user_data)->ssid_name;
-            s_esp32_wifimanager_ssid_hardcoded_details.ssid_pwd= 
-                ((esp32_wifimanager_credential_hardcoded_t*)user_data)->ssid_pwd;
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = INTERNAL\n");
-            //DO NOTHING. WILL TAKE CARE OF IT LATER ON
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = EXTERNAL FLASH\n");
-            s_esp32_wifimanager_eeprom_flash_details.ssid_name_addr = 
-                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_name_addr;
-            s_esp32_wifimanager_eeprom_flash_details.ssid_pwd_addr = 
-                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_pwd_addr;
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = EXTERNAL EEPROM\n");
-            s_esp32_wifimanager_eeprom_flash_details.ssid_name_addr = 
-                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_name_addr;
-            s_esp32_wifimanager_eeprom_flash_details.ssid_pwd_addr = 
-                ((esp32_wifimanager_credential_external_storage_t*)user_data)->ssid_pwd_addr;
-            break;
-        
-        default:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Input SRC = INVALID\n");
-            break;
+    if(wm->provisioning)
+    {
+        return;
     }
+    wm->provisioning = true;
+    wm->provision_winner = ESP32_WIFIMANAGER_PROVISION_WINNER_NONE;
+    wm->provision_start_us = esp_timer_get_time();
+    ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_PROVISION_START,
+                                        wm->provision_start_us,
+                                        0);
 
-    switch(s_esp32_wifimanager_config_mode)
+    switch(wm->config_mode)
     {
         case ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = SMARTCONFIG\n");
+            s_esp32_wifimanager_smartconfig_start(wm);
             break;
         
         case ESP32_WIFIMANAGER_CONFIG_WEBCONFIG:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = WEBCONFIG\n");
+            s_esp32_wifimanager_softap_start(wm);
+            s_esp32_wifimanager_webconfig_start(wm);
             break;
         
-        case ESP32_WIFIMANAGER_CONFIG_BLE:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = BLE\n");
+        case ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG:
+            //PORTAL TASK RUNS THROUGHOUT, THE RADIO IS TIME SLICED
+            //SMARTCONFIG GOES FIRST, IT IS THE QUICKER PATH WHEN IT WORKS
+            wm->sc_locked = false;
+            wm->ap_clients = 0;
+            wm->sc_slice = true;
+            s_esp32_wifimanager_webconfig_start(wm);
+            s_esp32_wifimanager_smartconfig_start(wm);
+            ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->slice_timer,
+                                                ESP32_WIFIMANAGER_COMBINED_SC_SLICE_MS,
+                                                false);
             break;
         
         default:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = INVALID\n");
+            //BLE (NOT IMPLEMENTED) OR INVALID
+            ESP32_WIFIMANAGER_LOGE(CONFIG_UNSUPPORTED, wm->config_mode, 0);
             break;
     }
+
+    //KEEP TRYING THE STORED NETWORK NEXT TO THE PORTAL
+    //SMARTCONFIG ALONE SNIFFS ON THE STATION INTERFACE, SO NOTHING TO RUN NEXT TO
+    wm->apsta_count = 0;
+    if(wm->backoff.apsta_retry_ms != 0 &&
+        wm->station_config.sta.ssid[0] != 0 &&
+        (wm->config_mode == ESP32_WIFIMANAGER_CONFIG_WEBCONFIG ||
+            wm->config_mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG))
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->apsta_timer,
+                                            wm->backoff.apsta_retry_ms,
+                                            true);
+    }
 }
 
-void ESP32_WIFIMANAGER_SetStatusLedType(esp32_wifimanager_status_led_type_t led_type)
+static bool s_esp32_wifimanager_provisioning_won(esp32_wifimanager_t* wm, esp32_wifimanager_provision_winner_t winner)
 {
-    //SET STATUS LED TYPE
+    //FIRST VALID CREDENTIALS WIN. FALSE IF ANOTHER METHOD ALREADY WON
+    //(OR PROVISIONING IS OVER), IN WHICH CASE THE CREDENTIALS ARE DROPPED
 
-    s_esp32_wifimanager_led_idle_level = led_type;
+    int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us;
 
-    if(s_debug_on)
+    if(!wm->provisioning ||
+        wm->provision_winner != ESP32_WIFIMANAGER_PROVISION_WINNER_NONE)
     {
-        ets_printf(ESP32_WIFIMANAGER_TAG" : Status LED idle level = %u\n", led_type);
+        wm->stats.provision_late_dropped++;
+        return false;
+    }
+    wm->provision_winner = winner;
+
+    ESP32_WIFIMANAGER_LATENCY_Record(&wm->latency, ESP32_WIFIMANAGER_PHASE_PROVISION_END, now_us, 0);
+    elapsed_us = now_us - wm->provision_start_us;
+    wm->stats.last_provision_us = elapsed_us;
+    wm->stats.total_provision_us += elapsed_us;
+    if(elapsed_us > wm->stats.max_provision_us)
+    {
+        wm->stats.max_provision_us = elapsed_us;
+    }
+    wm->stats.provision_ms[wm->stats.provision_samples % ESP32_WIFIMANAGER_PROVISION_SAMPLES] =
+        (uint32_t)(elapsed_us / 1000);
+    wm->stats.provision_samples++;
+    if(winner == ESP32_WIFIMANAGER_PROVISION_WINNER_SMARTCONFIG)
+    {
+        wm->stats.provisioned_smartconfig++;
     }
+    else
+    {
+        wm->stats.provisioned_webconfig++;
+    }
+
+    //RADIO STAYS WITH THE WINNER
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->slice_timer);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->apsta_timer);
+    return true;
 }
 
-void ESP32_WIFIMANAGER_SetGpioTriggerLevel(esp32_wifimanager_gpio_trigger_type_t level)
+static void s_esp32_wifimanager_provision_slice(esp32_wifimanager_t* wm)
 {
-    //SET GPIO TRIGGER LEVEL TYPE
+    //SMARTCONFIG_WEBCONFIG MODE. HAND THE RADIO TO THE OTHER METHOD
+    //UNLESS THE CURRENT ONE IS IN THE MIDDLE OF SOMETHING
 
-    s_esp32_wifimanager_gpio_trigger_type = level;
-    if(s_debug_on)
+    if(!wm->provisioning ||
+        wm->config_mode != ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG ||
+        wm->provision_winner != ESP32_WIFIMANAGER_PROVISION_WINNER_NONE)
     {
-        ets_printf(ESP32_WIFIMANAGER_TAG" : GPIO trigger type = %u\n", level);
+        return;
+    }
+
+    if(wm->sc_slice)
+    {
+        if(wm->sc_locked)
+        {
+            //LOCKED ON THE PHONE'S CHANNEL. ONE MORE SLICE TO FINISH
+            wm->sc_locked = false;
+            ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->slice_timer,
+                                                ESP32_WIFIMANAGER_COMBINED_SC_SLICE_MS,
+                                                false);
+            return;
+        }
+        s_esp32_wifimanager_smartconfig_stop(wm);
+        s_esp32_wifimanager_softap_start(wm);
+        wm->sc_slice = false;
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->slice_timer,
+                                            ESP32_WIFIMANAGER_COMBINED_AP_SLICE_MS,
+                                            false);
+    }
+    else
+    {
+        if(wm->ap_clients > 0)
+        {
+            //SOMEONE IS ON THE PORTAL. KEEP THE AP UP
+            ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->slice_timer,
+                                                ESP32_WIFIMANAGER_COMBINED_AP_SLICE_MS,
+                                                false);
+            return;
+        }
+        //A BACKGROUND STATION ATTEMPT (IF ANY) GIVES THE RADIO TO SMARTCONFIG
+        wm->driver->disconnect(wm->driver_ctx);
+        wm->driver->set_mode(wm->driver_ctx, WIFI_MODE_STA);
+        s_esp32_wifimanager_smartconfig_start(wm);
+        wm->sc_slice = true;
+        ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->slice_timer,
+                                            ESP32_WIFIMANAGER_COMBINED_SC_SLICE_MS,
+                                            false);
     }
+    wm->stats.provision_slices++;
 }
 
-void ESP32_WIFIMANAGER_SetUserCbFunction(void (*wifi_connected_cb)(char**, bool))
+static uint8_t s_esp32_wifimanager_apsta_channel(esp32_wifimanager_t* wm)
 {
-    //SET WIFI CONNECT CB FN
+    //LAST KNOWN CHANNEL OF THE STORED NETWORK. 0 = UNKNOWN
 
-    if(wifi_connected_cb != NULL)
+    if(wm->fast_connect.channel == 0 ||
+        strncmp((char*)wm->fast_connect.ssid,
+                (char*)wm->station_config.sta.ssid,
+                ESP32_WIFIMANAGER_SSID_LEN) != 0)
     {
-        s_esp32_wifimanager_wifi_connected_user_cb = wifi_connected_cb;
+        return 0;
     }
+    return wm->fast_connect.channel;
 }
 
-
-void ESP32_WIFIMANAGER_Mainiter(void)
+static void s_esp32_wifimanager_apsta_retry(esp32_wifimanager_t* wm)
 {
-    switch (s_state)
-    {
-        case  ESP32_WIFIMANAGER_STATE_INITIALIZE:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : ESP32_WIFIMANAGER_STATE_INITIALIZE\n");
-            s_esp32_wifimanager_intialize();
-            s_state = ESP32_WIFIMANAGER_STATE_CONNECTING;
-            break;
+    //SOFTAP IS UP. TRY THE STORED NETWORK ON THE STATION INTERFACE
+    //ONE RADIO, SO THE AP FOLLOWS WHATEVER CHANNEL THE STATION JOINS ON.
+    //THE AP WAS BROUGHT UP ON THE LAST KNOWN CHANNEL, SO A PINNED ATTEMPT
+    //DOES NOT MOVE IT. EVERY OTHER RETRY SCANS ALL CHANNELS (THE AP MAY
+    //HAVE COME BACK ELSEWHERE), BUT NOT WHILE A PORTAL CLIENT IS ASSOCIATED
+    //GOT_IP TEARS DOWN THE PORTAL, PORTAL CREDENTIALS STOP THIS TIMER
 
-        case ESP32_WIFIMANAGER_STATE_CONNECTING:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : ESP32_WIFIMANAGER_STATE_CONNECTING\n");
-            if(!s_esp32_wifimanager_connecting())
-            {
-                s_state = ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED;
-                break;
-            }
-            s_state = ESP32_WIFIMANAGER_STATE_IDLE;
-            break;
+    wifi_config_t config;
+    uint8_t channel;
 
-        case ESP32_WIFIMANAGER_STATE_CONNECTED:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : ESP32_WIFIMANAGER_STATE_CONNECTED\n");
-            s_esp32_wifimanager_connected();
-            s_state = ESP32_WIFIMANAGER_STATE_IDLE;
-            break;
+    if(!wm->provisioning ||
+        wm->provision_winner != ESP32_WIFIMANAGER_PROVISION_WINNER_NONE ||
+        ESP32_WIFIMANAGER_FSM_Connected(&wm->fsm))
+    {
+        ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->apsta_timer);
+        return;
+    }
+    if(wm->config_mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG && wm->sc_slice)
+    {
+        //SMARTCONFIG HAS THE RADIO
+        return;
+    }
 
-        case ESP32_WIFIMANAGER_STATE_DISCONNECTED:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : ESP32_WIFIMANAGER_STATE_DISCONNECTED\n");
-            s_esp32_wifimanager_disconnected();
-            s_state = ESP32_WIFIMANAGER_STATE_IDLE;
-            break;
+    wm->apsta_count++;
+    channel = s_esp32_wifimanager_apsta_channel(wm);
+    memcpy(&config, &wm->station_config, sizeof(config));
+    if(channel != 0 && channel == wm->ap_channel &&
+        (wm->ap_clients > 0 || (wm->apsta_count & 1) != 0))
+    {
+        config.sta.bssid_set = true;
+        memcpy(config.sta.bssid, wm->fast_connect.bssid, 6);
+        config.sta.channel = channel;
+        config.sta.scan_method = WIFI_FAST_SCAN;
+    }
+    else if(wm->ap_clients > 0)
+    {
+        wm->stats.apsta_deferred++;
+        return;
+    }
+    else
+    {
+        config.sta.bssid_set = false;
+        config.sta.channel = 0;
+        config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    wm->stats.apsta_retries++;
 
-        case ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED\n");
-            s_esp32_wifimanager_connection_failed();
-            s_state = ESP32_WIFIMANAGER_STATE_IDLE;
-            break;
-        
-        case ESP32_WIFIMANAGER_STATE_IDLE:
-            //DO NOTHING
-            break;
-        
-        default:
-            break;
+    if(wm->debug_on)
+    {
+        ESP32_WIFIMANAGER_LOGD(APSTA_RETRY, wm->apsta_count, config.sta.channel);
     }
+
+    wm->driver->disconnect(wm->driver_ctx);
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &config);
+    s_esp32_wifimanager_wifi_connect(wm);
 }
 
-static void s_esp32_wifimanager_intialize(void)
+static void s_esp32_wifimanager_smartconfig_start(esp32_wifimanager_t* wm)
 {
-    //INTIALIZE ESP32 WIFIMANAGER MODULE
-
-    //SET LED GPIO AS OUTPUT
-    ESP32_GPIO_SetDirection(s_esp32_wifimanager_gpio_led, GPIO_DIRECTION_OUTPUT);
-
-    //SET UP LED FLASHING TIMER
-    s_esp32_wifimanager_led_status = true;
-    ESP32_TIMER_SetDebug(true);
-    ESP32_TIMER_Initialize(TIMER_GROUP0,
-                            TIMER0,
-                            true,
-                            TIMER_DIRECTION_UP,
-                            true,
-                            2);
-    ESP32_TIMER_SetInterruptCb(TIMER_GROUP0,
-                            TIMER0,
-                            ESP32_TIMER_MS_TO_CNT_VALUE(ESP32_WIFIMANAGER_STATUS_LED_TOGGLE_MS, 2),
-                            s_esp32_wifimanager_led_toggle_cb,
-                            NULL);
-
-    //SET UP WIFI CONNECT CHECK TIMER
-    ESP32_TIMER_Initialize(TIMER_GROUP0,
-                            TIMER1,
-                            true,
-                            TIMER_DIRECTION_UP,
-                            true,
-                            2);
-    ESP32_TIMER_SetInterruptCb(TIMER_GROUP0,
-                            TIMER1,
-                            ESP32_TIMER_MS_TO_CNT_VALUE(ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS, 2),
-                            s_esp32_wifimanager_wifi_connect_check_cb,
-                            (void*)&s_station_config);
-    
-    //START LED FLASHING TIMER
-    ESP32_TIMER_Start(TIMER_GROUP0, TIMER0);
+    //START ESPTOUCH SNIFFING (STA MODE)
 
-    //START WIFI CONNECT CHECK TIMER
-    ESP32_TIMER_Start(TIMER_GROUP0, TIMER1);
+    if(wm->driver->smartconfig_start(wm->driver_ctx) == ESP_OK)
+    {
+        wm->sc_running = true;
+    }
+}
 
-    //INITIALIZE ESP32 WIFI STACK
-    wifi_init_config_t config = WIFI_INIT_CONFIG_DEFAULT();
-    esp_wifi_init(&config);
-    esp_wifi_set_mode(WIFI_MODE_STA);
+static void s_esp32_wifimanager_smartconfig_stop(esp32_wifimanager_t* wm)
+{
+    //STOP ESPTOUCH SNIFFING (IF RUNNING)
 
-    //REGISTER WIFI EVENT HANDLER
-    esp_event_loop_init(s_esp32_wifimanager_wifi_evt_handler, NULL);
-  
-    switch(s_esp32_wifimanager_credential_src)
+    if(wm->sc_running)
     {
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO:
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL:
-            //USED INTERNALLY SAVED WIFI CREDENTIALS
-            //SET AUTOCONNECT STORAGE TO FLASH
-            esp_wifi_set_storage(WIFI_STORAGE_FLASH);
-            //SET WIFI AUTOCONNECT TO TRUE
-            esp_wifi_set_auto_connect(true);
-            esp_wifi_get_config(WIFI_IF_STA, &s_station_config);
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED:
-            //USE HARDCODED SUPPLIED WIFI CREDENTIALS
-            //SET WIFI AUTOCONNECT TO FALSE
-            esp_wifi_set_auto_connect(false);
-            strcpy((char * restrict)s_station_config.sta.ssid, 
-                s_esp32_wifimanager_ssid_hardcoded_details.ssid_name);
-            strcpy((char * restrict)s_station_config.sta.password,
-                s_esp32_wifimanager_ssid_hardcoded_details.ssid_pwd);
-            s_station_config.sta.bssid_set = false;
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM:
-            //NOT SUPPORTED FOR NOW
-            return;
-            break;
-        
-        case ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH:
-            //NOT SUPPORTED FOR NOW
-            return;
-            break;
-        
-        default:
-            return;
-            break;
+        wm->driver->smartconfig_stop(wm->driver_ctx);
+        wm->sc_running = false;
     }
+}
 
-    //SET CONFIGURATION
-    esp_wifi_set_config(WIFI_IF_STA, (wifi_config_t*)&s_station_config);
+static void s_esp32_wifimanager_webconfig_start(esp32_wifimanager_t* wm)
+{
+    //START PORTAL TASK. CAPTIVE DNS ANSWERS WITH THIS RADIO'S SOFTAP ADDRESS
 
-    if(s_debug_on)
+    tcpip_adapter_ip_info_t ip_info;
+
+    if(wm->driver->get_ip_info(wm->driver_ctx, TCPIP_ADAPTER_IF_AP, &ip_info) == ESP_OK &&
+        ip_info.ip.addr != 0)
+    {
+        ESP32_WIFIMANAGER_DNS_SetAddress(&wm->webconfig.dns, ip_info.ip.addr);
+    }
+    if(ESP32_WIFIMANAGER_WEBCONFIG_Start(&wm->webconfig,
+                                            (const char (*)[ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1])
+                                            wm->custom_field_names,
+                                            wm->custom_field_count,
+                                            s_esp32_wifimanager_web_result_cb,
+                                            wm) != ESP_OK)
     {
-        ets_printf(ESP32_WIFIMANAGER_TAG" : Initialized (%u, %u) led @ pin %u\n", s_esp32_wifimanager_credential_src,
-                                                                                    s_esp32_wifimanager_config_mode,
-                                                                                    s_esp32_wifimanager_gpio_led);
+        ESP32_WIFIMANAGER_LOGE(WEBCONFIG_FAILED, 0, 0);
     }
 }
 
-static bool s_esp32_wifimanager_connecting(void)
+static void s_esp32_wifimanager_provisioning_stop(esp32_wifimanager_t* wm)
 {
-    //CONNECT TO WIFI
+    //STOP RUNNING PROVISIONING METHOD (IF ANY)
 
-    //CHECK FOR TRIGGER
-    //IF TRIGGER = GPIO DO CHECK RIGHT NOW
-    //IF TRIGGER = NOCONNECTION, LET IT PROCEED TO CONNECT TO WIFI
-    if(s_esp32_wifimanager_credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_GPIO)
+    if(!wm->provisioning)
     {
-        //CHECK IF GPIO ACTIVATED
-        ets_printf(ESP32_WIFIMANAGER_TAG" : Checking trigger gpio level\n");
-        uint8_t retval;
-        if(ESP32_GPIO_GetValue(s_esp32_wifimanager_gpio_trigger_pin, &retval) == ESP_OK && 
-            retval == s_esp32_wifimanager_gpio_trigger_type)
-        {
-            //START CONFIGURATION PROCESS
-            //RETURN FALSE TO GO INTO FAILED STATE AND START CONFIGURATION
-            //MANUALLY START WIFI AS WIFI IS NOT STARTED YET 
-            //AND SMARTCONFIG NEEDS IT TO BE STARTED
-            ets_printf(ESP32_WIFIMANAGER_TAG" : gpio triggered !!\n");
-            esp_wifi_start();
-            return false;
-        }
+        return;
     }
+    wm->provisioning = false;
 
-    //CHECK FOR CONNECTION ATTEMPTS
-    if(s_wifi_attempt_count >= ESP32_WIFIMANAGER_WIFI_RETRY_COUNT)
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->slice_timer);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&wm->apsta_timer);
+    if(wm->apsta_count != 0)
     {
-        //MAX ATTEMPT REACHED
-        ets_printf(ESP32_WIFIMANAGER_TAG" : Max connection attempts reached !\n");
-        return false;
+        //BACKGROUND ATTEMPTS LEFT THEIR OWN PINNING IN THE DRIVER
+        wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+    }
+    s_esp32_wifimanager_smartconfig_stop(wm);
+    if(wm->config_mode == ESP32_WIFIMANAGER_CONFIG_WEBCONFIG ||
+        wm->config_mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG)
+    {
+        ESP32_WIFIMANAGER_WEBCONFIG_Stop(&wm->webconfig);
+        wm->driver->set_mode(wm->driver_ctx, WIFI_MODE_STA);
     }
+    //BLINK LED WHILE RETRYING
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&wm->led_timer,
+                                        ESP32_WIFIMANAGER_STATUS_LED_TOGGLE_MS,
+                                        true);
+}
 
-    ets_printf(ESP32_WIFIMANAGER_TAG" : Wifi connect attempt #%u\n", s_wifi_attempt_count);
-    s_wifi_attempt_count++;
+static void s_esp32_wifimanager_softap_start(esp32_wifimanager_t* wm)
+{
+    //BRING UP PROVISIONING SOFTAP NEXT TO THE STATION INTERFACE
 
-    //START WIFI
-    esp_wifi_start();
+    wifi_config_t ap_config;
 
-    //CONNECT TO WIFI
-    esp_wifi_connect();
+    memset(&ap_config, 0, sizeof(ap_config));
+    strcpy((char*)ap_config.ap.ssid, ESP32_WIFIMANAGER_SOFTAP_SSID);
+    ap_config.ap.ssid_len = strlen(ESP32_WIFIMANAGER_SOFTAP_SSID);
+    strcpy((char*)ap_config.ap.password, ESP32_WIFIMANAGER_SOFTAP_PWD);
+    ap_config.ap.authmode = (strlen(ESP32_WIFIMANAGER_SOFTAP_PWD) >= 8) ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
+    //WITH APSTA RETRIES, SIT ON THE STORED NETWORK'S CHANNEL SO JOINING IT
+    //DOES NOT PULL THE AP (AND ITS CLIENTS) TO ANOTHER ONE
+    wm->ap_channel = ESP32_WIFIMANAGER_SOFTAP_CHANNEL;
+    if(wm->backoff.apsta_retry_ms != 0 && s_esp32_wifimanager_apsta_channel(wm) != 0)
+    {
+        wm->ap_channel = s_esp32_wifimanager_apsta_channel(wm);
+    }
+    ap_config.ap.channel = wm->ap_channel;
+    ap_config.ap.max_connection = ESP32_WIFIMANAGER_SOFTAP_MAX_CONN;
+    ap_config.ap.beacon_interval = 100;
 
-    return true;
+    //STOP STATION FROM HOPPING CHANNELS UNDER THE AP
+    wm->driver->disconnect(wm->driver_ctx);
+    wm->driver->set_mode(wm->driver_ctx, WIFI_MODE_APSTA);
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_AP, &ap_config);
+    s_esp32_wifimanager_wifi_start(wm);
+
+    ESP32_WIFIMANAGER_LOGI(SOFTAP_UP, wm->ap_channel, 0);
 }
 
-static void s_esp32_wifimanager_connected(void)
+static void s_esp32_wifimanager_custom_field_load(esp32_wifimanager_t* wm)
 {
-    //WIFI CONNECTION OK
+    //LOAD SAVED CUSTOM FIELD VALUES FROM NVS (ONCE)
 
-    //STOP ALL TIMERS
-    ESP32_TIMER_Stop(TIMER_GROUP0, TIMER0);
-    ESP32_TIMER_Stop(TIMER_GROUP0, TIMER1);
-    //TURN LED ON
-    ESP32_GPIO_SetValue(s_esp32_wifimanager_gpio_led, true);
-    //CALL USER CB
-    if(s_esp32_wifimanager_wifi_connected_user_cb != NULL)
+    nvs_handle handle;
+    size_t len = sizeof(wm->custom_field_values);
+
+    if(wm->custom_field_loaded)
+    {
+        return;
+    }
+    wm->custom_field_loaded = true;
+
+    if(nvs_open(wm->nvs_namespace, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return;
+    }
+    if(nvs_get_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_CUSTOM_FIELDS,
+                    wm->custom_field_values, &len) != ESP_OK ||
+        len != sizeof(wm->custom_field_values))
     {
-        (*s_esp32_wifimanager_wifi_connected_user_cb)(NULL, true);
+        memset(wm->custom_field_values, 0, sizeof(wm->custom_field_values));
     }
+    nvs_close(handle);
 }
 
-static void s_esp32_wifimanager_disconnected(void)
+static void s_esp32_wifimanager_web_result_cb(const esp32_wifimanager_provision_data_t* result, void* arg)
 {
-    //WIFI DISCONNECTED
+    //WEBCONFIG POST RECEIVED (WEBCONFIG TASK OF INSTANCE arg)
+    //HAND OVER TO STATE MACHINE
+
+    esp32_wifimanager_t* wm = arg;
 
+    //A LATER POST REPLACES AN EARLIER ONE NOT YET APPLIED, NEVER TEARS IT
+    portENTER_CRITICAL(&wm->web_lock);
+    memcpy(&wm->web_result, result, sizeof(esp32_wifimanager_provision_data_t));
+    portEXIT_CRITICAL(&wm->web_lock);
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_WEB_CREDENTIALS, 0);
 }
 
-static void s_esp32_wifimanager_connection_failed(void)
+static void s_esp32_wifimanager_web_credentials(esp32_wifimanager_t* wm)
 {
-    //WIFI CONNECTION FAILED
+    //APPLY CREDENTIALS AND CUSTOM FIELDS FROM WEBCONFIG
 
-    //STOP ALL TIMERS
-    ESP32_TIMER_Stop(TIMER_GROUP0, TIMER0);
-    ESP32_TIMER_Stop(TIMER_GROUP0, TIMER1);
-    
-    //TURN LED OFF
-    ESP32_GPIO_SetValue(s_esp32_wifimanager_gpio_led, false);
-    
-    //CALL USER CB
-    if(s_esp32_wifimanager_wifi_connected_user_cb != NULL)
+    nvs_handle handle;
+    uint8_t i;
+
+    portENTER_CRITICAL(&wm->web_lock);
+    memcpy(&wm->web_applied, &wm->web_result, sizeof(esp32_wifimanager_provision_data_t));
+    portEXIT_CRITICAL(&wm->web_lock);
+
+    ESP32_WIFIMANAGER_LOGI(WEBCONFIG_SSID,
+                            ESP32_WIFIMANAGER_LOG_Hash((const uint8_t*)wm->web_applied.ssid,
+                                                        ESP32_WIFIMANAGER_SSID_LEN),
+                            0);
+
+    //SAVE CUSTOM FIELDS
+    for(i = 0; i < ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT; i++)
+    {
+        strcpy(wm->custom_field_values[i], wm->web_applied.custom[i]);
+    }
+    if(nvs_open(wm->nvs_namespace, NVS_READWRITE, &handle) == ESP_OK)
     {
-        (*s_esp32_wifimanager_wifi_connected_user_cb)(NULL, false);
+        if(nvs_set_blob(handle, ESP32_WIFIMANAGER_NVS_KEY_CUSTOM_FIELDS,
+                        wm->custom_field_values,
+                        sizeof(wm->custom_field_values)) == ESP_OK)
+        {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
     }
 
-    //START CONFIGURATION PROCES
-    switch(s_esp32_wifimanager_config_mode)
+    if(wm->credential_src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI)
     {
-        case ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG:
-            //START SMARTCONFIG
-            esp_smartconfig_set_type(SC_TYPE_ESPTOUCH);
-            esp_smartconfig_start(s_esp32_wifimanager_smartconfig_cb);
-            break;
-        
-        case ESP32_WIFIMANAGER_CONFIG_WEBCONFIG:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = WEBCONFIG\n");
-            break;
-        
-        case ESP32_WIFIMANAGER_CONFIG_BLE:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = BLE\n");
-            break;
-        
-        default:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : Config Mode = INVALID\n");
-            break;
+        ESP32_WIFIMANAGER_CTX_AddCredential(wm,
+                                            wm->web_applied.ssid,
+                                            wm->web_applied.pwd);
     }
+
+    //NEW NETWORK. CACHED FAST PATHS DO NOT APPLY
+    memset(&wm->station_config, 0, sizeof(wm->station_config));
+    memcpy(wm->station_config.sta.ssid, wm->web_applied.ssid,
+            strlen(wm->web_applied.ssid));
+    memcpy(wm->station_config.sta.password, wm->web_applied.pwd,
+            strlen(wm->web_applied.pwd));
+    wm->fast_connect_active = false;
+    s_esp32_wifimanager_dhcp_cache_fallback(wm);
+
+    //TEAR DOWN PORTAL AND CONNECT
+    s_esp32_wifimanager_provisioning_stop(wm);
+    wm->driver->set_config(wm->driver_ctx, WIFI_IF_STA, &wm->station_config);
+    ESP32_WIFIMANAGER_FSM_AttemptsReset(&wm->fsm);
+    s_esp32_wifimanager_set_state(wm, ESP32_WIFIMANAGER_STATE_CONNECTING);
 }
 
 static void s_esp32_wifimanager_led_toggle_cb(void* pArg)
 {
     //LED TOGGLE TIMER CB FUNCTION
 
-    ESP32_GPIO_SetDebug(false);
-    s_esp32_wifimanager_led_status = !s_esp32_wifimanager_led_status;
-    ESP32_GPIO_SetValue(s_esp32_wifimanager_gpio_led, s_esp32_wifimanager_led_status);
-    ESP32_GPIO_SetDebug(true);
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
+
+    wm->led_status = !wm->led_status;
+    ESP32_GPIO_SetValue(wm->gpio_led, wm->led_status);
 }
 
 static void s_esp32_wifimanager_wifi_connect_check_cb(void* pArg)
 {
     //WIFI CONNECTED CHECK CB
+    //STATE MACHINE DECIDES WHAT TO DO
 
-    if(s_wifi_connected)
-    {
-        //DO NOTHING
-        //STATE MACHINE WILL TAKE CARE OF IT      
-        return;
-    }
+    esp32_wifimanager_t* wm = (esp32_wifimanager_t*)pArg;
 
-    //WIFI NOT CONNECTED
-    //SET STATE TO ESP32_WIFIMANAGER_STATE_CONNECTING
-    s_state = ESP32_WIFIMANAGER_STATE_CONNECTING;
+    s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_CONNECT_CHECK, 0);
 }
 
-static esp_err_t s_esp32_wifimanager_wifi_evt_handler(void* ctx, system_event_t* evt)
+esp_err_t ESP32_WIFIMANAGER_CTX_DriverEvent(esp32_wifimanager_t* wm, system_event_t* evt)
 {
-    //WIFI EVENT HANDLER
+    //WIFI EVENT HANDLER. DRIVER EVENT CONTEXT OF THE RADIO wm IS BOUND TO
+
+    esp32_wifimanager_fast_connect_t ap = {0};
 
     switch(evt->event_id)
     {
         case SYSTEM_EVENT_WIFI_READY:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_WIFI_READY\n");
+            ESP32_WIFIMANAGER_LOGI(EVT_WIFI_READY, 0, 0);
             break;
         
         case SYSTEM_EVENT_SCAN_DONE:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_SCAN_DONE\n");
+            ESP32_WIFIMANAGER_LOGI(EVT_SCAN_DONE, 0, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_SCAN_DONE, 0);
             break;
         
         case SYSTEM_EVENT_STA_START:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_STA_START\n");
+            ESP32_WIFIMANAGER_LOGI(EVT_STA_START, 0, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_STA_START, 0);
             break;
 
         case SYSTEM_EVENT_STA_CONNECTED:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_STA_CONNECTED\n");
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SSID : %s\n", 
-                                            (evt->event_info).connected.ssid);
+            ESP32_WIFIMANAGER_LOGI(EVT_STA_CONNECTED,
+                                    ESP32_WIFIMANAGER_LOG_Hash((evt->event_info).connected.ssid,
+                                                                (evt->event_info).connected.ssid_len),
+                                    (evt->event_info).connected.channel);
+            //KEEP AP DETAILS FOR FAST RECONNECT. THE MANAGER TASK MAY BE READING
+            //THE LAST ONES, SO THEY ARE SWAPPED IN WHOLE UNDER THE LOCK
+            memcpy(ap.ssid,
+                    (evt->event_info).connected.ssid,
+                    ((evt->event_info).connected.ssid_len < ESP32_WIFIMANAGER_SSID_LEN) ?
+                        (evt->event_info).connected.ssid_len : ESP32_WIFIMANAGER_SSID_LEN);
+            memcpy(ap.bssid, (evt->event_info).connected.bssid, 6);
+            ap.channel = (evt->event_info).connected.channel;
+            ap.authmode = (evt->event_info).connected.authmode;
+            portENTER_CRITICAL(&wm->drv_lock);
+            memcpy(&wm->fast_connect_pending, &ap, sizeof(esp32_wifimanager_fast_connect_t));
+            portEXIT_CRITICAL(&wm->drv_lock);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_STA_CONNECTED, 0);
             break;
         
         case SYSTEM_EVENT_STA_DISCONNECTED:
@@ -533,61 +4773,72 @@ static esp_err_t s_esp32_wifimanager_wifi_evt_handler(void* ctx, system_event_t*
             //SEND THE WRONG PASSWORD TO EXITING SSID)
             //IT COULD HAPPEN THAT STA_DISCONNECT IS NEVER CALLED SO WE NEED
             //THE WIFI CONNECTED TIMER ALSO
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_STA_DISCONNECTED\n");
-            s_state = ESP32_WIFIMANAGER_STATE_DISCONNECTED;
+            ESP32_WIFIMANAGER_LOGI(EVT_STA_DISCONNECTED, (evt->event_info).disconnected.reason, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_STA_DISCONNECTED,
+                                            (evt->event_info).disconnected.reason);
             break;
         
         case SYSTEM_EVENT_STA_GOT_IP:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_STA_GOT_IP\n");
-            ets_printf(ESP32_WIFIMANAGER_TAG" : IP : %u.%u.%u.%u\n",
-                                        ((evt->event_info).got_ip.ip_info.ip.addr & 0x000000FF),
-                                        ((evt->event_info).got_ip.ip_info.ip.addr & 0x0000FF00) >> 8,
-                                        ((evt->event_info).got_ip.ip_info.ip.addr & 0x00FF0000) >> 16,
-                                        ((evt->event_info).got_ip.ip_info.ip.addr & 0xFF000000) >> 24);
-            s_state = ESP32_WIFIMANAGER_STATE_CONNECTED;
+            ESP32_WIFIMANAGER_LOGI(EVT_STA_GOT_IP, (evt->event_info).got_ip.ip_info.ip.addr, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_STA_GOT_IP,
+                                            (evt->event_info).got_ip.ip_info.ip.addr);
+            break;
+        
+        case SYSTEM_EVENT_AP_STACONNECTED:
+            ESP32_WIFIMANAGER_LOGI(EVT_AP_STACONNECTED, 0, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_AP_CLIENT, 1);
+            break;
+
+        case SYSTEM_EVENT_AP_STADISCONNECTED:
+            ESP32_WIFIMANAGER_LOGI(EVT_AP_STADISCONNECTED, 0, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_AP_CLIENT, 0);
             break;
         
         default:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : EVT_UNKNOWN\n");
+            ESP32_WIFIMANAGER_LOGD(EVT_UNKNOWN, evt->event_id, 0);
             break;
     }
     return ESP_OK;
 }
 
-static void s_esp32_wifimanager_smartconfig_cb(smartconfig_status_t status, void *pdata)
+void ESP32_WIFIMANAGER_CTX_SmartconfigEvent(esp32_wifimanager_t* wm, smartconfig_status_t status, void* pdata)
 {
-    //ESP32 SMARTCOFIG EVENT CB FUNCTION
+    //ESP32 SMARTCOFIG EVENT CB FUNCTION. ROUTED BY THE RADIO wm IS BOUND TO
+    wifi_config_t* wifi_config;
 
     switch(status)
     {
         case SC_STATUS_WAIT:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: SC_STATUS_WAIT\n");
+            ESP32_WIFIMANAGER_LOGI(SC_WAIT, 0, 0);
             break;
         
         case SC_STATUS_FIND_CHANNEL:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: SC_STATUS_FIND_CHANNEL\n");
+            ESP32_WIFIMANAGER_LOGI(SC_FIND_CHANNEL, 0, 0);
             break;
         
         case SC_STATUS_GETTING_SSID_PSWD:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: SC_STATUS_GETTING_SSID_PSWD\n");
+            ESP32_WIFIMANAGER_LOGI(SC_GETTING_SSID_PSWD, 0, 0);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_SC_LOCKED, 0);
             break;
 
         case SC_STATUS_LINK:
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: SC_STATUS_LINK\n");
-            wifi_config_t *wifi_config = pdata;
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: SSID = %s\n", wifi_config->sta.ssid);
-            ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: PASSWORD = %s\n", wifi_config->sta.password);
-            esp_wifi_disconnect();
-            esp_wifi_set_config(ESP_IF_WIFI_STA, wifi_config);
-            esp_wifi_connect();
+            wifi_config = pdata;
+            //PASSWORD IS NEVER LOGGED, ONLY ITS LENGTH
+            ESP32_WIFIMANAGER_LOGI(SC_LINK,
+                                    ESP32_WIFIMANAGER_LOG_Hash(wifi_config->sta.ssid, ESP32_WIFIMANAGER_SSID_LEN),
+                                    strnlen((const char*)wifi_config->sta.password, ESP32_WIFIMANAGER_SSID_PWD_LEN));
+            portENTER_CRITICAL(&wm->drv_lock);
+            memcpy(&wm->sc_config, wifi_config, sizeof(wifi_config_t));
+            portEXIT_CRITICAL(&wm->drv_lock);
+            s_esp32_wifimanager_post_evt(wm, ESP32_WIFIMANAGER_EVT_SC_LINK, 0);
             break;
 
         case SC_STATUS_LINK_OVER:
             if(pdata != NULL)
             {
-                uint8_t ip[4] = {0};
-                memcpy(ip, (uint8_t* )pdata, 4);
-                ets_printf(ESP32_WIFIMANAGER_TAG" : SMARTCONFIG: IP = %u.%u.%u.%u\n", ip[0], ip[1], ip[2], ip[3]);
+                uint32_t ip = 0;
+                memcpy(&ip, (uint8_t* )pdata, 4);
+                ESP32_WIFIMANAGER_LOGI(SC_LINK_OVER, ip, 0);
             }
             break;
     }
@@ -0,0 +1,362 @@
+/**************************************************
+* ESP32 WIFI-MANAGER FLASH / EEPROM CREDENTIAL LOG
+*
+* SEE ESP32_WIFIMANAGER_CREDLOG.h
+*
+* ONLY CALLED FROM THE CONTEXT OF THE INSTANCE THAT
+* OWNS THE LOG
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_CREDLOG.h"
+#include "esp_spi_flash.h"
+#include "esp_timer.h"
+#include "rom/crc.h"
+#include <stddef.h>
+#include <string.h>
+
+#define CREDLOG_ERASED_WORD         (0xFFFFFFFF)
+#define CREDLOG_FILL_CHUNK          (32)
+
+//INTERNAL FUNCTIONS
+static esp_err_t s_credlog_spi_read(uint32_t addr, void* data, size_t len);
+static esp_err_t s_credlog_spi_write(uint32_t addr, const void* data, size_t len);
+static esp_err_t s_credlog_spi_erase(uint32_t addr, size_t len);
+static uint32_t s_credlog_page_addr(esp32_wifimanager_credlog_t* credlog, uint32_t page);
+static uint32_t s_credlog_record_addr(esp32_wifimanager_credlog_t* credlog, uint32_t page, uint32_t slot);
+static bool s_credlog_read_page_hdr(esp32_wifimanager_credlog_t* credlog,
+                                    uint32_t page,
+                                    esp32_wifimanager_credlog_page_hdr_t* hdr);
+static bool s_credlog_slot_empty(esp32_wifimanager_credlog_t* credlog, uint32_t page, uint32_t slot);
+static bool s_credlog_read_record(esp32_wifimanager_credlog_t* credlog,
+                                    uint32_t page,
+                                    uint32_t slot,
+                                    esp32_wifimanager_credlog_record_t* record);
+static bool s_credlog_write_verified(esp32_wifimanager_credlog_t* credlog, uint32_t addr, const void* data, size_t len);
+static esp_err_t s_credlog_erase_page(esp32_wifimanager_credlog_t* credlog, uint32_t page);
+static uint32_t s_credlog_record_crc(const esp32_wifimanager_credlog_record_t* record);
+
+static const esp32_wifimanager_storage_ops_t s_credlog_spi_ops = {
+    .read = s_credlog_spi_read,
+    .write = s_credlog_spi_write,
+    .erase = s_credlog_spi_erase,
+    .page_size = SPI_FLASH_SEC_SIZE
+};
+
+const esp32_wifimanager_storage_ops_t* ESP32_WIFIMANAGER_CREDLOG_SpiFlashOps(void)
+{
+    //BUILT IN ESP32 SPI FLASH ACCESS
+
+    return &s_credlog_spi_ops;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Open(esp32_wifimanager_credlog_t* credlog,
+                                            const esp32_wifimanager_storage_ops_t* ops,
+                                            uint32_t start_addr,
+                                            uint32_t end_addr)
+{
+    //LOCATE ACTIVE PAGE, ITS TAIL AND THE LATEST VALID RECORD
+
+    esp32_wifimanager_credlog_page_hdr_t hdr;
+    int64_t start_us = esp_timer_get_time();
+    uint32_t page;
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t mid;
+    uint32_t slot;
+
+    credlog->open = false;
+    credlog->have_latest = false;
+    credlog->active_page = -1;
+    credlog->tail = 0;
+
+    if(ops == NULL || ops->read == NULL || ops->write == NULL || ops->page_size == 0 ||
+        end_addr <= start_addr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(ops->erase != NULL && (start_addr % ops->page_size) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    credlog->ops = ops;
+    credlog->start = start_addr;
+    credlog->page_count = (end_addr - start_addr) / ops->page_size;
+    credlog->records_per_page = (ops->page_size - sizeof(esp32_wifimanager_credlog_page_hdr_t)) /
+                                    sizeof(esp32_wifimanager_credlog_record_t);
+    if(ops->page_size <= sizeof(esp32_wifimanager_credlog_page_hdr_t) ||
+        credlog->page_count < 2 || credlog->records_per_page == 0)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    credlog->stats.boot_reads = 0;
+
+    //ACTIVE PAGE = VALID HEADER WITH HIGHEST SEQ
+    for(page = 0; page < credlog->page_count; page++)
+    {
+        if(s_credlog_read_page_hdr(credlog, page, &hdr) &&
+            (credlog->active_page < 0 || hdr.seq > credlog->active_seq))
+        {
+            credlog->active_page = page;
+            credlog->active_seq = hdr.seq;
+        }
+    }
+    credlog->open = true;
+
+    if(credlog->active_page >= 0)
+    {
+        //SLOTS ARE FILLED IN ORDER. FIND FIRST EMPTY ONE
+        lo = 0;
+        hi = credlog->records_per_page;
+        while(lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            if(s_credlog_slot_empty(credlog, credlog->active_page, mid))
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        credlog->tail = lo;
+
+        //NEWEST VALID RECORD. TORN ONES ARE SKIPPED
+        for(slot = credlog->tail; slot > 0; slot--)
+        {
+            if(s_credlog_read_record(credlog, credlog->active_page, slot - 1, &credlog->latest))
+            {
+                credlog->have_latest = true;
+                break;
+            }
+            credlog->stats.torn_records++;
+        }
+    }
+
+    credlog->stats.boot_read_us = (uint32_t)(esp_timer_get_time() - start_us);
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Read(esp32_wifimanager_credlog_t* credlog, uint8_t* ssid, uint8_t* pwd)
+{
+    //COPY OUT LATEST CREDENTIALS
+
+    if(!credlog->open)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if(!credlog->have_latest)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(ssid, credlog->latest.ssid, ESP32_WIFIMANAGER_SSID_LEN);
+    memcpy(pwd, credlog->latest.pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Save(esp32_wifimanager_credlog_t* credlog, const uint8_t* ssid, const uint8_t* pwd)
+{
+    //APPEND CREDENTIALS UNLESS THEY MATCH THE LATEST RECORD
+
+    esp32_wifimanager_credlog_record_t record;
+    esp32_wifimanager_credlog_page_hdr_t hdr;
+    uint32_t page;
+    esp_err_t err;
+
+    if(!credlog->open)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(credlog->have_latest &&
+        memcmp(credlog->latest.ssid, ssid, ESP32_WIFIMANAGER_SSID_LEN) == 0 &&
+        memcmp(credlog->latest.pwd, pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN) == 0)
+    {
+        credlog->stats.coalesced++;
+        return ESP_OK;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.magic = ESP32_WIFIMANAGER_CREDLOG_RECORD_MAGIC;
+    record.seq = credlog->have_latest ? (credlog->latest.seq + 1) : 0;
+    memcpy(record.ssid, ssid, ESP32_WIFIMANAGER_SSID_LEN);
+    memcpy(record.pwd, pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+    record.crc = s_credlog_record_crc(&record);
+
+    //APPEND TO ACTIVE PAGE. A SLOT THAT FAILS VERIFY IS LEFT BEHIND
+    while(credlog->active_page >= 0 && credlog->tail < credlog->records_per_page)
+    {
+        if(s_credlog_write_verified(credlog,
+                                    s_credlog_record_addr(credlog, credlog->active_page, credlog->tail),
+                                    &record, sizeof(record)))
+        {
+            credlog->tail++;
+            credlog->stats.appends++;
+            credlog->latest = record;
+            credlog->have_latest = true;
+            return ESP_OK;
+        }
+        credlog->tail++;
+        credlog->stats.torn_records++;
+    }
+
+    //ACTIVE PAGE FULL (OR LOG EMPTY). MOVE TO NEXT PAGE
+    //RECORD FIRST, HEADER LAST, SO THE SWITCH IS ATOMIC
+    page = (credlog->active_page < 0) ? 0 : ((credlog->active_page + 1) % credlog->page_count);
+    err = s_credlog_erase_page(credlog, page);
+    if(err != ESP_OK)
+    {
+        return err;
+    }
+    if(!s_credlog_write_verified(credlog, s_credlog_record_addr(credlog, page, 0), &record, sizeof(record)))
+    {
+        credlog->stats.torn_records++;
+        return ESP_FAIL;
+    }
+    hdr.magic = ESP32_WIFIMANAGER_CREDLOG_PAGE_MAGIC;
+    hdr.seq = (credlog->active_page < 0) ? 0 : (credlog->active_seq + 1);
+    hdr.reserved = CREDLOG_ERASED_WORD;
+    hdr.crc = crc32_le(0, (const uint8_t*)&hdr, offsetof(esp32_wifimanager_credlog_page_hdr_t, crc));
+    if(!s_credlog_write_verified(credlog, s_credlog_page_addr(credlog, page), &hdr, sizeof(hdr)))
+    {
+        return ESP_FAIL;
+    }
+
+    credlog->active_page = page;
+    credlog->active_seq = hdr.seq;
+    credlog->tail = 1;
+    credlog->stats.appends++;
+    credlog->latest = record;
+    credlog->have_latest = true;
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_CREDLOG_GetStats(esp32_wifimanager_credlog_t* credlog, esp32_wifimanager_credlog_stats_t* stats)
+{
+    //GET CREDENTIAL LOG COUNTERS
+
+    *stats = credlog->stats;
+}
+
+static esp_err_t s_credlog_spi_read(uint32_t addr, void* data, size_t len)
+{
+    return spi_flash_read(addr, data, len);
+}
+
+static esp_err_t s_credlog_spi_write(uint32_t addr, const void* data, size_t len)
+{
+    return spi_flash_write(addr, data, len);
+}
+
+static esp_err_t s_credlog_spi_erase(uint32_t addr, size_t len)
+{
+    return spi_flash_erase_range(addr, len);
+}
+
+static uint32_t s_credlog_page_addr(esp32_wifimanager_credlog_t* credlog, uint32_t page)
+{
+    return credlog->start + page * credlog->ops->page_size;
+}
+
+static uint32_t s_credlog_record_addr(esp32_wifimanager_credlog_t* credlog, uint32_t page, uint32_t slot)
+{
+    return s_credlog_page_addr(credlog, page) + sizeof(esp32_wifimanager_credlog_page_hdr_t) +
+            slot * sizeof(esp32_wifimanager_credlog_record_t);
+}
+
+static bool s_credlog_read_page_hdr(esp32_wifimanager_credlog_t* credlog,
+                                    uint32_t page,
+                                    esp32_wifimanager_credlog_page_hdr_t* hdr)
+{
+    //TRUE IF PAGE HAS A VALID HEADER
+
+    credlog->stats.boot_reads++;
+    if((*credlog->ops->read)(s_credlog_page_addr(credlog, page), hdr, sizeof(*hdr)) != ESP_OK)
+    {
+        return false;
+    }
+    return (hdr->magic == ESP32_WIFIMANAGER_CREDLOG_PAGE_MAGIC &&
+            hdr->crc == crc32_le(0, (const uint8_t*)hdr, offsetof(esp32_wifimanager_credlog_page_hdr_t, crc)));
+}
+
+static bool s_credlog_slot_empty(esp32_wifimanager_credlog_t* credlog, uint32_t page, uint32_t slot)
+{
+    //SLOT NEVER WRITTEN (ERASED MAGIC)
+    //A TORN WRITE WHICH GOT AS FAR AS THE MAGIC COUNTS AS USED
+
+    uint32_t magic;
+
+    credlog->stats.boot_reads++;
+    if((*credlog->ops->read)(s_credlog_record_addr(credlog, page, slot), &magic, sizeof(magic)) != ESP_OK)
+    {
+        return false;
+    }
+    return (magic == CREDLOG_ERASED_WORD);
+}
+
+static bool s_credlog_read_record(esp32_wifimanager_credlog_t* credlog,
+                                    uint32_t page,
+                                    uint32_t slot,
+                                    esp32_wifimanager_credlog_record_t* record)
+{
+    //TRUE IF SLOT HOLDS A COMPLETE RECORD
+
+    credlog->stats.boot_reads++;
+    if((*credlog->ops->read)(s_credlog_record_addr(credlog, page, slot), record, sizeof(*record)) != ESP_OK)
+    {
+        return false;
+    }
+    return (record->magic == ESP32_WIFIMANAGER_CREDLOG_RECORD_MAGIC &&
+            record->crc == s_credlog_record_crc(record));
+}
+
+static bool s_credlog_write_verified(esp32_wifimanager_credlog_t* credlog, uint32_t addr, const void* data, size_t len)
+{
+    //WRITE THEN READ BACK
+
+    if(len > sizeof(credlog->scratch) ||
+        (*credlog->ops->write)(addr, data, len) != ESP_OK ||
+        (*credlog->ops->read)(addr, &credlog->scratch, len) != ESP_OK)
+    {
+        return false;
+    }
+    return (memcmp(&credlog->scratch, data, len) == 0);
+}
+
+static esp_err_t s_credlog_erase_page(esp32_wifimanager_credlog_t* credlog, uint32_t page)
+{
+    //ERASE ONE PAGE. BYTE WRITABLE STORAGE IS FILLED WITH 0xFF
+
+    uint8_t fill[CREDLOG_FILL_CHUNK];
+    uint32_t addr = s_credlog_page_addr(credlog, page);
+    uint32_t end = addr + credlog->ops->page_size;
+    uint32_t len;
+    esp_err_t err;
+
+    credlog->stats.erases++;
+    if(credlog->ops->erase != NULL)
+    {
+        return (*credlog->ops->erase)(addr, credlog->ops->page_size);
+    }
+
+    memset(fill, 0xFF, sizeof(fill));
+    for(; addr < end; addr += len)
+    {
+        len = ((end - addr) < sizeof(fill)) ? (end - addr) : sizeof(fill);
+        err = (*credlog->ops->write)(addr, fill, len);
+        if(err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+static uint32_t s_credlog_record_crc(const esp32_wifimanager_credlog_record_t* record)
+{
+    //CRC OVER EVERYTHING BEFORE THE CRC FIELD
+
+    return crc32_le(0, (const uint8_t*)record, offsetof(esp32_wifimanager_credlog_record_t, crc));
+}
@@ -0,0 +1,88 @@
+/**************************************************
+* ESP32 WIFI-MANAGER FLASH / EEPROM CREDENTIAL LOG
+*
+* APPEND ONLY, CRC PROTECTED CREDENTIAL RECORDS IN A
+* USER GIVEN STORAGE REGION. THE REGION IS SPLIT IN
+* PAGES (ERASE UNITS) USED ROUND ROBIN, SO ERASES ARE
+* SPREAD OVER THE WHOLE REGION
+*
+*  PAGE   [HEADER][RECORD 0][RECORD 1]...
+*  HEADER MAGIC, PAGE SEQ, CRC
+*  RECORD MAGIC, SEQ, SSID, PASSWORD, CRC
+*
+* - OPEN READS THE PAGE HEADERS AND BINARY SEARCHES
+*   THE ACTIVE PAGE FOR ITS TAIL, SO THE NUMBER OF
+*   READS AT BOOT DOES NOT GROW WITH SAVE HISTORY.
+*   AFTER OPEN, THE TAIL IS KEPT IN RAM
+* - SAVING THE SAME CREDENTIALS AS THE LAST RECORD
+*   WRITES NOTHING
+* - EVERY WRITE IS READ BACK. A TORN OR BAD RECORD
+*   IS SKIPPED, NEVER REWRITTEN IN PLACE
+* - ON PAGE CHANGE THE FIRST RECORD IS WRITTEN BEFORE
+*   THE PAGE HEADER. POWER LOSS IN BETWEEN LEAVES THE
+*   OLD PAGE ACTIVE
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_CREDLOG_
+#define _ESP32_WIFIMANAGER_CREDLOG_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ESP32_WIFIMANAGER_CREDLOG_PAGE_MAGIC        (0x57434C50) //"WCLP"
+#define ESP32_WIFIMANAGER_CREDLOG_RECORD_MAGIC      (0x57434C52) //"WCLR"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t reserved;
+    uint32_t crc;
+}esp32_wifimanager_credlog_page_hdr_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    uint32_t crc;
+}esp32_wifimanager_credlog_record_t;
+
+//ONE OPEN LOG. EACH MANAGER INSTANCE KEEPS ITS OWN
+typedef struct
+{
+    const esp32_wifimanager_storage_ops_t* ops;
+    uint32_t start;
+    uint32_t page_count;
+    uint32_t records_per_page;
+    bool open;
+
+    //ACTIVE PAGE (-1 = LOG EMPTY) AND FIRST FREE RECORD SLOT IN IT
+    int32_t active_page;
+    uint32_t active_seq;
+    uint32_t tail;
+
+    //LATEST VALID RECORD
+    esp32_wifimanager_credlog_record_t latest;
+    bool have_latest;
+
+    //SCRATCH FOR READ BACK
+    esp32_wifimanager_credlog_record_t scratch;
+
+    esp32_wifimanager_credlog_stats_t stats;
+}esp32_wifimanager_credlog_t;
+
+//ESP32 SPI FLASH ACCESS (ADDRESSES ARE ABSOLUTE FLASH OFFSETS)
+const esp32_wifimanager_storage_ops_t* ESP32_WIFIMANAGER_CREDLOG_SpiFlashOps(void);
+
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Open(esp32_wifimanager_credlog_t* credlog,
+                                            const esp32_wifimanager_storage_ops_t* ops,
+                                            uint32_t start_addr,
+                                            uint32_t end_addr);
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Read(esp32_wifimanager_credlog_t* credlog, uint8_t* ssid, uint8_t* pwd);
+esp_err_t ESP32_WIFIMANAGER_CREDLOG_Save(esp32_wifimanager_credlog_t* credlog, const uint8_t* ssid, const uint8_t* pwd);
+void ESP32_WIFIMANAGER_CREDLOG_GetStats(esp32_wifimanager_credlog_t* credlog, esp32_wifimanager_credlog_stats_t* stats);
+
+#endif
@@ -0,0 +1,320 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CAPTIVE PORTAL DNS RESPONDER
+*
+* SEE ESP32_WIFIMANAGER_DNS.h
+*
+* MEMORY BUDGET
+*   PACKET BUFFER   : ESP32_WIFIMANAGER_DNS_BUF_LEN (IN THE HANDLE)
+*   ANSWER RECORD   : 16 BYTES (IN THE HANDLE)
+*   TASK STACK      : ESP32_WIFIMANAGER_DNS_STACK_SIZE
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_DNS.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <ctype.h>
+
+#define DNS_HDR_LEN         (12)
+#define DNS_ANSWER_LEN      ESP32_WIFIMANAGER_DNS_ANSWER_LEN
+#define DNS_NAME_MAX        (255)
+#define DNS_TTL_OFFSET      (6)
+#define DNS_ADDR_OFFSET     (12)
+#define DNS_TYPE_A          (1)
+#define DNS_TYPE_ANY        (255)
+#define DNS_CLASS_IN        (1)
+#define DNS_CLASS_ANY       (255)
+#define DNS_RCODE_FORMERR   (1)
+#define DNS_RCODE_NOTIMP    (4)
+
+//INTERNAL VARIABLES
+//ANSWER RECORD TEMPLATE, COPIED INTO EACH HANDLE BY INIT
+static const uint8_t s_dns_answer[DNS_ANSWER_LEN] = {0xC0, DNS_HDR_LEN,
+                                                0x00, DNS_TYPE_A,
+                                                0x00, DNS_CLASS_IN,
+                                                (ESP32_WIFIMANAGER_DNS_TTL_S >> 24) & 0xFF,
+                                                (ESP32_WIFIMANAGER_DNS_TTL_S >> 16) & 0xFF,
+                                                (ESP32_WIFIMANAGER_DNS_TTL_S >> 8) & 0xFF,
+                                                ESP32_WIFIMANAGER_DNS_TTL_S & 0xFF,
+                                                0x00, 0x04,
+                                                192, 168, 4, 1};
+
+//OS CONNECTIVITY CHECK HOSTNAMES, DNS WIRE FORMAT
+static const char* const s_dns_probe_names[] =
+{
+    "\x11" "connectivitycheck" "\x07" "gstatic" "\x03" "com",
+    "\x11" "connectivitycheck" "\x07" "android" "\x03" "com",
+    "\x08" "clients3" "\x06" "google" "\x03" "com",
+    "\x07" "captive" "\x05" "apple" "\x03" "com",
+    "\x03" "www" "\x05" "apple" "\x03" "com",
+    "\x03" "www" "\x0F" "msftconnecttest" "\x03" "com",
+    "\x03" "www" "\x08" "msftncsi" "\x03" "com",
+    "\x03" "dns" "\x08" "msftncsi" "\x03" "com",
+    "\x0C" "detectportal" "\x07" "firefox" "\x03" "com",
+    "\x07" "nmcheck" "\x05" "gnome" "\x03" "org",
+    "\x12" "connectivity-check" "\x06" "ubuntu" "\x03" "com"
+};
+
+//INTERNAL FUNCTIONS
+static void s_dns_task(void* pArg);
+static bool s_dns_is_probe(const uint8_t* name, size_t len);
+static size_t s_dns_error(esp32_wifimanager_dns_t* dns, uint8_t* msg, uint8_t rcode);
+
+void ESP32_WIFIMANAGER_DNS_Init(esp32_wifimanager_dns_t* dns, uint16_t port)
+{
+    //RESET HANDLE. ANSWERS 192.168.4.1 UNTIL SETADDRESS
+
+    memset(dns, 0, sizeof(*dns));
+    dns->fd = -1;
+    dns->port = (port != 0) ? port : ESP32_WIFIMANAGER_DNS_PORT;
+    memcpy(dns->answer, s_dns_answer, DNS_ANSWER_LEN);
+}
+
+esp_err_t ESP32_WIFIMANAGER_DNS_Start(esp32_wifimanager_dns_t* dns)
+{
+    //BIND THE PORT AND START DNS TASK, ANSWERING WITH THE ADDRESS FROM SETADDRESS
+    //BINDING HERE, NOT IN THE TASK, LETS A SECOND RESPONDER ON THE SAME PORT FAIL LOUDLY
+    //A TASK STILL WINDING DOWN FROM A STOP IS KEPT RUNNING
+
+    struct sockaddr_in addr;
+
+    dns->running = true;
+
+    if(dns->task != NULL)
+    {
+        return ESP_OK;
+    }
+
+    dns->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(dns->fd < 0)
+    {
+        dns->running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(dns->port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(dns->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(dns->fd);
+        dns->fd = -1;
+        dns->running = false;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(xTaskCreate(s_dns_task,
+                    "wifimgr_dns",
+                    ESP32_WIFIMANAGER_DNS_STACK_SIZE,
+                    dns,
+                    ESP32_WIFIMANAGER_DNS_TASK_PRIORITY,
+                    &dns->task) != pdPASS)
+    {
+        close(dns->fd);
+        dns->fd = -1;
+        dns->running = false;
+        dns->task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_DNS_Stop(esp32_wifimanager_dns_t* dns)
+{
+    //ASK DNS TASK TO EXIT
+    //TASK NOTICES WITHIN ONE SELECT TIMEOUT
+
+    dns->running = false;
+}
+
+void ESP32_WIFIMANAGER_DNS_GetStats(esp32_wifimanager_dns_t* dns, esp32_wifimanager_dns_stats_t* stats)
+{
+    //GET DNS RESPONDER COUNTERS
+
+    *stats = dns->stats;
+}
+
+void ESP32_WIFIMANAGER_DNS_SetAddress(esp32_wifimanager_dns_t* dns, uint32_t ip)
+{
+    //PATCH THE ADDRESS INTO THE ANSWER RECORD (ONCE PER START)
+
+    memcpy(&dns->answer[DNS_ADDR_OFFSET], &ip, 4);
+}
+
+size_t ESP32_WIFIMANAGER_DNS_Reply(esp32_wifimanager_dns_t* dns, uint8_t* msg, size_t len, size_t size)
+{
+    //TURN THE QUERY IN msg INTO ITS REPLY, IN PLACE
+
+    size_t pos = DNS_HDR_LEN;
+    size_t name_len;
+    uint16_t qtype;
+    uint16_t qclass;
+    bool answer;
+
+    if(len < DNS_HDR_LEN || len > size || (msg[2] & 0x80) != 0)
+    {
+        //TOO SHORT, OR A RESPONSE. NEVER ANSWER THOSE
+        return 0;
+    }
+    if((msg[2] & 0x78) != 0)
+    {
+        return s_dns_error(dns, msg, DNS_RCODE_NOTIMP);
+    }
+    if(msg[4] != 0 || msg[5] != 1)
+    {
+        return s_dns_error(dns, msg, DNS_RCODE_FORMERR);
+    }
+
+    //QNAME: UNCOMPRESSED LABELS UP TO THE ROOT, AT MOST DNS_NAME_MAX WITH THE ROOT BYTE
+    while(pos < len && msg[pos] != 0)
+    {
+        if((msg[pos] & 0xC0) != 0)
+        {
+            return s_dns_error(dns, msg, DNS_RCODE_FORMERR);
+        }
+        pos += msg[pos] + 1;
+        if(pos - DNS_HDR_LEN >= DNS_NAME_MAX)
+        {
+            return s_dns_error(dns, msg, DNS_RCODE_FORMERR);
+        }
+    }
+    if(pos + 5 > len)
+    {
+        return s_dns_error(dns, msg, DNS_RCODE_FORMERR);
+    }
+    name_len = pos - DNS_HDR_LEN;
+    pos++;
+    qtype = (msg[pos] << 8) | msg[pos + 1];
+    qclass = (msg[pos + 2] << 8) | msg[pos + 3];
+    pos += 4;
+
+    answer = (qtype == DNS_TYPE_A || qtype == DNS_TYPE_ANY) &&
+                (qclass == DNS_CLASS_IN || qclass == DNS_CLASS_ANY);
+    if(answer && pos + DNS_ANSWER_LEN > size)
+    {
+        return 0;
+    }
+
+    //HEADER: QR, AA, RD AS ASKED, RA. ONE QUESTION, ONE OR NO ANSWER
+    msg[2] = 0x84 | (msg[2] & 0x01);
+    msg[3] = 0x80;
+    msg[6] = 0;
+    msg[7] = answer ? 1 : 0;
+    memset(&msg[8], 0, 4);
+
+    dns->stats.queries++;
+    if(!answer)
+    {
+        dns->stats.no_data++;
+        return pos;
+    }
+
+    memcpy(&msg[pos], dns->answer, DNS_ANSWER_LEN);
+    if(s_dns_is_probe(&msg[DNS_HDR_LEN], name_len))
+    {
+        memset(&msg[pos + DNS_TTL_OFFSET], 0, 4);
+        dns->stats.probes++;
+    }
+    dns->stats.answered++;
+    return pos + DNS_ANSWER_LEN;
+}
+
+static void s_dns_task(void* pArg)
+{
+    //DNS SERVER TASK. ONE DATAGRAM AT A TIME, REPLY SENT BEFORE THE NEXT IS READ
+    //THE SOCKET WAS BOUND BY START
+
+    esp32_wifimanager_dns_t* dns = pArg;
+    int fd = dns->fd;
+    int n;
+    size_t reply_len;
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+    struct timeval tv;
+    fd_set fds;
+    int64_t start_us;
+    uint32_t service_us;
+
+    while(dns->running)
+    {
+        //WAIT FOR A QUERY, WAKING UP PERIODICALLY TO CHECK FOR STOP
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        if(select(fd + 1, &fds, NULL, NULL, &tv) <= 0)
+        {
+            continue;
+        }
+
+        addr_len = sizeof(addr);
+        n = recvfrom(fd, dns->buf, sizeof(dns->buf), 0, (struct sockaddr*)&addr, &addr_len);
+        if(n <= 0)
+        {
+            continue;
+        }
+
+        start_us = esp_timer_get_time();
+        reply_len = ESP32_WIFIMANAGER_DNS_Reply(dns, dns->buf, (size_t)n, sizeof(dns->buf));
+        if(reply_len == 0)
+        {
+            dns->stats.dropped++;
+            continue;
+        }
+        if(sendto(fd, dns->buf, reply_len, 0, (struct sockaddr*)&addr, addr_len) != (int)reply_len)
+        {
+            dns->stats.dropped++;
+        }
+
+        service_us = (uint32_t)(esp_timer_get_time() - start_us);
+        if(service_us > dns->stats.max_service_us)
+        {
+            dns->stats.max_service_us = service_us;
+        }
+    }
+
+    close(fd);
+    dns->fd = -1;
+    dns->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static bool s_dns_is_probe(const uint8_t* name, size_t len)
+{
+    //WIRE FORMAT NAME IS ONE OF THE CONNECTIVITY CHECK HOSTS (CASE INSENSITIVE)
+    //LABEL LENGTH BYTES ARE < 64, SO tolower LEAVES THEM ALONE
+
+    uint8_t i;
+    size_t j;
+    const char* probe;
+
+    for(i = 0; i < sizeof(s_dns_probe_names) / sizeof(s_dns_probe_names[0]); i++)
+    {
+        probe = s_dns_probe_names[i];
+        if(strlen(probe) != len)
+        {
+            continue;
+        }
+        for(j = 0; j < len && tolower(name[j]) == probe[j]; j++)
+        {
+        }
+        if(j == len)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t s_dns_error(esp32_wifimanager_dns_t* dns, uint8_t* msg, uint8_t rcode)
+{
+    //HEADER ONLY REPLY WITH AN ERROR CODE. OPCODE AND RD ARE ECHOED
+
+    dns->stats.errors++;
+    msg[2] = 0x80 | (msg[2] & 0x79);
+    msg[3] = 0x80 | rcode;
+    memset(&msg[4], 0, 8);
+    return DNS_HDR_LEN;
+}
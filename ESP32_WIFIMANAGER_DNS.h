@@ -0,0 +1,62 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CAPTIVE PORTAL DNS RESPONDER
+*
+* UDP PORT 53 ON THE SOFTAP WHILE THE WEBCONFIG
+* PORTAL RUNS. EVERY A QUERY IS ANSWERED WITH THE
+* SOFTAP ADDRESS, SO PHONES' CONNECTIVITY CHECKS
+* LAND ON THE PORTAL AND THE OS OPENS IT
+*
+*   A / ANY (CLASS IN)      SOFTAP ADDRESS
+*   OTHER TYPES (AAAA...)   NOERROR, NO ANSWER, SO
+*                           CLIENTS FALL BACK TO A
+*   NOT A STANDARD QUERY    NOTIMP / FORMERR
+*
+* OS CONNECTIVITY CHECK NAMES (ANDROID, APPLE,
+* WINDOWS, FIREFOX, LINUX DESKTOPS) ARE ANSWERED
+* WITH TTL 0, SO THEY ARE LOOKED UP AGAIN AS SOON
+* AS THE DEVICE LEAVES PROVISIONING
+*
+* NO HEAP: THE REPLY IS BUILT IN THE RECEIVE BUFFER.
+* HEADER FLAGS AND COUNTS ARE PATCHED, THE QUESTION
+* IS KEPT AS IS AND A PREBUILT 16 BYTE ANSWER RECORD
+* IS APPENDED
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_DNS_
+#define _ESP32_WIFIMANAGER_DNS_
+
+#include "ESP32_WIFIMANAGER.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define ESP32_WIFIMANAGER_DNS_ANSWER_LEN    (16)
+
+//ONE RESPONDER. EACH WEBCONFIG PORTAL KEEPS ITS OWN
+typedef struct
+{
+    TaskHandle_t task;
+    volatile bool running;
+    int fd;
+    uint16_t port;
+    uint8_t buf[ESP32_WIFIMANAGER_DNS_BUF_LEN];
+    //ANSWER RECORD: NAME = POINTER TO THE QUESTION, TYPE A, CLASS IN, TTL, 4 BYTE ADDRESS
+    uint8_t answer[ESP32_WIFIMANAGER_DNS_ANSWER_LEN];
+    esp32_wifimanager_dns_stats_t stats;
+}esp32_wifimanager_dns_t;
+
+//port 0 = ESP32_WIFIMANAGER_DNS_PORT
+void ESP32_WIFIMANAGER_DNS_Init(esp32_wifimanager_dns_t* dns, uint16_t port);
+
+//START FAILS WITH ESP_ERR_INVALID_STATE IF THE PORT IS ALREADY TAKEN
+esp_err_t ESP32_WIFIMANAGER_DNS_Start(esp32_wifimanager_dns_t* dns);
+void ESP32_WIFIMANAGER_DNS_Stop(esp32_wifimanager_dns_t* dns);
+void ESP32_WIFIMANAGER_DNS_GetStats(esp32_wifimanager_dns_t* dns, esp32_wifimanager_dns_stats_t* stats);
+
+//REPLY BUILDING, NO SOCKETS (ALSO USED BY HOST BENCHMARKS)
+//THE OWNER SETS ITS RADIO'S SOFTAP ADDRESS BEFORE START. ip IS IN NETWORK ORDER. REPLY RETURNS THE REPLY LENGTH, 0 = DROP
+void ESP32_WIFIMANAGER_DNS_SetAddress(esp32_wifimanager_dns_t* dns, uint32_t ip);
+size_t ESP32_WIFIMANAGER_DNS_Reply(esp32_wifimanager_dns_t* dns, uint8_t* msg, size_t len, size_t size);
+
+#endif
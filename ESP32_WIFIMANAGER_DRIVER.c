@@ -0,0 +1,440 @@
+/**************************************************
+* ESP32 WIFI-MANAGER RADIO DRIVER TABLE
+*
+* SEE ESP32_WIFIMANAGER_DRIVER.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_DRIVER.h"
+#include "esp_event_loop.h"
+#include "lwip/netif.h"
+#include "lwip/dhcp.h"
+#include "lwip/prot/dhcp.h"
+#include "lwip/etharp.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+//INTERNAL TYPES
+//THE ESP32'S ONE RADIO. THE EVENT LOOP AND SMARTCONFIG CALLBACKS CARRY NO
+//INSTANCE, SO THEY ARE ROUTED THROUGH owner. calls COUNTS CALLBACKS STILL
+//USING THE OWNER THEY READ, SO UNBIND CAN WAIT THEM OUT
+typedef struct
+{
+    esp32_wifimanager_t* owner;
+    volatile uint32_t calls;
+    bool up;
+}driver_idf_t;
+
+//LWIP CALL RUN IN THE TCPIP THREAD (tcpip_api_call)
+typedef struct
+{
+    struct tcpip_api_call_data call;
+    tcpip_adapter_if_t iface;
+    ip4_addr_t ip;
+    bool found;
+}driver_idf_ip_call_t;
+
+//INTERNAL VARIABLES
+static driver_idf_t s_driver_idf;
+
+//INTERNAL FUNCTIONS
+static esp32_wifimanager_t* s_driver_idf_enter(void);
+static void s_driver_idf_leave(void);
+static esp_err_t s_driver_idf_evt_handler(void* ctx, system_event_t* evt);
+static void s_driver_idf_smartconfig_cb(smartconfig_status_t status, void* pdata);
+static esp_err_t s_driver_idf_ip_call(tcpip_api_call_fn fn, tcpip_adapter_if_t iface, uint32_t ip, bool* found);
+static struct netif* s_driver_idf_netif(tcpip_adapter_if_t iface);
+static err_t s_driver_idf_dhcp_stop_fn(struct tcpip_api_call_data* call);
+static err_t s_driver_idf_dhcp_renew_fn(struct tcpip_api_call_data* call);
+static err_t s_driver_idf_arp_probe_fn(struct tcpip_api_call_data* call);
+static err_t s_driver_idf_arp_lookup_fn(struct tcpip_api_call_data* call);
+
+static esp_err_t s_driver_idf_bind(void* ctx, esp32_wifimanager_t* wm)
+{
+    //FIRST INSTANCE TO BIND OWNS THE RADIO UNTIL IT UNBINDS
+
+    esp32_wifimanager_t* expected = NULL;
+
+    if(!__atomic_compare_exchange_n(&s_driver_idf.owner, &expected, wm, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+        expected != wm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+static void s_driver_idf_unbind(void* ctx, esp32_wifimanager_t* wm)
+{
+    //STOP ROUTING EVENTS TO wm, THEN WAIT FOR CALLBACKS THAT ALREADY READ IT
+
+    esp32_wifimanager_t* expected = wm;
+
+    if(!__atomic_compare_exchange_n(&s_driver_idf.owner, &expected, NULL, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+        return;
+    }
+    while(__atomic_load_n(&s_driver_idf.calls, __ATOMIC_SEQ_CST) != 0)
+    {
+        vTaskDelay(1);
+    }
+}
+
+static esp_err_t s_driver_idf_init(void* ctx)
+{
+    //WIFI STACK AND EVENT LOOP CAN ONLY BE INITIALIZED ONCE PER BOOT
+
+    wifi_init_config_t config = WIFI_INIT_CONFIG_DEFAULT();
+
+    if(s_driver_idf.up)
+    {
+        return ESP_OK;
+    }
+    s_driver_idf.up = true;
+
+    esp_wifi_init(&config);
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    return esp_event_loop_init(s_driver_idf_evt_handler, NULL);
+}
+
+static esp_err_t s_driver_idf_set_mode(void* ctx, wifi_mode_t mode)
+{
+    return esp_wifi_set_mode(mode);
+}
+
+static esp_err_t s_driver_idf_start(void* ctx)
+{
+    return esp_wifi_start();
+}
+
+static esp_err_t s_driver_idf_connect(void* ctx)
+{
+    return esp_wifi_connect();
+}
+
+static esp_err_t s_driver_idf_disconnect(void* ctx)
+{
+    return esp_wifi_disconnect();
+}
+
+static esp_err_t s_driver_idf_set_config(void* ctx, wifi_interface_t iface, wifi_config_t* config)
+{
+    return esp_wifi_set_config(iface, config);
+}
+
+static esp_err_t s_driver_idf_get_config(void* ctx, wifi_interface_t iface, wifi_config_t* config)
+{
+    return esp_wifi_get_config(iface, config);
+}
+
+static esp_err_t s_driver_idf_set_storage(void* ctx, wifi_storage_t storage)
+{
+    return esp_wifi_set_storage(storage);
+}
+
+static esp_err_t s_driver_idf_set_auto_connect(void* ctx, bool on)
+{
+    return esp_wifi_set_auto_connect(on);
+}
+
+static esp_err_t s_driver_idf_sta_get_ap_info(void* ctx, wifi_ap_record_t* ap)
+{
+    return esp_wifi_sta_get_ap_info(ap);
+}
+
+static esp_err_t s_driver_idf_set_ps(void* ctx, wifi_ps_type_t ps)
+{
+    return esp_wifi_set_ps(ps);
+}
+
+static esp_err_t s_driver_idf_get_ps(void* ctx, wifi_ps_type_t* ps)
+{
+    return esp_wifi_get_ps(ps);
+}
+
+static esp_err_t s_driver_idf_scan_start(void* ctx, const wifi_scan_config_t* config, bool block)
+{
+    return esp_wifi_scan_start(config, block);
+}
+
+static esp_err_t s_driver_idf_scan_stop(void* ctx)
+{
+    return esp_wifi_scan_stop();
+}
+
+static esp_err_t s_driver_idf_scan_get_ap_records(void* ctx, uint16_t* number, wifi_ap_record_t* records)
+{
+    return esp_wifi_scan_get_ap_records(number, records);
+}
+
+static esp_err_t s_driver_idf_smartconfig_start(void* ctx)
+{
+    esp_smartconfig_set_type(SC_TYPE_ESPTOUCH);
+    return esp_smartconfig_start(s_driver_idf_smartconfig_cb);
+}
+
+static esp_err_t s_driver_idf_smartconfig_stop(void* ctx)
+{
+    return esp_smartconfig_stop();
+}
+
+static esp_err_t s_driver_idf_dhcpc_start(void* ctx, tcpip_adapter_if_t iface)
+{
+    return tcpip_adapter_dhcpc_start(iface);
+}
+
+static esp_err_t s_driver_idf_dhcpc_stop(void* ctx, tcpip_adapter_if_t iface)
+{
+    //A CLIENT STARTED BY dhcp_renew IS UNKNOWN TO THE ADAPTER. STOP IT IN LWIP TOO
+
+    esp_err_t err = tcpip_adapter_dhcpc_stop(iface);
+
+    s_driver_idf_ip_call(s_driver_idf_dhcp_stop_fn, iface, 0, NULL);
+    return err;
+}
+
+static esp_err_t s_driver_idf_get_ip_info(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info)
+{
+    return tcpip_adapter_get_ip_info(iface, info);
+}
+
+static esp_err_t s_driver_idf_set_ip_info(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info)
+{
+    return tcpip_adapter_set_ip_info(iface, info);
+}
+
+static esp_err_t s_driver_idf_get_dns_info(void* ctx,
+                                            tcpip_adapter_if_t iface,
+                                            tcpip_adapter_dns_type_t type,
+                                            tcpip_adapter_dns_info_t* dns)
+{
+    return tcpip_adapter_get_dns_info(iface, type, dns);
+}
+
+static esp_err_t s_driver_idf_set_dns_info(void* ctx,
+                                            tcpip_adapter_if_t iface,
+                                            tcpip_adapter_dns_type_t type,
+                                            tcpip_adapter_dns_info_t* dns)
+{
+    return tcpip_adapter_set_dns_info(iface, type, dns);
+}
+
+static uint32_t s_driver_idf_dhcp_lease_s(void* ctx, tcpip_adapter_if_t iface)
+{
+    //T0 OF THE LAST ACK, FROM THE LWIP DHCP CLIENT
+
+    struct netif* netif = NULL;
+    struct dhcp* dhcp;
+
+    if(tcpip_adapter_get_netif(iface, (void**)&netif) != ESP_OK || netif == NULL)
+    {
+        return 0;
+    }
+    dhcp = netif_dhcp_data(netif);
+    return (dhcp != NULL) ? dhcp->offered_t0_lease : 0;
+}
+
+static esp_err_t s_driver_idf_dhcp_renew(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    return s_driver_idf_ip_call(s_driver_idf_dhcp_renew_fn, iface, ip, NULL);
+}
+
+static esp_err_t s_driver_idf_arp_probe(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    return s_driver_idf_ip_call(s_driver_idf_arp_probe_fn, iface, ip, NULL);
+}
+
+static bool s_driver_idf_arp_lookup(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    bool found = false;
+
+    s_driver_idf_ip_call(s_driver_idf_arp_lookup_fn, iface, ip, &found);
+    return found;
+}
+
+static const esp32_wifimanager_driver_t s_driver_idf_ops = {.bind = s_driver_idf_bind,
+                                                            .unbind = s_driver_idf_unbind,
+                                                            .init = s_driver_idf_init,
+                                                            .set_mode = s_driver_idf_set_mode,
+                                                            .start = s_driver_idf_start,
+                                                            .connect = s_driver_idf_connect,
+                                                            .disconnect = s_driver_idf_disconnect,
+                                                            .set_config = s_driver_idf_set_config,
+                                                            .get_config = s_driver_idf_get_config,
+                                                            .set_storage = s_driver_idf_set_storage,
+                                                            .set_auto_connect = s_driver_idf_set_auto_connect,
+                                                            .sta_get_ap_info = s_driver_idf_sta_get_ap_info,
+                                                            .set_ps = s_driver_idf_set_ps,
+                                                            .get_ps = s_driver_idf_get_ps,
+                                                            .scan_start = s_driver_idf_scan_start,
+                                                            .scan_stop = s_driver_idf_scan_stop,
+                                                            .scan_get_ap_records = s_driver_idf_scan_get_ap_records,
+                                                            .smartconfig_start = s_driver_idf_smartconfig_start,
+                                                            .smartconfig_stop = s_driver_idf_smartconfig_stop,
+                                                            .dhcpc_start = s_driver_idf_dhcpc_start,
+                                                            .dhcpc_stop = s_driver_idf_dhcpc_stop,
+                                                            .get_ip_info = s_driver_idf_get_ip_info,
+                                                            .set_ip_info = s_driver_idf_set_ip_info,
+                                                            .get_dns_info = s_driver_idf_get_dns_info,
+                                                            .set_dns_info = s_driver_idf_set_dns_info,
+                                                            .dhcp_lease_s = s_driver_idf_dhcp_lease_s,
+                                                            .dhcp_renew = s_driver_idf_dhcp_renew,
+                                                            .arp_probe = s_driver_idf_arp_probe,
+                                                            .arp_lookup = s_driver_idf_arp_lookup};
+
+const esp32_wifimanager_driver_t* ESP32_WIFIMANAGER_DRIVER_Idf(void)
+{
+    //THE ESP32'S OWN RADIO
+
+    return &s_driver_idf_ops;
+}
+
+static esp32_wifimanager_t* s_driver_idf_enter(void)
+{
+    //COUNT THE CALLBACK IN BEFORE READING THE OWNER. NULL = NOT BOUND
+
+    esp32_wifimanager_t* wm;
+
+    __atomic_add_fetch(&s_driver_idf.calls, 1, __ATOMIC_SEQ_CST);
+    wm = __atomic_load_n(&s_driver_idf.owner, __ATOMIC_SEQ_CST);
+    if(wm == NULL)
+    {
+        s_driver_idf_leave();
+    }
+    return wm;
+}
+
+static void s_driver_idf_leave(void)
+{
+    __atomic_sub_fetch(&s_driver_idf.calls, 1, __ATOMIC_SEQ_CST);
+}
+
+static esp_err_t s_driver_idf_evt_handler(void* ctx, system_event_t* evt)
+{
+    //EVENT LOOP TASK. HAND THE EVENT TO THE BOUND INSTANCE
+
+    esp32_wifimanager_t* wm = s_driver_idf_enter();
+    esp_err_t err = ESP_OK;
+
+    if(wm != NULL)
+    {
+        err = ESP32_WIFIMANAGER_CTX_DriverEvent(wm, evt);
+        s_driver_idf_leave();
+    }
+    return err;
+}
+
+static void s_driver_idf_smartconfig_cb(smartconfig_status_t status, void* pdata)
+{
+    //SMARTCONFIG TASK. HAND THE STATUS TO THE BOUND INSTANCE
+
+    esp32_wifimanager_t* wm = s_driver_idf_enter();
+
+    if(wm != NULL)
+    {
+        ESP32_WIFIMANAGER_CTX_SmartconfigEvent(wm, status, pdata);
+        s_driver_idf_leave();
+    }
+}
+
+static esp_err_t s_driver_idf_ip_call(tcpip_api_call_fn fn, tcpip_adapter_if_t iface, uint32_t ip, bool* found)
+{
+    //RUN fn IN THE TCPIP THREAD AND WAIT FOR IT
+
+    driver_idf_ip_call_t req;
+
+    memset(&req, 0, sizeof(req));
+    req.iface = iface;
+    req.ip.addr = ip;
+    if(tcpip_api_call(fn, &req.call) != ERR_OK)
+    {
+        return ESP_FAIL;
+    }
+    if(found != NULL)
+    {
+        *found = req.found;
+    }
+    return ESP_OK;
+}
+
+static struct netif* s_driver_idf_netif(tcpip_adapter_if_t iface)
+{
+    struct netif* netif = NULL;
+
+    if(tcpip_adapter_get_netif(iface, (void**)&netif) != ESP_OK)
+    {
+        return NULL;
+    }
+    return netif;
+}
+
+static err_t s_driver_idf_dhcp_stop_fn(struct tcpip_api_call_data* call)
+{
+    struct netif* netif = s_driver_idf_netif(((driver_idf_ip_call_t*)call)->iface);
+
+    if(netif == NULL)
+    {
+        return ERR_IF;
+    }
+    dhcp_stop(netif);
+    return ERR_OK;
+}
+
+static err_t s_driver_idf_dhcp_renew_fn(struct tcpip_api_call_data* call)
+{
+    //TCPIP THREAD. dhcp_start KEEPS THE ADDRESS (tcpip_adapter_dhcpc_start
+    //WOULD CLEAR IT AND THE DNS SERVERS). THEN REBOOT ON ip THE WAY LWIP
+    //RESTORES ITS LAST ADDRESS: REQUEST IT, NO DISCOVER ROUND
+
+    driver_idf_ip_call_t* req = (driver_idf_ip_call_t*)call;
+    struct netif* netif = s_driver_idf_netif(req->iface);
+    struct dhcp* dhcp;
+
+    if(netif == NULL || dhcp_start(netif) != ERR_OK)
+    {
+        return ERR_IF;
+    }
+    dhcp = netif_dhcp_data(netif);
+    if(dhcp == NULL)
+    {
+        return ERR_IF;
+    }
+    ip4_addr_copy(dhcp->offered_ip_addr, req->ip);
+    dhcp->state = DHCP_STATE_BOUND;
+    dhcp_network_changed(netif);
+    return ERR_OK;
+}
+
+static err_t s_driver_idf_arp_probe_fn(struct tcpip_api_call_data* call)
+{
+    driver_idf_ip_call_t* req = (driver_idf_ip_call_t*)call;
+    struct netif* netif = s_driver_idf_netif(req->iface);
+
+    if(netif == NULL)
+    {
+        return ERR_IF;
+    }
+    if(ip4_addr_cmp(&req->ip, netif_ip4_addr(netif)))
+    {
+        return etharp_acd_probe(netif, &req->ip);
+    }
+    return etharp_request(netif, &req->ip);
+}
+
+static err_t s_driver_idf_arp_lookup_fn(struct tcpip_api_call_data* call)
+{
+    driver_idf_ip_call_t* req = (driver_idf_ip_call_t*)call;
+    struct netif* netif = s_driver_idf_netif(req->iface);
+    struct eth_addr* eth;
+    const ip4_addr_t* ip;
+
+    if(netif == NULL)
+    {
+        return ERR_IF;
+    }
+    req->found = (etharp_find_addr(netif, &req->ip, &eth, &ip) >= 0);
+    return ERR_OK;
+}
@@ -0,0 +1,90 @@
+/**************************************************
+* ESP32 WIFI-MANAGER RADIO DRIVER TABLE
+*
+* EVERY WIFI DRIVER / TCPIP ADAPTER / SMARTCONFIG CALL
+* OF AN INSTANCE GOES THROUGH ITS OWN TABLE, WITH THE
+* RADIO CONTEXT GIVEN TO ESP32_WIFIMANAGER_CTX_SetDriver
+* AS FIRST ARGUMENT. THE OPS MIRROR THE IDF CALLS
+*
+* A RADIO IS BOUND TO ONE INSTANCE AT A TIME. BIND
+* ROUTES ITS EVENTS TO THAT INSTANCE THROUGH
+* ESP32_WIFIMANAGER_CTX_DriverEvent AND
+* ESP32_WIFIMANAGER_CTX_SmartconfigEvent, SO NO
+* CALLBACK NEEDS A GLOBAL TO FIND ITS INSTANCE
+*
+* ESP32_WIFIMANAGER_DRIVER_Idf IS THE ESP32'S ONE
+* RADIO (CONTEXT UNUSED) AND THE DEFAULT OF EVERY
+* INSTANCE. A SECOND INSTANCE ON IT IS REFUSED AT
+* SETPARAMETERS. INSTANCES ON OTHER RADIOS (A SECOND
+* MODULE, A HOST FAKE) RUN SIDE BY SIDE
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_DRIVER_
+#define _ESP32_WIFIMANAGER_DRIVER_
+
+#include "ESP32_WIFIMANAGER.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_smartconfig.h"
+#include "tcpip_adapter.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+struct esp32_wifimanager_driver_s
+{
+    //CLAIM THE RADIO FOR wm. ESP_ERR_INVALID_STATE IF ANOTHER INSTANCE HOLDS IT
+    esp_err_t (*bind)(void* ctx, esp32_wifimanager_t* wm);
+    //RELEASE IT. RETURNS ONCE NO EVENT FOR wm IS BEING DELIVERED
+    void (*unbind)(void* ctx, esp32_wifimanager_t* wm);
+    //BRING THE DRIVER UP IN STA MODE (ONCE PER RADIO)
+    esp_err_t (*init)(void* ctx);
+
+    esp_err_t (*set_mode)(void* ctx, wifi_mode_t mode);
+    esp_err_t (*start)(void* ctx);
+    esp_err_t (*connect)(void* ctx);
+    esp_err_t (*disconnect)(void* ctx);
+    esp_err_t (*set_config)(void* ctx, wifi_interface_t iface, wifi_config_t* config);
+    esp_err_t (*get_config)(void* ctx, wifi_interface_t iface, wifi_config_t* config);
+    esp_err_t (*set_storage)(void* ctx, wifi_storage_t storage);
+    esp_err_t (*set_auto_connect)(void* ctx, bool on);
+    esp_err_t (*sta_get_ap_info)(void* ctx, wifi_ap_record_t* ap);
+    esp_err_t (*set_ps)(void* ctx, wifi_ps_type_t ps);
+    esp_err_t (*get_ps)(void* ctx, wifi_ps_type_t* ps);
+    esp_err_t (*scan_start)(void* ctx, const wifi_scan_config_t* config, bool block);
+    esp_err_t (*scan_stop)(void* ctx);
+    esp_err_t (*scan_get_ap_records)(void* ctx, uint16_t* number, wifi_ap_record_t* records);
+
+    //ESPTOUCH. STATUS GOES TO ESP32_WIFIMANAGER_CTX_SmartconfigEvent OF THE BOUND INSTANCE
+    esp_err_t (*smartconfig_start)(void* ctx);
+    esp_err_t (*smartconfig_stop)(void* ctx);
+
+    esp_err_t (*dhcpc_start)(void* ctx, tcpip_adapter_if_t iface);
+    esp_err_t (*dhcpc_stop)(void* ctx, tcpip_adapter_if_t iface);
+    esp_err_t (*get_ip_info)(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info);
+    esp_err_t (*set_ip_info)(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info);
+    esp_err_t (*get_dns_info)(void* ctx,
+                                tcpip_adapter_if_t iface,
+                                tcpip_adapter_dns_type_t type,
+                                tcpip_adapter_dns_info_t* dns);
+    esp_err_t (*set_dns_info)(void* ctx,
+                                tcpip_adapter_if_t iface,
+                                tcpip_adapter_dns_type_t type,
+                                tcpip_adapter_dns_info_t* dns);
+    //LEASE TIME OFFERED BY THE DHCP SERVER (0 = UNKNOWN)
+    uint32_t (*dhcp_lease_s)(void* ctx, tcpip_adapter_if_t iface);
+    //DHCP INIT-REBOOT OF ip: START THE CLIENT WITHOUT CLEARING THE ADDRESS AND
+    //REQUEST ip AGAIN. AN ACK SHOWS IN dhcp_lease_s, A NAK DROPS THE ADDRESS
+    esp_err_t (*dhcp_renew)(void* ctx, tcpip_adapter_if_t iface, uint32_t ip);
+    //ASK WHO HAS ip. OUR OWN ADDRESS IS PROBED WITH SENDER 0.0.0.0 (RFC 5227)
+    esp_err_t (*arp_probe)(void* ctx, tcpip_adapter_if_t iface, uint32_t ip);
+    //DID ANY HOST ANSWER FOR ip (ARP TABLE HAS IT)
+    bool (*arp_lookup)(void* ctx, tcpip_adapter_if_t iface, uint32_t ip);
+};
+
+const esp32_wifimanager_driver_t* ESP32_WIFIMANAGER_DRIVER_Idf(void);
+
+//RADIO -> INSTANCE. DRIVER EVENT CONTEXT, NEVER BLOCKS
+esp_err_t ESP32_WIFIMANAGER_CTX_DriverEvent(esp32_wifimanager_t* wm, system_event_t* evt);
+void ESP32_WIFIMANAGER_CTX_SmartconfigEvent(esp32_wifimanager_t* wm, smartconfig_status_t status, void* pdata);
+
+#endif
@@ -0,0 +1,166 @@
+/**************************************************
+* ESP32 WIFI-MANAGER STATE CORE
+*
+* SEE ESP32_WIFIMANAGER_FSM.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_FSM.h"
+
+#define FSM_STATE_MASK          (0x000000FFu)
+#define FSM_CONNECTED           (0x00000100u)
+#define FSM_ATTEMPTS_SHIFT      (16)
+#define FSM_ATTEMPTS_MASK       (0x00FF0000u)
+#define FSM_BIT(state)          (1u << (state))
+
+//LEGAL NEXT STATES PER STATE
+//INITIALIZE IS ONLY ENTERED THROUGH ESP32_WIFIMANAGER_FSM_Reset
+//EVENTS ARE ONLY APPLIED IN IDLE, SO EVERY EVENT DRIVEN STATE STARTS THERE
+static const uint8_t s_fsm_table[ESP32_WIFIMANAGER_STATE_IDLE + 1] =
+{
+    [ESP32_WIFIMANAGER_STATE_INITIALIZE]        = FSM_BIT(ESP32_WIFIMANAGER_STATE_CONNECTING),
+    [ESP32_WIFIMANAGER_STATE_CONNECTING]        = FSM_BIT(ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED) |
+                                                  FSM_BIT(ESP32_WIFIMANAGER_STATE_IDLE),
+    [ESP32_WIFIMANAGER_STATE_CONNECTED]         = FSM_BIT(ESP32_WIFIMANAGER_STATE_IDLE),
+    [ESP32_WIFIMANAGER_STATE_DISCONNECTED]      = FSM_BIT(ESP32_WIFIMANAGER_STATE_IDLE),
+    [ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED] = FSM_BIT(ESP32_WIFIMANAGER_STATE_IDLE),
+    [ESP32_WIFIMANAGER_STATE_IDLE]              = FSM_BIT(ESP32_WIFIMANAGER_STATE_CONNECTING) |
+                                                  FSM_BIT(ESP32_WIFIMANAGER_STATE_CONNECTED) |
+                                                  FSM_BIT(ESP32_WIFIMANAGER_STATE_DISCONNECTED)
+};
+
+//INTERNAL FUNCTIONS
+static uint32_t s_fsm_update(esp32_wifimanager_fsm_t* fsm, uint32_t clear, uint32_t set);
+
+void ESP32_WIFIMANAGER_FSM_Reset(esp32_wifimanager_fsm_t* fsm, esp32_wifimanager_state_t state)
+{
+    //UNCONDITIONAL START STATE, LINK DOWN, NO ATTEMPTS
+
+    __atomic_store_n(&fsm->word, (uint32_t)state & FSM_STATE_MASK, __ATOMIC_SEQ_CST);
+}
+
+esp32_wifimanager_fsm_result_t ESP32_WIFIMANAGER_FSM_Transition(esp32_wifimanager_fsm_t* fsm,
+                                                                esp32_wifimanager_state_t to)
+{
+    //MOVE TO STATE to IF THE TABLE ALLOWS IT FROM THE CURRENT STATE
+    //THE CHECK AND THE CHANGE ARE ONE ATOMIC STEP
+
+    uint32_t old = __atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE);
+    uint32_t from;
+
+    for(;;)
+    {
+        from = old & FSM_STATE_MASK;
+        if(from == (uint32_t)to)
+        {
+            return ESP32_WIFIMANAGER_FSM_SAME;
+        }
+        if(!ESP32_WIFIMANAGER_FSM_IsLegal((esp32_wifimanager_state_t)from, to))
+        {
+            __atomic_fetch_add(&fsm->illegal, 1, __ATOMIC_RELAXED);
+            return ESP32_WIFIMANAGER_FSM_ILLEGAL;
+        }
+        if(__atomic_compare_exchange_n(&fsm->word, &old, (old & ~FSM_STATE_MASK) | (uint32_t)to,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return ESP32_WIFIMANAGER_FSM_OK;
+        }
+        //old NOW HOLDS THE WORD THAT WON. RECHECK AGAINST IT
+        __atomic_fetch_add(&fsm->cas_retries, 1, __ATOMIC_RELAXED);
+    }
+}
+
+bool ESP32_WIFIMANAGER_FSM_IsLegal(esp32_wifimanager_state_t from, esp32_wifimanager_state_t to)
+{
+    //TABLE LOOKUP
+
+    if(from > ESP32_WIFIMANAGER_STATE_IDLE || to > ESP32_WIFIMANAGER_STATE_IDLE)
+    {
+        return false;
+    }
+    return (s_fsm_table[from] & FSM_BIT(to)) != 0;
+}
+
+esp32_wifimanager_state_t ESP32_WIFIMANAGER_FSM_State(const esp32_wifimanager_fsm_t* fsm)
+{
+    //CURRENT STATE
+
+    return (esp32_wifimanager_state_t)(__atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE) & FSM_STATE_MASK);
+}
+
+bool ESP32_WIFIMANAGER_FSM_Connected(const esp32_wifimanager_fsm_t* fsm)
+{
+    //LINK UP FLAG
+
+    return (__atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE) & FSM_CONNECTED) != 0;
+}
+
+void ESP32_WIFIMANAGER_FSM_SetConnected(esp32_wifimanager_fsm_t* fsm, bool connected)
+{
+    //SET / CLEAR LINK UP FLAG
+
+    if(connected)
+    {
+        s_fsm_update(fsm, 0, FSM_CONNECTED);
+    }
+    else
+    {
+        s_fsm_update(fsm, FSM_CONNECTED, 0);
+    }
+}
+
+uint8_t ESP32_WIFIMANAGER_FSM_Attempts(const esp32_wifimanager_fsm_t* fsm)
+{
+    //CONNECT ATTEMPTS IN THIS ROUND
+
+    return (uint8_t)((__atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE) & FSM_ATTEMPTS_MASK) >> FSM_ATTEMPTS_SHIFT);
+}
+
+uint8_t ESP32_WIFIMANAGER_FSM_AttemptsInc(esp32_wifimanager_fsm_t* fsm)
+{
+    //COUNT ONE MORE ATTEMPT (SATURATES AT 255). RETURNS THE COUNT BEFORE IT
+
+    uint32_t old = __atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE);
+    uint32_t attempts;
+
+    for(;;)
+    {
+        attempts = (old & FSM_ATTEMPTS_MASK) >> FSM_ATTEMPTS_SHIFT;
+        if(attempts == 0xFF)
+        {
+            return 0xFF;
+        }
+        if(__atomic_compare_exchange_n(&fsm->word, &old, old + (1u << FSM_ATTEMPTS_SHIFT),
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return (uint8_t)attempts;
+        }
+        __atomic_fetch_add(&fsm->cas_retries, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void ESP32_WIFIMANAGER_FSM_AttemptsReset(esp32_wifimanager_fsm_t* fsm)
+{
+    //START A NEW ROUND OF ATTEMPTS
+
+    s_fsm_update(fsm, FSM_ATTEMPTS_MASK, 0);
+}
+
+static uint32_t s_fsm_update(esp32_wifimanager_fsm_t* fsm, uint32_t clear, uint32_t set)
+{
+    //ATOMICALLY CLEAR THEN SET BITS OF THE WORD. RETURNS THE NEW WORD
+
+    uint32_t old = __atomic_load_n(&fsm->word, __ATOMIC_ACQUIRE);
+    uint32_t new_word;
+
+    for(;;)
+    {
+        new_word = (old & ~clear) | set;
+        if(new_word == old ||
+            __atomic_compare_exchange_n(&fsm->word, &old, new_word,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return new_word;
+        }
+        __atomic_fetch_add(&fsm->cas_retries, 1, __ATOMIC_RELAXED);
+    }
+}
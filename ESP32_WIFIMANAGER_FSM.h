@@ -0,0 +1,51 @@
+/**************************************************
+* ESP32 WIFI-MANAGER STATE CORE
+*
+* STATE, LINK UP FLAG AND CONNECT ATTEMPT COUNT LIVE
+* IN ONE 32 BIT WORD, CHANGED ONLY BY COMPARE AND SWAP,
+* SO THEY ARE ALWAYS SEEN TOGETHER AND AN UPDATE FROM
+* ONE CORE CANNOT OVERWRITE ONE FROM THE OTHER
+*
+*   BITS  0..7   esp32_wifimanager_state_t
+*   BIT   8      LINK UP (GOT IP)
+*   BITS 16..23  CONNECT ATTEMPTS IN THIS ROUND
+*
+* STATE CHANGES ARE CHECKED AGAINST A TRANSITION TABLE.
+* AN ILLEGAL ONE LEAVES THE WORD AS IT IS AND IS COUNTED
+*
+* NO DRIVER OR RTOS CALLS
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_FSM_
+#define _ESP32_WIFIMANAGER_FSM_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_FSM_OK = 0,
+    ESP32_WIFIMANAGER_FSM_SAME,         //ALREADY IN THAT STATE. NOTHING CHANGED
+    ESP32_WIFIMANAGER_FSM_ILLEGAL       //NOT IN THE TABLE. NOTHING CHANGED
+}esp32_wifimanager_fsm_result_t;
+
+typedef struct
+{
+    volatile uint32_t word;
+    volatile uint32_t illegal;          //REJECTED TRANSITIONS
+    volatile uint32_t cas_retries;      //UPDATES THAT RACED ANOTHER WRITER AND WERE REDONE
+}esp32_wifimanager_fsm_t;
+
+void ESP32_WIFIMANAGER_FSM_Reset(esp32_wifimanager_fsm_t* fsm, esp32_wifimanager_state_t state);
+esp32_wifimanager_fsm_result_t ESP32_WIFIMANAGER_FSM_Transition(esp32_wifimanager_fsm_t* fsm,
+                                                                esp32_wifimanager_state_t to);
+bool ESP32_WIFIMANAGER_FSM_IsLegal(esp32_wifimanager_state_t from, esp32_wifimanager_state_t to);
+esp32_wifimanager_state_t ESP32_WIFIMANAGER_FSM_State(const esp32_wifimanager_fsm_t* fsm);
+bool ESP32_WIFIMANAGER_FSM_Connected(const esp32_wifimanager_fsm_t* fsm);
+void ESP32_WIFIMANAGER_FSM_SetConnected(esp32_wifimanager_fsm_t* fsm, bool connected);
+uint8_t ESP32_WIFIMANAGER_FSM_Attempts(const esp32_wifimanager_fsm_t* fsm);
+uint8_t ESP32_WIFIMANAGER_FSM_AttemptsInc(esp32_wifimanager_fsm_t* fsm);
+void ESP32_WIFIMANAGER_FSM_AttemptsReset(esp32_wifimanager_fsm_t* fsm);
+
+#endif
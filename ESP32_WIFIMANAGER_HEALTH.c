@@ -0,0 +1,431 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CONNECTIVITY HEALTH PROBE
+*
+* SEE ESP32_WIFIMANAGER_HEALTH.h
+*
+* MEMORY BUDGET
+*   PROBE STATE     : esp32_wifimanager_health_probe_t
+*                     (IN THE MANAGER INSTANCE)
+*   SOCKETS         : ONE PER CHECK, ONLY DURING A ROUND
+*   PACKET BUFFER   : ESP32_WIFIMANAGER_HEALTH_RX_LEN
+*                     (STACK, WHILE POLLING)
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_HEALTH.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <errno.h>
+
+#define HEALTH_GW               (0)
+#define HEALTH_DNS              (1)
+#define HEALTH_TCP              (2)
+
+#define HEALTH_ICMP_ECHO_REPLY  (0)
+#define HEALTH_ICMP_ECHO        (8)
+#define HEALTH_DNS_PORT         (53)
+#define HEALTH_DNS_HDR_LEN      (12)
+#define HEALTH_DNS_NAME_MAX     (255)
+#define HEALTH_DNS_LABEL_MAX    (63)
+#define HEALTH_DNS_NOERROR      (0)
+#define HEALTH_DNS_NXDOMAIN     (3)
+
+//INTERNAL FUNCTIONS
+static int s_health_open(int type, int proto, uint32_t ip, uint16_t port);
+static void s_health_done(esp32_wifimanager_health_probe_t* probe, uint8_t check, bool ok, int64_t now_us);
+static void s_health_gw_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us);
+static void s_health_dns_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us);
+static void s_health_tcp_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us);
+static uint16_t s_health_checksum(const uint8_t* data, size_t len);
+
+void ESP32_WIFIMANAGER_HEALTH_Init(esp32_wifimanager_health_probe_t* probe)
+{
+    //NO ROUND, NO SOCKETS
+
+    uint8_t i;
+
+    memset(probe, 0, sizeof(esp32_wifimanager_health_probe_t));
+    for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+    {
+        probe->sock[i] = -1;
+    }
+}
+
+void ESP32_WIFIMANAGER_HEALTH_Start(esp32_wifimanager_health_probe_t* probe,
+                                    const esp32_wifimanager_health_t* health,
+                                    uint32_t gw,
+                                    uint32_t dns,
+                                    uint16_t id,
+                                    int64_t now_us)
+{
+    //OPEN A SOCKET PER CHECK AND SEND. ANSWERS ARE PICKED UP BY POLL
+
+    uint8_t buf[HEALTH_DNS_HDR_LEN + HEALTH_DNS_NAME_MAX + 1 + 4];
+    struct sockaddr_in addr;
+    size_t len;
+    uint8_t i;
+
+    ESP32_WIFIMANAGER_HEALTH_Abort(probe);
+    memset(probe->rtt_us, 0, sizeof(probe->rtt_us));
+    probe->gw = gw;
+    probe->id = id;
+    probe->pending = 0;
+    probe->failed = 0;
+    probe->start_us = now_us;
+    probe->deadline_us = now_us + (int64_t)health->timeout_ms * 1000;
+
+    //GATEWAY. RAW SOCKET IS NOT CONNECTED, REPLIES ARE MATCHED ON SOURCE AND ID
+    if(health->checks & ESP32_WIFIMANAGER_HEALTH_GATEWAY)
+    {
+        probe->sock[HEALTH_GW] = (gw == 0) ? -1 : s_health_open(SOCK_RAW, IPPROTO_ICMP, 0, 0);
+        if(probe->sock[HEALTH_GW] >= 0)
+        {
+            ESP32_WIFIMANAGER_HEALTH_Echo(buf, id, (uint16_t)(now_us / 1000));
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = gw;
+            if(sendto(probe->sock[HEALTH_GW], buf, ESP32_WIFIMANAGER_HEALTH_ECHO_LEN, 0,
+                        (struct sockaddr*)&addr, sizeof(addr)) < 0)
+            {
+                close(probe->sock[HEALTH_GW]);
+                probe->sock[HEALTH_GW] = -1;
+            }
+        }
+    }
+
+    //DNS. CONNECTED UDP, SO AN ICMP UNREACHABLE FAILS IT AT ONCE
+    if(health->checks & ESP32_WIFIMANAGER_HEALTH_DNS)
+    {
+        len = ESP32_WIFIMANAGER_HEALTH_DnsQuery(buf, sizeof(buf), health->dns_name, id);
+        probe->sock[HEALTH_DNS] = (dns == 0 || len == 0) ? -1 : s_health_open(SOCK_DGRAM, 0, dns, HEALTH_DNS_PORT);
+        if(probe->sock[HEALTH_DNS] >= 0 && send(probe->sock[HEALTH_DNS], buf, len, 0) < 0)
+        {
+            close(probe->sock[HEALTH_DNS]);
+            probe->sock[HEALTH_DNS] = -1;
+        }
+    }
+
+    //TCP. CONNECT IS IN PROGRESS WHEN OPEN RETURNS
+    if(health->checks & ESP32_WIFIMANAGER_HEALTH_TCP)
+    {
+        probe->sock[HEALTH_TCP] = (health->tcp_ip == 0 || health->tcp_port == 0) ? -1 :
+                                    s_health_open(SOCK_STREAM, 0, health->tcp_ip, health->tcp_port);
+    }
+
+    for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+    {
+        if(!(health->checks & (1 << i)))
+        {
+            continue;
+        }
+        if(probe->sock[i] >= 0)
+        {
+            probe->pending |= (1 << i);
+        }
+        else
+        {
+            probe->failed |= (1 << i);
+        }
+    }
+}
+
+bool ESP32_WIFIMANAGER_HEALTH_Poll(esp32_wifimanager_health_probe_t* probe, int64_t now_us)
+{
+    //PICK UP WHATEVER HAS ARRIVED (NO WAITING). PAST THE DEADLINE,
+    //CHECKS STILL PENDING FAIL
+
+    fd_set rfds;
+    fd_set wfds;
+    struct timeval tv = {0, 0};
+    int max_fd = -1;
+    uint8_t i;
+
+    if(probe->pending == 0)
+    {
+        return true;
+    }
+
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+    {
+        if(!(probe->pending & (1 << i)))
+        {
+            continue;
+        }
+        FD_SET(probe->sock[i], (i == HEALTH_TCP) ? &wfds : &rfds);
+        if(probe->sock[i] > max_fd)
+        {
+            max_fd = probe->sock[i];
+        }
+    }
+
+    if(select(max_fd + 1, &rfds, &wfds, NULL, &tv) > 0)
+    {
+        if((probe->pending & ESP32_WIFIMANAGER_HEALTH_GATEWAY) && FD_ISSET(probe->sock[HEALTH_GW], &rfds))
+        {
+            s_health_gw_read(probe, now_us);
+        }
+        if((probe->pending & ESP32_WIFIMANAGER_HEALTH_DNS) && FD_ISSET(probe->sock[HEALTH_DNS], &rfds))
+        {
+            s_health_dns_read(probe, now_us);
+        }
+        if((probe->pending & ESP32_WIFIMANAGER_HEALTH_TCP) && FD_ISSET(probe->sock[HEALTH_TCP], &wfds))
+        {
+            s_health_tcp_read(probe, now_us);
+        }
+    }
+
+    if(probe->pending != 0 && now_us >= probe->deadline_us)
+    {
+        for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+        {
+            if(probe->pending & (1 << i))
+            {
+                s_health_done(probe, i, false, now_us);
+            }
+        }
+    }
+
+    return (probe->pending == 0);
+}
+
+bool ESP32_WIFIMANAGER_HEALTH_Running(const esp32_wifimanager_health_probe_t* probe)
+{
+    //A ROUND IS WAITING FOR ANSWERS
+
+    return (probe->pending != 0);
+}
+
+void ESP32_WIFIMANAGER_HEALTH_Abort(esp32_wifimanager_health_probe_t* probe)
+{
+    //CLOSE EVERYTHING. RESULT OF AN UNFINISHED ROUND IS LOST
+
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; i++)
+    {
+        if(probe->sock[i] >= 0)
+        {
+            close(probe->sock[i]);
+            probe->sock[i] = -1;
+        }
+    }
+    probe->pending = 0;
+}
+
+size_t ESP32_WIFIMANAGER_HEALTH_DnsQuery(uint8_t* buf, size_t size, const char* name, uint16_t id)
+{
+    //STANDARD QUERY, RECURSION DESIRED, ONE QUESTION: name A IN
+
+    size_t pos = HEALTH_DNS_HDR_LEN;
+    size_t label = 0;
+    size_t len;
+
+    len = strnlen(name, HEALTH_DNS_NAME_MAX);
+    if(len == 0 || len >= HEALTH_DNS_NAME_MAX - 1 || HEALTH_DNS_HDR_LEN + len + 2 + 4 > size)
+    {
+        return 0;
+    }
+
+    memset(buf, 0, HEALTH_DNS_HDR_LEN);
+    buf[0] = id >> 8;
+    buf[1] = id & 0xFF;
+    buf[2] = 0x01;
+    buf[5] = 1;
+
+    //a.b.c -> 1a1b1c0. POS IS THE LENGTH BYTE OF THE CURRENT LABEL
+    buf[pos] = 0;
+    for(; *name != 0; name++)
+    {
+        if(*name == '.')
+        {
+            if(label == 0)
+            {
+                return 0;
+            }
+            buf[pos] = label;
+            pos += label + 1;
+            label = 0;
+            continue;
+        }
+        if(++label > HEALTH_DNS_LABEL_MAX)
+        {
+            return 0;
+        }
+        buf[pos + label] = *name;
+    }
+    if(label == 0)
+    {
+        return 0;
+    }
+    buf[pos] = label;
+    pos += label + 1;
+    buf[pos++] = 0;
+
+    buf[pos++] = 0x00;
+    buf[pos++] = 0x01;
+    buf[pos++] = 0x00;
+    buf[pos++] = 0x01;
+    return pos;
+}
+
+void ESP32_WIFIMANAGER_HEALTH_Echo(uint8_t* buf, uint16_t id, uint16_t seq)
+{
+    //ICMP ECHO REQUEST HEADER, NO PAYLOAD
+
+    uint16_t sum;
+
+    buf[0] = HEALTH_ICMP_ECHO;
+    buf[1] = 0;
+    buf[2] = 0;
+    buf[3] = 0;
+    buf[4] = id >> 8;
+    buf[5] = id & 0xFF;
+    buf[6] = seq >> 8;
+    buf[7] = seq & 0xFF;
+    sum = s_health_checksum(buf, ESP32_WIFIMANAGER_HEALTH_ECHO_LEN);
+    buf[2] = sum >> 8;
+    buf[3] = sum & 0xFF;
+}
+
+static int s_health_open(int type, int proto, uint32_t ip, uint16_t port)
+{
+    //NON BLOCKING SOCKET. CONNECTED TO ip:port UNLESS ip IS 0
+
+    struct sockaddr_in addr;
+    int sock;
+
+    sock = socket(AF_INET, type, proto);
+    if(sock < 0)
+    {
+        return -1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    if(ip == 0)
+    {
+        return sock;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ip;
+    addr.sin_port = htons(port);
+    if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+    {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void s_health_done(esp32_wifimanager_health_probe_t* probe, uint8_t check, bool ok, int64_t now_us)
+{
+    //ONE CHECK FINISHED
+
+    close(probe->sock[check]);
+    probe->sock[check] = -1;
+    probe->pending &= ~(1 << check);
+    if(ok)
+    {
+        probe->rtt_us[check] = now_us - probe->start_us;
+    }
+    else
+    {
+        probe->failed |= (1 << check);
+    }
+}
+
+static void s_health_gw_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us)
+{
+    //RAW SOCKET SEES EVERY ICMP PACKET (WITH ITS IP HEADER). LOOK FOR OUR REPLY
+
+    uint8_t buf[ESP32_WIFIMANAGER_HEALTH_RX_LEN];
+    uint32_t src;
+    size_t ihl;
+    int len;
+
+    while((len = recv(probe->sock[HEALTH_GW], buf, sizeof(buf), 0)) > 0)
+    {
+        ihl = (buf[0] & 0x0F) * 4;
+        if((size_t)len < ihl + ESP32_WIFIMANAGER_HEALTH_ECHO_LEN)
+        {
+            continue;
+        }
+        memcpy(&src, &buf[12], sizeof(src));
+        if(src == probe->gw &&
+            buf[ihl] == HEALTH_ICMP_ECHO_REPLY &&
+            buf[ihl + 4] == (probe->id >> 8) &&
+            buf[ihl + 5] == (probe->id & 0xFF))
+        {
+            s_health_done(probe, HEALTH_GW, true, now_us);
+            return;
+        }
+    }
+}
+
+static void s_health_dns_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us)
+{
+    //ANSWER TO OUR QUERY. ANY ERROR ON THE CONNECTED SOCKET (UNREACHABLE) FAILS IT
+
+    uint8_t buf[ESP32_WIFIMANAGER_HEALTH_RX_LEN];
+    uint8_t rcode;
+    int len;
+
+    while((len = recv(probe->sock[HEALTH_DNS], buf, sizeof(buf), 0)) != 0)
+    {
+        if(len < 0)
+        {
+            if(errno != EWOULDBLOCK && errno != EAGAIN)
+            {
+                s_health_done(probe, HEALTH_DNS, false, now_us);
+            }
+            return;
+        }
+        if(len < HEALTH_DNS_HDR_LEN ||
+            buf[0] != (probe->id >> 8) ||
+            buf[1] != (probe->id & 0xFF) ||
+            !(buf[2] & 0x80))
+        {
+            continue;
+        }
+        rcode = buf[3] & 0x0F;
+        s_health_done(probe, HEALTH_DNS, rcode == HEALTH_DNS_NOERROR || rcode == HEALTH_DNS_NXDOMAIN, now_us);
+        return;
+    }
+}
+
+static void s_health_tcp_read(esp32_wifimanager_health_probe_t* probe, int64_t now_us)
+{
+    //CONNECT FINISHED. SO_ERROR TELLS HOW
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    if(getsockopt(probe->sock[HEALTH_TCP], SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+    {
+        err = -1;
+    }
+    s_health_done(probe, HEALTH_TCP, err == 0, now_us);
+}
+
+static uint16_t s_health_checksum(const uint8_t* data, size_t len)
+{
+    //INTERNET CHECKSUM (RFC 1071)
+
+    uint32_t sum = 0;
+    size_t i;
+
+    for(i = 0; i + 1 < len; i += 2)
+    {
+        sum += ((uint32_t)data[i] << 8) | data[i + 1];
+    }
+    if(i < len)
+    {
+        sum += (uint32_t)data[i] << 8;
+    }
+    while(sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
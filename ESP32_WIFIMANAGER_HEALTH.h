@@ -0,0 +1,67 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CONNECTIVITY HEALTH PROBE
+*
+* ONE PROBE ROUND RUNS THE CONFIGURED CHECKS IN
+* PARALLEL ON NON BLOCKING SOCKETS. THE MANAGER
+* STARTS A ROUND AND POLLS IT FROM ITS TIMER EVENTS,
+* SO NOTHING HERE BLOCKS AND THERE IS NO TASK
+*
+*   GATEWAY   ICMP ECHO TO THE DEFAULT GATEWAY. THE
+*             GATEWAY HAS TO RESOLVE US (ARP) AND
+*             ANSWER, SO A DEAD AP / BRIDGE SHOWS UP
+*             LONG BEFORE THE BEACON LOSS DOES
+*   DNS       A QUERY TO THE LEASE'S DNS SERVER.
+*             NOERROR OR NXDOMAIN = UPSTREAM WORKS,
+*             SERVFAIL / NO ANSWER = UPLINK IS DEAD
+*   TCP       CONNECT TO A CONFIGURED ENDPOINT
+*
+* A CHECK THAT CANNOT BE STARTED (NO GATEWAY, NO
+* SOCKET) FAILS STRAIGHT AWAY
+*
+* ALL STATE LIVES IN THE CALLER SUPPLIED
+* esp32_wifimanager_health_probe_t. NO HEAP
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_HEALTH_
+#define _ESP32_WIFIMANAGER_HEALTH_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//RECEIVE BUFFER (STACK, PER POLL). ONLY HEADERS ARE LOOKED AT
+#define ESP32_WIFIMANAGER_HEALTH_RX_LEN     (64)
+#define ESP32_WIFIMANAGER_HEALTH_ECHO_LEN   (8)     //ICMP ECHO HEADER, NO PAYLOAD
+
+typedef struct
+{
+    int sock[ESP32_WIFIMANAGER_HEALTH_CHECK_MAX];       //-1 = NOT OPEN
+    int64_t rtt_us[ESP32_WIFIMANAGER_HEALTH_CHECK_MAX]; //LAST ROUND. 0 = NO ANSWER
+    uint32_t gw;                //NETWORK ORDER
+    uint16_t id;                //ICMP ID / DNS ID OF THIS ROUND
+    uint8_t pending;            //CHECK BITS STILL WAITING
+    uint8_t failed;             //CHECK BITS THAT FAILED
+    int64_t start_us;
+    int64_t deadline_us;
+}esp32_wifimanager_health_probe_t;
+
+void ESP32_WIFIMANAGER_HEALTH_Init(esp32_wifimanager_health_probe_t* probe);
+//gw / dns IN NETWORK ORDER, 0 = UNKNOWN. id SHOULD BE RANDOM
+void ESP32_WIFIMANAGER_HEALTH_Start(esp32_wifimanager_health_probe_t* probe,
+                                    const esp32_wifimanager_health_t* health,
+                                    uint32_t gw,
+                                    uint32_t dns,
+                                    uint16_t id,
+                                    int64_t now_us);
+//TRUE WHEN THE ROUND IS OVER (ALL ANSWERED OR DEADLINE PASSED). RESULT IN probe->failed
+bool ESP32_WIFIMANAGER_HEALTH_Poll(esp32_wifimanager_health_probe_t* probe, int64_t now_us);
+bool ESP32_WIFIMANAGER_HEALTH_Running(const esp32_wifimanager_health_probe_t* probe);
+void ESP32_WIFIMANAGER_HEALTH_Abort(esp32_wifimanager_health_probe_t* probe);
+
+//PACKET BUILDING, NO SOCKETS (ALSO USED BY HOST TESTS)
+//DNSQUERY RETURNS THE QUERY LENGTH, 0 IF THE NAME DOES NOT FIT / IS INVALID
+size_t ESP32_WIFIMANAGER_HEALTH_DnsQuery(uint8_t* buf, size_t size, const char* name, uint16_t id);
+void ESP32_WIFIMANAGER_HEALTH_Echo(uint8_t* buf, uint16_t id, uint16_t seq);
+
+#endif
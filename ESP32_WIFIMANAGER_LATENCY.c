@@ -0,0 +1,202 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CONNECTION LATENCY
+*
+* SEE ESP32_WIFIMANAGER_LATENCY.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_LATENCY.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "xtensa/hal.h"
+#include <string.h>
+
+#define LATENCY_SNAPSHOT_SPINS      (4)     //COPY RETRIES BEFORE YIELDING TO THE WRITER
+
+//INTERNAL FUNCTIONS
+static void s_latency_close(esp32_wifimanager_latency_recorder_t* rec, esp32_wifimanager_latency_id_t id, int64_t ts_us);
+static uint8_t s_latency_reason_index(uint8_t reason);
+
+void ESP32_WIFIMANAGER_LATENCY_Record(esp32_wifimanager_latency_recorder_t* rec,
+                                        esp32_wifimanager_phase_t phase,
+                                        int64_t ts_us,
+                                        uint8_t reason)
+{
+    //TIMESTAMP A PHASE. CLOSE THE INTERVALS IT ENDS, OPEN THE ONES IT STARTS
+
+    uint32_t start = xthal_get_ccount();
+    uint32_t cycles;
+
+    if(phase >= ESP32_WIFIMANAGER_PHASE_MAX)
+    {
+        return;
+    }
+
+    rec->seq++;
+    __sync_synchronize();
+
+    if(rec->reset)
+    {
+        memset(&rec->latency, 0, sizeof(rec->latency));
+        rec->reset = false;
+    }
+
+    switch(phase)
+    {
+        case ESP32_WIFIMANAGER_PHASE_WIFI_START:
+            rec->from[ESP32_WIFIMANAGER_LATENCY_DRIVER_START] = ts_us;
+            rec->from[ESP32_WIFIMANAGER_LATENCY_CONNECT] = ts_us;
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_STA_START:
+            s_latency_close(rec, ESP32_WIFIMANAGER_LATENCY_DRIVER_START, ts_us);
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_CONNECT:
+            rec->from[ESP32_WIFIMANAGER_LATENCY_ASSOC] = ts_us;
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_STA_CONNECTED:
+            s_latency_close(rec, ESP32_WIFIMANAGER_LATENCY_ASSOC, ts_us);
+            rec->from[ESP32_WIFIMANAGER_LATENCY_DHCP] = ts_us;
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_GOT_IP:
+            s_latency_close(rec, ESP32_WIFIMANAGER_LATENCY_DHCP, ts_us);
+            s_latency_close(rec, ESP32_WIFIMANAGER_LATENCY_CONNECT, ts_us);
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_DISCONNECTED:
+            //AN ATTEMPT THAT FAILED IS NOT AN ASSOC / DHCP SAMPLE
+            //CONNECT KEEPS RUNNING FROM THE FIRST FAILURE OR LINK LOSS
+            rec->from[ESP32_WIFIMANAGER_LATENCY_ASSOC] = 0;
+            rec->from[ESP32_WIFIMANAGER_LATENCY_DHCP] = 0;
+            if(rec->from[ESP32_WIFIMANAGER_LATENCY_CONNECT] == 0)
+            {
+                rec->from[ESP32_WIFIMANAGER_LATENCY_CONNECT] = ts_us;
+            }
+            rec->latency.last_disconnect_reason = reason;
+            rec->latency.disconnect_reasons[s_latency_reason_index(reason)]++;
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_PROVISION_START:
+            rec->from[ESP32_WIFIMANAGER_LATENCY_PROVISION] = ts_us;
+            break;
+
+        case ESP32_WIFIMANAGER_PHASE_PROVISION_END:
+            s_latency_close(rec, ESP32_WIFIMANAGER_LATENCY_PROVISION, ts_us);
+            break;
+
+        default:
+            break;
+    }
+
+    rec->latency.phase_us[phase] = ts_us;
+    rec->latency.phase_count[phase]++;
+
+    cycles = xthal_get_ccount() - start;
+    rec->latency.record_cycles_last = cycles;
+    if(cycles > rec->latency.record_cycles_max)
+    {
+        rec->latency.record_cycles_max = cycles;
+    }
+    rec->latency.seq = rec->seq + 1;
+
+    __sync_synchronize();
+    rec->seq++;
+}
+
+void ESP32_WIFIMANAGER_LATENCY_Snapshot(esp32_wifimanager_latency_recorder_t* rec, esp32_wifimanager_latency_t* snapshot)
+{
+    //COPY STATE. RETRY IF THE WRITER WAS IN THE MIDDLE OF AN UPDATE
+
+    uint32_t seq;
+    uint8_t spins = 0;
+
+    for(;;)
+    {
+        seq = rec->seq;
+        __sync_synchronize();
+        if((seq & 1) == 0)
+        {
+            if(rec->reset)
+            {
+                memset(snapshot, 0, sizeof(esp32_wifimanager_latency_t));
+            }
+            else
+            {
+                memcpy(snapshot, &rec->latency, sizeof(esp32_wifimanager_latency_t));
+            }
+            __sync_synchronize();
+            if(seq == rec->seq)
+            {
+                return;
+            }
+        }
+
+        //WRITER MAY BE A LOWER PRIORITY TASK ON THIS CORE
+        if(++spins >= LATENCY_SNAPSHOT_SPINS)
+        {
+            spins = 0;
+            vTaskDelay(1);
+        }
+    }
+}
+
+void ESP32_WIFIMANAGER_LATENCY_Reset(esp32_wifimanager_latency_recorder_t* rec)
+{
+    //CLEAR ON THE NEXT RECORD, SO THE WRITER STAYS THE ONLY WRITER
+    //SNAPSHOTS READ AS EMPTY UNTIL THEN. INTERVALS IN PROGRESS STAY OPEN
+
+    rec->reset = true;
+}
+
+static void s_latency_close(esp32_wifimanager_latency_recorder_t* rec, esp32_wifimanager_latency_id_t id, int64_t ts_us)
+{
+    //END AN INTERVAL AND ADD IT TO ITS HISTOGRAM
+
+    esp32_wifimanager_histogram_t* hist = &rec->latency.hist[id];
+    uint32_t ms;
+    uint8_t bucket;
+
+    if(rec->from[id] == 0 || ts_us < rec->from[id])
+    {
+        return;
+    }
+
+    ms = (uint32_t)((ts_us - rec->from[id]) / 1000);
+    rec->from[id] = 0;
+
+    //BUCKET = BIT LENGTH OF ms
+    bucket = (ms == 0) ? 0 : (uint8_t)(32 - __builtin_clz(ms));
+    if(bucket >= ESP32_WIFIMANAGER_LATENCY_BUCKETS)
+    {
+        bucket = ESP32_WIFIMANAGER_LATENCY_BUCKETS - 1;
+    }
+    hist->buckets[bucket]++;
+
+    if(hist->count == 0 || ms < hist->min_ms)
+    {
+        hist->min_ms = ms;
+    }
+    if(ms > hist->max_ms)
+    {
+        hist->max_ms = ms;
+    }
+    hist->total_ms += ms;
+    hist->count++;
+}
+
+static uint8_t s_latency_reason_index(uint8_t reason)
+{
+    //MAP A WIFI DISCONNECT REASON TO ITS COUNTER
+
+    if(reason >= 1 && reason <= 25)
+    {
+        return reason;
+    }
+    if(reason >= 200 && reason <= 205)
+    {
+        return reason - 200 + 26;
+    }
+    return 0;
+}
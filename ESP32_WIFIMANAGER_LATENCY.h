@@ -0,0 +1,38 @@
+/**************************************************
+* ESP32 WIFI-MANAGER CONNECTION LATENCY
+*
+* TIMESTAMPS EACH CONNECTION PHASE AND KEEPS A FIXED
+* LOG2 (ms) HISTOGRAM PER PHASE INTERVAL. ONE RECORDER
+* PER MANAGER INSTANCE, NOTHING IS ALLOCATED
+*
+* RECORD IS ONLY CALLED FROM THE MANAGER CONTEXT
+* (SINGLE WRITER). SNAPSHOT CAN BE CALLED FROM ANY
+* TASK: THE WRITER BUMPS A SEQUENCE COUNTER BEFORE
+* AND AFTER EACH UPDATE AND THE READER RETRIES ITS
+* COPY UNTIL IT SEES THE SAME EVEN VALUE ON BOTH SIDES
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_LATENCY_
+#define _ESP32_WIFIMANAGER_LATENCY_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    esp32_wifimanager_latency_t latency;
+    volatile uint32_t seq;
+    volatile bool reset;
+    //START OF EACH INTERVAL IN PROGRESS. 0 = NOT RUNNING
+    int64_t from[ESP32_WIFIMANAGER_LATENCY_MAX];
+}esp32_wifimanager_latency_recorder_t;
+
+void ESP32_WIFIMANAGER_LATENCY_Record(esp32_wifimanager_latency_recorder_t* rec,
+                                        esp32_wifimanager_phase_t phase,
+                                        int64_t ts_us,
+                                        uint8_t reason);
+void ESP32_WIFIMANAGER_LATENCY_Snapshot(esp32_wifimanager_latency_recorder_t* rec, esp32_wifimanager_latency_t* snapshot);
+void ESP32_WIFIMANAGER_LATENCY_Reset(esp32_wifimanager_latency_recorder_t* rec);
+
+#endif
@@ -0,0 +1,179 @@
+/**************************************************
+* ESP32 WIFI-MANAGER DEFERRED BINARY LOG
+*
+* SEE ESP32_WIFIMANAGER_LOG.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_LOG.h"
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL > ESP32_WIFIMANAGER_LOG_LEVEL_NONE
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+
+#define LOG_RING_MASK           (ESP32_WIFIMANAGER_LOG_RING_LEN - 1)
+
+//INTERNAL TYPES
+typedef struct
+{
+    //SLOT SEQUENCE, STORED MINUS THE SLOT INDEX SO ALL ZERO IS A VALID EMPTY RING
+    //  == POS          FREE FOR THE PRODUCER CLAIMING POS
+    //  == POS + 1      PUBLISHED, READY FOR THE CONSUMER
+    volatile uint32_t seq;
+    uint32_t ts;            //esp_timer_get_time() >> 10
+    uint16_t id;
+    uint8_t level;
+    uint32_t arg[2];
+}log_slot_t;
+
+//INTERNAL VARIABLES
+static log_slot_t s_log_ring[ESP32_WIFIMANAGER_LOG_RING_LEN];
+static volatile uint32_t s_log_head;
+static uint32_t s_log_tail;             //CONSUMER ONLY
+static volatile uint32_t s_log_dropped;
+static TaskHandle_t s_log_task_handle;
+
+//INTERNAL FUNCTIONS
+static void s_log_drain_task(void* pArg);
+static bool s_log_read(log_slot_t* out);
+
+void ESP32_WIFIMANAGER_LOG_Write(uint8_t level, esp32_wifimanager_log_id_t id, uint32_t arg0, uint32_t arg1)
+{
+    //CLAIM A SLOT, FILL IT, PUBLISH IT. DROP IF THE RING IS FULL
+
+    uint32_t pos = __atomic_load_n(&s_log_head, __ATOMIC_RELAXED);
+    log_slot_t* slot;
+    int32_t diff;
+
+    for(;;)
+    {
+        slot = &s_log_ring[pos & LOG_RING_MASK];
+        diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) + (pos & LOG_RING_MASK) - pos);
+        if(diff == 0)
+        {
+            if(__atomic_compare_exchange_n(&s_log_head, &pos, pos + 1, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+            //LOST THE RACE. pos NOW HOLDS THE CURRENT HEAD
+        }
+        else if(diff < 0)
+        {
+            //CONSUMER HAS NOT FREED THIS SLOT YET
+            __atomic_fetch_add(&s_log_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n(&s_log_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->ts = (uint32_t)(esp_timer_get_time() >> 10);
+    slot->id = (uint16_t)id;
+    slot->level = level;
+    slot->arg[0] = arg0;
+    slot->arg[1] = arg1;
+    __atomic_store_n(&slot->seq, pos + 1 - (pos & LOG_RING_MASK), __ATOMIC_RELEASE);
+}
+
+uint32_t ESP32_WIFIMANAGER_LOG_Hash(const uint8_t* data, size_t max_len)
+{
+    //FNV-1a OVER A (POSSIBLY NOT NULL TERMINATED) STRING
+    //IDENTIFIES AN SSID ACROSS RECORDS WITHOUT LOGGING IT
+
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for(i = 0; i < max_len && data[i] != 0; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void ESP32_WIFIMANAGER_LOG_Start(void)
+{
+    //START THE DRAIN TASK (ONCE)
+    //RECORDS WRITTEN BEFORE THIS WAIT IN THE RING
+
+    if(s_log_task_handle != NULL)
+    {
+        return;
+    }
+    if(xTaskCreate(s_log_drain_task,
+                    "wifimanager_log",
+                    ESP32_WIFIMANAGER_LOG_TASK_STACK_SIZE,
+                    NULL,
+                    ESP32_WIFIMANAGER_LOG_TASK_PRIORITY,
+                    &s_log_task_handle) != pdPASS)
+    {
+        //NOTHING TO LOG THROUGH. SAY IT DIRECTLY, ONCE
+        s_log_task_handle = NULL;
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Log drain task start failed\n");
+    }
+}
+
+uint32_t ESP32_WIFIMANAGER_LOG_Dropped(void)
+{
+    //RECORDS LOST TO A FULL RING SO FAR
+
+    return __atomic_load_n(&s_log_dropped, __ATOMIC_RELAXED);
+}
+
+static void s_log_drain_task(void* pArg)
+{
+    //PRINT PUBLISHED RECORDS, THEN SLEEP
+    //A DROP IS REPORTED AS ITS OWN RECORD ONCE THE RING HAS ROOM AGAIN
+
+    log_slot_t rec;
+    uint32_t dropped_reported = 0;
+    uint32_t dropped;
+
+    for(;;)
+    {
+        while(s_log_read(&rec))
+        {
+            ets_printf("#WM%08x%02x%04x%08x%08x\n", rec.ts, rec.level, rec.id, rec.arg[0], rec.arg[1]);
+        }
+
+        dropped = ESP32_WIFIMANAGER_LOG_Dropped();
+        if(dropped != dropped_reported)
+        {
+            ets_printf("#WM%08x%02x%04x%08x%08x\n",
+                        (uint32_t)(esp_timer_get_time() >> 10),
+                        ESP32_WIFIMANAGER_LOG_LEVEL_WARN,
+                        ESP32_WIFIMANAGER_LOG_DROPPED,
+                        dropped - dropped_reported,
+                        0);
+            dropped_reported = dropped;
+        }
+
+        vTaskDelay(ESP32_WIFIMANAGER_LOG_DRAIN_MS / portTICK_PERIOD_MS);
+    }
+}
+
+static bool s_log_read(log_slot_t* out)
+{
+    //TAKE THE OLDEST PUBLISHED RECORD. FALSE IF THERE IS NONE
+
+    log_slot_t* slot = &s_log_ring[s_log_tail & LOG_RING_MASK];
+    uint32_t base = s_log_tail - (s_log_tail & LOG_RING_MASK);
+
+    if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != base + 1)
+    {
+        return false;
+    }
+    *out = *slot;
+
+    //FREE THE SLOT FOR THE PRODUCER ONE LAP AHEAD
+    __atomic_store_n(&slot->seq, base + ESP32_WIFIMANAGER_LOG_RING_LEN, __ATOMIC_RELEASE);
+    s_log_tail++;
+    return true;
+}
+
+#endif
@@ -0,0 +1,156 @@
+/**************************************************
+* ESP32 WIFI-MANAGER DEFERRED BINARY LOG
+*
+* LOG CALLS WRITE A FIXED 16 BYTE RECORD (TIME, LEVEL,
+* MESSAGE ID, TWO 32 BIT ARGUMENTS) INTO A LOCK FREE
+* RING AND RETURN. NO FORMATTING, NO UART, NO LOCKS,
+* SO THEY ARE SAFE FROM THE EVENT LOOP, DRIVER
+* CALLBACKS AND ISRs
+*
+* A LOW PRIORITY TASK DRAINS THE RING TO THE CONSOLE
+* AS ONE HEX LINE PER RECORD
+*
+*   #WM<time:8><level:2><id:4><arg0:8><arg1:8>
+*
+* TIME IS IN UNITS OF 1024 us. tools/logdecode.py
+* TURNS THESE LINES BACK INTO TEXT USING THE FORMAT
+* STRINGS IN ESP32_WIFIMANAGER_LOG_IDS BELOW. THE
+* FORMAT STRINGS ARE NOT COMPILED INTO THE FIRMWARE
+*
+* SECRETS NEVER REACH THE LOG. PASSWORDS ARE LOGGED AS
+* A LENGTH, SSIDS AS A 32 BIT HASH (ESP32_WIFIMANAGER_LOG_Hash)
+*
+* LEVELS ABOVE ESP32_WIFIMANAGER_LOG_LEVEL COMPILE TO
+* NOTHING, ARGUMENTS INCLUDED
+*
+* RING: BOUNDED MULTI PRODUCER / SINGLE CONSUMER QUEUE.
+* A PRODUCER CLAIMS A SLOT WITH A CAS ON THE HEAD, FILLS
+* IT AND PUBLISHES IT THROUGH THE SLOT SEQUENCE. WHEN
+* THE RING IS FULL THE RECORD IS DROPPED AND COUNTED
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_LOG_
+#define _ESP32_WIFIMANAGER_LOG_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stddef.h>
+
+//MESSAGE IDS AND THEIR (HOST SIDE) FORMATS
+//NEW IDS GO AT THE END SO OLD CAPTURES STILL DECODE
+//FORMAT FIELDS ARE PYTHON str.format, {0} = ARG0, {1} = ARG1, WITH SPECS
+//  u   UNSIGNED (DEFAULT)      i   SIGNED 32           x / 04x   HEX
+//  ip  IPV4 (LWIP ORDER)       mac LAST 4 BSSID BYTES  ssid      SSID HASH
+//  b0..b3 / sb0..sb3           UNSIGNED / SIGNED BYTE N
+//  h0 / h1                     LOW / HIGH 16 BITS
+//  e:<enum type>               ENUM NAME FROM include/ESP32_WIFIMANAGER.h
+#define ESP32_WIFIMANAGER_LOG_IDS(X)                                                            \
+    X(DROPPED,              "{0} log records dropped")                                          \
+    X(STATE,                "{0:e:esp32_wifimanager_state_t}")                                   \
+    X(STATE_ILLEGAL,        "Illegal transition {0:e:esp32_wifimanager_state_t} -> {1:e:esp32_wifimanager_state_t}") \
+    X(PROVISION_WINDOW,     "Provisioning window over, retrying")                               \
+    X(CONN_DONE,            "Connection #{0} took {1:h1} ticks, {1:h0} transitions")            \
+    X(HARDCODED_TOO_LONG,   "HARDCODED SSID / PASSWORD TOO LONG")                               \
+    X(INITIALIZED,          "Initialized ({0:b0}, {0:b1}) led @ pin {1}")                       \
+    X(GPIO_CHECK,           "Checking trigger gpio level")                                      \
+    X(GPIO_TRIGGERED,       "gpio triggered !!")                                                \
+    X(MAX_ATTEMPTS,         "Max connection attempts reached !")                                \
+    X(CONNECT_ATTEMPT,      "Wifi connect attempt #{0}")                                        \
+    X(FAST_CONNECT,         "Fast connect on channel {0}")                                      \
+    X(FAST_CONNECT_FAILED,  "Fast connect failed, full scan")                                   \
+    X(DHCP_CACHE_USED,      "Using cached DHCP lease")                                          \
+    X(DHCP_RESTARTED,       "DHCP client restarted")                                            \
+    X(MULTI_TRY,            "Trying {0:ssid} (rssi {1:i})")                                     \
+    X(SCAN_ATTEMPT,         "Wifi scan attempt #{0}")                                           \
+    X(SCAN_RESULT,          "{0} APs, {1} known")                                               \
+    X(CREDENTIAL_ADDED,     "Credential {0:ssid} added @ slot {1}")                             \
+    X(ROAM_SCAN,            "Roam scan, rssi {0:i}, channels 0x{1:04x}")                        \
+    X(ROAM_FROM,            "Roaming from {0:mac} ({1:i})")                                     \
+    X(ROAM_TO,              "Roaming to {0:mac} ({1:sb0}) ch {1:b1}")                           \
+    X(ROAMED,               "Roamed in {0} ms")                                                 \
+    X(CREDLOG_OPEN_FAILED,  "Credential log open failed ({0:i})")                               \
+    X(CREDLOG_EMPTY,        "Credential log empty")                                             \
+    X(CREDLOG_SAVE_FAILED,  "Credential log save failed")                                       \
+    X(NEXT_CHECK,           "Next check in {0} ms")                                             \
+    X(CONFIG_UNSUPPORTED,   "Config Mode = {0:e:esp32_wifimanager_config_mode_t} not supported") \
+    X(WEBCONFIG_FAILED,     "WEBCONFIG start failed")                                           \
+    X(SOFTAP_UP,            "SoftAP up on channel {0}")                                         \
+    X(WEBCONFIG_SSID,       "WEBCONFIG: SSID = {0:ssid}")                                       \
+    X(WEBCONFIG_LISTENING,  "Webconfig listening on port {0}")                                  \
+    X(WEBCONFIG_STOPPED,    "Webconfig stopped")                                                \
+    X(EVT_WIFI_READY,       "EVT_WIFI_READY")                                                   \
+    X(EVT_SCAN_DONE,        "EVT_SCAN_DONE")                                                    \
+    X(EVT_STA_START,        "EVT_STA_START")                                                    \
+    X(EVT_STA_CONNECTED,    "EVT_STA_CONNECTED SSID {0:ssid} ch {1}")                           \
+    X(EVT_STA_DISCONNECTED, "EVT_STA_DISCONNECTED reason {0}")                                  \
+    X(EVT_STA_GOT_IP,       "EVT_STA_GOT_IP IP {0:ip}")                                         \
+    X(EVT_AP_STACONNECTED,  "EVT_AP_STACONNECTED")                                              \
+    X(EVT_AP_STADISCONNECTED, "EVT_AP_STADISCONNECTED")                                         \
+    X(EVT_UNKNOWN,          "EVT_UNKNOWN {0}")                                                  \
+    X(SC_WAIT,              "SMARTCONFIG: SC_STATUS_WAIT")                                      \
+    X(SC_FIND_CHANNEL,      "SMARTCONFIG: SC_STATUS_FIND_CHANNEL")                              \
+    X(SC_GETTING_SSID_PSWD, "SMARTCONFIG: SC_STATUS_GETTING_SSID_PSWD")                         \
+    X(SC_LINK,              "SMARTCONFIG: SC_STATUS_LINK SSID {0:ssid}, password {1} chars")    \
+    X(SC_LINK_OVER,         "SMARTCONFIG: IP = {0:ip}")                                         \
+    X(POWER_LEVEL,          "Power {0:e:esp32_wifimanager_power_policy_t} (rssi {1:i})")        \
+    X(DNS_FAILED,           "Captive DNS start failed")                                         \
+    X(APSTA_RETRY,          "APSTA retry {0} (channel {1}, 0 = all)")                           \
+    X(APSTA_RECOVERED,      "Stored network back after {0} APSTA retries, portal closed")        \
+    X(FLAP_SUPPRESSED,      "Link flap {0} hidden, down {1} ms")                                \
+    X(HEALTH_DEGRADED,      "Link degraded, failed checks 0x{0:02x} for {1} rounds")            \
+    X(HEALTH_HEALTHY,       "Link healthy again, gateway rtt {0} ms")                           \
+    X(CREDENTIAL_EVICTED,   "Credential {0:ssid} evicted from full table @ slot {1}")          \
+    X(DHCP_CACHE_REJECTED,  "Cached lease {0:ip} rejected, gateway seen {1:b0}, address taken {1:b1}") \
+    X(DHCP_RENEWED,         "Cached lease {0:ip} renewed in place")
+
+#define ESP32_WIFIMANAGER_LOG_ENUM(name, fmt)   ESP32_WIFIMANAGER_LOG_##name,
+typedef enum
+{
+    ESP32_WIFIMANAGER_LOG_IDS(ESP32_WIFIMANAGER_LOG_ENUM)
+    ESP32_WIFIMANAGER_LOG_ID_MAX
+}esp32_wifimanager_log_id_t;
+#undef ESP32_WIFIMANAGER_LOG_ENUM
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL > ESP32_WIFIMANAGER_LOG_LEVEL_NONE
+void ESP32_WIFIMANAGER_LOG_Write(uint8_t level, esp32_wifimanager_log_id_t id, uint32_t arg0, uint32_t arg1);
+uint32_t ESP32_WIFIMANAGER_LOG_Hash(const uint8_t* data, size_t max_len);
+void ESP32_WIFIMANAGER_LOG_Start(void);
+uint32_t ESP32_WIFIMANAGER_LOG_Dropped(void);
+#else
+#define ESP32_WIFIMANAGER_LOG_Start()           ((void)0)
+#define ESP32_WIFIMANAGER_LOG_Dropped()         (0)
+#endif
+
+//ARGUMENT PACKING HELPERS
+#define ESP32_WIFIMANAGER_LOG_U16(v)            (((v) < 0xFFFF) ? (uint32_t)(v) : 0xFFFF)
+#define ESP32_WIFIMANAGER_LOG_BSSID(b)          (((uint32_t)(b)[2] << 24) | ((uint32_t)(b)[3] << 16) | \
+                                                 ((uint32_t)(b)[4] << 8) | (uint32_t)(b)[5])
+
+#define ESP32_WIFIMANAGER_LOG_WRITE(level, id, a0, a1)                                          \
+    ESP32_WIFIMANAGER_LOG_Write((level), ESP32_WIFIMANAGER_LOG_##id, (uint32_t)(a0), (uint32_t)(a1))
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL >= ESP32_WIFIMANAGER_LOG_LEVEL_ERROR
+#define ESP32_WIFIMANAGER_LOGE(id, a0, a1)      ESP32_WIFIMANAGER_LOG_WRITE(ESP32_WIFIMANAGER_LOG_LEVEL_ERROR, id, a0, a1)
+#else
+#define ESP32_WIFIMANAGER_LOGE(id, a0, a1)      ((void)0)
+#endif
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL >= ESP32_WIFIMANAGER_LOG_LEVEL_WARN
+#define ESP32_WIFIMANAGER_LOGW(id, a0, a1)      ESP32_WIFIMANAGER_LOG_WRITE(ESP32_WIFIMANAGER_LOG_LEVEL_WARN, id, a0, a1)
+#else
+#define ESP32_WIFIMANAGER_LOGW(id, a0, a1)      ((void)0)
+#endif
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL >= ESP32_WIFIMANAGER_LOG_LEVEL_INFO
+#define ESP32_WIFIMANAGER_LOGI(id, a0, a1)      ESP32_WIFIMANAGER_LOG_WRITE(ESP32_WIFIMANAGER_LOG_LEVEL_INFO, id, a0, a1)
+#else
+#define ESP32_WIFIMANAGER_LOGI(id, a0, a1)      ((void)0)
+#endif
+
+#if ESP32_WIFIMANAGER_LOG_LEVEL >= ESP32_WIFIMANAGER_LOG_LEVEL_DEBUG
+#define ESP32_WIFIMANAGER_LOGD(id, a0, a1)      ESP32_WIFIMANAGER_LOG_WRITE(ESP32_WIFIMANAGER_LOG_LEVEL_DEBUG, id, a0, a1)
+#else
+#define ESP32_WIFIMANAGER_LOGD(id, a0, a1)      ((void)0)
+#endif
+
+#endif
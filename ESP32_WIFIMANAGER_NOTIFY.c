@@ -0,0 +1,293 @@
+/**************************************************
+* ESP32 WIFI-MANAGER EVENT NOTIFICATIONS
+*
+* SEE ESP32_WIFIMANAGER_NOTIFY.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_NOTIFY.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+#define NOTIFY_RING_MASK        (ESP32_WIFIMANAGER_NOTIFY_RING_LEN - 1)
+
+//INTERNAL TYPES
+typedef struct
+{
+    esp32_wifimanager_notify_cb_t cb;   //NULL = FREE
+    void* arg;
+    uint32_t mask;
+    const esp32_wifimanager_t* source;  //NULL = ANY INSTANCE
+}notify_subscriber_t;
+
+//INTERNAL VARIABLES
+static notify_subscriber_t s_notify_subscribers[ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS];
+static portMUX_TYPE s_notify_lock = portMUX_INITIALIZER_UNLOCKED;
+
+//PRODUCERS (ANY MANAGER INSTANCE) RESERVE, FILL AND PUBLISH A SLOT UNDER s_notify_post_lock
+static esp32_wifimanager_notify_t s_notify_ring[ESP32_WIFIMANAGER_NOTIFY_RING_LEN];
+static portMUX_TYPE s_notify_post_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t s_notify_head;     //PRODUCERS, UNDER s_notify_post_lock
+static volatile uint32_t s_notify_tail;     //CONSUMER (NOTIFY TASK OR DRAINING MANAGER) ONLY
+static uint32_t s_notify_seq;
+static TaskHandle_t s_notify_task_handle;
+static volatile bool s_notify_draining;     //NO TASK: A MANAGER IS DRAINING THE RING
+
+//SUBSCRIBER BEING CALLED (-1 = NONE) AND THE TASK CALLING IT. SET UNDER THE LOCK
+static volatile int8_t s_notify_calling = -1;
+static TaskHandle_t s_notify_calling_task;
+
+static esp32_wifimanager_notify_stats_t s_notify_stats;
+
+//INTERNAL FUNCTIONS
+static void s_notify_task(void* pArg);
+static void s_notify_drain(void);
+static void s_notify_dispatch(const esp32_wifimanager_notify_t* notify);
+
+void ESP32_WIFIMANAGER_NOTIFY_Start(void)
+{
+    //START THE NOTIFY TASK (ONCE)
+
+    if(s_notify_task_handle != NULL)
+    {
+        return;
+    }
+    if(xTaskCreate(s_notify_task,
+                    "wifimanager_ntf",
+                    ESP32_WIFIMANAGER_NOTIFY_TASK_STACK_SIZE,
+                    NULL,
+                    ESP32_WIFIMANAGER_NOTIFY_TASK_PRIORITY,
+                    &s_notify_task_handle) != pdPASS)
+    {
+        //FALL BACK TO DELIVERING FROM THE MANAGER CONTEXT
+        s_notify_task_handle = NULL;
+        ets_printf(ESP32_WIFIMANAGER_TAG" : Notify task start failed\n");
+    }
+}
+
+esp_err_t ESP32_WIFIMANAGER_NOTIFY_Subscribe(esp32_wifimanager_notify_cb_t cb,
+                                                void* arg,
+                                                uint32_t mask,
+                                                const esp32_wifimanager_t* source)
+{
+    //ADD SUBSCRIBER OR UPDATE THE MASK AND SOURCE OF AN EXISTING ONE
+
+    esp_err_t err = ESP_ERR_NO_MEM;
+    int free_slot = -1;
+    uint8_t i;
+
+    if(cb == NULL || (mask & ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_notify_lock);
+    for(i = 0; i < ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; i++)
+    {
+        if(s_notify_subscribers[i].cb == cb && s_notify_subscribers[i].arg == arg)
+        {
+            s_notify_subscribers[i].mask = mask;
+            s_notify_subscribers[i].source = source;
+            err = ESP_OK;
+            break;
+        }
+        if(s_notify_subscribers[i].cb == NULL && free_slot < 0)
+        {
+            free_slot = i;
+        }
+    }
+    if(err != ESP_OK && free_slot >= 0)
+    {
+        s_notify_subscribers[free_slot].cb = cb;
+        s_notify_subscribers[free_slot].arg = arg;
+        s_notify_subscribers[free_slot].mask = mask;
+        s_notify_subscribers[free_slot].source = source;
+        s_notify_stats.subscribers++;
+        err = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_notify_lock);
+
+    return err;
+}
+
+esp_err_t ESP32_WIFIMANAGER_NOTIFY_Unsubscribe(esp32_wifimanager_notify_cb_t cb, void* arg)
+{
+    //REMOVE SUBSCRIBER
+    //RETURNS ONCE NO CALL TO IT IS RUNNING, SO arg CAN BE FREED AFTERWARDS
+    //(NOT WAITED FOR WHEN CALLED FROM INSIDE THE CALLBACK ITSELF)
+
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    bool wait = false;
+    uint8_t i;
+
+    portENTER_CRITICAL(&s_notify_lock);
+    for(i = 0; i < ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; i++)
+    {
+        if(s_notify_subscribers[i].cb != NULL &&
+            s_notify_subscribers[i].cb == cb && s_notify_subscribers[i].arg == arg)
+        {
+            s_notify_subscribers[i].cb = NULL;
+            s_notify_subscribers[i].mask = 0;
+            s_notify_stats.subscribers--;
+            wait = (s_notify_calling == i && s_notify_calling_task != self);
+            err = ESP_OK;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_notify_lock);
+
+    //A CALL STARTED BEFORE THE SLOT WAS CLEARED. WAIT FOR IT
+    while(wait && __atomic_load_n(&s_notify_calling, __ATOMIC_ACQUIRE) == i)
+    {
+        vTaskDelay(1);
+    }
+
+    return err;
+}
+
+void ESP32_WIFIMANAGER_NOTIFY_Post(const esp32_wifimanager_notify_t* notify)
+{
+    //COPY EVENT INTO THE RING AND WAKE THE NOTIFY TASK
+    //ANY MANAGER CONTEXT (MULTI PRODUCER). NEVER BLOCKS ON SUBSCRIBERS
+
+    uint32_t head;
+    esp32_wifimanager_notify_t* slot;
+    bool dropped = false;
+
+    portENTER_CRITICAL(&s_notify_post_lock);
+    s_notify_stats.posted++;
+    head = s_notify_head;
+    if(head - __atomic_load_n(&s_notify_tail, __ATOMIC_ACQUIRE) >= ESP32_WIFIMANAGER_NOTIFY_RING_LEN)
+    {
+        s_notify_stats.dropped++;
+        dropped = true;
+    }
+    else
+    {
+        slot = &s_notify_ring[head & NOTIFY_RING_MASK];
+        *slot = *notify;
+        slot->seq = ++s_notify_seq;
+        slot->ts_us = esp_timer_get_time();
+        __atomic_store_n(&s_notify_head, head + 1, __ATOMIC_RELEASE);
+    }
+    portEXIT_CRITICAL(&s_notify_post_lock);
+
+    if(dropped)
+    {
+        return;
+    }
+    if(s_notify_task_handle != NULL)
+    {
+        xTaskNotifyGive(s_notify_task_handle);
+    }
+    else
+    {
+        s_notify_drain();
+    }
+}
+
+void ESP32_WIFIMANAGER_NOTIFY_GetStats(esp32_wifimanager_notify_stats_t* stats)
+{
+    //COPY OF THE NOTIFY STATISTICS
+
+    *stats = s_notify_stats;
+}
+
+static void s_notify_task(void* pArg)
+{
+    //DELIVER POSTED EVENTS IN ORDER, THEN SLEEP UNTIL THE NEXT POST
+
+    uint32_t tail;
+
+    for(;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        tail = s_notify_tail;
+        while(tail != __atomic_load_n(&s_notify_head, __ATOMIC_ACQUIRE))
+        {
+            s_notify_dispatch(&s_notify_ring[tail & NOTIFY_RING_MASK]);
+            tail++;
+            //SLOT BELONGS TO THE PRODUCER AGAIN
+            __atomic_store_n(&s_notify_tail, tail, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+static void s_notify_drain(void)
+{
+    //NO NOTIFY TASK. THE POSTING MANAGER DELIVERS, ONE DRAINER AT A TIME
+    //A POST LANDING JUST AS THE DRAINER LETS GO IS PICKED UP BY THE RE-CHECK
+
+    uint32_t tail;
+    bool expected = false;
+
+    while(__atomic_compare_exchange_n(&s_notify_draining, &expected, true, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        tail = s_notify_tail;
+        while(tail != __atomic_load_n(&s_notify_head, __ATOMIC_ACQUIRE))
+        {
+            s_notify_dispatch(&s_notify_ring[tail & NOTIFY_RING_MASK]);
+            tail++;
+            __atomic_store_n(&s_notify_tail, tail, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&s_notify_draining, false, __ATOMIC_RELEASE);
+        if(tail == __atomic_load_n(&s_notify_head, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+        expected = false;
+    }
+}
+
+static void s_notify_dispatch(const esp32_wifimanager_notify_t* notify)
+{
+    //CALL EVERY SUBSCRIBER WHOSE MASK HAS THIS EVENT AND WHOSE SOURCE MATCHES
+    //THE ENTRY IS READ UNDER THE LOCK, THE CALLBACK RUNS OUTSIDE IT.
+    //s_notify_calling TELLS UNSUBSCRIBE A CALL IS IN FLIGHT
+
+    notify_subscriber_t sub;
+    uint32_t bit = ESP32_WIFIMANAGER_NOTIFY_MASK(notify->type);
+    int64_t start;
+    uint32_t took;
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; i++)
+    {
+        portENTER_CRITICAL(&s_notify_lock);
+        sub = s_notify_subscribers[i];
+        if(sub.source != NULL && sub.source != notify->source)
+        {
+            sub.cb = NULL;
+        }
+        if(sub.cb != NULL && (sub.mask & bit) != 0)
+        {
+            s_notify_calling = i;
+            s_notify_calling_task = xTaskGetCurrentTaskHandle();
+        }
+        portEXIT_CRITICAL(&s_notify_lock);
+
+        if(sub.cb == NULL || (sub.mask & bit) == 0)
+        {
+            continue;
+        }
+
+        start = esp_timer_get_time();
+        sub.cb(notify, sub.arg);
+        __atomic_store_n(&s_notify_calling, -1, __ATOMIC_RELEASE);
+        took = (uint32_t)(esp_timer_get_time() - start);
+        if(took > s_notify_stats.max_cb_us)
+        {
+            s_notify_stats.max_cb_us = took;
+        }
+    }
+
+    s_notify_stats.last_latency_us = (uint32_t)(esp_timer_get_time() - notify->ts_us);
+    if(s_notify_stats.last_latency_us > s_notify_stats.max_latency_us)
+    {
+        s_notify_stats.max_latency_us = s_notify_stats.last_latency_us;
+    }
+}
@@ -0,0 +1,38 @@
+/**************************************************
+* ESP32 WIFI-MANAGER EVENT NOTIFICATIONS
+*
+* FIXED TABLE OF SUBSCRIBERS, EACH WITH AN EVENT MASK
+* AND AN OPTIONAL SOURCE INSTANCE
+*
+* EVERY MANAGER INSTANCE POSTS AN EVENT BY COPYING IT
+* ONCE INTO A MULTI PRODUCER / SINGLE CONSUMER RING
+* AND WAKING THE NOTIFY TASK. PRODUCERS ONLY HOLD A
+* SHORT SPINLOCK FOR THE COPY. THE TASK HANDS EVERY
+* MATCHING SUBSCRIBER A CONST POINTER TO THAT RING
+* SLOT, SO A SLOW SUBSCRIBER DELAYS OTHER SUBSCRIBERS
+* BUT NEVER A MANAGER. A FULL RING DROPS THE NEW EVENT
+*
+* IF THE TASK CANNOT BE STARTED, THE POSTING MANAGER
+* DRAINS THE RING ITSELF. ONE DRAINS AT A TIME, SO
+* SUBSCRIBERS ARE STILL NEVER CALLED CONCURRENTLY
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_NOTIFY_
+#define _ESP32_WIFIMANAGER_NOTIFY_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+void ESP32_WIFIMANAGER_NOTIFY_Start(void);
+//source NULL = EVENTS OF EVERY INSTANCE
+esp_err_t ESP32_WIFIMANAGER_NOTIFY_Subscribe(esp32_wifimanager_notify_cb_t cb,
+                                                void* arg,
+                                                uint32_t mask,
+                                                const esp32_wifimanager_t* source);
+esp_err_t ESP32_WIFIMANAGER_NOTIFY_Unsubscribe(esp32_wifimanager_notify_cb_t cb, void* arg);
+//ANY MANAGER CONTEXT. NEVER BLOCKS ON SUBSCRIBERS
+void ESP32_WIFIMANAGER_NOTIFY_Post(const esp32_wifimanager_notify_t* notify);
+void ESP32_WIFIMANAGER_NOTIFY_GetStats(esp32_wifimanager_notify_stats_t* stats);
+
+#endif
@@ -0,0 +1,293 @@
+/**************************************************
+* ESP32 WIFI-MANAGER PROVISIONING PAYLOAD PARSER
+*
+* SEE ESP32_WIFIMANAGER_PARSER.h
+*
+* ALL STATE LIVES IN THE CALLER SUPPLIED
+* esp32_wifimanager_parser_t. NO HEAP, NO RECURSION,
+* ONE PASS PER BYTE
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_PARSER.h"
+#include <string.h>
+
+//INTERNAL TYPES
+typedef enum
+{
+    PARSER_FORM_KEY = 0,
+    PARSER_FORM_VALUE,
+    PARSER_FORM_PCT1,
+    PARSER_FORM_PCT2,
+    PARSER_TLV_TYPE,
+    PARSER_TLV_LEN,
+    PARSER_TLV_VALUE
+}parser_state_t;
+
+//INTERNAL FUNCTIONS
+static void s_parser_select_form_key(esp32_wifimanager_parser_t* parser);
+static void s_parser_select_tlv_type(esp32_wifimanager_parser_t* parser, uint8_t type);
+static bool s_parser_put(esp32_wifimanager_parser_t* parser, char c);
+static int8_t s_parser_hex(uint8_t c);
+
+void ESP32_WIFIMANAGER_PARSER_Init(esp32_wifimanager_parser_t* parser,
+                                    esp32_wifimanager_parser_format_t format,
+                                    esp32_wifimanager_provision_data_t* out)
+{
+    //RESET PARSER AND OUTPUT
+
+    memset(parser, 0, sizeof(esp32_wifimanager_parser_t));
+    memset(out, 0, sizeof(esp32_wifimanager_provision_data_t));
+    parser->format = format;
+    parser->out = out;
+    parser->status = ESP32_WIFIMANAGER_PARSER_OK;
+    parser->state = (format == ESP32_WIFIMANAGER_PARSER_FORMAT_TLV) ? PARSER_TLV_TYPE : PARSER_FORM_KEY;
+}
+
+esp32_wifimanager_parser_status_t ESP32_WIFIMANAGER_PARSER_Feed(esp32_wifimanager_parser_t* parser,
+                                                                const uint8_t* data,
+                                                                size_t len)
+{
+    //CONSUME NEXT CHUNK OF INPUT
+    //ONCE AN ERROR IS RETURNED, FURTHER INPUT IS IGNORED
+
+    size_t i;
+    uint8_t c;
+    int8_t nibble;
+
+    for(i = 0; i < len && parser->status == ESP32_WIFIMANAGER_PARSER_OK; i++)
+    {
+        c = data[i];
+
+        switch(parser->state)
+        {
+            case PARSER_FORM_KEY:
+                if(c == '=')
+                {
+                    s_parser_select_form_key(parser);
+                    parser->state = PARSER_FORM_VALUE;
+                }
+                else if(c == '&')
+                {
+                    //KEY WITHOUT VALUE
+                    parser->key_len = 0;
+                }
+                else if(parser->key_len < ESP32_WIFIMANAGER_PARSER_KEY_LEN)
+                {
+                    parser->key[parser->key_len++] = c;
+                }
+                else
+                {
+                    //TOO LONG FOR ANY KNOWN KEY. MARK AS UNKNOWN
+                    parser->key_len = ESP32_WIFIMANAGER_PARSER_KEY_LEN + 1;
+                }
+                break;
+
+            case PARSER_FORM_VALUE:
+                if(c == '&')
+                {
+                    parser->key_len = 0;
+                    parser->dst = NULL;
+                    parser->state = PARSER_FORM_KEY;
+                }
+                else if(c == '%')
+                {
+                    parser->state = PARSER_FORM_PCT1;
+                }
+                else if(!s_parser_put(parser, (c == '+') ? ' ' : (char)c))
+                {
+                    parser->status = ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW;
+                }
+                break;
+
+            case PARSER_FORM_PCT1:
+            case PARSER_FORM_PCT2:
+                nibble = s_parser_hex(c);
+                if(nibble < 0)
+                {
+                    parser->status = ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX;
+                    break;
+                }
+                if(parser->state == PARSER_FORM_PCT1)
+                {
+                    parser->hex = nibble << 4;
+                    parser->state = PARSER_FORM_PCT2;
+                    break;
+                }
+                parser->state = PARSER_FORM_VALUE;
+                if(!s_parser_put(parser, (char)(parser->hex | nibble)))
+                {
+                    parser->status = ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW;
+                }
+                break;
+
+            case PARSER_TLV_TYPE:
+                s_parser_select_tlv_type(parser, c);
+                parser->state = PARSER_TLV_LEN;
+                break;
+
+            case PARSER_TLV_LEN:
+                parser->tlv_remaining = c;
+                if(parser->dst != NULL && (size_t)c >= parser->dst_size)
+                {
+                    parser->status = ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW;
+                    break;
+                }
+                parser->state = (c == 0) ? PARSER_TLV_TYPE : PARSER_TLV_VALUE;
+                break;
+
+            case PARSER_TLV_VALUE:
+                s_parser_put(parser, (char)c);
+                if(--parser->tlv_remaining == 0)
+                {
+                    parser->state = PARSER_TLV_TYPE;
+                }
+                break;
+
+            default:
+                parser->status = ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX;
+                break;
+        }
+    }
+
+    return parser->status;
+}
+
+esp32_wifimanager_parser_status_t ESP32_WIFIMANAGER_PARSER_Finish(esp32_wifimanager_parser_t* parser)
+{
+    //END OF INPUT. CHECK NOTHING IS LEFT HALF DONE AND SSID IS PRESENT
+
+    if(parser->status != ESP32_WIFIMANAGER_PARSER_OK)
+    {
+        return parser->status;
+    }
+
+    if(parser->state == PARSER_FORM_PCT1 ||
+        parser->state == PARSER_FORM_PCT2 ||
+        parser->state == PARSER_TLV_LEN ||
+        parser->state == PARSER_TLV_VALUE)
+    {
+        parser->status = ESP32_WIFIMANAGER_PARSER_ERR_INCOMPLETE;
+    }
+    else if(parser->out->ssid[0] == 0)
+    {
+        parser->status = ESP32_WIFIMANAGER_PARSER_ERR_NO_SSID;
+    }
+
+    return parser->status;
+}
+
+bool ESP32_WIFIMANAGER_PARSER_CopyString(char* dst, size_t dst_size, const char* src)
+{
+    //BOUNDED STRING COPY
+
+    size_t len;
+
+    if(dst == NULL || src == NULL || dst_size == 0)
+    {
+        return false;
+    }
+    len = strnlen(src, dst_size);
+    if(len >= dst_size)
+    {
+        return false;
+    }
+    memcpy(dst, src, len + 1);
+    return true;
+}
+
+static void s_parser_select_form_key(esp32_wifimanager_parser_t* parser)
+{
+    //POINT DST AT THE OUTPUT FIELD FOR THE KEY JUST READ
+
+    parser->dst = NULL;
+    parser->dst_len = 0;
+
+    if(parser->key_len == 4 && memcmp(parser->key, "ssid", 4) == 0)
+    {
+        parser->dst = parser->out->ssid;
+        parser->dst_size = sizeof(parser->out->ssid);
+    }
+    else if(parser->key_len == 3 && memcmp(parser->key, "pwd", 3) == 0)
+    {
+        parser->dst = parser->out->pwd;
+        parser->dst_size = sizeof(parser->out->pwd);
+    }
+    else if(parser->key_len == 2 && parser->key[0] == 'f' &&
+            parser->key[1] >= '0' && parser->key[1] < '0' + ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT)
+    {
+        parser->dst = parser->out->custom[parser->key[1] - '0'];
+        parser->dst_size = sizeof(parser->out->custom[0]);
+    }
+
+    if(parser->dst != NULL)
+    {
+        //LAST OCCURRENCE OF A KEY WINS
+        memset(parser->dst, 0, parser->dst_size);
+    }
+}
+
+static void s_parser_select_tlv_type(esp32_wifimanager_parser_t* parser, uint8_t type)
+{
+    //POINT DST AT THE OUTPUT FIELD FOR THE TLV TYPE JUST READ
+
+    parser->dst = NULL;
+    parser->dst_len = 0;
+
+    if(type == ESP32_WIFIMANAGER_PARSER_TLV_SSID)
+    {
+        parser->dst = parser->out->ssid;
+        parser->dst_size = sizeof(parser->out->ssid);
+    }
+    else if(type == ESP32_WIFIMANAGER_PARSER_TLV_PWD)
+    {
+        parser->dst = parser->out->pwd;
+        parser->dst_size = sizeof(parser->out->pwd);
+    }
+    else if(type >= ESP32_WIFIMANAGER_PARSER_TLV_CUSTOM &&
+            type < ESP32_WIFIMANAGER_PARSER_TLV_CUSTOM + ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT)
+    {
+        parser->dst = parser->out->custom[type - ESP32_WIFIMANAGER_PARSER_TLV_CUSTOM];
+        parser->dst_size = sizeof(parser->out->custom[0]);
+    }
+
+    if(parser->dst != NULL)
+    {
+        memset(parser->dst, 0, parser->dst_size);
+    }
+}
+
+static bool s_parser_put(esp32_wifimanager_parser_t* parser, char c)
+{
+    //APPEND ONE BYTE TO CURRENT VALUE. ALWAYS KEEPS ROOM FOR THE NULL
+
+    if(parser->dst == NULL)
+    {
+        //VALUE OF AN UNKNOWN KEY
+        return true;
+    }
+    if(parser->dst_len + 1 >= parser->dst_size)
+    {
+        return false;
+    }
+    parser->dst[parser->dst_len++] = c;
+    return true;
+}
+
+static int8_t s_parser_hex(uint8_t c)
+{
+    //HEX DIGIT VALUE. -1 IF NOT A HEX DIGIT
+
+    if(c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
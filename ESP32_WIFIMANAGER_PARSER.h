@@ -0,0 +1,88 @@
+/**************************************************
+* ESP32 WIFI-MANAGER PROVISIONING PAYLOAD PARSER
+*
+* INCREMENTAL, ALLOCATION FREE DECODER FOR
+* PROVISIONING PAYLOADS. BYTES CAN BE FED IN ANY
+* CHUNK SIZE AS THEY ARRIVE. OUTPUT GOES STRAIGHT
+* INTO FIXED BUFFERS SIZED BY ESP32_WIFIMANAGER_SSID_LEN,
+* ESP32_WIFIMANAGER_SSID_PWD_LEN AND
+* ESP32_WIFIMANAGER_CUSTOM_FIELD_VALUE_LEN. A VALUE
+* THAT DOES NOT FIT IS AN ERROR, NEVER TRUNCATED
+*
+*  FORM  ssid=..&pwd=..&f0=..&fN=..
+*        (application/x-www-form-urlencoded)
+*
+*  TLV   [TYPE:1][LEN:1][VALUE:LEN] ...
+*        TYPE 0x01 = SSID
+*        TYPE 0x02 = PASSWORD
+*        TYPE 0x10 + N = CUSTOM FIELD N
+*        UNKNOWN TYPES ARE SKIPPED
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_PARSER_
+#define _ESP32_WIFIMANAGER_PARSER_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stddef.h>
+
+#define ESP32_WIFIMANAGER_PARSER_TLV_SSID           (0x01)
+#define ESP32_WIFIMANAGER_PARSER_TLV_PWD            (0x02)
+#define ESP32_WIFIMANAGER_PARSER_TLV_CUSTOM         (0x10)
+
+#define ESP32_WIFIMANAGER_PARSER_KEY_LEN            (4) //LONGEST KNOWN FORM KEY
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_PARSER_FORMAT_FORM = 0,
+    ESP32_WIFIMANAGER_PARSER_FORMAT_TLV
+}esp32_wifimanager_parser_format_t;
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_PARSER_OK = 0,
+    ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW,
+    ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX,
+    ESP32_WIFIMANAGER_PARSER_ERR_INCOMPLETE,
+    ESP32_WIFIMANAGER_PARSER_ERR_NO_SSID
+}esp32_wifimanager_parser_status_t;
+
+typedef struct
+{
+    char ssid[ESP32_WIFIMANAGER_SSID_LEN + 1];
+    char pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN + 1];
+    char custom[ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT][ESP32_WIFIMANAGER_CUSTOM_FIELD_VALUE_LEN + 1];
+}esp32_wifimanager_provision_data_t;
+
+typedef struct
+{
+    esp32_wifimanager_parser_format_t format;
+    esp32_wifimanager_parser_status_t status;
+    esp32_wifimanager_provision_data_t* out;
+    uint8_t state;
+
+    //CURRENT VALUE DESTINATION (NULL = SKIP VALUE)
+    char* dst;
+    size_t dst_size;
+    size_t dst_len;
+
+    //FORM
+    char key[ESP32_WIFIMANAGER_PARSER_KEY_LEN];
+    uint8_t key_len;
+    uint8_t hex;
+
+    //TLV
+    uint8_t tlv_remaining;
+}esp32_wifimanager_parser_t;
+
+void ESP32_WIFIMANAGER_PARSER_Init(esp32_wifimanager_parser_t* parser,
+                                    esp32_wifimanager_parser_format_t format,
+                                    esp32_wifimanager_provision_data_t* out);
+esp32_wifimanager_parser_status_t ESP32_WIFIMANAGER_PARSER_Feed(esp32_wifimanager_parser_t* parser,
+                                                                const uint8_t* data,
+                                                                size_t len);
+esp32_wifimanager_parser_status_t ESP32_WIFIMANAGER_PARSER_Finish(esp32_wifimanager_parser_t* parser);
+
+//BOUNDED STRING COPY. FALSE (AND DST UNTOUCHED) IF SRC DOES NOT FIT IN DST_SIZE - 1
+bool ESP32_WIFIMANAGER_PARSER_CopyString(char* dst, size_t dst_size, const char* src);
+
+#endif
@@ -0,0 +1,230 @@
+/**************************************************
+* ESP32 WIFI-MANAGER WPA2 PMK CACHE
+*
+* SEE ESP32_WIFIMANAGER_PMK.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_PMK.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/md.h"
+#include "mbedtls/pkcs5.h"
+#include "mbedtls/sha256.h"
+#include <string.h>
+
+//BACKGROUND JOB STATES
+typedef enum
+{
+    PMK_JOB_IDLE = 0,
+    PMK_JOB_RUNNING,
+    PMK_JOB_DONE
+}pmk_job_state_t;
+
+//INTERNAL FUNCTIONS
+static void s_pmk_job_task(void* pArg);
+static void s_pmk_job_clear(esp32_wifimanager_pmk_job_t* job);
+
+bool ESP32_WIFIMANAGER_PMK_IsPassphrase(const uint8_t* pwd, size_t max)
+{
+    //WPA2 PASSPHRASE IS 8..63 CHARACTERS. 64 IS ALREADY A HEX PSK, 0 IS OPEN
+
+    size_t len = strnlen((const char*)pwd, max);
+
+    return (len >= 8 && len <= 63);
+}
+
+void ESP32_WIFIMANAGER_PMK_Tag(const uint8_t* ssid, size_t ssid_len,
+                                const uint8_t* pwd, size_t pwd_len,
+                                uint8_t* tag)
+{
+    //CACHE KEY: SHA-256(SSID LENGTH | SSID | PASSPHRASE), TRUNCATED
+
+    mbedtls_sha256_context ctx;
+    uint8_t len = (uint8_t)ssid_len;
+    uint8_t digest[32];
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts_ret(&ctx, 0);
+    mbedtls_sha256_update_ret(&ctx, &len, 1);
+    mbedtls_sha256_update_ret(&ctx, ssid, ssid_len);
+    mbedtls_sha256_update_ret(&ctx, pwd, pwd_len);
+    mbedtls_sha256_finish_ret(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+
+    memcpy(tag, digest, ESP32_WIFIMANAGER_PMK_TAG_LEN);
+}
+
+esp_err_t ESP32_WIFIMANAGER_PMK_Derive(const uint8_t* ssid, size_t ssid_len,
+                                        const uint8_t* pwd, size_t pwd_len,
+                                        uint8_t* pmk)
+{
+    //PMK = PBKDF2-HMAC-SHA1(PASSPHRASE, SSID, 4096, 32) (IEEE 802.11i)
+
+    mbedtls_md_context_t ctx;
+    int ret;
+
+    mbedtls_md_init(&ctx);
+    ret = mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1);
+    if(ret == 0)
+    {
+        ret = mbedtls_pkcs5_pbkdf2_hmac(&ctx, pwd, pwd_len, ssid, ssid_len,
+                                        4096, ESP32_WIFIMANAGER_PMK_LEN, pmk);
+    }
+    mbedtls_md_free(&ctx);
+
+    return (ret == 0) ? ESP_OK : ESP_FAIL;
+}
+
+bool ESP32_WIFIMANAGER_PMK_Lookup(esp32_wifimanager_pmk_cache_t* cache, const uint8_t* tag, uint8_t* pmk)
+{
+    //COPY OUT THE PMK FOR A TAG. MARKS THE ENTRY AS USED
+
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_PMK_CACHE_SIZE; i++)
+    {
+        if(cache->entries[i].last_used != 0 &&
+            memcmp(cache->entries[i].tag, tag, ESP32_WIFIMANAGER_PMK_TAG_LEN) == 0)
+        {
+            cache->entries[i].last_used = ++cache->clock;
+            memcpy(pmk, cache->entries[i].pmk, ESP32_WIFIMANAGER_PMK_LEN);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ESP32_WIFIMANAGER_PMK_Insert(esp32_wifimanager_pmk_cache_t* cache,
+                                    const uint8_t* tag,
+                                    uint32_t ssid_hash,
+                                    const uint8_t* pmk)
+{
+    //STORE A NEW PMK OVER THE SAME SSID'S STALE ONE, AN EMPTY SLOT OR THE LRU
+
+    esp32_wifimanager_pmk_entry_t* slot = &cache->entries[0];
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_PMK_CACHE_SIZE; i++)
+    {
+        if(cache->entries[i].last_used != 0 && cache->entries[i].ssid_hash == ssid_hash)
+        {
+            slot = &cache->entries[i];
+            break;
+        }
+        if(cache->entries[i].last_used < slot->last_used)
+        {
+            slot = &cache->entries[i];
+        }
+    }
+
+    memcpy(slot->tag, tag, ESP32_WIFIMANAGER_PMK_TAG_LEN);
+    memcpy(slot->pmk, pmk, ESP32_WIFIMANAGER_PMK_LEN);
+    slot->ssid_hash = ssid_hash;
+    slot->last_used = ++cache->clock;
+}
+
+void ESP32_WIFIMANAGER_PMK_ToHex(const uint8_t* pmk, uint8_t* hex)
+{
+    //64 LOWER CASE HEX DIGITS, AS THE DRIVER TAKES A RAW PSK. NOT NULL TERMINATED
+
+    static const char digits[] = "0123456789abcdef";
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_PMK_LEN; i++)
+    {
+        hex[2 * i] = digits[pmk[i] >> 4];
+        hex[2 * i + 1] = digits[pmk[i] & 0x0F];
+    }
+}
+
+esp_err_t ESP32_WIFIMANAGER_PMK_DeriveStart(esp32_wifimanager_pmk_job_t* job,
+                                            const uint8_t* ssid, size_t ssid_len,
+                                            const uint8_t* pwd, size_t pwd_len,
+                                            void (*done)(void* arg),
+                                            void* arg)
+{
+    //START DERIVING A PMK ON THE JOB TASK. FAILS WHILE THE JOB IS PENDING
+
+    if(ssid_len > ESP32_WIFIMANAGER_SSID_LEN || pwd_len > ESP32_WIFIMANAGER_SSID_PWD_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) != PMK_JOB_IDLE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memcpy(job->ssid, ssid, ssid_len);
+    memcpy(job->pwd, pwd, pwd_len);
+    job->ssid_len = ssid_len;
+    job->pwd_len = pwd_len;
+    job->done = done;
+    job->arg = arg;
+    __atomic_store_n(&job->state, PMK_JOB_RUNNING, __ATOMIC_RELEASE);
+
+    if(xTaskCreate(s_pmk_job_task,
+                    "wifimanager_pmk",
+                    ESP32_WIFIMANAGER_PMK_TASK_STACK_SIZE,
+                    job,
+                    ESP32_WIFIMANAGER_PMK_TASK_PRIORITY,
+                    NULL) != pdPASS)
+    {
+        s_pmk_job_clear(job);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ESP32_WIFIMANAGER_PMK_DeriveTake(esp32_wifimanager_pmk_job_t* job, uint8_t* pmk, int64_t* derive_us)
+{
+    //COPY OUT A FINISHED JOB'S PMK AND FREE THE JOB
+
+    esp_err_t err;
+
+    if(__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) != PMK_JOB_DONE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    err = job->err;
+    if(err == ESP_OK)
+    {
+        memcpy(pmk, job->pmk, ESP32_WIFIMANAGER_PMK_LEN);
+        *derive_us = job->derive_us;
+    }
+    s_pmk_job_clear(job);
+    return err;
+}
+
+static void s_pmk_job_task(void* pArg)
+{
+    //DERIVE, PUBLISH, TELL THE OWNER, EXIT
+    //THE OWNER MAY REUSE THE JOB ONCE IT IS DONE, SO done AND arg ARE READ FIRST
+
+    esp32_wifimanager_pmk_job_t* job = (esp32_wifimanager_pmk_job_t*)pArg;
+    int64_t start_us = esp_timer_get_time();
+    void (*done)(void* arg) = job->done;
+    void* arg = job->arg;
+
+    job->err = ESP32_WIFIMANAGER_PMK_Derive(job->ssid, job->ssid_len,
+                                            job->pwd, job->pwd_len,
+                                            job->pmk);
+    job->derive_us = esp_timer_get_time() - start_us;
+    memset(job->pwd, 0, sizeof(job->pwd));
+    __atomic_store_n(&job->state, PMK_JOB_DONE, __ATOMIC_RELEASE);
+
+    if(done != NULL)
+    {
+        (*done)(arg);
+    }
+    vTaskDelete(NULL);
+}
+
+static void s_pmk_job_clear(esp32_wifimanager_pmk_job_t* job)
+{
+    //WIPE KEY MATERIAL AND MAKE THE JOB FREE
+
+    memset((void*)job, 0, sizeof(*job));
+    __atomic_store_n(&job->state, PMK_JOB_IDLE, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,85 @@
+/**************************************************
+* ESP32 WIFI-MANAGER WPA2 PMK CACHE
+*
+* THE SUPPLICANT RUNS PBKDF2-SHA1 (4096 ROUNDS) ON
+* THE PASSPHRASE AT EVERY ASSOCIATION. THE MANAGER
+* DERIVES THE PMK ONCE PER (SSID, PASSPHRASE), KEEPS
+* IT HERE (PERSISTED TO NVS BY THE CALLER) AND
+* CONNECTS WITH THE 64 HEX DIGIT PSK INSTEAD
+*
+* ENTRIES ARE KEYED BY A SHA-256 TAG OF SSID AND
+* PASSPHRASE, SO CHANGING EITHER MISSES THE CACHE.
+* INSERTING A PMK FOR AN SSID DROPS ITS OLD ENTRY,
+* ELSE THE LEAST RECENTLY USED ONE IS REPLACED
+*
+* PBKDF2 TAKES HUNDREDS OF ms, SO A MISS IS DERIVED
+* BY A ONE SHOT JOB ON ITS OWN TASK. EACH OWNER HAS
+* ITS OWN JOB HANDLE, ONE JOB AT A TIME PER HANDLE.
+* done RUNS ON THE JOB TASK, THE OWNER THEN TAKES
+* THE RESULT FROM ITS OWN CONTEXT (TAKE GIVES
+* INVALID_STATE WHILE THE JOB STILL RUNS)
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_PMK_
+#define _ESP32_WIFIMANAGER_PMK_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ESP32_WIFIMANAGER_PMK_LEN           (32)
+#define ESP32_WIFIMANAGER_PMK_TAG_LEN       (16)
+
+typedef struct
+{
+    uint8_t tag[ESP32_WIFIMANAGER_PMK_TAG_LEN];
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    uint32_t ssid_hash;
+    uint32_t last_used;         //0 = EMPTY SLOT
+}esp32_wifimanager_pmk_entry_t;
+
+typedef struct
+{
+    esp32_wifimanager_pmk_entry_t entries[ESP32_WIFIMANAGER_PMK_CACHE_SIZE];
+    uint32_t clock;
+}esp32_wifimanager_pmk_cache_t;
+
+//BACKGROUND JOB. OWNER WRITES IT WHILE IDLE, THE JOB TASK WHILE RUNNING
+//ZERO INITIALIZED = IDLE
+typedef struct
+{
+    volatile uint8_t state;
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    size_t ssid_len;
+    size_t pwd_len;
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    esp_err_t err;
+    int64_t derive_us;
+    void (*done)(void* arg);
+    void* arg;
+}esp32_wifimanager_pmk_job_t;
+
+bool ESP32_WIFIMANAGER_PMK_IsPassphrase(const uint8_t* pwd, size_t max);
+void ESP32_WIFIMANAGER_PMK_Tag(const uint8_t* ssid, size_t ssid_len,
+                                const uint8_t* pwd, size_t pwd_len,
+                                uint8_t* tag);
+esp_err_t ESP32_WIFIMANAGER_PMK_Derive(const uint8_t* ssid, size_t ssid_len,
+                                        const uint8_t* pwd, size_t pwd_len,
+                                        uint8_t* pmk);
+bool ESP32_WIFIMANAGER_PMK_Lookup(esp32_wifimanager_pmk_cache_t* cache, const uint8_t* tag, uint8_t* pmk);
+void ESP32_WIFIMANAGER_PMK_Insert(esp32_wifimanager_pmk_cache_t* cache,
+                                    const uint8_t* tag,
+                                    uint32_t ssid_hash,
+                                    const uint8_t* pmk);
+void ESP32_WIFIMANAGER_PMK_ToHex(const uint8_t* pmk, uint8_t* hex);
+
+esp_err_t ESP32_WIFIMANAGER_PMK_DeriveStart(esp32_wifimanager_pmk_job_t* job,
+                                            const uint8_t* ssid, size_t ssid_len,
+                                            const uint8_t* pwd, size_t pwd_len,
+                                            void (*done)(void* arg),
+                                            void* arg);
+esp_err_t ESP32_WIFIMANAGER_PMK_DeriveTake(esp32_wifimanager_pmk_job_t* job, uint8_t* pmk, int64_t* derive_us);
+
+#endif
@@ -0,0 +1,93 @@
+/**************************************************
+* ESP32 WIFI-MANAGER POWER POLICY
+*
+* SEE ESP32_WIFIMANAGER_POWER.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_POWER.h"
+
+esp32_wifimanager_power_policy_t ESP32_WIFIMANAGER_POWER_Effective(const esp32_wifimanager_power_t* power,
+                                                                    int16_t rssi_q4,
+                                                                    bool busy)
+{
+    //LEVEL TO USE NOW. CONFIGURED POLICY IS THE MOST SAVING ONE ALLOWED
+
+    esp32_wifimanager_power_policy_t policy = power->policy;
+
+    if(busy)
+    {
+        return ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    }
+    if(rssi_q4 != 0 &&
+        rssi_q4 < (int16_t)power->weak_rssi * 16 &&
+        policy != ESP32_WIFIMANAGER_POWER_PERFORMANCE)
+    {
+        policy--;
+    }
+    return policy;
+}
+
+wifi_ps_type_t ESP32_WIFIMANAGER_POWER_PsType(esp32_wifimanager_power_policy_t policy)
+{
+    //DRIVER MODEM SLEEP TYPE FOR A POLICY
+
+    switch(policy)
+    {
+        case ESP32_WIFIMANAGER_POWER_BALANCED:
+            return WIFI_PS_MIN_MODEM;
+
+        case ESP32_WIFIMANAGER_POWER_MAX_SAVE:
+            return WIFI_PS_MAX_MODEM;
+
+        default:
+            return WIFI_PS_NONE;
+    }
+}
+
+uint8_t ESP32_WIFIMANAGER_POWER_ListenInterval(const esp32_wifimanager_power_t* power)
+{
+    //MAX SAVE WAKE PERIOD IN BEACONS, ROUNDED UP TO A WHOLE NUMBER OF DTIMS
+
+    uint8_t dtim = (power->dtim_period == 0) ? 1 : power->dtim_period;
+    uint16_t interval = (power->listen_interval == 0) ? dtim : power->listen_interval;
+
+    interval = ((interval + dtim - 1) / dtim) * dtim;
+    return (interval > 255) ? (255 / dtim) * dtim : (uint8_t)interval;
+}
+
+uint16_t ESP32_WIFIMANAGER_POWER_DutyPermille(const esp32_wifimanager_power_t* power,
+                                                esp32_wifimanager_power_policy_t policy)
+{
+    //ESTIMATED FRACTION OF TIME THE RADIO IS ON, 1/1000
+
+    uint32_t period_us;
+
+    switch(policy)
+    {
+        case ESP32_WIFIMANAGER_POWER_BALANCED:
+            period_us = ((power->dtim_period == 0) ? 1 : power->dtim_period) * ESP32_WIFIMANAGER_POWER_BEACON_US;
+            break;
+
+        case ESP32_WIFIMANAGER_POWER_MAX_SAVE:
+            period_us = ESP32_WIFIMANAGER_POWER_ListenInterval(power) * ESP32_WIFIMANAGER_POWER_BEACON_US;
+            break;
+
+        default:
+            return 1000;
+    }
+    if(period_us <= ESP32_WIFIMANAGER_POWER_WAKE_US)
+    {
+        return 1000;
+    }
+    return (uint16_t)((ESP32_WIFIMANAGER_POWER_WAKE_US * 1000 + period_us / 2) / period_us);
+}
+
+uint32_t ESP32_WIFIMANAGER_POWER_AvgMw(uint16_t duty_permille)
+{
+    //AVERAGE POWER FOR A RADIO DUTY CYCLE (= mWh PER HOUR)
+
+    uint32_t ua = ESP32_WIFIMANAGER_POWER_SLEEP_MA * 1000 +
+                    (ESP32_WIFIMANAGER_POWER_ACTIVE_MA - ESP32_WIFIMANAGER_POWER_SLEEP_MA) * duty_permille;
+
+    return (uint32_t)(((uint64_t)ua * ESP32_WIFIMANAGER_POWER_SUPPLY_MV) / 1000000);
+}
@@ -0,0 +1,35 @@
+/**************************************************
+* ESP32 WIFI-MANAGER POWER POLICY
+*
+* PURE FUNCTIONS (NO DRIVER CALLS) USED BY THE
+* MANAGER TO PICK THE MODEM SLEEP LEVEL WHILE
+* CONNECTED AND TO ESTIMATE WHAT IT COSTS
+*
+*  - AN ACTIVITY HINT (APP IS BUSY) FORCES PERFORMANCE
+*  - A WEAK LINK STEPS BACK ONE LEVEL: LONG SLEEPS
+*    MISS TOO MANY BEACONS ON A MARGINAL SIGNAL
+*  - MAX SAVE LISTEN INTERVAL IS ROUNDED UP TO A
+*    MULTIPLE OF THE DTIM PERIOD SO EVERY WAKEUP
+*    LANDS ON A DTIM BEACON (BUFFERED BROADCASTS)
+*  - RADIO DUTY CYCLE AND POWER ARE A SIMPLE MODEL:
+*    ON FOR POWER_WAKE_US PER WAKEUP, ELSE ASLEEP
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_POWER_
+#define _ESP32_WIFIMANAGER_POWER_
+
+#include "ESP32_WIFIMANAGER.h"
+#include "esp_wifi_types.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+esp32_wifimanager_power_policy_t ESP32_WIFIMANAGER_POWER_Effective(const esp32_wifimanager_power_t* power,
+                                                                    int16_t rssi_q4,
+                                                                    bool busy);
+wifi_ps_type_t ESP32_WIFIMANAGER_POWER_PsType(esp32_wifimanager_power_policy_t policy);
+uint8_t ESP32_WIFIMANAGER_POWER_ListenInterval(const esp32_wifimanager_power_t* power);
+uint16_t ESP32_WIFIMANAGER_POWER_DutyPermille(const esp32_wifimanager_power_t* power,
+                                                esp32_wifimanager_power_policy_t policy);
+uint32_t ESP32_WIFIMANAGER_POWER_AvgMw(uint16_t duty_permille);
+
+#endif
@@ -0,0 +1,97 @@
+/**************************************************
+* ESP32 WIFI-MANAGER ROAMING DECISIONS
+*
+* SEE ESP32_WIFIMANAGER_ROAM.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_ROAM.h"
+#include <string.h>
+
+//INTERNAL FUNCTIONS
+static bool s_roam_other_bssid(const esp32_wifimanager_scan_entry_t* ap,
+                                const uint8_t* ssid,
+                                const uint8_t* cur_bssid);
+
+int16_t ESP32_WIFIMANAGER_ROAM_Smooth(int16_t rssi_q4, int8_t sample)
+{
+    //RSSI EWMA IN 1/16 dBm (1/4 NEW SAMPLE). 0 = NO SAMPLE YET
+
+    if(rssi_q4 == 0)
+    {
+        return (int16_t)sample * 16;
+    }
+    return rssi_q4 + (((int16_t)sample * 16) - rssi_q4) / 4;
+}
+
+bool ESP32_WIFIMANAGER_ROAM_ShouldScan(const esp32_wifimanager_roam_t* roam,
+                                        int16_t rssi_q4,
+                                        int64_t now_us,
+                                        int64_t last_roam_us)
+{
+    //WEAK SIGNAL AND NOT RATE LIMITED
+
+    if(rssi_q4 == 0 || rssi_q4 >= (int16_t)roam->rssi_threshold * 16)
+    {
+        return false;
+    }
+    return (last_roam_us == 0 || (now_us - last_roam_us) >= (int64_t)roam->min_interval_ms * 1000);
+}
+
+uint16_t ESP32_WIFIMANAGER_ROAM_Channels(const esp32_wifimanager_scan_entry_t* const* aps,
+                                            uint8_t count,
+                                            const uint8_t* ssid,
+                                            const uint8_t* cur_bssid)
+{
+    //BIT N SET = SCAN CHANNEL N
+
+    uint16_t mask = 0;
+    uint8_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        if(s_roam_other_bssid(aps[i], ssid, cur_bssid) &&
+            aps[i]->channel >= 1 && aps[i]->channel <= ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX)
+        {
+            mask |= (1 << aps[i]->channel);
+        }
+    }
+    return mask;
+}
+
+int8_t ESP32_WIFIMANAGER_ROAM_Pick(const esp32_wifimanager_scan_entry_t* const* aps,
+                                    uint8_t count,
+                                    const uint8_t* ssid,
+                                    const uint8_t* cur_bssid,
+                                    int8_t cur_rssi,
+                                    uint8_t hysteresis_db,
+                                    int64_t seen_after_us)
+{
+    //STRONGEST CANDIDATE BY WHAT THIS ROAM SCAN MEASURED. -1 = STAY
+
+    uint8_t i;
+    int8_t best = -1;
+
+    for(i = 0; i < count; i++)
+    {
+        if(aps[i]->last_seen_us < seen_after_us || !s_roam_other_bssid(aps[i], ssid, cur_bssid))
+        {
+            continue;
+        }
+        if((int16_t)aps[i]->last_rssi >= (int16_t)cur_rssi + hysteresis_db &&
+            (best < 0 || aps[i]->last_rssi > aps[best]->last_rssi))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static bool s_roam_other_bssid(const esp32_wifimanager_scan_entry_t* ap,
+                                const uint8_t* ssid,
+                                const uint8_t* cur_bssid)
+{
+    //SAME SSID, DIFFERENT BSSID
+
+    return (strncmp((const char*)ap->ssid, (const char*)ssid, ESP32_WIFIMANAGER_SSID_LEN) == 0 &&
+            memcmp(ap->bssid, cur_bssid, 6) != 0);
+}
@@ -0,0 +1,41 @@
+/**************************************************
+* ESP32 WIFI-MANAGER ROAMING DECISIONS
+*
+* PURE FUNCTIONS (NO DRIVER CALLS) USED BY THE
+* MANAGER TO DECIDE WHEN TO LOOK FOR A BETTER BSSID,
+* WHICH CHANNELS TO SCAN AND WHERE TO GO
+*
+*  - SCAN WHEN THE SMOOTHED RSSI IS BELOW THRESHOLD
+*    AND THE LAST ROAM SCAN IS OLD ENOUGH
+*  - SCAN ONLY CHANNELS WHERE THE SCAN CACHE KNOWS
+*    OTHER BSSIDS OF THE SAME SSID (NONE = ALL)
+*  - GO TO THE STRONGEST SAME SSID BSSID SEEN BY THIS
+*    ROAM SCAN THAT BEATS THE CURRENT ONE BY AT LEAST
+*    THE HYSTERESIS
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_ROAM_
+#define _ESP32_WIFIMANAGER_ROAM_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+int16_t ESP32_WIFIMANAGER_ROAM_Smooth(int16_t rssi_q4, int8_t sample);
+bool ESP32_WIFIMANAGER_ROAM_ShouldScan(const esp32_wifimanager_roam_t* roam,
+                                        int16_t rssi_q4,
+                                        int64_t now_us,
+                                        int64_t last_roam_us);
+uint16_t ESP32_WIFIMANAGER_ROAM_Channels(const esp32_wifimanager_scan_entry_t* const* aps,
+                                            uint8_t count,
+                                            const uint8_t* ssid,
+                                            const uint8_t* cur_bssid);
+int8_t ESP32_WIFIMANAGER_ROAM_Pick(const esp32_wifimanager_scan_entry_t* const* aps,
+                                    uint8_t count,
+                                    const uint8_t* ssid,
+                                    const uint8_t* cur_bssid,
+                                    int8_t cur_rssi,
+                                    uint8_t hysteresis_db,
+                                    int64_t seen_after_us);
+
+#endif
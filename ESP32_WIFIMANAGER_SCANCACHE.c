@@ -0,0 +1,199 @@
+/**************************************************
+* ESP32 WIFI-MANAGER SCAN CACHE
+*
+* SEE ESP32_WIFIMANAGER_SCANCACHE.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_SCANCACHE.h"
+#include <string.h>
+
+//INTERNAL FUNCTIONS
+static int8_t s_scancache_lookup(esp32_wifimanager_scancache_t* cache, const uint8_t* bssid);
+static int8_t s_scancache_alloc(esp32_wifimanager_scancache_t* cache);
+static void s_scancache_remove(esp32_wifimanager_scancache_t* cache, uint8_t slot);
+static void s_scancache_sort(esp32_wifimanager_scancache_t* cache);
+
+void ESP32_WIFIMANAGER_SCANCACHE_Update(esp32_wifimanager_scancache_t* cache,
+                                        const wifi_ap_record_t* records,
+                                        uint16_t count,
+                                        uint8_t channel,
+                                        int64_t now_us)
+{
+    //MERGE SCAN RESULTS FOR CHANNEL (0 = ALL CHANNELS) INTO THE CACHE
+
+    esp32_wifimanager_scan_entry_t* entry;
+    uint16_t i;
+    uint8_t slot;
+    int8_t found;
+
+    for(i = 0; i < count; i++)
+    {
+        found = s_scancache_lookup(cache, records[i].bssid);
+        if(found < 0)
+        {
+            found = s_scancache_alloc(cache);
+            entry = &cache->entries[found];
+            memset(entry, 0, sizeof(esp32_wifimanager_scan_entry_t));
+            memcpy(entry->bssid, records[i].bssid, 6);
+            entry->rssi_q4 = (int16_t)records[i].rssi * 16;
+        }
+        else
+        {
+            entry = &cache->entries[found];
+            entry->rssi_q4 += (((int16_t)records[i].rssi * 16) - entry->rssi_q4) / 4;
+        }
+        memcpy(entry->ssid, records[i].ssid, ESP32_WIFIMANAGER_SSID_LEN);
+        entry->ssid[ESP32_WIFIMANAGER_SSID_LEN] = 0;
+        entry->channel = records[i].primary;
+        entry->authmode = (uint8_t)records[i].authmode;
+        entry->last_rssi = records[i].rssi;
+        entry->rssi = (int8_t)(entry->rssi_q4 / 16);
+        entry->misses = 0;
+        entry->last_seen_us = now_us;
+    }
+
+    //ENTRIES ON THE SCANNED CHANNEL(S) THAT WERE NOT SEEN
+    for(slot = 0; slot < ESP32_WIFIMANAGER_SCAN_CACHE_SIZE; slot++)
+    {
+        entry = &cache->entries[slot];
+        if(!cache->used[slot] || entry->last_seen_us == now_us)
+        {
+            continue;
+        }
+        if(channel == ESP32_WIFIMANAGER_SCANCACHE_ALL_CHANNELS || entry->channel == channel)
+        {
+            if(++entry->misses >= ESP32_WIFIMANAGER_SCAN_CACHE_MISS_LIMIT)
+            {
+                s_scancache_remove(cache, slot);
+            }
+        }
+    }
+
+    ESP32_WIFIMANAGER_SCANCACHE_Expire(cache, now_us);
+    s_scancache_sort(cache);
+}
+
+void ESP32_WIFIMANAGER_SCANCACHE_Expire(esp32_wifimanager_scancache_t* cache, int64_t now_us)
+{
+    //DROP ENTRIES NOT SEEN FOR MAX AGE
+
+    uint8_t slot;
+    uint8_t before = cache->count;
+
+    for(slot = 0; slot < ESP32_WIFIMANAGER_SCAN_CACHE_SIZE; slot++)
+    {
+        if(cache->used[slot] &&
+            (now_us - cache->entries[slot].last_seen_us) > (int64_t)ESP32_WIFIMANAGER_SCAN_CACHE_MAX_AGE_MS * 1000)
+        {
+            s_scancache_remove(cache, slot);
+        }
+    }
+    if(cache->count != before)
+    {
+        s_scancache_sort(cache);
+    }
+}
+
+uint8_t ESP32_WIFIMANAGER_SCANCACHE_Sorted(esp32_wifimanager_scancache_t* cache,
+                                            const esp32_wifimanager_scan_entry_t** results,
+                                            uint8_t max)
+{
+    //POINTERS TO CACHED ENTRIES, STRONGEST FIRST
+
+    uint8_t i;
+
+    for(i = 0; i < cache->count && i < max; i++)
+    {
+        results[i] = &cache->entries[cache->sorted[i]];
+    }
+    return i;
+}
+
+const esp32_wifimanager_scan_entry_t* ESP32_WIFIMANAGER_SCANCACHE_Find(esp32_wifimanager_scancache_t* cache,
+                                                                        const uint8_t* bssid)
+{
+    //CACHED ENTRY FOR BSSID. NULL IF NOT CACHED
+
+    int8_t slot = s_scancache_lookup(cache, bssid);
+
+    return (slot < 0) ? NULL : &cache->entries[slot];
+}
+
+void ESP32_WIFIMANAGER_SCANCACHE_Clear(esp32_wifimanager_scancache_t* cache)
+{
+    //EMPTY THE CACHE
+
+    memset(cache->used, 0, sizeof(cache->used));
+    cache->count = 0;
+}
+
+static int8_t s_scancache_lookup(esp32_wifimanager_scancache_t* cache, const uint8_t* bssid)
+{
+    //SLOT HOLDING BSSID. -1 IF NOT CACHED
+
+    uint8_t slot;
+
+    for(slot = 0; slot < ESP32_WIFIMANAGER_SCAN_CACHE_SIZE; slot++)
+    {
+        if(cache->used[slot] && memcmp(cache->entries[slot].bssid, bssid, 6) == 0)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static int8_t s_scancache_alloc(esp32_wifimanager_scancache_t* cache)
+{
+    //FREE SLOT, OR THE LEAST RECENTLY SEEN ONE WHEN FULL
+
+    uint8_t slot;
+    uint8_t oldest = 0;
+
+    for(slot = 0; slot < ESP32_WIFIMANAGER_SCAN_CACHE_SIZE; slot++)
+    {
+        if(!cache->used[slot])
+        {
+            cache->used[slot] = true;
+            cache->count++;
+            return slot;
+        }
+        if(cache->entries[slot].last_seen_us < cache->entries[oldest].last_seen_us)
+        {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+static void s_scancache_remove(esp32_wifimanager_scancache_t* cache, uint8_t slot)
+{
+    //FREE SLOT. SORTED INDEX IS REBUILT BY THE CALLER
+
+    cache->used[slot] = false;
+    cache->count--;
+}
+
+static void s_scancache_sort(esp32_wifimanager_scancache_t* cache)
+{
+    //REBUILD SORTED INDEX (INSERTION SORT, CACHE IS SMALL)
+
+    uint8_t slot;
+    uint8_t n = 0;
+    uint8_t j;
+
+    for(slot = 0; slot < ESP32_WIFIMANAGER_SCAN_CACHE_SIZE; slot++)
+    {
+        if(!cache->used[slot])
+        {
+            continue;
+        }
+        j = n++;
+        while(j > 0 && cache->entries[cache->sorted[j - 1]].rssi_q4 < cache->entries[slot].rssi_q4)
+        {
+            cache->sorted[j] = cache->sorted[j - 1];
+            j--;
+        }
+        cache->sorted[j] = slot;
+    }
+}
@@ -0,0 +1,50 @@
+/**************************************************
+* ESP32 WIFI-MANAGER SCAN CACHE
+*
+* BOUNDED CACHE OF NEARBY ACCESS POINTS, KEYED BY
+* BSSID. FED FROM EVERY SCAN (FULL OR SINGLE CHANNEL)
+*
+* - RSSI IS AN EWMA (1/4 NEW SAMPLE) OVER SCANS
+* - ENTRIES EXPIRE BY AGE, OR AFTER BEING MISSED BY
+*   SCANS OF THEIR OWN CHANNEL
+* - WHEN FULL, THE OLDEST ENTRY IS REPLACED
+* - A SORTED INDEX (STRONGEST FIRST) IS KEPT, SO
+*   QUERIES RETURN POINTERS WITHOUT COPYING
+*
+* ONE CACHE PER MANAGER INSTANCE. ONLY CALLED FROM
+* THAT INSTANCE'S MANAGER CONTEXT
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_SCANCACHE_
+#define _ESP32_WIFIMANAGER_SCANCACHE_
+
+#include "ESP32_WIFIMANAGER.h"
+#include "esp_wifi_types.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ESP32_WIFIMANAGER_SCANCACHE_ALL_CHANNELS    (0)
+
+typedef struct
+{
+    esp32_wifimanager_scan_entry_t entries[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    bool used[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    //ENTRY INDEXES, STRONGEST SMOOTHED RSSI FIRST
+    uint8_t sorted[ESP32_WIFIMANAGER_SCAN_CACHE_SIZE];
+    uint8_t count;
+}esp32_wifimanager_scancache_t;
+
+void ESP32_WIFIMANAGER_SCANCACHE_Update(esp32_wifimanager_scancache_t* cache,
+                                        const wifi_ap_record_t* records,
+                                        uint16_t count,
+                                        uint8_t channel,
+                                        int64_t now_us);
+void ESP32_WIFIMANAGER_SCANCACHE_Expire(esp32_wifimanager_scancache_t* cache, int64_t now_us);
+uint8_t ESP32_WIFIMANAGER_SCANCACHE_Sorted(esp32_wifimanager_scancache_t* cache,
+                                            const esp32_wifimanager_scan_entry_t** results,
+                                            uint8_t max);
+const esp32_wifimanager_scan_entry_t* ESP32_WIFIMANAGER_SCANCACHE_Find(esp32_wifimanager_scancache_t* cache,
+                                                                        const uint8_t* bssid);
+void ESP32_WIFIMANAGER_SCANCACHE_Clear(esp32_wifimanager_scancache_t* cache);
+
+#endif
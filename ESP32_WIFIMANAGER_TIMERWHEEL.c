@@ -0,0 +1,213 @@
+/**************************************************
+* ESP32 WIFI-MANAGER SOFTWARE TIMER WHEEL
+*
+* SEE ESP32_WIFIMANAGER_TIMERWHEEL.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_TIMERWHEEL.h"
+#include "esp_timer.h"
+#include <string.h>
+
+//INTERNAL FUNCTIONS
+static uint32_t s_timerwheel_now_tick(void);
+static void s_timerwheel_insert(esp32_wifimanager_timer_t* timer);
+static void s_timerwheel_unlink(esp32_wifimanager_timer_t* timer);
+
+void ESP32_WIFIMANAGER_TIMERWHEEL_Setup(esp32_wifimanager_timerwheel_t* wheel,
+                                        esp32_wifimanager_timer_t* timer,
+                                        void (*cb)(void* pArg),
+                                        void* arg)
+{
+    //INITIALIZE A TIMER ON wheel. MUST NOT BE ARMED
+
+    memset(timer, 0, sizeof(esp32_wifimanager_timer_t));
+    timer->wheel = wheel;
+    timer->cb = cb;
+    timer->arg = arg;
+}
+
+void ESP32_WIFIMANAGER_TIMERWHEEL_Start(esp32_wifimanager_timer_t* timer,
+                                        uint32_t delay_ms,
+                                        bool periodic)
+{
+    //(RE)ARM TIMER TO FIRE AFTER DELAY_MS (ROUNDED UP TO A TICK)
+    //DELAY COUNTS FROM NOW, NOT FROM THE LAST ADVANCE. THE CALLER MAY
+    //HAVE BEEN BLOCKED FOR A WHILE WITH current_tick BEHIND
+
+    esp32_wifimanager_timerwheel_t* wheel = timer->wheel;
+    uint32_t ticks = (delay_ms + ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS - 1) / ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+    uint32_t now = s_timerwheel_now_tick();
+
+    if(!wheel->started)
+    {
+        wheel->current_tick = now;
+        wheel->started = true;
+    }
+
+    if(ticks == 0)
+    {
+        ticks = 1;
+    }
+
+    if(timer->armed)
+    {
+        s_timerwheel_unlink(timer);
+    }
+
+    timer->period_ticks = periodic ? ticks : 0;
+    timer->expiry_tick = now + ticks;
+    s_timerwheel_insert(timer);
+}
+
+void ESP32_WIFIMANAGER_TIMERWHEEL_Stop(esp32_wifimanager_timer_t* timer)
+{
+    //DISARM TIMER. NO-OP IF NOT ARMED
+
+    if(timer->armed)
+    {
+        s_timerwheel_unlink(timer);
+    }
+}
+
+bool ESP32_WIFIMANAGER_TIMERWHEEL_IsArmed(esp32_wifimanager_timer_t* timer)
+{
+    return timer->armed;
+}
+
+uint32_t ESP32_WIFIMANAGER_TIMERWHEEL_Advance(esp32_wifimanager_timerwheel_t* wheel)
+{
+    //PROCESS ALL TICKS ELAPSED SINCE LAST CALL AND FIRE DUE TIMERS
+    //RETURNS NUMBER OF TIMERS FIRED
+
+    uint32_t now = s_timerwheel_now_tick();
+    uint32_t elapsed;
+    uint32_t i;
+    uint32_t fired = 0;
+    esp32_wifimanager_timer_t* timer;
+    esp32_wifimanager_timer_t* next;
+
+    if(!wheel->started || wheel->armed_count == 0)
+    {
+        wheel->current_tick = now;
+        return 0;
+    }
+
+    elapsed = now - wheel->current_tick;
+    if(elapsed > ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS)
+    {
+        //EVERY SLOT IS VISITED ONCE ANYWAY
+        elapsed = ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS;
+    }
+
+    for(i = 1; i <= elapsed; i++)
+    {
+        timer = wheel->slots[(wheel->current_tick + i) & (ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS - 1)];
+        while(timer != NULL)
+        {
+            next = timer->next;
+            if((int32_t)(timer->expiry_tick - now) <= 0)
+            {
+                s_timerwheel_unlink(timer);
+                if(timer->period_ticks != 0)
+                {
+                    timer->expiry_tick = now + timer->period_ticks;
+                    s_timerwheel_insert(timer);
+                }
+                fired++;
+                //CB MAY RE ARM OR STOP ANY TIMER. RESTART SLOT WALK
+                (*timer->cb)(timer->arg);
+                next = wheel->slots[(wheel->current_tick + i) & (ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS - 1)];
+            }
+            timer = next;
+        }
+    }
+
+    wheel->current_tick = now;
+    return fired;
+}
+
+uint32_t ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(esp32_wifimanager_timerwheel_t* wheel)
+{
+    //TIME UNTIL NEXT TIMER EXPIRY
+    //ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER IF NOTHING ARMED
+    //TIMERS MORE THAN ONE REVOLUTION AWAY REPORT ONE REVOLUTION
+
+    uint32_t d;
+    uint32_t now;
+    esp32_wifimanager_timer_t* timer;
+
+    if(wheel->armed_count == 0)
+    {
+        return ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER;
+    }
+
+    now = s_timerwheel_now_tick();
+
+    for(d = 0; d <= ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS; d++)
+    {
+        timer = wheel->slots[(wheel->current_tick + d) & (ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS - 1)];
+        for(; timer != NULL; timer = timer->next)
+        {
+            if((int32_t)(timer->expiry_tick - (wheel->current_tick + d)) <= 0)
+            {
+                //DUE (OR OVERDUE) RELATIVE TO REAL TIME
+                if((int32_t)(timer->expiry_tick - now) <= 0)
+                {
+                    return 0;
+                }
+                return (timer->expiry_tick - now) * ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+            }
+        }
+    }
+
+    return ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS * ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS;
+}
+
+static uint32_t s_timerwheel_now_tick(void)
+{
+    //MONOTONIC WHEEL TICK FROM SYSTEM TIME
+
+    return (uint32_t)(esp_timer_get_time() / (1000LL * ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS));
+}
+
+static void s_timerwheel_insert(esp32_wifimanager_timer_t* timer)
+{
+    //PUSH TIMER AT HEAD OF ITS SLOT
+
+    esp32_wifimanager_timerwheel_t* wheel = timer->wheel;
+    esp32_wifimanager_timer_t** slot = &wheel->slots[timer->expiry_tick & (ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS - 1)];
+
+    timer->prev = NULL;
+    timer->next = *slot;
+    if(*slot != NULL)
+    {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+    timer->armed = true;
+    wheel->armed_count++;
+}
+
+static void s_timerwheel_unlink(esp32_wifimanager_timer_t* timer)
+{
+    //REMOVE TIMER FROM ITS SLOT
+
+    esp32_wifimanager_timerwheel_t* wheel = timer->wheel;
+
+    if(timer->prev != NULL)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        wheel->slots[timer->expiry_tick & (ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS - 1)] = timer->next;
+    }
+    if(timer->next != NULL)
+    {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->armed = false;
+    wheel->armed_count--;
+}
@@ -0,0 +1,64 @@
+/**************************************************
+* ESP32 WIFI-MANAGER SOFTWARE TIMER WHEEL
+*
+* HASHED TIMING WHEEL USED FOR ALL MODULE TIMEOUTS
+* (STATUS LED, RECONNECT BACKOFF, DHCP RENEW, ...)
+* NO HARDWARE TIMER IS USED. THE WHEEL IS ADVANCED
+* BY THE MANAGER (QUEUE CONSUMER) CONTEXT, WHICH IS
+* ALSO WHERE ALL CALLBACKS RUN
+*
+* EACH MANAGER INSTANCE OWNS ONE WHEEL. A TIMER IS
+* BOUND TO ITS WHEEL BY SETUP
+*
+* START AND STOP ARE O(1). ONLY CALL THEM FROM THE
+* CONTEXT THAT ADVANCES THE WHEEL
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_TIMERWHEEL_
+#define _ESP32_WIFIMANAGER_TIMERWHEEL_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS        (50)
+#define ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS          (64) //POWER OF 2
+#define ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER       (0xFFFFFFFF)
+
+struct esp32_wifimanager_timerwheel_s;
+
+typedef struct esp32_wifimanager_timer_s
+{
+    struct esp32_wifimanager_timerwheel_s* wheel;
+    struct esp32_wifimanager_timer_s* next;
+    struct esp32_wifimanager_timer_s* prev;
+    uint32_t expiry_tick;
+    uint32_t period_ticks;  //0 = ONE SHOT
+    void (*cb)(void* pArg);
+    void* arg;
+    bool armed;
+}esp32_wifimanager_timer_t;
+
+//EACH SLOT IS A DOUBLY LINKED LIST OF TIMERS EXPIRING ON
+//A TICK THAT MAPS TO IT (ANY ROUND)
+typedef struct esp32_wifimanager_timerwheel_s
+{
+    esp32_wifimanager_timer_t* slots[ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS];
+    uint32_t current_tick;
+    bool started;
+    uint32_t armed_count;
+}esp32_wifimanager_timerwheel_t;
+
+void ESP32_WIFIMANAGER_TIMERWHEEL_Setup(esp32_wifimanager_timerwheel_t* wheel,
+                                        esp32_wifimanager_timer_t* timer,
+                                        void (*cb)(void* pArg),
+                                        void* arg);
+void ESP32_WIFIMANAGER_TIMERWHEEL_Start(esp32_wifimanager_timer_t* timer,
+                                        uint32_t delay_ms,
+                                        bool periodic);
+void ESP32_WIFIMANAGER_TIMERWHEEL_Stop(esp32_wifimanager_timer_t* timer);
+bool ESP32_WIFIMANAGER_TIMERWHEEL_IsArmed(esp32_wifimanager_timer_t* timer);
+
+uint32_t ESP32_WIFIMANAGER_TIMERWHEEL_Advance(esp32_wifimanager_timerwheel_t* wheel);
+uint32_t ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(esp32_wifimanager_timerwheel_t* wheel);
+
+#endif
@@ -0,0 +1,88 @@
+/**************************************************
+* ESP32 WIFI-MANAGER INPUT TRACE RECORDER
+*
+* SEE ESP32_WIFIMANAGER_TRACE.h
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_TRACE.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include <string.h>
+
+#define TRACE_MASK              (ESP32_WIFIMANAGER_TRACE_LEN - 1)
+
+void ESP32_WIFIMANAGER_TRACE_Record(esp32_wifimanager_trace_t* trace,
+                                    esp32_wifimanager_trace_kind_t kind,
+                                    uint8_t type,
+                                    uint32_t arg,
+                                    uint16_t lag_us)
+{
+    //APPEND ONE RECORD, OVERWRITING THE OLDEST WHEN FULL
+
+    uint32_t pos = trace->head;
+    esp32_wifimanager_trace_record_t* rec = &trace->ring[pos & TRACE_MASK];
+
+    rec->ts_us = (uint32_t)esp_timer_get_time();
+    rec->arg = arg;
+    rec->kind = (uint8_t)kind;
+    rec->type = type;
+    rec->lag_us = lag_us;
+    __atomic_store_n(&trace->head, pos + 1, __ATOMIC_RELEASE);
+}
+
+uint16_t ESP32_WIFIMANAGER_TRACE_Export(esp32_wifimanager_trace_t* trace,
+                                        esp32_wifimanager_trace_record_t* records,
+                                        uint16_t max)
+{
+    //COPY THE NEWEST (UP TO max) RECORDS, OLDEST FIRST. RETURNS HOW MANY
+
+    uint32_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+    uint32_t count = (head < ESP32_WIFIMANAGER_TRACE_LEN) ? head : ESP32_WIFIMANAGER_TRACE_LEN;
+    uint32_t first;
+    uint32_t valid_from;
+    uint32_t i;
+
+    if(count > max)
+    {
+        count = max;
+    }
+    first = head - count;
+    for(i = 0; i < count; i++)
+    {
+        records[i] = trace->ring[(first + i) & TRACE_MASK];
+    }
+
+    //A RECORD IS STALE IF THE WRITER HAS SINCE REUSED (OR IS REUSING) ITS SLOT
+    head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+    if(head >= ESP32_WIFIMANAGER_TRACE_LEN)
+    {
+        valid_from = head - ESP32_WIFIMANAGER_TRACE_LEN + 1;
+        if(valid_from > first)
+        {
+            i = valid_from - first;
+            if(i >= count)
+            {
+                return 0;
+            }
+            memmove(records, &records[i], (count - i) * sizeof(esp32_wifimanager_trace_record_t));
+            count -= i;
+        }
+    }
+    return (uint16_t)count;
+}
+
+void ESP32_WIFIMANAGER_TRACE_Dump(esp32_wifimanager_trace_t* trace)
+{
+    //PRINT THE RING, OLDEST FIRST, ONE #WT LINE PER RECORD
+    //DECODE WITH tools/tracedecode.py
+
+    esp32_wifimanager_trace_record_t rec;
+    uint32_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+    uint32_t pos = (head < ESP32_WIFIMANAGER_TRACE_LEN) ? 0 : head - ESP32_WIFIMANAGER_TRACE_LEN + 1;
+
+    for(; pos != head; pos++)
+    {
+        rec = trace->ring[pos & TRACE_MASK];
+        ets_printf("#WT%08x%02x%02x%04x%08x\n", rec.ts_us, rec.kind, rec.type, rec.lag_us, rec.arg);
+    }
+}
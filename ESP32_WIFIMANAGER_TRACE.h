@@ -0,0 +1,40 @@
+/**************************************************
+* ESP32 WIFI-MANAGER INPUT TRACE RECORDER
+*
+* FLIGHT RECORDER OF EVERY INPUT THE MANAGER ACTS ON:
+* PROCESSED EVENTS (WIFI DRIVER EVENTS WITH REASON,
+* TIMER FIRINGS, SMARTCONFIG / WEBCONFIG RESULTS) AND
+* THE VALUES IT READS FROM HARDWARE (GPIO TRIGGER
+* LEVEL, BACKOFF JITTER RANDOM, ROAMING RSSI)
+*
+* FIXED RAM RING PER MANAGER INSTANCE, OLDEST RECORD
+* OVERWRITTEN FIRST
+* RECORD IS ONLY CALLED FROM THE MANAGER CONTEXT
+* (SINGLE WRITER). EXPORT CAN RUN IN ANY TASK: IT
+* DROPS RECORDS THE WRITER OVERWROTE DURING THE COPY
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_TRACE_
+#define _ESP32_WIFIMANAGER_TRACE_
+
+#include "ESP32_WIFIMANAGER.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    esp32_wifimanager_trace_record_t ring[ESP32_WIFIMANAGER_TRACE_LEN];
+    volatile uint32_t head;     //RECORDS WRITTEN SINCE BOOT
+}esp32_wifimanager_trace_t;
+
+void ESP32_WIFIMANAGER_TRACE_Record(esp32_wifimanager_trace_t* trace,
+                                    esp32_wifimanager_trace_kind_t kind,
+                                    uint8_t type,
+                                    uint32_t arg,
+                                    uint16_t lag_us);
+uint16_t ESP32_WIFIMANAGER_TRACE_Export(esp32_wifimanager_trace_t* trace,
+                                        esp32_wifimanager_trace_record_t* records,
+                                        uint16_t max);
+void ESP32_WIFIMANAGER_TRACE_Dump(esp32_wifimanager_trace_t* trace);
+
+#endif
@@ -0,0 +1,476 @@
+/**************************************************
+* ESP32 WIFI-MANAGER WEBCONFIG PORTAL
+*
+* SEE ESP32_WIFIMANAGER_WEBCONFIG.h
+*
+* MEMORY BUDGET
+*   REQUEST BUFFER  : ESP32_WIFIMANAGER_WEBCONFIG_BUF_LEN (IN THE HANDLE)
+*   RESULT          : sizeof(esp32_wifimanager_provision_data_t) (IN THE HANDLE)
+*   BODY PARSER     : sizeof(esp32_wifimanager_parser_t) (IN THE HANDLE)
+*                     BODY IS PARSED AS IT ARRIVES, IT IS
+*                     NEVER HELD IN FULL
+*   TASK STACK      : ESP32_WIFIMANAGER_WEBCONFIG_STACK_SIZE
+*   PAGE            : IN FLASH, SENT WITHOUT COPYING
+**************************************************/
+
+#include "ESP32_WIFIMANAGER_WEBCONFIG.h"
+#include "ESP32_WIFIMANAGER_WEBCONFIG_PAGE.h"
+#include "ESP32_WIFIMANAGER_LOG.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+//INTERNAL VARIABLES
+static const char s_webconfig_hdr_page[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: close\r\n"
+    "Content-Length: ";
+static const char s_webconfig_hdr_json[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Connection: close\r\n\r\n";
+static const char s_webconfig_rsp_saved[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Connection: close\r\n\r\n"
+    "<html><body><h3>Saved. Connecting...</h3></body></html>";
+static const char s_webconfig_rsp_redirect[] =
+    "HTTP/1.1 302 Found\r\n"
+    "Location: http://192.168.4.1" ESP32_WIFIMANAGER_WEBCONFIG_PATH "\r\n"
+    "Connection: close\r\n\r\n";
+static const char s_webconfig_rsp_bad[] =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Connection: close\r\n\r\n";
+static const char s_webconfig_rsp_too_large[] =
+    "HTTP/1.1 413 Payload Too Large\r\n"
+    "Connection: close\r\n\r\n";
+
+//INTERNAL FUNCTIONS
+static void s_webconfig_task(void* pArg);
+static void s_webconfig_handle_client(esp32_wifimanager_webconfig_t* web, int fd);
+static bool s_webconfig_send(esp32_wifimanager_webconfig_t* web, int fd, const void* data, size_t len);
+static void s_webconfig_heap_sample(esp32_wifimanager_webconfig_t* web);
+static void s_webconfig_send_page(esp32_wifimanager_webconfig_t* web, int fd);
+static void s_webconfig_send_fields(esp32_wifimanager_webconfig_t* web, int fd);
+static const char* s_webconfig_header(const char* headers, const char* headers_end, const char* name);
+
+void ESP32_WIFIMANAGER_WEBCONFIG_Init(esp32_wifimanager_webconfig_t* web, uint16_t port, uint16_t dns_port)
+{
+    //RESET HANDLE AND ITS DNS RESPONDER
+
+    memset(web, 0, sizeof(*web));
+    web->listen_fd = -1;
+    web->port = (port != 0) ? port : ESP32_WIFIMANAGER_WEBCONFIG_PORT;
+    ESP32_WIFIMANAGER_DNS_Init(&web->dns, dns_port);
+}
+
+esp_err_t ESP32_WIFIMANAGER_WEBCONFIG_Start(esp32_wifimanager_webconfig_t* web,
+                                            const char (*field_names)[ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1],
+                                            uint8_t field_count,
+                                            esp32_wifimanager_webconfig_cb_t cb,
+                                            void* arg)
+{
+    //BIND THE PORT AND START WEBCONFIG TASK
+    //A TASK STILL WINDING DOWN FROM A STOP IS KEPT RUNNING
+
+    int opt = 1;
+    struct sockaddr_in addr;
+
+    web->field_names = field_names;
+    web->field_count = field_count;
+    web->cb = cb;
+    web->cb_arg = arg;
+    web->running = true;
+
+    //CAPTIVE DNS. WITHOUT IT THE PORTAL STILL WORKS BY ADDRESS
+    if(ESP32_WIFIMANAGER_DNS_Start(&web->dns) != ESP_OK)
+    {
+        ESP32_WIFIMANAGER_LOGW(DNS_FAILED, 0, 0);
+    }
+
+    if(web->task != NULL)
+    {
+        return ESP_OK;
+    }
+
+    web->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(web->listen_fd < 0)
+    {
+        web->running = false;
+        ESP32_WIFIMANAGER_DNS_Stop(&web->dns);
+        return ESP_ERR_NO_MEM;
+    }
+    setsockopt(web->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(web->port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(web->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(web->listen_fd, 2) != 0)
+    {
+        close(web->listen_fd);
+        web->listen_fd = -1;
+        web->running = false;
+        ESP32_WIFIMANAGER_DNS_Stop(&web->dns);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(xTaskCreate(s_webconfig_task,
+                    "wifimgr_web",
+                    ESP32_WIFIMANAGER_WEBCONFIG_STACK_SIZE,
+                    web,
+                    ESP32_WIFIMANAGER_WEBCONFIG_TASK_PRIORITY,
+                    &web->task) != pdPASS)
+    {
+        close(web->listen_fd);
+        web->listen_fd = -1;
+        web->running = false;
+        web->task = NULL;
+        ESP32_WIFIMANAGER_DNS_Stop(&web->dns);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ESP32_WIFIMANAGER_WEBCONFIG_Stop(esp32_wifimanager_webconfig_t* web)
+{
+    //ASK WEBCONFIG AND DNS TASKS TO EXIT
+    //TASKS NOTICE WITHIN ONE ACCEPT TIMEOUT
+
+    web->running = false;
+    ESP32_WIFIMANAGER_DNS_Stop(&web->dns);
+}
+
+void ESP32_WIFIMANAGER_WEBCONFIG_GetStats(esp32_wifimanager_webconfig_t* web, esp32_wifimanager_webconfig_stats_t* stats)
+{
+    //GET WEBCONFIG MEASUREMENTS
+
+    *stats = web->stats;
+}
+
+static void s_webconfig_task(void* pArg)
+{
+    //WEBCONFIG SERVER TASK. SERVES ONE CLIENT AT A TIME
+    //THE LISTENING SOCKET WAS BOUND BY START
+
+    esp32_wifimanager_webconfig_t* web = pArg;
+    int listen_fd = web->listen_fd;
+    int client_fd;
+    struct timeval tv;
+    fd_set fds;
+    UBaseType_t stack_free;
+    uint32_t heap_drop;
+
+    ESP32_WIFIMANAGER_LOGI(WEBCONFIG_LISTENING, web->port, 0);
+
+    while(web->running)
+    {
+        //WAIT FOR A CLIENT, WAKING UP PERIODICALLY TO CHECK FOR STOP
+        FD_ZERO(&fds);
+        FD_SET(listen_fd, &fds);
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        if(select(listen_fd + 1, &fds, NULL, NULL, &tv) <= 0)
+        {
+            continue;
+        }
+
+        client_fd = accept(listen_fd, NULL, NULL);
+        if(client_fd < 0)
+        {
+            continue;
+        }
+
+        tv.tv_sec = ESP32_WIFIMANAGER_WEBCONFIG_RECV_TIMEOUT_S;
+        tv.tv_usec = 0;
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        s_webconfig_handle_client(web, client_fd);
+
+        //LWIP HOLDS THE REPLY UNTIL IT IS ACKED, SO THE LOWEST SAMPLE IS THE PEAK
+        //SET BEFORE THE CLOSE, A CLIENT READING TO EOF SEES IT
+        heap_drop = (web->heap_start > web->heap_min) ? web->heap_start - web->heap_min : 0;
+        web->stats.last_heap = heap_drop;
+        if(heap_drop > web->stats.heap_peak)
+        {
+            web->stats.heap_peak = heap_drop;
+        }
+        close(client_fd);
+
+        stack_free = uxTaskGetStackHighWaterMark(NULL);
+        if(web->stats.stack_free_min == 0 || stack_free < web->stats.stack_free_min)
+        {
+            web->stats.stack_free_min = stack_free;
+        }
+    }
+
+    close(listen_fd);
+    web->listen_fd = -1;
+
+    ESP32_WIFIMANAGER_LOGI(WEBCONFIG_STOPPED, 0, 0);
+    web->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static void s_webconfig_handle_client(esp32_wifimanager_webconfig_t* web, int fd)
+{
+    //READ ONE REQUEST AND ANSWER IT
+
+    size_t len = 0;
+    int n;
+    char* headers_end = NULL;
+    char* path;
+    char* path_end;
+    char* body;
+    size_t body_len;
+    size_t remaining;
+    long content_length;
+    const char* value;
+    esp32_wifimanager_parser_status_t status;
+    bool is_get;
+
+    web->req_start_us = esp_timer_get_time();
+    web->first_byte_sent = false;
+    web->heap_start = esp_get_free_heap_size();
+    web->heap_min = web->heap_start;
+    web->stats.requests++;
+
+    //READ UNTIL END OF HEADERS
+    while(len < sizeof(web->buf) - 1)
+    {
+        n = recv(fd, web->buf + len, sizeof(web->buf) - 1 - len, 0);
+        s_webconfig_heap_sample(web);
+        if(n <= 0)
+        {
+            return;
+        }
+        len += n;
+        web->buf[len] = 0;
+        headers_end = strstr(web->buf, "\r\n\r\n");
+        if(headers_end != NULL)
+        {
+            break;
+        }
+    }
+    if(headers_end == NULL)
+    {
+        s_webconfig_send(web, fd, s_webconfig_rsp_too_large, sizeof(s_webconfig_rsp_too_large) - 1);
+        return;
+    }
+
+    //REQUEST LINE : METHOD SP PATH SP VERSION
+    if(strncmp(web->buf, "GET ", 4) == 0)
+    {
+        is_get = true;
+        path = web->buf + 4;
+    }
+    else if(strncmp(web->buf, "POST ", 5) == 0)
+    {
+        is_get = false;
+        path = web->buf + 5;
+    }
+    else
+    {
+        s_webconfig_send(web, fd, s_webconfig_rsp_bad, sizeof(s_webconfig_rsp_bad) - 1);
+        return;
+    }
+    path_end = strchr(path, ' ');
+    if(path_end == NULL || path_end > headers_end)
+    {
+        s_webconfig_send(web, fd, s_webconfig_rsp_bad, sizeof(s_webconfig_rsp_bad) - 1);
+        return;
+    }
+    *path_end = 0;
+
+    if(is_get)
+    {
+        if(strcmp(path, "/") == 0 || strcmp(path, ESP32_WIFIMANAGER_WEBCONFIG_PATH) == 0)
+        {
+            s_webconfig_send_page(web, fd);
+        }
+        else if(strcmp(path, "/fields") == 0)
+        {
+            s_webconfig_send_fields(web, fd);
+        }
+        else
+        {
+            s_webconfig_send(web, fd, s_webconfig_rsp_redirect, sizeof(s_webconfig_rsp_redirect) - 1);
+        }
+    }
+    else if(strcmp(path, ESP32_WIFIMANAGER_WEBCONFIG_PATH) == 0)
+    {
+        //FEED BODY TO THE PARSER AS IT ARRIVES, REUSING THE REQUEST BUFFER
+        value = s_webconfig_header(path_end + 1, headers_end, "Content-Length:");
+        content_length = (value != NULL) ? strtol(value, NULL, 10) : -1;
+        if(content_length < 0 || content_length > ESP32_WIFIMANAGER_WEBCONFIG_BODY_MAX)
+        {
+            s_webconfig_send(web, fd, s_webconfig_rsp_too_large, sizeof(s_webconfig_rsp_too_large) - 1);
+            return;
+        }
+        value = s_webconfig_header(path_end + 1, headers_end, "Content-Type:");
+        while(value != NULL && *value == ' ')
+        {
+            value++;
+        }
+        ESP32_WIFIMANAGER_PARSER_Init(&web->parser,
+                                        (value != NULL && strncasecmp(value, "application/octet-stream", 24) == 0) ?
+                                            ESP32_WIFIMANAGER_PARSER_FORMAT_TLV : ESP32_WIFIMANAGER_PARSER_FORMAT_FORM,
+                                        &web->result);
+
+        body = headers_end + 4;
+        body_len = len - (body - web->buf);
+        if(body_len > (size_t)content_length)
+        {
+            body_len = content_length;
+        }
+        remaining = content_length - body_len;
+        status = ESP32_WIFIMANAGER_PARSER_Feed(&web->parser, (const uint8_t*)body, body_len);
+        while(remaining > 0 && status == ESP32_WIFIMANAGER_PARSER_OK)
+        {
+            n = recv(fd, web->buf,
+                        (remaining < sizeof(web->buf)) ? remaining : sizeof(web->buf), 0);
+            s_webconfig_heap_sample(web);
+            if(n <= 0)
+            {
+                return;
+            }
+            remaining -= n;
+            status = ESP32_WIFIMANAGER_PARSER_Feed(&web->parser, (const uint8_t*)web->buf, n);
+        }
+
+        if(ESP32_WIFIMANAGER_PARSER_Finish(&web->parser) != ESP32_WIFIMANAGER_PARSER_OK)
+        {
+            s_webconfig_send(web, fd, s_webconfig_rsp_bad, sizeof(s_webconfig_rsp_bad) - 1);
+            return;
+        }
+        s_webconfig_send(web, fd, s_webconfig_rsp_saved, sizeof(s_webconfig_rsp_saved) - 1);
+        if(web->cb != NULL)
+        {
+            (*web->cb)(&web->result, web->cb_arg);
+        }
+    }
+    else
+    {
+        s_webconfig_send(web, fd, s_webconfig_rsp_redirect, sizeof(s_webconfig_rsp_redirect) - 1);
+    }
+
+    //MEASUREMENTS
+    if(len > web->stats.buf_peak)
+    {
+        web->stats.buf_peak = len;
+    }
+}
+
+static bool s_webconfig_send(esp32_wifimanager_webconfig_t* web, int fd, const void* data, size_t len)
+{
+    //SEND ALL DATA. RECORD TIME TO FIRST BYTE
+
+    const uint8_t* p = data;
+    int n;
+    uint32_t ttfb;
+
+    if(!web->first_byte_sent)
+    {
+        web->first_byte_sent = true;
+        ttfb = (uint32_t)(esp_timer_get_time() - web->req_start_us);
+        web->stats.last_ttfb_us = ttfb;
+        if(ttfb > web->stats.max_ttfb_us)
+        {
+            web->stats.max_ttfb_us = ttfb;
+        }
+    }
+
+    while(len > 0)
+    {
+        n = send(fd, p, len, 0);
+        s_webconfig_heap_sample(web);
+        if(n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void s_webconfig_heap_sample(esp32_wifimanager_webconfig_t* web)
+{
+    //LOWEST FREE HEAP OF THE REQUEST
+
+    uint32_t heap_now = esp_get_free_heap_size();
+
+    if(heap_now < web->heap_min)
+    {
+        web->heap_min = heap_now;
+    }
+}
+
+static void s_webconfig_send_page(esp32_wifimanager_webconfig_t* web, int fd)
+{
+    //SEND GZIPPED PAGE DIRECTLY FROM FLASH
+
+    char len_str[16];
+    int n;
+
+    n = snprintf(len_str, sizeof(len_str), "%u\r\n\r\n", (unsigned)sizeof(s_webconfig_page_gz));
+    if(s_webconfig_send(web, fd, s_webconfig_hdr_page, sizeof(s_webconfig_hdr_page) - 1) &&
+        s_webconfig_send(web, fd, len_str, n))
+    {
+        s_webconfig_send(web, fd, s_webconfig_page_gz, sizeof(s_webconfig_page_gz));
+    }
+}
+
+static void s_webconfig_send_fields(esp32_wifimanager_webconfig_t* web, int fd)
+{
+    //SEND CUSTOM FIELD NAMES AS A JSON ARRAY
+    //NAMES ARE CHECKED FOR JSON SAFE CHARACTERS WHEN ADDED
+
+    size_t len = 0;
+    uint8_t i;
+
+    web->buf[len++] = '[';
+    for(i = 0; i < web->field_count; i++)
+    {
+        len += snprintf(web->buf + len, sizeof(web->buf) - len, "%s\"%s\"",
+                        (i == 0) ? "" : ",", web->field_names[i]);
+    }
+    web->buf[len++] = ']';
+
+    if(s_webconfig_send(web, fd, s_webconfig_hdr_json, sizeof(s_webconfig_hdr_json) - 1))
+    {
+        s_webconfig_send(web, fd, web->buf, len);
+    }
+}
+
+static const char* s_webconfig_header(const char* headers, const char* headers_end, const char* name)
+{
+    //FIND HEADER (NAME INCLUDES THE ':'). RETURNS POINTER JUST PAST THE NAME, NULL IF MISSING
+
+    const char* line = headers;
+    size_t name_len = strlen(name);
+
+    while(line != NULL && line < headers_end)
+    {
+        line = strstr(line, "\r\n");
+        if(line == NULL || line >= headers_end)
+        {
+            break;
+        }
+        line += 2;
+        if(strncasecmp(line, name, name_len) == 0)
+        {
+            return line + name_len;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,71 @@
+/**************************************************
+* ESP32 WIFI-MANAGER WEBCONFIG PORTAL
+*
+* MINIMAL HTTP SERVER ON THE SOFTAP, ONE CLIENT AT
+* A TIME, FIXED BUFFERS ONLY (NO HEAP ALLOCATION BY
+* THIS MODULE)
+*
+*   GET  /, /config   GZIPPED CONFIG PAGE STRAIGHT
+*                     FROM FLASH
+*   GET  /fields      JSON LIST OF CUSTOM FIELD NAMES
+*   POST /config      ssid, pwd, f0..fN (FORM ENCODED,
+*                     OR TLV WITH CONTENT-TYPE
+*                     application/octet-stream)
+*   ANYTHING ELSE     REDIRECT TO /config
+*
+*   CAPTIVE DNS (UDP 53, ESP32_WIFIMANAGER_DNS.h)
+*   STARTS AND STOPS WITH THE PORTAL
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_WEBCONFIG_
+#define _ESP32_WIFIMANAGER_WEBCONFIG_
+
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_PARSER.h"
+#include "ESP32_WIFIMANAGER_DNS.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+//CALLED FROM THE WEBCONFIG TASK AFTER A VALID POST HAS BEEN ANSWERED
+//arg IS THE ONE GIVEN TO START
+typedef void (*esp32_wifimanager_webconfig_cb_t)(const esp32_wifimanager_provision_data_t* result, void* arg);
+
+//ONE PORTAL. EACH MANAGER INSTANCE KEEPS ITS OWN
+typedef struct
+{
+    TaskHandle_t task;
+    volatile bool running;
+    int listen_fd;
+    uint16_t port;
+    char buf[ESP32_WIFIMANAGER_WEBCONFIG_BUF_LEN];
+    esp32_wifimanager_provision_data_t result;
+    esp32_wifimanager_parser_t parser;
+    const char (*field_names)[ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1];
+    uint8_t field_count;
+    esp32_wifimanager_webconfig_cb_t cb;
+    void* cb_arg;
+
+    //PER REQUEST MEASUREMENT. FREE HEAP IS SAMPLED AFTER EVERY recv / send
+    esp32_wifimanager_webconfig_stats_t stats;
+    int64_t req_start_us;
+    bool first_byte_sent;
+    uint32_t heap_start;
+    uint32_t heap_min;
+
+    //CAPTIVE DNS, STARTS AND STOPS WITH THE PORTAL
+    esp32_wifimanager_dns_t dns;
+}esp32_wifimanager_webconfig_t;
+
+//port / dns_port 0 = ESP32_WIFIMANAGER_WEBCONFIG_PORT / ESP32_WIFIMANAGER_DNS_PORT
+void ESP32_WIFIMANAGER_WEBCONFIG_Init(esp32_wifimanager_webconfig_t* web, uint16_t port, uint16_t dns_port);
+
+//START FAILS WITH ESP_ERR_INVALID_STATE IF THE HTTP PORT IS ALREADY TAKEN
+esp_err_t ESP32_WIFIMANAGER_WEBCONFIG_Start(esp32_wifimanager_webconfig_t* web,
+                                            const char (*field_names)[ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1],
+                                            uint8_t field_count,
+                                            esp32_wifimanager_webconfig_cb_t cb,
+                                            void* arg);
+void ESP32_WIFIMANAGER_WEBCONFIG_Stop(esp32_wifimanager_webconfig_t* web);
+void ESP32_WIFIMANAGER_WEBCONFIG_GetStats(esp32_wifimanager_webconfig_t* web, esp32_wifimanager_webconfig_stats_t* stats);
+
+#endif
@@ -0,0 +1,58 @@
+/**************************************************
+* ESP32 WIFI-MANAGER WEBCONFIG PAGE
+*
+* GENERATED FROM html/config.html BY html/mkpage.py
+* DO NOT EDIT
+**************************************************/
+
+#ifndef _ESP32_WIFIMANAGER_WEBCONFIG_PAGE_
+#define _ESP32_WIFIMANAGER_WEBCONFIG_PAGE_
+
+#include <stdint.h>
+
+static const uint8_t s_webconfig_page_gz[661] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x54, 0xDB, 0x8E, 0x9B, 0x30,
+    0x10, 0x7D, 0xE7, 0x2B, 0x28, 0x55, 0x95, 0x44, 0xDD, 0x40, 0x2E, 0x7B, 0x2B, 0x90, 0x3C, 0x74,
+    0x37, 0x95, 0x56, 0xAA, 0xB4, 0x91, 0xB2, 0x52, 0xD5, 0x47, 0x07, 0x8F, 0xC3, 0x74, 0x8D, 0x4D,
+    0x6D, 0x93, 0x4B, 0xA3, 0xFC, 0x7B, 0x6D, 0x20, 0xBB, 0xA1, 0x52, 0x95, 0x48, 0xC6, 0xE3, 0x39,
+    0x67, 0x8E, 0xCF, 0x0C, 0xA4, 0x1F, 0x1E, 0x9F, 0x1F, 0x5E, 0x7E, 0x2E, 0x17, 0x7E, 0x6E, 0x0A,
+    0x3E, 0xF7, 0xD2, 0xF3, 0x02, 0x84, 0xDA, 0xA5, 0x00, 0x43, 0xFC, 0x2C, 0x27, 0x4A, 0x83, 0x99,
+    0x05, 0x95, 0x61, 0xC3, 0xFB, 0xE0, 0x1C, 0x16, 0xA4, 0x80, 0x59, 0xB0, 0x45, 0xD8, 0x95, 0x52,
+    0x99, 0xC0, 0xCF, 0xA4, 0x30, 0x20, 0x6C, 0xDA, 0x0E, 0xA9, 0xC9, 0x67, 0x14, 0xB6, 0x98, 0xC1,
+    0xB0, 0xDE, 0x5C, 0xA1, 0x40, 0x83, 0x84, 0x0F, 0x75, 0x46, 0x38, 0xCC, 0xC6, 0x8E, 0xC3, 0xA0,
+    0xE1, 0x30, 0x5F, 0xAC, 0x96, 0xD3, 0x89, 0xFF, 0x03, 0xBF, 0xA1, 0xBF, 0x02, 0x53, 0x95, 0x69,
+    0xD4, 0xC4, 0xBD, 0x54, 0x9B, 0x83, 0x5B, 0xD7, 0x92, 0x1E, 0x8E, 0xCC, 0x52, 0x0F, 0x19, 0x29,
+    0x90, 0x1F, 0x62, 0x4D, 0x84, 0x1E, 0x6A, 0x50, 0xC8, 0x92, 0x35, 0xC9, 0x5E, 0x37, 0x4A, 0x56,
+    0x82, 0xC6, 0x1F, 0xD9, 0xC4, 0xFD, 0x92, 0x82, 0xA8, 0x0D, 0x8A, 0x78, 0x94, 0x94, 0x84, 0x52,
+    0x14, 0x9B, 0x78, 0x0C, 0xC5, 0xC9, 0x63, 0x52, 0x15, 0xC7, 0x82, 0xEC, 0x1B, 0x35, 0xF1, 0x64,
+    0x02, 0xC5, 0x39, 0x93, 0x54, 0x46, 0x76, 0x89, 0x18, 0xBB, 0x04, 0x27, 0x6B, 0xA9, 0x28, 0xA8,
+    0xA1, 0x22, 0x14, 0x2B, 0x1D, 0xDF, 0x96, 0xFB, 0x93, 0x97, 0x8F, 0x1B, 0x45, 0x1A, 0xFF, 0x40,
+    0x3C, 0x0E, 0xA7, 0x6F, 0x6C, 0x43, 0x23, 0xCB, 0x78, 0x74, 0xF2, 0x38, 0x59, 0x03, 0x3F, 0x52,
+    0xD4, 0x25, 0x27, 0x87, 0x78, 0xCD, 0x65, 0xF6, 0x7A, 0x99, 0x11, 0xDE, 0x5B, 0xC4, 0x3B, 0x43,
+    0xF8, 0xC5, 0x69, 0x44, 0x51, 0x56, 0xE6, 0xD8, 0x08, 0x1C, 0x8F, 0x46, 0x9F, 0x6C, 0xE1, 0xBD,
+    0x3B, 0x77, 0x3A, 0x5A, 0x0D, 0x36, 0xF2, 0x26, 0x2D, 0xBC, 0xE9, 0x56, 0x0D, 0x27, 0x8E, 0x64,
+    0x5D, 0x19, 0x23, 0xC5, 0x25, 0xCB, 0x5B, 0xFE, 0x5D, 0x37, 0x7F, 0xEC, 0x00, 0x9D, 0x8B, 0x8F,
+    0x26, 0x77, 0x37, 0xF4, 0x3E, 0xC9, 0x24, 0x97, 0xAA, 0xB1, 0xA1, 0x29, 0x6B, 0xCD, 0xEC, 0x7A,
+    0x70, 0xED, 0x3C, 0x48, 0xA3, 0xB6, 0x41, 0x69, 0xD4, 0xCE, 0x8A, 0xEB, 0x94, 0x5D, 0x9C, 0xD7,
+    0xBE, 0x1D, 0x90, 0x5C, 0xD2, 0x59, 0xB0, 0x7C, 0x5E, 0xBD, 0x04, 0x3E, 0xC9, 0x0C, 0x4A, 0x31,
+    0x0B, 0x22, 0x3B, 0x22, 0x0C, 0x37, 0xAE, 0xFB, 0xF9, 0x78, 0x7E, 0xD9, 0x74, 0xBB, 0xF5, 0xD2,
+    0xDA, 0xB5, 0xF9, 0x6A, 0xF5, 0xF4, 0x98, 0xD6, 0x66, 0xB4, 0x13, 0xA6, 0x35, 0xD2, 0xC0, 0xB7,
+    0xDD, 0xE3, 0x20, 0x36, 0x76, 0xB0, 0x82, 0xE9, 0x24, 0xF0, 0x15, 0xFC, 0xAE, 0x50, 0x01, 0x9D,
+    0xA7, 0x51, 0x03, 0x3B, 0xC3, 0x97, 0x44, 0xEB, 0x9D, 0x95, 0xDB, 0xA1, 0x28, 0x77, 0x96, 0xC1,
+    0x1C, 0x4A, 0xF7, 0xD8, 0x9E, 0x77, 0x18, 0x6F, 0xA7, 0xC1, 0x05, 0x11, 0xC5, 0xAD, 0x8F, 0x56,
+    0x3C, 0x73, 0x41, 0xBB, 0x71, 0x77, 0xAB, 0x7D, 0x6D, 0x29, 0x74, 0xB5, 0x2E, 0xD0, 0x04, 0xF3,
+    0x15, 0xD9, 0x42, 0x1A, 0x35, 0x47, 0xCE, 0x07, 0x77, 0x73, 0x37, 0xB8, 0x99, 0xC2, 0xD2, 0xCC,
+    0x3D, 0x06, 0x26, 0xCB, 0xFB, 0xBD, 0x88, 0x21, 0x70, 0xAA, 0x7B, 0x83, 0xD0, 0xE4, 0x20, 0xFA,
+    0xAC, 0x12, 0xB5, 0x1B, 0x7D, 0x35, 0x38, 0x2A, 0x7B, 0x79, 0x25, 0x7C, 0x15, 0xFE, 0xD2, 0x36,
+    0x30, 0x38, 0xFD, 0x9B, 0x22, 0x06, 0x47, 0x6F, 0x4B, 0x94, 0xCF, 0x66, 0x54, 0x66, 0x55, 0x61,
+    0x5F, 0xAE, 0x70, 0x03, 0x66, 0xC1, 0xC1, 0x3D, 0x7E, 0x3D, 0x3C, 0xD1, 0x7E, 0x8F, 0xF5, 0x06,
+    0x89, 0x27, 0x42, 0x5B, 0x7A, 0x41, 0x6C, 0xB5, 0x37, 0xE8, 0xFE, 0x0A, 0x5B, 0x30, 0x7F, 0x07,
+    0x67, 0x0A, 0x88, 0x81, 0x16, 0xDF, 0xEF, 0xD5, 0xF7, 0xB5, 0x78, 0x1E, 0x1A, 0xD8, 0x9B, 0x87,
+    0xF6, 0xF5, 0xDD, 0x27, 0x35, 0x0C, 0xFE, 0x0B, 0xAB, 0x8D, 0xB5, 0x30, 0x08, 0x6B, 0x73, 0xAD,
+    0x84, 0xCF, 0x68, 0x37, 0xD6, 0xCE, 0xEF, 0x8D, 0x9D, 0xB7, 0xD7, 0x89, 0xC7, 0x43, 0x52, 0x96,
+    0x20, 0xE8, 0x43, 0x8E, 0x9C, 0xF6, 0x61, 0x90, 0xB0, 0x4E, 0x80, 0x0F, 0x92, 0x53, 0xFD, 0x77,
+    0x73, 0xD4, 0xFA, 0x65, 0xAD, 0x6C, 0x26, 0x28, 0x6A, 0xBE, 0x41, 0x7F, 0x01, 0x63, 0xD9, 0x45,
+    0x66, 0x9B, 0x04, 0x00, 0x00,
+};
+
+#endif
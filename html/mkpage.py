@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+#
+# REGENERATE ESP32_WIFIMANAGER_WEBCONFIG_PAGE.h FROM config.html
+# PAGE IS STORED GZIPPED IN FLASH AND SENT AS IS (Content-Encoding: gzip)
+#
+# USAGE : python3 html/mkpage.py
+#
+
+import gzip
+import os
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = os.path.join(here, "config.html")
+dst = os.path.join(here, "..", "ESP32_WIFIMANAGER_WEBCONFIG_PAGE.h")
+
+with open(src, "rb") as f:
+    data = gzip.compress(f.read(), compresslevel=9, mtime=0)
+
+lines = []
+for i in range(0, len(data), 16):
+    lines.append("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+
+with open(dst, "w") as f:
+    f.write("/**************************************************\n")
+    f.write("* ESP32 WIFI-MANAGER WEBCONFIG PAGE\n")
+    f.write("*\n")
+    f.write("* GENERATED FROM html/config.html BY html/mkpage.py\n")
+    f.write("* DO NOT EDIT\n")
+    f.write("**************************************************/\n\n")
+    f.write("#ifndef _ESP32_WIFIMANAGER_WEBCONFIG_PAGE_\n")
+    f.write("#define _ESP32_WIFIMANAGER_WEBCONFIG_PAGE_\n\n")
+    f.write("#include <stdint.h>\n\n")
+    f.write("static const uint8_t s_webconfig_page_gz[%d] = {\n" % len(data))
+    f.write("\n".join(lines) + "\n")
+    f.write("};\n\n")
+    f.write("#endif\n")
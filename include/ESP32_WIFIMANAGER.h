@@ -34,6 +34,11 @@
 *                    ADDRESS                   - SAVE WIFI CREDENTIAL TO FLASH/EEPROM
 *                                              - ON RESTART, AGAIN READ FLASH/EEPROM ADDRESS
 *                                                AND CONNECT TO READ SSID
+*
+*  MULTI             NOT ABLE TO CONNECT       - START SSID FRAMEWORK EITHER IN SMARTCONFIG
+*                    TO ANY KNOWN SSID           OR IN TCP WEBSERVER
+*                    FOUND IN ONE SCAN         - WIFI CONNECT SUCCESSFULL
+*                    (BEST RANKED FIRST)       - PROVISIONED SSID IS ADDED TO CREDENTIAL TABLE
 * REFERENCES
 * -----------
 *   (1) ONLINE HTML EDITOR
@@ -51,6 +56,7 @@
 
 #include <stdio.h>
 #include "esp_log.h"
+#include "esp_err.h"
 #include "sdkconfig.h"
 
 
@@ -58,12 +64,164 @@
 #define ESP32_WIFIMANAGER_WIFI_RETRY_COUNT          (3)
 #define ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS     (4000)
 
+//RECONNECT SCHEDULER DEFAULTS
+#define ESP32_WIFIMANAGER_BACKOFF_DEFAULT()         {.initial_ms = ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS, \
+                                                     .max_ms = 300000,                                   \
+                                                     .multiplier = 2,                                    \
+                                                     .jitter_pct = 20,                                   \
+                                                     .fast_retry_ms = 500,                               \
+                                                     .provision_window_ms = 120000,                      \
+                                                     .apsta_retry_ms = 15000,                            \
+                                                     .hold_down_ms = 5000}
+
+//ROAMING DEFAULTS (ROAMING IS OFF UNTIL ESP32_WIFIMANAGER_SetRoaming)
+#define ESP32_WIFIMANAGER_ROAM_DEFAULT()            {.rssi_threshold = -72,         \
+                                                     .hysteresis_db = 8,            \
+                                                     .check_ms = 2000,              \
+                                                     .min_interval_ms = 30000}
+
+//POWER POLICY DEFAULTS (DRIVER POWER SAVE IS LEFT ALONE UNTIL ESP32_WIFIMANAGER_SetPower)
+#define ESP32_WIFIMANAGER_POWER_DEFAULT()           {.policy = ESP32_WIFIMANAGER_POWER_BALANCED,   \
+                                                     .listen_interval = 3,                          \
+                                                     .dtim_period = 1,                              \
+                                                     .weak_rssi = -78,                              \
+                                                     .check_ms = 5000}
+
+//CONNECTIVITY HEALTH PROBE DEFAULTS (PROBING IS OFF UNTIL ESP32_WIFIMANAGER_SetHealth)
+//WORST CASE DETECTION OF A DEAD UPLINK IS ABOUT max_interval_ms + fail_threshold ROUNDS
+#define ESP32_WIFIMANAGER_HEALTH_DEFAULT()          {.checks = ESP32_WIFIMANAGER_HEALTH_GATEWAY |      \
+                                                               ESP32_WIFIMANAGER_HEALTH_DNS,           \
+                                                     .fail_threshold = 2,                              \
+                                                     .interval_ms = 5000,                              \
+                                                     .max_interval_ms = 20000,                         \
+                                                     .suspect_interval_ms = 1000,                      \
+                                                     .timeout_ms = 1000,                               \
+                                                     .dns_name = "example.com"}
+#define ESP32_WIFIMANAGER_HEALTH_NAME_LEN           (63)
+#define ESP32_WIFIMANAGER_HEALTH_POLL_MS            (50)    //ANSWER PICKUP PERIOD DURING A ROUND
+
+//POWER ESTIMATE MODEL (RADIO ON FOR WAKE_US EVERY BEACON IT LISTENS TO)
+#define ESP32_WIFIMANAGER_POWER_BEACON_US           (102400)    //100 TU
+#define ESP32_WIFIMANAGER_POWER_WAKE_US             (4000)
+#define ESP32_WIFIMANAGER_POWER_ACTIVE_MA           (100)       //RADIO RX / LISTEN
+#define ESP32_WIFIMANAGER_POWER_SLEEP_MA            (20)        //MODEM SLEEP, CPU AT 80 MHZ
+#define ESP32_WIFIMANAGER_POWER_SUPPLY_MV           (3300)
+
+//LOGGING. LEVELS ABOVE ESP32_WIFIMANAGER_LOG_LEVEL ARE NOT COMPILED IN
+//OVERRIDE FROM component.mk, E.G. CFLAGS += -DESP32_WIFIMANAGER_LOG_LEVEL=1
+//DEBUG RECORDS ARE ALSO GATED AT RUNTIME BY ESP32_WIFIMANAGER_SetDebug
+#define ESP32_WIFIMANAGER_LOG_LEVEL_NONE            (0)
+#define ESP32_WIFIMANAGER_LOG_LEVEL_ERROR           (1)
+#define ESP32_WIFIMANAGER_LOG_LEVEL_WARN            (2)
+#define ESP32_WIFIMANAGER_LOG_LEVEL_INFO            (3)
+#define ESP32_WIFIMANAGER_LOG_LEVEL_DEBUG           (4)
+#ifndef ESP32_WIFIMANAGER_LOG_LEVEL
+#define ESP32_WIFIMANAGER_LOG_LEVEL                 ESP32_WIFIMANAGER_LOG_LEVEL_DEBUG
+#endif
+#define ESP32_WIFIMANAGER_LOG_RING_LEN              (64)    //RECORDS, POWER OF 2
+#define ESP32_WIFIMANAGER_LOG_DRAIN_MS              (100)
+#define ESP32_WIFIMANAGER_LOG_TASK_PRIORITY         (1)
+#define ESP32_WIFIMANAGER_LOG_TASK_STACK_SIZE       (2048)
+
 #define ESP32_WIFIMANAGER_STATUS_LED_TOGGLE_MS      (200)
 
+#define ESP32_WIFIMANAGER_EVT_QUEUE_LEN             (16)
+#define ESP32_WIFIMANAGER_TASK_STACK_SIZE           (3072)
+
 #define ESP32_WIFIMANAGER_WEBCONFIG_PATH            "/config"
 #define ESP32_WIFIMANAGER_SSID_LEN                  (32)
 #define ESP32_WIFIMANAGER_SSID_PWD_LEN              (64)
 #define ESP32_WIFIMANAGER_CUSTOM_FIELD_MAX_COUNT    (5)
+#define ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN     (16)
+#define ESP32_WIFIMANAGER_CUSTOM_FIELD_VALUE_LEN    (64)
+
+#define ESP32_WIFIMANAGER_SOFTAP_SSID               "ESP32"
+#define ESP32_WIFIMANAGER_SOFTAP_PWD                "123456789"
+#define ESP32_WIFIMANAGER_SOFTAP_CHANNEL            (1)
+#define ESP32_WIFIMANAGER_SOFTAP_MAX_CONN           (4)
+
+#define ESP32_WIFIMANAGER_WEBCONFIG_PORT            (80)
+#define ESP32_WIFIMANAGER_WEBCONFIG_BUF_LEN         (1024)
+#define ESP32_WIFIMANAGER_WEBCONFIG_STACK_SIZE      (3072)
+#define ESP32_WIFIMANAGER_WEBCONFIG_TASK_PRIORITY   (5)
+#define ESP32_WIFIMANAGER_WEBCONFIG_RECV_TIMEOUT_S  (3)
+#define ESP32_WIFIMANAGER_WEBCONFIG_BODY_MAX        (2048)
+
+//CAPTIVE PORTAL DNS (RUNS WITH THE WEBCONFIG PORTAL)
+#define ESP32_WIFIMANAGER_DNS_PORT                  (53)
+#define ESP32_WIFIMANAGER_DNS_BUF_LEN               (512)   //LARGEST PLAIN DNS OVER UDP MESSAGE
+#define ESP32_WIFIMANAGER_DNS_TTL_S                 (60)    //CONNECTIVITY CHECK NAMES GET 0
+#define ESP32_WIFIMANAGER_DNS_STACK_SIZE            (2048)
+#define ESP32_WIFIMANAGER_DNS_TASK_PRIORITY         (5)
+
+//SMARTCONFIG_WEBCONFIG MODE. ONE RADIO, SO SMARTCONFIG (STA, CHANNEL HOPPING)
+//AND THE SOFTAP PORTAL (FIXED CHANNEL) TAKE TURNS. A SLICE IS HELD WHILE
+//SMARTCONFIG IS LOCKED ON A CHANNEL OR A PORTAL CLIENT IS ASSOCIATED
+#define ESP32_WIFIMANAGER_COMBINED_SC_SLICE_MS      (8000)
+#define ESP32_WIFIMANAGER_COMBINED_AP_SLICE_MS      (8000)
+
+//PROVISIONING TIMES KEPT IN THE STATS, FOR ESP32_WIFIMANAGER_ProvisionPercentile
+#define ESP32_WIFIMANAGER_PROVISION_SAMPLES         (32)
+
+#define ESP32_WIFIMANAGER_NVS_NAMESPACE             "wifimanager"
+#define ESP32_WIFIMANAGER_NVS_NAMESPACE_LEN         (16)    //IDF LIMIT, WITH THE NUL
+#define ESP32_WIFIMANAGER_NVS_KEY_FAST_CONNECT      "fastconn"
+#define ESP32_WIFIMANAGER_NVS_KEY_DHCP_LEASE        "dhcplease"
+#define ESP32_WIFIMANAGER_NVS_KEY_CREDENTIALS       "credtable"
+#define ESP32_WIFIMANAGER_NVS_KEY_CUSTOM_FIELDS     "customfields"
+#define ESP32_WIFIMANAGER_NVS_KEY_PMK_CACHE         "pmkcache"
+
+//WPA2 PMK CACHE. (SSID, PASSPHRASE) PAIRS WHOSE DERIVED KEY IS KEPT IN NVS
+//A MISSING KEY IS DERIVED ON A SHORT LIVED LOW PRIORITY TASK
+#define ESP32_WIFIMANAGER_PMK_CACHE_SIZE            (4)
+#define ESP32_WIFIMANAGER_PMK_TASK_PRIORITY         (1)
+#define ESP32_WIFIMANAGER_PMK_TASK_STACK_SIZE       (3072)
+
+#define ESP32_WIFIMANAGER_CREDENTIAL_TABLE_SIZE     (8)
+#define ESP32_WIFIMANAGER_CREDENTIAL_INDEX_SIZE     (16) //POWER OF 2, >= 2 x TABLE SIZE
+#define ESP32_WIFIMANAGER_SCAN_MAX_AP               (16)
+
+//SCAN CACHE. WITH BACKGROUND REFRESH ON (ESP32_WIFIMANAGER_SetScanRefresh)
+//ONE CHANNEL IS SCANNED (PASSIVE) EVERY REFRESH PERIOD WHILE CONNECTED,
+//ROTATING OVER ALL CHANNELS. AN ENTRY IS DROPPED WHEN IT IS OLDER THAN
+//MAX_AGE OR WAS MISSED BY MISS_LIMIT SCANS OF ITS CHANNEL. A RECONNECT ONLY
+//SKIPS ITS SCAN IF EVERY CHANNEL WAS REFRESHED WITHIN MAX_AGE
+#define ESP32_WIFIMANAGER_SCAN_CACHE_SIZE           (24)
+#define ESP32_WIFIMANAGER_SCAN_CACHE_MAX_AGE_MS     (90000)
+#define ESP32_WIFIMANAGER_SCAN_CACHE_MISS_LIMIT     (2)
+#define ESP32_WIFIMANAGER_SCAN_REFRESH_MS           (60000)     //SUGGESTED PERIOD
+#define ESP32_WIFIMANAGER_SCAN_REFRESH_MIN_MS       (1000)
+#define ESP32_WIFIMANAGER_SCAN_PASSIVE_MS           (120)
+#define ESP32_WIFIMANAGER_SCAN_CHANNEL_MAX          (13)
+
+//LATENCY HISTOGRAMS. BUCKET 0 = < 1 ms, BUCKET N = 2^(N-1) .. 2^N - 1 ms
+//LAST BUCKET ALSO TAKES EVERYTHING LONGER
+#define ESP32_WIFIMANAGER_LATENCY_BUCKETS           (16)
+#define ESP32_WIFIMANAGER_LATENCY_REASONS           (32)
+
+//EVENT NOTIFICATIONS. SUBSCRIBER CALLBACKS RUN IN THE NOTIFY TASK, NOT THE
+//MANAGER. EVENTS ARRIVING WHILE RING_LEN ARE STILL UNDELIVERED ARE DROPPED
+#define ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS    (16)
+#define ESP32_WIFIMANAGER_NOTIFY_RING_LEN           (8)     //EVENTS, POWER OF 2
+#define ESP32_WIFIMANAGER_NOTIFY_TASK_PRIORITY      (4)
+#define ESP32_WIFIMANAGER_NOTIFY_TASK_STACK_SIZE    (3072)
+
+//INPUT TRACE. RAM RING OF 12 BYTE RECORDS (SEE ESP32_WIFIMANAGER_CTX_Replay)
+#define ESP32_WIFIMANAGER_TRACE_LEN                 (256)   //RECORDS, POWER OF 2
+#define ESP32_WIFIMANAGER_TRACE_REPLAY_INPUTS       (8)     //HARDWARE READS QUEUED PER REPLAYED EVENT
+#define ESP32_WIFIMANAGER_TRACE_REPLAY_STEPS        (64)    //MAX MAINITER CALLS PER REPLAYED EVENT
+
+#define ESP32_WIFIMANAGER_DHCP_CACHE_MIN_LEASE_S    (60)
+#define ESP32_WIFIMANAGER_DHCP_CACHE_DEFAULT_LEASE_S (3600)
+#define ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS       (200)   //ARP WAIT BEFORE A CACHED LEASE IS REPORTED UP
+#define ESP32_WIFIMANAGER_DHCP_RENEW_WAIT_MS        (4000)  //INIT-REBOOT ACK WAIT BEFORE A FULL DISCOVER
+#define ESP32_WIFIMANAGER_VALID_EPOCH               (1514764800) //2018-01-01, WALL CLOCK IS SET
+
+//MANAGER INSTANCE (OPAQUE). THE ESP32_WIFIMANAGER_* API WORKS ON A BUILT IN
+//DEFAULT INSTANCE, THE ESP32_WIFIMANAGER_CTX_* API ON AN EXPLICIT ONE
+typedef struct esp32_wifimanager_s esp32_wifimanager_t;
+//RADIO OPS TABLE OF AN INSTANCE. SEE ESP32_WIFIMANAGER_DRIVER.h
+typedef struct esp32_wifimanager_driver_s esp32_wifimanager_driver_t;
 
 typedef enum
 {
@@ -81,7 +239,8 @@ typedef enum
     ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
     ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL,
     ESP32_WIFIMANAGER_CREDENTIAL_SRC_FLASH,
-    ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM
+    ESP32_WIFIMANAGER_CREDENTIAL_SRC_EEPROM,
+    ESP32_WIFIMANAGER_CREDENTIAL_SRC_MULTI
 }esp32_wifimanager_credential_src_t;
 
 typedef enum
@@ -102,19 +261,408 @@ typedef struct
     char* ssid_pwd;
 }esp32_wifimanager_credential_hardcoded_t;
 
+//STORAGE ACCESS FOR THE FLASH / EEPROM CREDENTIAL LOG
+typedef struct
+{
+    esp_err_t (*read)(uint32_t addr, void* data, size_t len);
+    esp_err_t (*write)(uint32_t addr, const void* data, size_t len);
+    esp_err_t (*erase)(uint32_t addr, size_t len);  //NULL = BYTE WRITABLE, PAGE RESET BY WRITING 0xFF
+    uint32_t page_size;                             //ERASE UNIT (FLASH SECTOR) OR LOG PAGE SIZE
+}esp32_wifimanager_storage_ops_t;
+
+//CREDENTIALS ARE KEPT AS AN APPEND ONLY LOG IN [ssid_name_addr, ssid_pwd_addr)
+//THE REGION MUST HOLD AT LEAST 2 PAGES
 typedef struct
 {
     uint32_t ssid_name_addr;
     uint32_t ssid_pwd_addr;
+    const esp32_wifimanager_storage_ops_t* ops;     //NULL = ESP32 SPI FLASH (FLASH SOURCE ONLY)
 }esp32_wifimanager_credential_external_storage_t;
 
 typedef enum
 {
     ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG = 0,
     ESP32_WIFIMANAGER_CONFIG_WEBCONFIG,
-    ESP32_WIFIMANAGER_CONFIG_BLE
+    ESP32_WIFIMANAGER_CONFIG_BLE,
+    ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG  //BOTH, FIRST TO DELIVER CREDENTIALS WINS
 }esp32_wifimanager_config_mode_t;
 
+typedef struct
+{
+    uint32_t initial_ms;            //FIRST RETRY DELAY (ALSO CONNECT TIMEOUT), >= WIFI_CONNECT_CHECK_MS
+    uint32_t max_ms;                //BACKOFF CAP
+    uint8_t multiplier;             //DELAY GROWTH PER RETRY
+    uint8_t jitter_pct;             //RANDOM SPREAD +/- % OF DELAY
+    uint32_t fast_retry_ms;         //RETRY DELAY AFTER A TRANSIENT DISCONNECT
+    uint32_t provision_window_ms;   //PROVISIONING TIME BEFORE RETRYING AGAIN. 0 = FOREVER
+    uint32_t apsta_retry_ms;        //STORED NETWORK RETRY PERIOD WHILE THE SOFTAP IS UP. 0 = OFF
+    uint32_t hold_down_ms;          //TRANSIENT DROPS SHORTER THAN THIS ARE NOT REPORTED. 0 = OFF
+}esp32_wifimanager_backoff_t;
+
+//DISCONNECT REASON CLASSES (ESP32_WIFIMANAGER_DisconnectClass)
+typedef enum
+{
+    ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT = 0,     //BLIP. RETRY AT ONCE, HIDDEN DURING HOLD DOWN
+    ESP32_WIFIMANAGER_DISCONNECT_AUTH,              //KEY OR CREDENTIALS REJECTED
+    ESP32_WIFIMANAGER_DISCONNECT_AP_GONE,           //AP NOT FOUND, LEFT OR REFUSING US
+    ESP32_WIFIMANAGER_DISCONNECT_CLASS_MAX
+}esp32_wifimanager_disconnect_class_t;
+
+typedef struct
+{
+    int8_t rssi_threshold;          //LOOK FOR A BETTER BSSID BELOW THIS (SMOOTHED) RSSI
+    uint8_t hysteresis_db;          //TARGET MUST BE AT LEAST THIS MUCH STRONGER
+    uint32_t check_ms;              //RSSI SAMPLE PERIOD WHILE CONNECTED
+    uint32_t min_interval_ms;       //MIN TIME BETWEEN ROAM SCANS / HANDOVERS
+}esp32_wifimanager_roam_t;
+
+//POWER POLICY WHILE CONNECTED, LEAST TO MOST SAVING
+typedef enum
+{
+    ESP32_WIFIMANAGER_POWER_PERFORMANCE = 0,    //NO MODEM SLEEP (WIFI_PS_NONE)
+    ESP32_WIFIMANAGER_POWER_BALANCED,           //WAKE EVERY DTIM (WIFI_PS_MIN_MODEM)
+    ESP32_WIFIMANAGER_POWER_MAX_SAVE,           //WAKE EVERY LISTEN INTERVAL (WIFI_PS_MAX_MODEM)
+    ESP32_WIFIMANAGER_POWER_MAX
+}esp32_wifimanager_power_policy_t;
+
+typedef struct
+{
+    esp32_wifimanager_power_policy_t policy;    //MOST SAVING LEVEL ALLOWED
+    uint8_t listen_interval;        //MAX_SAVE WAKE PERIOD, BEACONS. ROUNDED UP TO A MULTIPLE OF DTIM
+    uint8_t dtim_period;            //AP DTIM PERIOD (THE DRIVER DOES NOT REPORT IT)
+    int8_t weak_rssi;               //BELOW THIS (SMOOTHED) RSSI USE ONE LEVEL LESS SAVING
+    uint32_t check_ms;              //RSSI SAMPLE PERIOD WHILE CONNECTED
+}esp32_wifimanager_power_t;
+
+//CONNECTIVITY HEALTH CHECKS (BITS)
+typedef enum
+{
+    ESP32_WIFIMANAGER_HEALTH_GATEWAY = 0x01,    //ICMP ECHO TO THE DEFAULT GATEWAY
+    ESP32_WIFIMANAGER_HEALTH_DNS = 0x02,        //RESOLVE dns_name WITH THE LEASE'S DNS SERVER
+    ESP32_WIFIMANAGER_HEALTH_TCP = 0x04         //CONNECT TO tcp_ip:tcp_port
+}esp32_wifimanager_health_check_t;
+
+#define ESP32_WIFIMANAGER_HEALTH_CHECK_MAX          (3)
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_HEALTH_UNKNOWN = 0,       //NOT CONNECTED, OR NO ROUND DONE YET
+    ESP32_WIFIMANAGER_HEALTH_HEALTHY,
+    ESP32_WIFIMANAGER_HEALTH_DEGRADED           //LINK UP, BUT fail_threshold ROUNDS IN A ROW FAILED
+}esp32_wifimanager_health_state_t;
+
+typedef struct
+{
+    uint8_t checks;                 //ESP32_WIFIMANAGER_HEALTH_* BITS
+    uint8_t fail_threshold;         //FAILED ROUNDS IN A ROW BEFORE DEGRADED
+    uint32_t interval_ms;           //ROUND PERIOD AFTER CONNECT. DOUBLES PER GOOD ROUND
+    uint32_t max_interval_ms;       //UP TO THIS ON A STABLE LINK
+    uint32_t suspect_interval_ms;   //NEXT ROUND AFTER A FAILED ONE (CONFIRM QUICKLY)
+    uint32_t timeout_ms;            //ROUND TIMEOUT. CHECKS RUN IN PARALLEL
+    uint32_t tcp_ip;                //TCP CHECK ENDPOINT, NETWORK ORDER
+    uint16_t tcp_port;
+    char dns_name[ESP32_WIFIMANAGER_HEALTH_NAME_LEN + 1];
+}esp32_wifimanager_health_t;
+
+typedef enum
+{
+    ESP32_WIFIMANAGER_DHCP_CACHE_OFF = 0,
+    ESP32_WIFIMANAGER_DHCP_CACHE_STATIC
+}esp32_wifimanager_dhcp_cache_mode_t;
+
+typedef struct
+{
+    uint32_t requests;
+    uint32_t last_ttfb_us;
+    uint32_t max_ttfb_us;
+    uint32_t buf_peak;          //MOST OF THE REQUEST BUFFER EVER USED
+    uint32_t last_heap;         //FREE HEAP DROP DURING THE LAST REQUEST (LWIP)
+    uint32_t heap_peak;         //LARGEST FREE HEAP DROP DURING A REQUEST
+    uint32_t stack_free_min;    //WEB TASK STACK HIGH WATER MARK
+}esp32_wifimanager_webconfig_stats_t;
+
+typedef struct
+{
+    uint32_t queries;           //STANDARD QUERIES ANSWERED (WITH OR WITHOUT AN ADDRESS)
+    uint32_t answered;          //A / ANY, GOT THE SOFTAP ADDRESS
+    uint32_t probes;            //OF THOSE, OS CONNECTIVITY CHECK NAMES
+    uint32_t no_data;           //OTHER TYPES (AAAA, ...), EMPTY ANSWER
+    uint32_t errors;            //FORMERR / NOTIMP REPLIES
+    uint32_t dropped;           //NOT ANSWERED (RESPONSES, RUNTS, SEND FAILED)
+    uint32_t max_service_us;    //RECEIVED -> REPLY SENT
+}esp32_wifimanager_dns_stats_t;
+
+typedef struct
+{
+    uint32_t appends;           //RECORDS WRITTEN
+    uint32_t coalesced;         //SAVES SKIPPED, SAME CREDENTIALS AS LAST RECORD
+    uint32_t erases;            //PAGE ERASES (WEAR)
+    uint32_t torn_records;      //RECORDS SKIPPED FOR BAD CRC / FAILED VERIFY
+    uint32_t boot_reads;        //STORAGE READS TO FIND THE LATEST RECORD
+    uint32_t boot_read_us;
+}esp32_wifimanager_credlog_stats_t;
+
+//CONNECTION PHASES TIMESTAMPED BY THE MANAGER
+typedef enum
+{
+    ESP32_WIFIMANAGER_PHASE_WIFI_START = 0,     //esp_wifi_start (FIRST CALL)
+    ESP32_WIFIMANAGER_PHASE_STA_START,
+    ESP32_WIFIMANAGER_PHASE_CONNECT,            //esp_wifi_connect
+    ESP32_WIFIMANAGER_PHASE_STA_CONNECTED,      //AUTH + ASSOC (+ 4 WAY HANDSHAKE) DONE
+    ESP32_WIFIMANAGER_PHASE_GOT_IP,
+    ESP32_WIFIMANAGER_PHASE_DISCONNECTED,
+    ESP32_WIFIMANAGER_PHASE_PROVISION_START,
+    ESP32_WIFIMANAGER_PHASE_PROVISION_END,      //VALID CREDENTIALS RECEIVED
+    ESP32_WIFIMANAGER_PHASE_MAX
+}esp32_wifimanager_phase_t;
+
+//INTERVALS BETWEEN PHASES, ONE HISTOGRAM EACH
+typedef enum
+{
+    ESP32_WIFIMANAGER_LATENCY_DRIVER_START = 0, //WIFI_START -> STA_START
+    ESP32_WIFIMANAGER_LATENCY_ASSOC,            //CONNECT -> STA_CONNECTED (SCAN + AUTH + ASSOC)
+    ESP32_WIFIMANAGER_LATENCY_DHCP,             //STA_CONNECTED -> GOT_IP
+    ESP32_WIFIMANAGER_LATENCY_CONNECT,          //WIFI_START OR LINK LOSS -> GOT_IP
+    ESP32_WIFIMANAGER_LATENCY_PROVISION,        //PROVISION_START -> PROVISION_END
+    ESP32_WIFIMANAGER_LATENCY_MAX
+}esp32_wifimanager_latency_id_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t total_ms;
+    uint32_t buckets[ESP32_WIFIMANAGER_LATENCY_BUCKETS];
+}esp32_wifimanager_histogram_t;
+
+typedef struct
+{
+    uint32_t seq;                                           //CHANGES ON EVERY UPDATE
+    int64_t phase_us[ESP32_WIFIMANAGER_PHASE_MAX];          //LAST ENTRY (esp_timer_get_time). 0 = NEVER
+    uint32_t phase_count[ESP32_WIFIMANAGER_PHASE_MAX];
+    uint8_t last_disconnect_reason;
+    //DISCONNECTS PER REASON. INDEX = REASON (1..25), 200..205 -> 26..31, 0 = OTHER
+    uint16_t disconnect_reasons[ESP32_WIFIMANAGER_LATENCY_REASONS];
+    esp32_wifimanager_histogram_t hist[ESP32_WIFIMANAGER_LATENCY_MAX];
+
+    //COST OF RECORDING ONE PHASE (CPU CYCLES)
+    uint32_t record_cycles_last;
+    uint32_t record_cycles_max;
+}esp32_wifimanager_latency_t;
+
+//EVENTS DELIVERED TO SUBSCRIBERS
+typedef enum
+{
+    ESP32_WIFIMANAGER_NOTIFY_CONNECTED = 0,     //GOT IP
+    ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED,      //LINK LOST, RECONNECTING
+    ESP32_WIFIMANAGER_NOTIFY_CONNECTION_FAILED, //RETRIES USED UP, PROVISIONING STARTED
+    ESP32_WIFIMANAGER_NOTIFY_ROAMED,            //GOT IP ON ANOTHER BSSID OF THE SAME SSID
+    ESP32_WIFIMANAGER_NOTIFY_DEGRADED,          //LINK UP, HEALTH CHECKS FAILING
+    ESP32_WIFIMANAGER_NOTIFY_HEALTHY,           //HEALTH CHECKS PASS AGAIN AFTER DEGRADED
+    ESP32_WIFIMANAGER_NOTIFY_MAX
+}esp32_wifimanager_notify_type_t;
+
+#define ESP32_WIFIMANAGER_NOTIFY_MASK(type)         (1u << (type))
+#define ESP32_WIFIMANAGER_NOTIFY_MASK_ALL           ((1u << ESP32_WIFIMANAGER_NOTIFY_MAX) - 1)
+
+//EVENT PAYLOAD. ONE COPY IS SHARED BY ALL SUBSCRIBERS (READ ONLY)
+//AND IS ONLY VALID DURING THE CALLBACK
+typedef struct
+{
+    esp32_wifimanager_notify_type_t type;
+    esp32_wifimanager_t* source;    //INSTANCE THAT POSTED IT
+    uint32_t seq;                   //+1 PER EVENT POSTED. A GAP MEANS EVENTS WERE DROPPED
+    int64_t ts_us;                  //esp_timer_get_time() WHEN POSTED
+    uint32_t ip;                    //NETWORK ORDER. 0 WHEN NOT CONNECTED
+    uint32_t netmask;
+    uint32_t gw;
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN + 1];
+    uint8_t bssid[6];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t reason;                 //DISCONNECT REASON (wifi_err_reason_t). 0 IF NONE
+    uint8_t health;                 //DEGRADED: FAILED CHECKS (ESP32_WIFIMANAGER_HEALTH_* BITS)
+}esp32_wifimanager_notify_t;
+
+typedef void (*esp32_wifimanager_notify_cb_t)(const esp32_wifimanager_notify_t* notify, void* arg);
+
+typedef struct
+{
+    uint32_t posted;
+    uint32_t dropped;           //RING FULL, SUBSCRIBERS TOO SLOW
+    uint32_t last_latency_us;   //POSTED -> LAST SUBSCRIBER RETURNED
+    uint32_t max_latency_us;
+    uint32_t max_cb_us;         //SLOWEST SINGLE CALLBACK
+    uint8_t subscribers;
+}esp32_wifimanager_notify_stats_t;
+
+//WHAT A TRACE RECORD HOLDS
+typedef enum
+{
+    ESP32_WIFIMANAGER_TRACE_EVT = 0,            //EVENT PROCESSED. type = MANAGER EVENT, arg = ITS ARGUMENT
+    ESP32_WIFIMANAGER_TRACE_GPIO,               //arg = TRIGGER PIN LEVEL READ
+    ESP32_WIFIMANAGER_TRACE_RANDOM,             //arg = esp_random() USED FOR BACKOFF JITTER
+    ESP32_WIFIMANAGER_TRACE_RSSI,               //arg = (int8_t) RSSI SAMPLED FOR ROAMING
+    ESP32_WIFIMANAGER_TRACE_ARP                 //arg = CACHED LEASE PROBE, BIT 0 GATEWAY ANSWERED, BIT 1 ADDRESS TAKEN
+}esp32_wifimanager_trace_kind_t;
+
+typedef struct
+{
+    uint32_t ts_us;             //esp_timer_get_time(), LOW 32 BITS
+    uint32_t arg;
+    uint8_t kind;               //esp32_wifimanager_trace_kind_t
+    uint8_t type;
+    uint16_t lag_us;            //EVT: POSTED -> PROCESSED. SATURATES AT 65535
+}esp32_wifimanager_trace_record_t;
+
+//SCAN CACHE ENTRY. RSSI IS SMOOTHED OVER SCANS
+typedef struct
+{
+    uint8_t bssid[6];
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN + 1];
+    uint8_t channel;
+    uint8_t authmode;
+    int8_t rssi;
+    int8_t last_rssi;
+    uint8_t misses;
+    int16_t rssi_q4;            //EWMA, 1/16 dBm
+    int64_t last_seen_us;
+}esp32_wifimanager_scan_entry_t;
+
+typedef struct
+{
+    //LIFETIME COUNTERS
+    //MAINITER_TICKS COUNTS STATE MACHINE STEPS (NON IDLE)
+    //WAKEUPS COUNTS MAINITER CALLS (POLLED) OR QUEUE WAKEUPS (TASK)
+    uint32_t mainiter_ticks;
+    uint32_t state_transitions;
+    uint32_t state_illegal;         //TRANSITIONS REJECTED BY THE STATE TABLE
+    uint32_t state_cas_retries;     //STATE WORD UPDATES THAT LOST A RACE AND WERE REDONE
+    uint32_t wakeups;
+    uint32_t wakeups_per_hour;
+    uint32_t evt_dropped;
+
+    //SOFTWARE TIMERS. CALLBACKS FIRED AND TIME SPENT FIRING THEM
+    uint32_t timer_fires;
+    uint32_t timer_cpu_us;
+
+    //CONNECT ATTEMPTS ON A KNOWN BSSID/CHANNEL VS FULL SCAN
+    uint32_t scan_skipped;
+    uint32_t scan_needed;
+
+    //RECONNECT SCHEDULER
+    uint32_t reconnect_attempts;
+    uint32_t fast_retries;
+    uint32_t last_backoff_ms;
+
+    //DHCP (STA_CONNECTED -> GOT_IP) LATENCY AND LEASE CACHE USE
+    int64_t last_dhcp_us;
+    int64_t total_dhcp_us;
+    uint32_t dhcp_count;
+    uint32_t dhcp_cache_hits;
+    uint32_t dhcp_cache_misses;
+    uint32_t dhcp_cache_rejected;   //ADDRESS TAKEN OR GATEWAY SILENT ON THE ARP PROBE
+    uint32_t dhcp_renewed;          //CACHED LEASE CONFIRMED BY THE SERVER IN PLACE
+    uint32_t dhcp_renew_failed;
+
+    //WPA2 PMK CACHE. CONNECTS WITH A CACHED KEY VS KEYS DERIVED (AND CPU TIME SPENT)
+    uint32_t pmk_hits;
+    uint32_t pmk_derived;
+    int64_t pmk_derive_us;
+    uint32_t connections;
+    uint32_t disconnections;
+
+    //LINK FLAPS. LINK LOSSES BY REASON CLASS. SUPPRESSED = TRANSIENT DROPS
+    //THAT RECOVERED WITHIN THE HOLD DOWN, SO SUBSCRIBERS NEVER SAW THEM
+    uint32_t link_loss_class[ESP32_WIFIMANAGER_DISCONNECT_CLASS_MAX];
+    uint32_t flaps_suppressed;
+    uint32_t hold_down_expired;
+    int64_t last_flap_us;
+    int64_t max_flap_us;
+
+    //CREDENTIAL SOURCE THE TIMINGS BELOW WERE TAKEN WITH
+    esp32_wifimanager_credential_src_t credential_src;
+
+    //TIMINGS (us). 0 = NOT MEASURED YET
+    int64_t boot_to_got_ip_us;
+    int64_t last_recovery_us;
+    int64_t max_recovery_us;
+    int64_t total_recovery_us;
+    uint32_t recoveries;
+
+    //LAST CONNECTION (INITIALIZE OR STA_DISCONNECTED -> GOT_IP)
+    uint32_t last_conn_mainiter_ticks;
+    uint32_t last_conn_state_transitions;
+
+    //ROAMING. HANDOVER = LEAVING OLD BSSID -> GOT_IP ON NEW ONE
+    uint32_t roam_scans;
+    uint32_t roam_handovers;
+    uint32_t roam_failures;
+    uint32_t roam_scan_failures;    //ROAM SCANS THE DRIVER REFUSED TO START
+    int64_t last_handover_us;
+    int64_t max_handover_us;
+
+    //SCANS AND RADIO TIME SPENT SCANNING
+    uint32_t scans_full;
+    uint32_t scans_channel;
+    int64_t scan_full_busy_us;
+    int64_t scan_channel_busy_us;
+    uint32_t scan_busy_ms_per_min;
+
+    //PROVISIONING. START -> FIRST VALID CREDENTIALS, BY WINNING METHOD
+    uint32_t provisioned_smartconfig;
+    uint32_t provisioned_webconfig;
+    uint32_t provision_late_dropped;    //CREDENTIALS FROM THE LOSING METHOD
+    uint32_t provision_slices;          //SMARTCONFIG <-> SOFTAP SWITCHES
+    int64_t last_provision_us;
+    int64_t max_provision_us;
+    int64_t total_provision_us;
+    //LAST PROVISION_SAMPLES TIMES (ms), A RING. provision_samples KEEPS
+    //COUNTING, SAMPLE n IS AT n % PROVISION_SAMPLES
+    uint32_t provision_ms[ESP32_WIFIMANAGER_PROVISION_SAMPLES];
+    uint32_t provision_samples;
+
+    //STORED NETWORK RETRIES WHILE THE SOFTAP IS UP (APSTA)
+    //RECOVERIES = GOT_IP BEFORE ANY CREDENTIALS ARRIVED (PORTAL TORN DOWN)
+    uint32_t apsta_retries;
+    uint32_t apsta_deferred;            //SKIPPED, A SCAN WOULD MOVE THE AP UNDER A PORTAL CLIENT
+    uint32_t apsta_recoveries;
+
+    //POWER. TIME SPENT AT EACH LEVEL (NOT CONNECTED COUNTS AS PERFORMANCE)
+    //RADIO ON TIME, DUTY AND AVERAGE POWER ARE ESTIMATES FROM THE POWER MODEL
+    int64_t power_level_us[ESP32_WIFIMANAGER_POWER_MAX];
+    uint32_t power_switches;
+    int64_t radio_on_us;
+    uint16_t radio_duty_permille;
+    uint32_t power_avg_mw;              //= ESTIMATED mWh PER HOUR
+
+    //HEALTH PROBE. ROUNDS RUN AND FAILED, FAILURES AND LAST ANSWER TIME PER CHECK
+    //(INDEX = BIT NUMBER OF ESP32_WIFIMANAGER_HEALTH_*), TIMES REPORTED DEGRADED
+    uint32_t health_rounds;
+    uint32_t health_failed_rounds;
+    uint32_t health_fail[ESP32_WIFIMANAGER_HEALTH_CHECK_MAX];
+    int64_t health_rtt_us[ESP32_WIFIMANAGER_HEALTH_CHECK_MAX];
+    uint32_t health_degraded;
+    uint32_t health_interval_ms;        //CURRENT ROUND PERIOD
+
+    //LOG RECORDS LOST TO A FULL RING
+    uint32_t log_dropped;
+
+    //REPLAY: HARDWARE READS WITH NO MATCHING RECORDED VALUE
+    uint32_t replay_diverged;
+
+    //WEBCONFIG PORTAL AND ITS CAPTIVE DNS
+    esp32_wifimanager_webconfig_stats_t webconfig;
+    esp32_wifimanager_dns_stats_t dns;
+
+    //FLASH / EEPROM CREDENTIAL LOG
+    esp32_wifimanager_credlog_stats_t credlog;
+
+    //SUBSCRIBER NOTIFICATIONS
+    esp32_wifimanager_notify_stats_t notify;
+}esp32_wifimanager_stats_t;
+
 //END CUSTOM VARIABLE STRUCTURES-------------------------------------------------
 
 void ESP32_WIFIMANAGER_SetDebug(uint8_t debug);
@@ -125,9 +673,143 @@ void ESP32_WIFIMANAGER_SetParameters(esp32_wifimanager_credential_src_t input_mo
                                         char* project_name);
 void ESP32_WIFIMANAGER_SetStatusLedType(esp32_wifimanager_status_led_type_t led_type);                                       
 void ESP32_WIFIMANAGER_SetGpioTriggerLevel(esp32_wifimanager_gpio_trigger_type_t level);
+esp_err_t ESP32_WIFIMANAGER_AddCustomField(const char* name);
+esp_err_t ESP32_WIFIMANAGER_GetCustomFieldValue(const char* name, char* value, size_t len);
+esp_err_t ESP32_WIFIMANAGER_AddCredential(const char* ssid, const char* pwd);
+esp_err_t ESP32_WIFIMANAGER_RemoveCredential(const char* ssid);
+void ESP32_WIFIMANAGER_SetBackoff(const esp32_wifimanager_backoff_t* backoff);
+void ESP32_WIFIMANAGER_SetDhcpCacheMode(esp32_wifimanager_dhcp_cache_mode_t mode);
+void ESP32_WIFIMANAGER_SetRoaming(const esp32_wifimanager_roam_t* roam);
+void ESP32_WIFIMANAGER_SetPower(const esp32_wifimanager_power_t* power);
+void ESP32_WIFIMANAGER_SetHealth(const esp32_wifimanager_health_t* health);
+//HEALTH OF THE CURRENT LINK (UNKNOWN WHILE NOT CONNECTED). SAFE FROM ANY TASK
+esp32_wifimanager_health_state_t ESP32_WIFIMANAGER_GetHealth(void);
+//CONNECT WITH A CACHED WPA2 PMK INSTEAD OF THE PASSPHRASE (DEFAULT ON)
+//THE KEY IS DERIVED ONCE PER SSID / PASSPHRASE IN THE BACKGROUND AND STORED
+//IN NVS. ONLY USED FOR APS SEEN WITH WPA / WPA2-PSK. THE PSK ONLY GOES TO THE
+//DRIVER'S RAM CONFIG, FLASH KEEPS THE PASSPHRASE
+void ESP32_WIFIMANAGER_SetPmkCache(bool on);
+//BACKGROUND SCAN CACHE REFRESH PERIOD. 0 = OFF (DEFAULT). NO REFRESH WHILE THE
+//POWER LEVEL IS MAX_SAVE. CALL BEFORE MAINITER / STARTTASK
+void ESP32_WIFIMANAGER_SetScanRefresh(uint32_t period_ms);
+//APP ACTIVITY HINT. RADIO STAYS OUT OF MODEM SLEEP FOR THE NEXT busy_ms
+//(CHECKED EVERY check_ms). 0 = IDLE NOW. SAFE FROM ANY TASK
+void ESP32_WIFIMANAGER_PowerHint(uint32_t busy_ms);
+//CLASS OF A DISCONNECT REASON (wifi_err_reason_t, AS IN NOTIFY reason)
+esp32_wifimanager_disconnect_class_t ESP32_WIFIMANAGER_DisconnectClass(uint8_t reason);
+//ESTIMATED AVERAGE POWER (mW = mWh PER HOUR) OF A POLICY, FOR SIZING BATTERIES
+uint32_t ESP32_WIFIMANAGER_PowerEstimate(const esp32_wifimanager_power_t* power,
+                                            esp32_wifimanager_power_policy_t policy);
+//pct-TH PERCENTILE (NEAREST RANK) OF THE PROVISIONING TIMES IN stats, IN ms
+//50 = MEDIAN. 0 IF NOTHING WAS PROVISIONED
+uint32_t ESP32_WIFIMANAGER_ProvisionPercentile(const esp32_wifimanager_stats_t* stats, uint8_t pct);
+//POINTERS INTO THE SCAN CACHE, STRONGEST FIRST. NOTHING IS COPIED
+//ENTRIES CHANGE WHEN THE NEXT SCAN COMPLETES, SO CALL FROM THE MANAGER
+//CONTEXT (THE MAINITER CALLER)
+uint8_t ESP32_WIFIMANAGER_GetScanResults(const esp32_wifimanager_scan_entry_t** results, uint8_t max);
+
+//EVENT SUBSCRIPTIONS. mask = ESP32_WIFIMANAGER_NOTIFY_MASK(...) BITS
+//EVENTS OF EVERY INSTANCE. notify->source TELLS WHICH ONE POSTED IT
+//SUBSCRIBING AGAIN WITH THE SAME cb / arg CHANGES THE MASK
+//UNSUBSCRIBE RETURNS ONCE NO CALL TO cb IS RUNNING (UNLESS CALLED FROM cb ITSELF)
+esp_err_t ESP32_WIFIMANAGER_Subscribe(esp32_wifimanager_notify_cb_t cb, void* arg, uint32_t mask);
+esp_err_t ESP32_WIFIMANAGER_Unsubscribe(esp32_wifimanager_notify_cb_t cb, void* arg);
+//LEGACY SINGLE CALLBACK. A SUBSCRIBER FOR CONNECTED (true),
+//DISCONNECTED AND CONNECTION_FAILED (false). FIRST ARGUMENT IS ALWAYS NULL
 void ESP32_WIFIMANAGER_SetUserCbFunction(void (*wifi_connected_cb)(char**, bool));
 
 //OPERATION FUNCTIONS
+//EITHER START THE MANAGER TASK ONCE OR CALL MAINITER FROM THE APPLICATION LOOP
+esp_err_t ESP32_WIFIMANAGER_StartTask(uint8_t priority);
 void ESP32_WIFIMANAGER_Mainiter(void);
 
+//STATISTICS FUNCTIONS
+void ESP32_WIFIMANAGER_GetStats(esp32_wifimanager_stats_t* stats);
+void ESP32_WIFIMANAGER_ResetStats(void);
+//CONSISTENT COPY OF PHASE TIMESTAMPS AND LATENCY HISTOGRAMS
+//SAFE TO CALL FROM ANY TASK. NO LOCKS, NO ALLOCATION
+void ESP32_WIFIMANAGER_GetLatency(esp32_wifimanager_latency_t* snapshot);
+
+//INPUT TRACE (DEFAULT INSTANCE RECORDS FROM BOOT)
+//GETTRACE COPIES THE NEWEST RECORDS, OLDEST FIRST. SAFE FROM ANY TASK
+//DUMPTRACE PRINTS THEM AS #WT LINES FOR tools/tracedecode.py
+void ESP32_WIFIMANAGER_SetTrace(bool on);
+uint16_t ESP32_WIFIMANAGER_GetTrace(esp32_wifimanager_trace_record_t* records, uint16_t max);
+void ESP32_WIFIMANAGER_DumpTrace(void);
+
+//INSTANCE (CONTEXT) API. THE FUNCTIONS ABOVE, ON AN EXPLICIT INSTANCE
+//EVERY INSTANCE HAS ITS OWN STATE MACHINE, QUEUE, TIMERS, TRACE, SCAN CACHE,
+//CREDENTIAL LOG, PORTAL AND PMK JOB, AND DRIVES ITS OWN RADIO (SETDRIVER).
+//INSTANCES SHARING A FLASH NEED THEIR OWN NVS NAMESPACE (SETNAMESPACE).
+//SETPARAMETERS BINDS THE INSTANCE TO ITS RADIO. IT IS REFUSED WHILE ANOTHER
+//INSTANCE HOLDS THAT RADIO (THE ESP32'S OWN RADIO IS THE DEFAULT OF ALL), THEN
+//STARTTASK / REPLAY RETURN ESP_ERR_INVALID_STATE AND MAINITER DOES NOTHING.
+//THE BINARY LOG AND THE NOTIFY RING ARE SHARED. NOTIFY EVENTS CARRY THEIR SOURCE
+//DESTROY RELEASES THE RADIO AND FREES A CREATED INSTANCE, UNLESS ITS MANAGER
+//TASK, PORTAL OR PMK JOB IS STILL RUNNING (ESP_ERR_INVALID_STATE)
+esp32_wifimanager_t* ESP32_WIFIMANAGER_CTX_Create(void);
+esp_err_t ESP32_WIFIMANAGER_CTX_Destroy(esp32_wifimanager_t* wm);
+esp32_wifimanager_t* ESP32_WIFIMANAGER_CTX_Default(void);
+size_t ESP32_WIFIMANAGER_CTX_Size(void);
+
+void ESP32_WIFIMANAGER_CTX_SetDebug(esp32_wifimanager_t* wm, uint8_t debug);
+void ESP32_WIFIMANAGER_CTX_SetParameters(esp32_wifimanager_t* wm,
+                                            esp32_wifimanager_credential_src_t input_mode,
+                                            esp32_wifimanager_config_mode_t config_mode,
+                                            void* user_data,
+                                            uint8_t gpio_led_pin,
+                                            char* project_name);
+void ESP32_WIFIMANAGER_CTX_SetStatusLedType(esp32_wifimanager_t* wm, esp32_wifimanager_status_led_type_t led_type);
+void ESP32_WIFIMANAGER_CTX_SetGpioTriggerLevel(esp32_wifimanager_t* wm, esp32_wifimanager_gpio_trigger_type_t level);
+esp_err_t ESP32_WIFIMANAGER_CTX_AddCustomField(esp32_wifimanager_t* wm, const char* name);
+esp_err_t ESP32_WIFIMANAGER_CTX_GetCustomFieldValue(esp32_wifimanager_t* wm, const char* name, char* value, size_t len);
+esp_err_t ESP32_WIFIMANAGER_CTX_AddCredential(esp32_wifimanager_t* wm, const char* ssid, const char* pwd);
+esp_err_t ESP32_WIFIMANAGER_CTX_RemoveCredential(esp32_wifimanager_t* wm, const char* ssid);
+void ESP32_WIFIMANAGER_CTX_SetBackoff(esp32_wifimanager_t* wm, const esp32_wifimanager_backoff_t* backoff);
+void ESP32_WIFIMANAGER_CTX_SetDhcpCacheMode(esp32_wifimanager_t* wm, esp32_wifimanager_dhcp_cache_mode_t mode);
+void ESP32_WIFIMANAGER_CTX_SetRoaming(esp32_wifimanager_t* wm, const esp32_wifimanager_roam_t* roam);
+void ESP32_WIFIMANAGER_CTX_SetPower(esp32_wifimanager_t* wm, const esp32_wifimanager_power_t* power);
+void ESP32_WIFIMANAGER_CTX_SetHealth(esp32_wifimanager_t* wm, const esp32_wifimanager_health_t* health);
+esp32_wifimanager_health_state_t ESP32_WIFIMANAGER_CTX_GetHealth(esp32_wifimanager_t* wm);
+void ESP32_WIFIMANAGER_CTX_SetPmkCache(esp32_wifimanager_t* wm, bool on);
+void ESP32_WIFIMANAGER_CTX_SetScanRefresh(esp32_wifimanager_t* wm, uint32_t period_ms);
+//EACH INSTANCE HAS ITS OWN PORTAL. 0 = PORT 80 / 53. START FAILS IF THE PORT IS TAKEN
+esp_err_t ESP32_WIFIMANAGER_CTX_SetPortalPorts(esp32_wifimanager_t* wm, uint16_t http_port, uint16_t dns_port);
+//NULL = THE ESP32'S OWN RADIO. ctx IS PASSED TO EVERY OP. CALL BEFORE SETPARAMETERS
+esp_err_t ESP32_WIFIMANAGER_CTX_SetDriver(esp32_wifimanager_t* wm,
+                                            const esp32_wifimanager_driver_t* driver,
+                                            void* ctx);
+//NULL = ESP32_WIFIMANAGER_NVS_NAMESPACE. UP TO 15 CHARACTERS. CALL BEFORE SETPARAMETERS
+esp_err_t ESP32_WIFIMANAGER_CTX_SetNamespace(esp32_wifimanager_t* wm, const char* name);
+void ESP32_WIFIMANAGER_CTX_PowerHint(esp32_wifimanager_t* wm, uint32_t busy_ms);
+void ESP32_WIFIMANAGER_CTX_SetUserCbFunction(esp32_wifimanager_t* wm, void (*wifi_connected_cb)(char**, bool));
+//LIKE ESP32_WIFIMANAGER_Subscribe, BUT ONLY EVENTS POSTED BY wm. UNSUBSCRIBE AS USUAL
+esp_err_t ESP32_WIFIMANAGER_CTX_Subscribe(esp32_wifimanager_t* wm,
+                                            esp32_wifimanager_notify_cb_t cb,
+                                            void* arg,
+                                            uint32_t mask);
+esp_err_t ESP32_WIFIMANAGER_CTX_StartTask(esp32_wifimanager_t* wm, uint8_t priority);
+void ESP32_WIFIMANAGER_CTX_Mainiter(esp32_wifimanager_t* wm);
+void ESP32_WIFIMANAGER_CTX_GetStats(esp32_wifimanager_t* wm, esp32_wifimanager_stats_t* stats);
+//CLEARS COUNTERS AND LATENCY HISTOGRAMS. A CONNECTION IN PROGRESS KEEPS ITS START
+//POINT AND ITS OPEN LATENCY INTERVALS
+void ESP32_WIFIMANAGER_CTX_ResetStats(esp32_wifimanager_t* wm);
+void ESP32_WIFIMANAGER_CTX_GetLatency(esp32_wifimanager_t* wm, esp32_wifimanager_latency_t* snapshot);
+uint8_t ESP32_WIFIMANAGER_CTX_GetScanResults(esp32_wifimanager_t* wm,
+                                                const esp32_wifimanager_scan_entry_t** results,
+                                                uint8_t max);
+void ESP32_WIFIMANAGER_CTX_SetTrace(esp32_wifimanager_t* wm, bool on);
+uint16_t ESP32_WIFIMANAGER_CTX_GetTrace(esp32_wifimanager_t* wm, esp32_wifimanager_trace_record_t* records, uint16_t max);
+void ESP32_WIFIMANAGER_CTX_DumpTrace(esp32_wifimanager_t* wm);
+
+//DETERMINISTIC REPLAY OF A TRACE (HOST BUILD, STUB DRIVER)
+//wm MUST BE IN POLLED MODE, JUST AFTER SETPARAMETERS. set_time SETS THE STUB
+//esp_timer_get_time() CLOCK. EACH RECORDED EVENT IS INJECTED AT ITS TIME, WITH
+//THE HARDWARE READS RECORDED AFTER IT QUEUED AS INPUTS, THEN MAINITER RUNS UNTIL
+//THE MANAGER IS IDLE AGAIN. LIVE EVENTS (DRIVER, TIMERS) ARE IGNORED MEANWHILE
+esp_err_t ESP32_WIFIMANAGER_CTX_Replay(esp32_wifimanager_t* wm,
+                                        const esp32_wifimanager_trace_record_t* records,
+                                        uint32_t count,
+                                        void (*set_time)(int64_t ts_us));
+
 #endif
\ No newline at end of file
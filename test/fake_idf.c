@@ -0,0 +1,1315 @@
+/**************************************************
+* ESP32 WIFI-MANAGER HOST TEST FAKES
+*
+* SEE fake_idf.h
+**************************************************/
+
+#define _GNU_SOURCE
+#include "fake_idf.h"
+#include "esp_event_loop.h"
+#include "esp_smartconfig.h"
+#include "esp_spi_flash.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "tcpip_adapter.h"
+#include "lwip/dhcp.h"
+#include "lwip/etharp.h"
+#include "lwip/priv/tcpip_priv.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "rom/crc.h"
+#include "xtensa/hal.h"
+#include "ESP32_GPIO.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FAKE_NVS_ENTRIES        (32)
+#define FAKE_NVS_NAMESPACES     (8)
+#define FAKE_NVS_KEY_LEN        (16)
+#define FAKE_NVS_BLOB_LEN       (2048)
+
+typedef struct fake_task_s
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    TaskFunction_t fn;
+    void* arg;
+}fake_task_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t len;
+    uint32_t item_size;
+    uint32_t head;
+    uint32_t tail;
+    uint8_t data[];
+}fake_queue_t;
+
+typedef struct
+{
+    bool used;
+    nvs_handle ns;
+    char key[FAKE_NVS_KEY_LEN];
+    size_t len;
+    uint8_t blob[FAKE_NVS_BLOB_LEN];
+}fake_nvs_entry_t;
+
+//TEST VISIBLE STATE
+int64_t fake_idf_now_us = 1;
+bool fake_idf_realtime;
+uint32_t fake_idf_heap_free = 100000;
+bool fake_idf_tasks = true;
+bool fake_idf_verbose;
+uint8_t fake_idf_gpio_level = 1;
+fake_idf_wifi_t fake_idf_wifi;
+uint8_t fake_idf_flash[FAKE_IDF_FLASH_SIZE];
+unsigned fake_idf_checks;
+unsigned fake_idf_failures;
+
+//INTERNAL VARIABLES
+static pthread_mutex_t s_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread fake_task_t* s_current_task;
+static system_event_cb_t s_event_cb;
+static void* s_event_ctx;
+static sc_callback_t s_sc_cb;
+static fake_nvs_entry_t s_nvs[FAKE_NVS_ENTRIES];
+static char s_nvs_ns[FAKE_NVS_NAMESPACES][FAKE_NVS_KEY_LEN];   //HANDLE = INDEX + 1
+static uint32_t s_random = 1;
+static uint32_t s_ccount;
+
+//INTERNAL FUNCTIONS
+static void* s_task_entry(void* pArg);
+static fake_task_t* s_task_new(void);
+static void s_deadline(struct timespec* ts, TickType_t ticks);
+static fake_nvs_entry_t* s_nvs_find(nvs_handle ns, const char* key);
+
+__attribute__((constructor)) static void s_fake_idf_init(void)
+{
+    //FLASH STARTS ERASED
+
+    fake_idf_flash_erase_all();
+}
+
+/* TEST HELPERS */
+
+void fake_idf_advance_ms(uint32_t ms)
+{
+    //MOVE THE esp_timer_get_time() CLOCK
+
+    __atomic_add_fetch(&fake_idf_now_us, (int64_t)ms * 1000, __ATOMIC_RELAXED);
+}
+
+void fake_idf_set_time(int64_t ts_us)
+{
+    //JUMP THE CLOCK (REPLAY)
+
+    __atomic_store_n(&fake_idf_now_us, ts_us, __ATOMIC_RELAXED);
+}
+
+void fake_idf_seed(uint32_t seed)
+{
+    //RESTART esp_random
+
+    s_random = seed;
+}
+
+void fake_idf_nvs_erase_all(void)
+{
+    //FORGET EVERY NVS KEY
+
+    pthread_mutex_lock(&s_critical);
+    memset(s_nvs, 0, sizeof(s_nvs));
+    memset(s_nvs_ns, 0, sizeof(s_nvs_ns));
+    pthread_mutex_unlock(&s_critical);
+}
+
+void fake_idf_flash_erase_all(void)
+{
+    //WHOLE FLASH IMAGE BACK TO 0xFF
+
+    memset(fake_idf_flash, 0xFF, sizeof(fake_idf_flash));
+}
+
+void fake_idf_post_event(system_event_t* evt)
+{
+    fake_idf_radio_post_event(&fake_idf_wifi, evt);
+}
+
+void fake_idf_sta_start(void)
+{
+    fake_idf_radio_sta_start(&fake_idf_wifi);
+}
+
+void fake_idf_sta_connected(const char* ssid, const uint8_t* bssid, uint8_t channel, wifi_auth_mode_t authmode)
+{
+    fake_idf_radio_sta_connected(&fake_idf_wifi, ssid, bssid, channel, authmode);
+}
+
+void fake_idf_sta_disconnected(uint8_t reason)
+{
+    fake_idf_radio_sta_disconnected(&fake_idf_wifi, reason);
+}
+
+void fake_idf_sta_got_ip(uint32_t ip)
+{
+    fake_idf_radio_sta_got_ip(&fake_idf_wifi, ip);
+}
+
+void fake_idf_scan_done(void)
+{
+    fake_idf_radio_scan_done(&fake_idf_wifi);
+}
+
+void fake_idf_radio_post_event(fake_idf_wifi_t* radio, system_event_t* evt)
+{
+    //HAND A DRIVER EVENT TO THE REGISTERED HANDLER (EVENT TASK IN THE REAL IDF)
+    //OR, FOR A fake_idf_driver RADIO, TO ITS BOUND INSTANCE
+
+    if(radio != &fake_idf_wifi)
+    {
+        if(radio->owner != NULL)
+        {
+            ESP32_WIFIMANAGER_CTX_DriverEvent(radio->owner, evt);
+        }
+        return;
+    }
+    if(s_event_cb != NULL)
+    {
+        (*s_event_cb)(s_event_ctx, evt);
+    }
+}
+
+void fake_idf_radio_sta_start(fake_idf_wifi_t* radio)
+{
+    //SYSTEM_EVENT_STA_START
+
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = SYSTEM_EVENT_STA_START;
+    fake_idf_radio_post_event(radio, &evt);
+}
+
+void fake_idf_radio_sta_connected(fake_idf_wifi_t* radio,
+                                    const char* ssid,
+                                    const uint8_t* bssid,
+                                    uint8_t channel,
+                                    wifi_auth_mode_t authmode)
+{
+    //SYSTEM_EVENT_STA_CONNECTED. THE DRIVER NOW REPORTS THE AP
+
+    system_event_t evt;
+    size_t len = strnlen(ssid, sizeof(evt.event_info.connected.ssid));
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = SYSTEM_EVENT_STA_CONNECTED;
+    memcpy(evt.event_info.connected.ssid, ssid, len);
+    evt.event_info.connected.ssid_len = (uint8_t)len;
+    memcpy(evt.event_info.connected.bssid, bssid, 6);
+    evt.event_info.connected.channel = channel;
+    evt.event_info.connected.authmode = authmode;
+    radio->associated = true;
+    memcpy(radio->bssid, bssid, 6);
+    fake_idf_radio_post_event(radio, &evt);
+}
+
+void fake_idf_radio_sta_disconnected(fake_idf_wifi_t* radio, uint8_t reason)
+{
+    //SYSTEM_EVENT_STA_DISCONNECTED
+
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = SYSTEM_EVENT_STA_DISCONNECTED;
+    evt.event_info.disconnected.reason = reason;
+    radio->associated = false;
+    fake_idf_radio_post_event(radio, &evt);
+}
+
+void fake_idf_radio_sta_got_ip(fake_idf_wifi_t* radio, uint32_t ip)
+{
+    //SYSTEM_EVENT_STA_GOT_IP
+
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = SYSTEM_EVENT_STA_GOT_IP;
+    evt.event_info.got_ip.ip_info.ip.addr = ip;
+    radio->sta_ip.ip.addr = ip;
+    fake_idf_radio_post_event(radio, &evt);
+}
+
+void fake_idf_radio_scan_done(fake_idf_wifi_t* radio)
+{
+    //SYSTEM_EVENT_SCAN_DONE WITH radio->scan_records
+
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = SYSTEM_EVENT_SCAN_DONE;
+    evt.event_info.scan_done.number = (uint8_t)radio->scan_count;
+    fake_idf_radio_post_event(radio, &evt);
+}
+
+void fake_idf_radio_smartconfig(fake_idf_wifi_t* radio, smartconfig_status_t status, void* pdata)
+{
+    //HAND ESPTOUCH PROGRESS TO THE CALLBACK GIVEN TO esp_smartconfig_start
+    //OR, FOR A fake_idf_driver RADIO, TO ITS BOUND INSTANCE
+
+    if(radio != &fake_idf_wifi)
+    {
+        if(radio->owner != NULL)
+        {
+            ESP32_WIFIMANAGER_CTX_SmartconfigEvent(radio->owner, status, pdata);
+        }
+        return;
+    }
+    if(s_sc_cb != NULL)
+    {
+        (*s_sc_cb)(status, pdata);
+    }
+}
+
+int fake_idf_summary(const char* name)
+{
+    //ONE LINE RESULT. NON ZERO EXIT IF ANY CHECK FAILED
+
+    printf("%s: %u checks, %u failed\n", name, fake_idf_checks, fake_idf_failures);
+    return (fake_idf_failures == 0) ? 0 : 1;
+}
+
+/* ROM / SYSTEM */
+
+int ets_printf(const char* fmt, ...)
+{
+    //SILENT UNLESS fake_idf_verbose
+
+    va_list ap;
+    int ret = 0;
+
+    if(fake_idf_verbose)
+    {
+        va_start(ap, fmt);
+        ret = vprintf(fmt, ap);
+        va_end(ap);
+    }
+    return ret;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    //TEST CONTROLLED CLOCK, OR THE HOST MONOTONIC CLOCK
+
+    struct timespec ts;
+
+    if(fake_idf_realtime)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+    }
+    return __atomic_load_n(&fake_idf_now_us, __ATOMIC_RELAXED);
+}
+
+uint32_t esp_random(void)
+{
+    //REPEATABLE SEQUENCE
+
+    s_random = s_random * 1103515245 + 12345;
+    return s_random;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    //WHATEVER THE TEST SAYS
+
+    return __atomic_load_n(&fake_idf_heap_free, __ATOMIC_RELAXED);
+}
+
+unsigned xthal_get_ccount(void)
+{
+    //MONOTONIC, NOT CYCLES
+
+    return __atomic_add_fetch(&s_ccount, 1, __ATOMIC_RELAXED);
+}
+
+uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    //SAME RESULT AS THE ESP32 ROM (ZLIB CRC-32)
+
+    uint32_t i;
+    uint8_t bit;
+
+    crc = ~crc;
+    for(i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void ESP32_GPIO_SetDirection(uint8_t gpio, gpio_dir_t dir)
+{
+}
+
+esp_err_t ESP32_GPIO_GetValue(uint8_t gpio, uint8_t* value)
+{
+    //TRIGGER PIN READS fake_idf_gpio_level
+
+    *value = fake_idf_gpio_level;
+    return ESP_OK;
+}
+
+void ESP32_GPIO_SetValue(uint8_t gpio, bool value)
+{
+}
+
+/* FREERTOS */
+
+void portENTER_CRITICAL(portMUX_TYPE* mux)
+{
+    //ONE PROCESS WIDE RECURSIVE LOCK STANDS IN FOR EVERY SPINLOCK
+
+    pthread_mutex_lock(&s_critical);
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE* mux)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn,
+                        const char* name,
+                        uint32_t stack,
+                        void* arg,
+                        UBaseType_t priority,
+                        TaskHandle_t* handle)
+{
+    //ONE DETACHED THREAD PER TASK
+    //CREATED DETACHED: A SHORT TASK MAY DELETE ITSELF (AND FREE task) BEFORE WE RETURN
+
+    fake_task_t* task;
+    pthread_t thread;
+    pthread_attr_t attr;
+    int err;
+
+    if(!fake_idf_tasks)
+    {
+        return pdFALSE;
+    }
+
+    task = s_task_new();
+    task->fn = fn;
+    task->arg = arg;
+    if(handle != NULL)
+    {
+        *handle = task;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&thread, &attr, s_task_entry, task);
+    pthread_attr_destroy(&attr);
+    if(err != 0)
+    {
+        free(task);
+        return pdFALSE;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    //ONLY SELF DELETE IS SUPPORTED
+
+    fake_task_t* task = s_current_task;
+
+    if(handle == NULL || handle == task)
+    {
+        //FREE THE HANDLE HERE, THE THREAD IS DETACHED
+        if(task != NULL)
+        {
+            s_current_task = NULL;
+            pthread_mutex_destroy(&task->lock);
+            pthread_cond_destroy(&task->cond);
+            free(task);
+        }
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    //REAL TIME SLEEP. THE FAKE CLOCK DOES NOT MOVE
+
+    usleep((useconds_t)(ticks == 0 ? 1 : ticks) * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle)
+{
+    return 1024;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    //THE MAIN THREAD GETS A HANDLE ON FIRST USE
+
+    if(s_current_task == NULL)
+    {
+        s_current_task = s_task_new();
+    }
+    return s_current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    fake_task_t* task = (fake_task_t*)handle;
+
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    fake_task_t* task = (fake_task_t*)xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    uint32_t value;
+
+    s_deadline(&deadline, ticks);
+    pthread_mutex_lock(&task->lock);
+    while(task->notify == 0 && ticks != 0)
+    {
+        if(ticks == portMAX_DELAY)
+        {
+            pthread_cond_wait(&task->cond, &task->lock);
+        }
+        else if(pthread_cond_timedwait(&task->cond, &task->lock, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    value = task->notify;
+    if(value != 0)
+    {
+        task->notify = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size)
+{
+    fake_queue_t* q = calloc(1, sizeof(fake_queue_t) + len * item_size);
+
+    if(q == NULL)
+    {
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->len = len;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t ticks)
+{
+    //NEVER BLOCKS. FULL = FAIL
+
+    fake_queue_t* q = (fake_queue_t*)handle;
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&q->lock);
+    if(q->head - q->tail < q->len)
+    {
+        memcpy(&q->data[(q->head % q->len) * q->item_size], item, q->item_size);
+        q->head++;
+        pthread_cond_signal(&q->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t handle, const void* item, BaseType_t* woken)
+{
+    return xQueueSend(handle, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticks)
+{
+    fake_queue_t* q = (fake_queue_t*)handle;
+    struct timespec deadline;
+    BaseType_t ret = pdFALSE;
+
+    s_deadline(&deadline, ticks);
+    pthread_mutex_lock(&q->lock);
+    while(q->head == q->tail && ticks != 0)
+    {
+        if(ticks == portMAX_DELAY)
+        {
+            pthread_cond_wait(&q->cond, &q->lock);
+        }
+        else if(pthread_cond_timedwait(&q->cond, &q->lock, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    if(q->head != q->tail)
+    {
+        memcpy(item, &q->data[(q->tail % q->len) * q->item_size], q->item_size);
+        q->tail++;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+{
+    fake_queue_t* q = (fake_queue_t*)handle;
+    UBaseType_t n;
+
+    pthread_mutex_lock(&q->lock);
+    n = q->head - q->tail;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+BaseType_t xQueueReset(QueueHandle_t handle)
+{
+    fake_queue_t* q = (fake_queue_t*)handle;
+
+    pthread_mutex_lock(&q->lock);
+    q->tail = q->head;
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+void vQueueDelete(QueueHandle_t handle)
+{
+    free(handle);
+}
+
+/* WIFI DRIVER (PER RADIO, CONTEXT = fake_idf_wifi_t) */
+
+static esp_err_t s_radio_bind(void* ctx, esp32_wifimanager_t* wm)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+    esp32_wifimanager_t* expected = NULL;
+
+    if(!__atomic_compare_exchange_n(&radio->owner, &expected, wm, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+        expected != wm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+static void s_radio_unbind(void* ctx, esp32_wifimanager_t* wm)
+{
+    //EVENTS ARE DELIVERED ON THE TEST THREAD, NONE CAN BE IN FLIGHT
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    __atomic_compare_exchange_n(&radio->owner, &wm, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static esp_err_t s_radio_init(void* ctx)
+{
+    //THE DRIVER STARTS FROM WHAT FLASH HOLDS
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    if(!radio->up)
+    {
+        radio->up = true;
+        radio->sta = radio->sta_flash;
+        radio->storage = WIFI_STORAGE_FLASH;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_mode(void* ctx, wifi_mode_t mode)
+{
+    ((fake_idf_wifi_t*)ctx)->mode = mode;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_start(void* ctx)
+{
+    ((fake_idf_wifi_t*)ctx)->started = true;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_connect(void* ctx)
+{
+    ((fake_idf_wifi_t*)ctx)->connects++;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_disconnect(void* ctx)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    radio->disconnects++;
+    radio->associated = false;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_config(void* ctx, wifi_interface_t iface, wifi_config_t* config)
+{
+    //RAM COPY ALWAYS, FLASH COPY ONLY WITH WIFI_STORAGE_FLASH
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    if(iface == WIFI_IF_AP)
+    {
+        radio->ap = *config;
+        return ESP_OK;
+    }
+    radio->sta = *config;
+    if(radio->storage == WIFI_STORAGE_FLASH)
+    {
+        radio->sta_flash = *config;
+        radio->flash_writes++;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_get_config(void* ctx, wifi_interface_t iface, wifi_config_t* config)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    *config = (iface == WIFI_IF_AP) ? radio->ap : radio->sta;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_storage(void* ctx, wifi_storage_t storage)
+{
+    ((fake_idf_wifi_t*)ctx)->storage = storage;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_auto_connect(void* ctx, bool on)
+{
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_sta_get_ap_info(void* ctx, wifi_ap_record_t* ap)
+{
+    //FAILS WHILE NOT ASSOCIATED, AS THE DRIVER DOES
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    if(!radio->associated)
+    {
+        return ESP_FAIL;
+    }
+    memset(ap, 0, sizeof(*ap));
+    memcpy(ap->bssid, radio->bssid, 6);
+    memcpy(ap->ssid, radio->sta.sta.ssid, sizeof(radio->sta.sta.ssid));
+    ap->rssi = radio->rssi;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_ps(void* ctx, wifi_ps_type_t ps)
+{
+    ((fake_idf_wifi_t*)ctx)->ps = ps;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_get_ps(void* ctx, wifi_ps_type_t* ps)
+{
+    *ps = ((fake_idf_wifi_t*)ctx)->ps;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_scan_start(void* ctx, const wifi_scan_config_t* config, bool block)
+{
+    //RESULTS ARRIVE WHEN THE TEST CALLS fake_idf_radio_scan_done
+
+    ((fake_idf_wifi_t*)ctx)->scans++;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_scan_stop(void* ctx)
+{
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_scan_get_ap_records(void* ctx, uint16_t* number, wifi_ap_record_t* records)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    if(*number > radio->scan_count)
+    {
+        *number = radio->scan_count;
+    }
+    memcpy(records, radio->scan_records, *number * sizeof(wifi_ap_record_t));
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_smartconfig_start(void* ctx)
+{
+    //PROGRESS ARRIVES WHEN THE TEST CALLS fake_idf_radio_smartconfig
+
+    ((fake_idf_wifi_t*)ctx)->smartconfig = true;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_smartconfig_stop(void* ctx)
+{
+    ((fake_idf_wifi_t*)ctx)->smartconfig = false;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_dhcpc_start(void* ctx, tcpip_adapter_if_t iface)
+{
+    //LIKE THE ADAPTER: A FULL DISCOVER FROM 0.0.0.0
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    radio->dhcpc_on = true;
+    radio->lease_s = 0;
+    memset(&radio->sta_ip, 0, sizeof(radio->sta_ip));
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_dhcpc_stop(void* ctx, tcpip_adapter_if_t iface)
+{
+    ((fake_idf_wifi_t*)ctx)->dhcpc_on = false;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_get_ip_info(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    *info = (iface == TCPIP_ADAPTER_IF_AP) ? radio->ap_ip : radio->sta_ip;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_ip_info(void* ctx, tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    if(iface == TCPIP_ADAPTER_IF_AP)
+    {
+        radio->ap_ip = *info;
+    }
+    else
+    {
+        radio->sta_ip = *info;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_get_dns_info(void* ctx,
+                                        tcpip_adapter_if_t iface,
+                                        tcpip_adapter_dns_type_t type,
+                                        tcpip_adapter_dns_info_t* dns)
+{
+    *dns = ((fake_idf_wifi_t*)ctx)->dns;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_set_dns_info(void* ctx,
+                                        tcpip_adapter_if_t iface,
+                                        tcpip_adapter_dns_type_t type,
+                                        tcpip_adapter_dns_info_t* dns)
+{
+    ((fake_idf_wifi_t*)ctx)->dns = *dns;
+    return ESP_OK;
+}
+
+static uint32_t s_radio_dhcp_lease_s(void* ctx, tcpip_adapter_if_t iface)
+{
+    return ((fake_idf_wifi_t*)ctx)->lease_s;
+}
+
+static esp_err_t s_radio_dhcp_renew(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    //CLIENT RUNS, ADDRESS STAYS. THE TEST ACKS BY SETTING lease_s
+
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+
+    radio->renews++;
+    radio->dhcpc_on = true;
+    radio->lease_s = 0;
+    return ESP_OK;
+}
+
+static esp_err_t s_radio_arp_probe(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    ((fake_idf_wifi_t*)ctx)->arp_probes++;
+    return ESP_OK;
+}
+
+static bool s_radio_arp_lookup(void* ctx, tcpip_adapter_if_t iface, uint32_t ip)
+{
+    fake_idf_wifi_t* radio = (fake_idf_wifi_t*)ctx;
+    uint8_t i;
+
+    for(i = 0; i < radio->arp_host_count; i++)
+    {
+        if(radio->arp_hosts[i] == ip)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const esp32_wifimanager_driver_t fake_idf_driver = {.bind = s_radio_bind,
+                                                    .unbind = s_radio_unbind,
+                                                    .init = s_radio_init,
+                                                    .set_mode = s_radio_set_mode,
+                                                    .start = s_radio_start,
+                                                    .connect = s_radio_connect,
+                                                    .disconnect = s_radio_disconnect,
+                                                    .set_config = s_radio_set_config,
+                                                    .get_config = s_radio_get_config,
+                                                    .set_storage = s_radio_set_storage,
+                                                    .set_auto_connect = s_radio_set_auto_connect,
+                                                    .sta_get_ap_info = s_radio_sta_get_ap_info,
+                                                    .set_ps = s_radio_set_ps,
+                                                    .get_ps = s_radio_get_ps,
+                                                    .scan_start = s_radio_scan_start,
+                                                    .scan_stop = s_radio_scan_stop,
+                                                    .scan_get_ap_records = s_radio_scan_get_ap_records,
+                                                    .smartconfig_start = s_radio_smartconfig_start,
+                                                    .smartconfig_stop = s_radio_smartconfig_stop,
+                                                    .dhcpc_start = s_radio_dhcpc_start,
+                                                    .dhcpc_stop = s_radio_dhcpc_stop,
+                                                    .get_ip_info = s_radio_get_ip_info,
+                                                    .set_ip_info = s_radio_set_ip_info,
+                                                    .get_dns_info = s_radio_get_dns_info,
+                                                    .set_dns_info = s_radio_set_dns_info,
+                                                    .dhcp_lease_s = s_radio_dhcp_lease_s,
+                                                    .dhcp_renew = s_radio_dhcp_renew,
+                                                    .arp_probe = s_radio_arp_probe,
+                                                    .arp_lookup = s_radio_arp_lookup};
+
+/* IDF ENTRY POINTS, ON fake_idf_wifi */
+
+esp_err_t esp_event_loop_init(system_event_cb_t cb, void* ctx)
+{
+    s_event_cb = cb;
+    s_event_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t* config)
+{
+    return s_radio_init(&fake_idf_wifi);
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    return s_radio_set_mode(&fake_idf_wifi, mode);
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    return s_radio_start(&fake_idf_wifi);
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    return s_radio_connect(&fake_idf_wifi);
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    return s_radio_disconnect(&fake_idf_wifi);
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t iface, wifi_config_t* config)
+{
+    return s_radio_set_config(&fake_idf_wifi, iface, config);
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t iface, wifi_config_t* config)
+{
+    return s_radio_get_config(&fake_idf_wifi, iface, config);
+}
+
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage)
+{
+    return s_radio_set_storage(&fake_idf_wifi, storage);
+}
+
+esp_err_t esp_wifi_set_auto_connect(bool on)
+{
+    return s_radio_set_auto_connect(&fake_idf_wifi, on);
+}
+
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t* config, bool block)
+{
+    return s_radio_scan_start(&fake_idf_wifi, config, block);
+}
+
+esp_err_t esp_wifi_scan_stop(void)
+{
+    return s_radio_scan_stop(&fake_idf_wifi);
+}
+
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t* number)
+{
+    *number = fake_idf_wifi.scan_count;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_scan_get_ap_records(uint16_t* number, wifi_ap_record_t* records)
+{
+    return s_radio_scan_get_ap_records(&fake_idf_wifi, number, records);
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap)
+{
+    return s_radio_sta_get_ap_info(&fake_idf_wifi, ap);
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t ps)
+{
+    return s_radio_set_ps(&fake_idf_wifi, ps);
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t* ps)
+{
+    return s_radio_get_ps(&fake_idf_wifi, ps);
+}
+
+esp_err_t esp_smartconfig_set_type(smartconfig_type_t type)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_smartconfig_start(sc_callback_t cb, ...)
+{
+    s_sc_cb = cb;
+    return s_radio_smartconfig_start(&fake_idf_wifi);
+}
+
+esp_err_t esp_smartconfig_stop(void)
+{
+    return s_radio_smartconfig_stop(&fake_idf_wifi);
+}
+
+/* TCPIP ADAPTER */
+
+esp_err_t tcpip_adapter_dhcpc_start(tcpip_adapter_if_t iface)
+{
+    return s_radio_dhcpc_start(&fake_idf_wifi, iface);
+}
+
+esp_err_t tcpip_adapter_dhcpc_stop(tcpip_adapter_if_t iface)
+{
+    return s_radio_dhcpc_stop(&fake_idf_wifi, iface);
+}
+
+esp_err_t tcpip_adapter_set_ip_info(tcpip_adapter_if_t iface, const tcpip_adapter_ip_info_t* info)
+{
+    tcpip_adapter_ip_info_t copy = *info;
+
+    return s_radio_set_ip_info(&fake_idf_wifi, iface, &copy);
+}
+
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t iface, tcpip_adapter_ip_info_t* info)
+{
+    return s_radio_get_ip_info(&fake_idf_wifi, iface, info);
+}
+
+esp_err_t tcpip_adapter_set_dns_info(tcpip_adapter_if_t iface, tcpip_adapter_dns_type_t type, tcpip_adapter_dns_info_t* dns)
+{
+    return s_radio_set_dns_info(&fake_idf_wifi, iface, type, dns);
+}
+
+esp_err_t tcpip_adapter_get_dns_info(tcpip_adapter_if_t iface, tcpip_adapter_dns_type_t type, tcpip_adapter_dns_info_t* dns)
+{
+    return s_radio_get_dns_info(&fake_idf_wifi, iface, type, dns);
+}
+
+esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t iface, void** netif)
+{
+    //NO LWIP HERE. THE DEFAULT DRIVER THEN REPORTS AN UNKNOWN LEASE TIME
+
+    *netif = NULL;
+    return ESP_FAIL;
+}
+
+struct dhcp* netif_dhcp_data(struct netif* netif)
+{
+    return NULL;
+}
+
+/* LWIP (NEVER REACHED, NO NETIF ABOVE) */
+
+err_t tcpip_api_call(tcpip_api_call_fn fn, struct tcpip_api_call_data* call)
+{
+    return fn(call);
+}
+
+err_t dhcp_start(struct netif* netif)
+{
+    return ERR_IF;
+}
+
+void dhcp_stop(struct netif* netif)
+{
+}
+
+void dhcp_network_changed(struct netif* netif)
+{
+}
+
+err_t etharp_request(struct netif* netif, const ip4_addr_t* ip)
+{
+    return ERR_IF;
+}
+
+err_t etharp_acd_probe(struct netif* netif, const ip4_addr_t* ip)
+{
+    return ERR_IF;
+}
+
+ssize_t etharp_find_addr(struct netif* netif, const ip4_addr_t* ip, struct eth_addr** eth, const ip4_addr_t** ip_ret)
+{
+    return -1;
+}
+
+/* NVS (A HANDLE IS ITS NAMESPACE, KEYS ARE PER NAMESPACE) */
+
+esp_err_t nvs_open(const char* name, nvs_open_mode mode, nvs_handle* handle)
+{
+    //LIKE THE IDF: A NAMESPACE IS CREATED BY ITS FIRST READWRITE OPEN
+
+    esp_err_t err = ESP_ERR_NVS_NOT_FOUND;
+    uint8_t i;
+
+    if(strlen(name) >= FAKE_NVS_KEY_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_critical);
+    for(i = 0; i < FAKE_NVS_NAMESPACES; i++)
+    {
+        if(strcmp(s_nvs_ns[i], name) == 0)
+        {
+            err = ESP_OK;
+            break;
+        }
+    }
+    if(err != ESP_OK && mode == NVS_READWRITE)
+    {
+        for(i = 0; i < FAKE_NVS_NAMESPACES && s_nvs_ns[i][0] != '\0'; i++)
+        {
+        }
+        if(i < FAKE_NVS_NAMESPACES)
+        {
+            strcpy(s_nvs_ns[i], name);
+            err = ESP_OK;
+        }
+        else
+        {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    pthread_mutex_unlock(&s_critical);
+    *handle = (err == ESP_OK) ? (nvs_handle)i + 1 : 0;
+    return err;
+}
+
+void nvs_close(nvs_handle handle)
+{
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out, size_t* len)
+{
+    fake_nvs_entry_t* entry;
+    esp_err_t err = ESP_OK;
+
+    pthread_mutex_lock(&s_critical);
+    entry = s_nvs_find(handle, key);
+    if(entry == NULL)
+    {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    }
+    else if(out == NULL)
+    {
+        *len = entry->len;
+    }
+    else if(*len < entry->len)
+    {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    else
+    {
+        memcpy(out, entry->blob, entry->len);
+        *len = entry->len;
+    }
+    pthread_mutex_unlock(&s_critical);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t len)
+{
+    fake_nvs_entry_t* entry;
+    uint8_t i;
+
+    if(len > FAKE_NVS_BLOB_LEN || strlen(key) >= FAKE_NVS_KEY_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pthread_mutex_lock(&s_critical);
+    entry = s_nvs_find(handle, key);
+    for(i = 0; entry == NULL && i < FAKE_NVS_ENTRIES; i++)
+    {
+        if(!s_nvs[i].used)
+        {
+            entry = &s_nvs[i];
+            entry->used = true;
+            entry->ns = handle;
+            strcpy(entry->key, key);
+        }
+    }
+    if(entry != NULL)
+    {
+        memcpy(entry->blob, value, len);
+        entry->len = len;
+    }
+    pthread_mutex_unlock(&s_critical);
+    return (entry != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key)
+{
+    fake_nvs_entry_t* entry;
+
+    pthread_mutex_lock(&s_critical);
+    entry = s_nvs_find(handle, key);
+    if(entry != NULL)
+    {
+        entry->used = false;
+    }
+    pthread_mutex_unlock(&s_critical);
+    return (entry != NULL) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle handle)
+{
+    return ESP_OK;
+}
+
+/* SPI FLASH (NOR: WRITES CLEAR BITS, ERASE SETS THEM) */
+
+esp_err_t spi_flash_read(size_t src, void* dst, size_t size)
+{
+    if(src + size > FAKE_IDF_FLASH_SIZE)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, &fake_idf_flash[src], size);
+    return ESP_OK;
+}
+
+esp_err_t spi_flash_write(size_t dst, const void* src, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)src;
+    size_t i;
+
+    if(dst + size > FAKE_IDF_FLASH_SIZE)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for(i = 0; i < size; i++)
+    {
+        fake_idf_flash[dst + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_flash_erase_range(size_t start, size_t size)
+{
+    if((start % SPI_FLASH_SEC_SIZE) != 0 || (size % SPI_FLASH_SEC_SIZE) != 0 ||
+        start + size > FAKE_IDF_FLASH_SIZE)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&fake_idf_flash[start], 0xFF, size);
+    return ESP_OK;
+}
+
+/* INTERNAL */
+
+static void* s_task_entry(void* pArg)
+{
+    fake_task_t* task = (fake_task_t*)pArg;
+
+    s_current_task = task;
+    (*task->fn)(task->arg);
+    return NULL;
+}
+
+static fake_task_t* s_task_new(void)
+{
+    fake_task_t* task = calloc(1, sizeof(fake_task_t));
+
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    return task;
+}
+
+static void s_deadline(struct timespec* ts, TickType_t ticks)
+{
+    //ABSOLUTE REAL TIME DEADLINE ticks FROM NOW
+
+    uint64_t ns;
+
+    clock_gettime(CLOCK_REALTIME, ts);
+    if(ticks == portMAX_DELAY)
+    {
+        return;
+    }
+    ns = (uint64_t)ts->tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+static fake_nvs_entry_t* s_nvs_find(nvs_handle ns, const char* key)
+{
+    uint8_t i;
+
+    for(i = 0; i < FAKE_NVS_ENTRIES; i++)
+    {
+        if(s_nvs[i].used && s_nvs[i].ns == ns && strncmp(s_nvs[i].key, key, FAKE_NVS_KEY_LEN) == 0)
+        {
+            return &s_nvs[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,120 @@
+/**************************************************
+* ESP32 WIFI-MANAGER HOST TEST FAKES
+*
+* IN-PROCESS STAND-INS FOR THE ESP-IDF PIECES THE
+* COMPONENT CALLS: CLOCK, FREERTOS TASKS / QUEUES /
+* CRITICAL SECTIONS (PTHREADS), WIFI DRIVER, EVENT
+* LOOP, NVS, SPI FLASH AND ROM CRC
+*
+* THE CLOCK ONLY MOVES WHEN A TEST MOVES IT (OR
+* FOLLOWS THE HOST WITH fake_idf_realtime). TASKS
+* ARE REAL THREADS UNLESS fake_idf_tasks IS FALSE,
+* THEN xTaskCreate FAILS (MODULES FALL BACK TO THE
+* CALLER'S CONTEXT)
+**************************************************/
+
+#ifndef _FAKE_IDF_
+#define _FAKE_IDF_
+
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "tcpip_adapter.h"
+#include "ESP32_WIFIMANAGER_DRIVER.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define FAKE_IDF_FLASH_SIZE         (0x10000)
+#define FAKE_IDF_SCAN_MAX           (16)
+#define FAKE_IDF_ARP_MAX            (4)
+
+//TEST ASSERTIONS. A FAILED CHECK IS REPORTED AND COUNTED, THE TEST GOES ON
+#define CHECK(cond)                                                             \
+    do                                                                          \
+    {                                                                           \
+        fake_idf_checks++;                                                      \
+        if(!(cond))                                                             \
+        {                                                                       \
+            fake_idf_failures++;                                                \
+            printf("%s:%d: CHECK FAILED: %s\n", __FILE__, __LINE__, #cond);     \
+        }                                                                       \
+    } while(0)
+
+typedef struct
+{
+    wifi_config_t sta;              //DRIVER RAM COPY (esp_wifi_get_config)
+    wifi_config_t sta_flash;        //WHAT WAS WRITTEN WITH WIFI_STORAGE_FLASH
+    wifi_config_t ap;
+    wifi_storage_t storage;
+    wifi_ps_type_t ps;
+    wifi_mode_t mode;               //LAST set_mode
+    bool started;
+    bool associated;
+    bool smartconfig;               //SNIFFING (smartconfig_start .. smartconfig_stop)
+    int8_t rssi;
+    uint8_t bssid[6];
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t scans;
+    uint32_t flash_writes;
+    wifi_ap_record_t scan_records[FAKE_IDF_SCAN_MAX];
+    uint16_t scan_count;
+    bool up;                        //esp_wifi_init / DRIVER init DONE
+    bool dhcpc_on;
+    tcpip_adapter_ip_info_t sta_ip; //WHAT get_ip_info REPORTS
+    tcpip_adapter_ip_info_t ap_ip;
+    tcpip_adapter_dns_info_t dns;
+    uint32_t lease_s;               //OFFERED T0 (0 = UNKNOWN)
+    uint32_t renews;                //dhcp_renew CALLS, ADDRESS KEPT (UNLIKE dhcpc_start)
+    uint32_t arp_probes;
+    uint32_t arp_hosts[FAKE_IDF_ARP_MAX];   //ADDRESSES THAT ANSWER ARP
+    uint8_t arp_host_count;
+    esp32_wifimanager_t* owner;     //INSTANCE BOUND THROUGH fake_idf_driver
+}fake_idf_wifi_t;
+
+extern int64_t fake_idf_now_us;
+extern bool fake_idf_realtime;             //esp_timer_get_time IS CLOCK_MONOTONIC
+extern uint32_t fake_idf_heap_free;         //esp_get_free_heap_size, NOT TRACKED BY THE FAKES
+extern bool fake_idf_tasks;
+extern bool fake_idf_verbose;
+extern uint8_t fake_idf_gpio_level;
+extern fake_idf_wifi_t fake_idf_wifi;       //THE RADIO BEHIND esp_wifi_* (DEFAULT DRIVER)
+extern const esp32_wifimanager_driver_t fake_idf_driver;   //CONTEXT = ANY OTHER fake_idf_wifi_t
+extern uint8_t fake_idf_flash[FAKE_IDF_FLASH_SIZE];
+extern unsigned fake_idf_checks;
+extern unsigned fake_idf_failures;
+
+void fake_idf_advance_ms(uint32_t ms);
+void fake_idf_set_time(int64_t ts_us);      //CTX_Replay set_time HOOK
+void fake_idf_seed(uint32_t seed);          //esp_random RESTARTS FROM seed
+void fake_idf_nvs_erase_all(void);
+void fake_idf_flash_erase_all(void);
+
+//DRIVER EVENTS, DELIVERED TO THE HANDLER GIVEN TO esp_event_loop_init
+void fake_idf_post_event(system_event_t* evt);
+void fake_idf_sta_start(void);
+void fake_idf_sta_connected(const char* ssid, const uint8_t* bssid, uint8_t channel, wifi_auth_mode_t authmode);
+void fake_idf_sta_disconnected(uint8_t reason);
+void fake_idf_sta_got_ip(uint32_t ip);
+void fake_idf_scan_done(void);
+
+//THE SAME ON ANY RADIO. fake_idf_wifi GOES THROUGH THE EVENT LOOP, OTHERS
+//STRAIGHT TO THE INSTANCE BOUND THROUGH fake_idf_driver
+void fake_idf_radio_post_event(fake_idf_wifi_t* radio, system_event_t* evt);
+void fake_idf_radio_sta_start(fake_idf_wifi_t* radio);
+void fake_idf_radio_sta_connected(fake_idf_wifi_t* radio,
+                                    const char* ssid,
+                                    const uint8_t* bssid,
+                                    uint8_t channel,
+                                    wifi_auth_mode_t authmode);
+void fake_idf_radio_sta_disconnected(fake_idf_wifi_t* radio, uint8_t reason);
+void fake_idf_radio_sta_got_ip(fake_idf_wifi_t* radio, uint32_t ip);
+void fake_idf_radio_scan_done(fake_idf_wifi_t* radio);
+//ESPTOUCH PROGRESS AS THE SMARTCONFIG CALLBACK SEES IT. pdata: wifi_config_t
+//FOR SC_STATUS_LINK, THE PHONE'S IPv4 (4 BYTES) FOR SC_STATUS_LINK_OVER
+void fake_idf_radio_smartconfig(fake_idf_wifi_t* radio, smartconfig_status_t status, void* pdata);
+
+//PRINT THE CHECK SUMMARY, RETURN THE PROCESS EXIT CODE
+int fake_idf_summary(const char* name);
+
+#endif
@@ -0,0 +1,6 @@
+#include "common.h"
+typedef enum {GPIO_DIRECTION_INPUT, GPIO_DIRECTION_OUTPUT} gpio_dir_t;
+void ESP32_GPIO_SetDirection(uint8_t, gpio_dir_t);
+esp_err_t ESP32_GPIO_GetValue(uint8_t, uint8_t*);
+void ESP32_GPIO_SetValue(uint8_t, bool);
+void ESP32_GPIO_SetDebug(bool);
@@ -0,0 +1,23 @@
+/**************************************************
+* HOST TEST STAND-INS FOR THE ESP-IDF v3 HEADERS
+*
+* DECLARATIONS ONLY, CUT DOWN TO WHAT THE COMPONENT
+* USES. THE FAKES LIVE IN test/fake_idf.c
+**************************************************/
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+typedef int32_t esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_INVALID_CRC 0x109
+#define ESP_ERR_TIMEOUT 0x107
+int ets_printf(const char* fmt, ...);
+#define IRAM_ATTR
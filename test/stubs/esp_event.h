@@ -0,0 +1,12 @@
+#pragma once
+#include "esp_wifi_types.h"
+#include "tcpip_adapter.h"
+typedef enum { SYSTEM_EVENT_WIFI_READY=0, SYSTEM_EVENT_SCAN_DONE, SYSTEM_EVENT_STA_START, SYSTEM_EVENT_STA_STOP, SYSTEM_EVENT_STA_CONNECTED, SYSTEM_EVENT_STA_DISCONNECTED, SYSTEM_EVENT_STA_AUTHMODE_CHANGE, SYSTEM_EVENT_STA_GOT_IP, SYSTEM_EVENT_STA_LOST_IP, SYSTEM_EVENT_AP_START=12, SYSTEM_EVENT_AP_STOP, SYSTEM_EVENT_AP_STACONNECTED, SYSTEM_EVENT_AP_STADISCONNECTED, SYSTEM_EVENT_MAX } system_event_id_t;
+typedef struct { uint8_t ssid[32]; uint8_t ssid_len; uint8_t bssid[6]; uint8_t channel; wifi_auth_mode_t authmode; } system_event_sta_connected_t;
+typedef struct { uint8_t ssid[32]; uint8_t ssid_len; uint8_t bssid[6]; uint8_t reason; } system_event_sta_disconnected_t;
+typedef struct { uint32_t status; uint8_t number; uint8_t scan_id; } system_event_sta_scan_done_t;
+typedef struct { tcpip_adapter_ip_info_t ip_info; bool ip_changed; } system_event_sta_got_ip_t;
+typedef struct { uint8_t mac[6]; uint8_t aid; } system_event_ap_staconnected_t;
+typedef union { system_event_sta_connected_t connected; system_event_sta_disconnected_t disconnected; system_event_sta_scan_done_t scan_done; system_event_sta_got_ip_t got_ip; system_event_ap_staconnected_t sta_connected; system_event_ap_staconnected_t sta_disconnected; } system_event_info_t;
+typedef struct { system_event_id_t event_id; system_event_info_t event_info; } system_event_t;
+typedef esp_err_t (*system_event_cb_t)(void*, system_event_t*);
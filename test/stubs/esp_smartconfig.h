@@ -0,0 +1,6 @@
+#pragma once
+#include "common.h"
+typedef enum {SC_STATUS_WAIT=0, SC_STATUS_FIND_CHANNEL, SC_STATUS_GETTING_SSID_PSWD, SC_STATUS_LINK, SC_STATUS_LINK_OVER} smartconfig_status_t;
+typedef enum {SC_TYPE_ESPTOUCH=0, SC_TYPE_AIRKISS, SC_TYPE_ESPTOUCH_AIRKISS} smartconfig_type_t;
+typedef void (*sc_callback_t)(smartconfig_status_t, void*);
+esp_err_t esp_smartconfig_set_type(smartconfig_type_t); esp_err_t esp_smartconfig_start(sc_callback_t, ...); esp_err_t esp_smartconfig_stop(void);
@@ -0,0 +1,6 @@
+#pragma once
+#include "common.h"
+#define SPI_FLASH_SEC_SIZE 4096
+esp_err_t spi_flash_read(size_t src, void* dst, size_t size);
+esp_err_t spi_flash_write(size_t dst, const void* src, size_t size);
+esp_err_t spi_flash_erase_range(size_t start, size_t size);
@@ -0,0 +1,5 @@
+#pragma once
+#include "common.h"
+uint32_t esp_random(void);
+esp_err_t esp_efuse_mac_get_default(uint8_t*);
+uint32_t esp_get_free_heap_size(void);
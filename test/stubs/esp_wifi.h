@@ -0,0 +1,12 @@
+#pragma once
+#include "esp_wifi_types.h"
+typedef struct { int x; } wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() {0}
+esp_err_t esp_wifi_init(const wifi_init_config_t*); esp_err_t esp_wifi_set_mode(wifi_mode_t); esp_err_t esp_wifi_get_mode(wifi_mode_t*);
+esp_err_t esp_wifi_start(void); esp_err_t esp_wifi_stop(void); esp_err_t esp_wifi_connect(void); esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_set_config(wifi_interface_t, wifi_config_t*); esp_err_t esp_wifi_get_config(wifi_interface_t, wifi_config_t*);
+esp_err_t esp_wifi_set_storage(wifi_storage_t); esp_err_t esp_wifi_set_auto_connect(bool);
+esp_err_t esp_wifi_scan_start(const wifi_scan_config_t*, bool); esp_err_t esp_wifi_scan_stop(void);
+esp_err_t esp_wifi_scan_get_ap_num(uint16_t*); esp_err_t esp_wifi_scan_get_ap_records(uint16_t*, wifi_ap_record_t*);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t*); esp_err_t esp_wifi_set_ps(wifi_ps_type_t); esp_err_t esp_wifi_get_ps(wifi_ps_type_t*);
+esp_err_t esp_wifi_set_channel(uint8_t, wifi_second_chan_t);
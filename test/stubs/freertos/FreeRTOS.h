@@ -0,0 +1,15 @@
+#pragma once
+#include "common.h"
+typedef int BaseType_t; typedef unsigned UBaseType_t; typedef uint32_t TickType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffff
+#define portTICK_PERIOD_MS 10
+#define pdMS_TO_TICKS(x) ((x)/10)
+#define portYIELD_FROM_ISR() do{}while(0)
+typedef struct { int x; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void portENTER_CRITICAL(portMUX_TYPE*); void portEXIT_CRITICAL(portMUX_TYPE*);
+void portENTER_CRITICAL_ISR(portMUX_TYPE*); void portEXIT_CRITICAL_ISR(portMUX_TYPE*);
+#define tskNO_AFFINITY 0x7fffffff
@@ -0,0 +1,10 @@
+#pragma once
+#include "FreeRTOS.h"
+typedef void* QueueHandle_t;
+QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t);
+BaseType_t xQueueSend(QueueHandle_t, const void*, TickType_t);
+BaseType_t xQueueSendFromISR(QueueHandle_t, const void*, BaseType_t*);
+BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t);
+void vQueueDelete(QueueHandle_t);
+BaseType_t xQueueReset(QueueHandle_t);
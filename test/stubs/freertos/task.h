@@ -0,0 +1,8 @@
+#pragma once
+#include "FreeRTOS.h"
+typedef void* TaskHandle_t; typedef void (*TaskFunction_t)(void*);
+BaseType_t xTaskCreate(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t*);
+void vTaskDelete(TaskHandle_t); void vTaskDelay(TickType_t); TickType_t xTaskGetTickCount(void);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t);
+BaseType_t xTaskNotifyGive(TaskHandle_t); uint32_t ulTaskNotifyTake(BaseType_t, TickType_t);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
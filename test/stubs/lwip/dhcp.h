@@ -0,0 +1,6 @@
+#pragma once
+#include "lwip/err.h"
+#include "lwip/netif.h"
+struct dhcp { uint8_t state; ip4_addr_t offered_ip_addr; uint32_t offered_t0_lease; uint32_t offered_t1_renew; };
+struct dhcp* netif_dhcp_data(struct netif*);
+err_t dhcp_start(struct netif*); void dhcp_stop(struct netif*); void dhcp_network_changed(struct netif*);
@@ -0,0 +1,7 @@
+#pragma once
+#include <sys/types.h>
+#include "lwip/err.h"
+#include "lwip/netif.h"
+struct eth_addr { uint8_t addr[6]; };
+err_t etharp_request(struct netif*, const ip4_addr_t*); err_t etharp_acd_probe(struct netif*, const ip4_addr_t*);
+ssize_t etharp_find_addr(struct netif*, const ip4_addr_t*, struct eth_addr**, const ip4_addr_t**);
@@ -0,0 +1,6 @@
+#pragma once
+#include "tcpip_adapter.h"
+struct netif { ip4_addr_t ip_addr; void* client_data; };
+#define netif_ip4_addr(netif)       ((const ip4_addr_t*)&(netif)->ip_addr)
+#define ip4_addr_cmp(a, b)          ((a)->addr == (b)->addr)
+#define ip4_addr_copy(dst, src)     ((dst).addr = (src).addr)
@@ -0,0 +1,2 @@
+#pragma once
+typedef enum { DHCP_STATE_OFF = 0, DHCP_STATE_BOUND = 10 } dhcp_state_enum_t;
@@ -0,0 +1,8 @@
+#pragma once
+#include <stddef.h>
+typedef enum { MBEDTLS_MD_NONE=0, MBEDTLS_MD_MD2, MBEDTLS_MD_MD4, MBEDTLS_MD_MD5, MBEDTLS_MD_SHA1 } mbedtls_md_type_t;
+typedef struct mbedtls_md_info_t mbedtls_md_info_t;
+typedef struct { const mbedtls_md_info_t* md_info; void* md_ctx; void* hmac_ctx; } mbedtls_md_context_t;
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t);
+void mbedtls_md_init(mbedtls_md_context_t*); void mbedtls_md_free(mbedtls_md_context_t*);
+int mbedtls_md_setup(mbedtls_md_context_t*, const mbedtls_md_info_t*, int);
@@ -0,0 +1,3 @@
+#pragma once
+#include "md.h"
+int mbedtls_pkcs5_pbkdf2_hmac(mbedtls_md_context_t*, const unsigned char*, size_t, const unsigned char*, size_t, unsigned int, unsigned int, unsigned char*);
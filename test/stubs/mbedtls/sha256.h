@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+typedef struct { uint32_t total[2]; uint32_t state[8]; unsigned char buffer[64]; int is224; } mbedtls_sha256_context;
+void mbedtls_sha256_init(mbedtls_sha256_context*); void mbedtls_sha256_free(mbedtls_sha256_context*);
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context*, int);
+int mbedtls_sha256_update_ret(mbedtls_sha256_context*, const unsigned char*, size_t);
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context*, unsigned char*);
@@ -0,0 +1,8 @@
+#pragma once
+#include "common.h"
+typedef uint32_t nvs_handle;
+typedef enum {NVS_READONLY, NVS_READWRITE} nvs_open_mode;
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+esp_err_t nvs_open(const char*, nvs_open_mode, nvs_handle*); void nvs_close(nvs_handle);
+esp_err_t nvs_get_blob(nvs_handle, const char*, void*, size_t*); esp_err_t nvs_set_blob(nvs_handle, const char*, const void*, size_t);
+esp_err_t nvs_erase_key(nvs_handle, const char*); esp_err_t nvs_commit(nvs_handle);
@@ -0,0 +1,13 @@
+#pragma once
+#include "common.h"
+typedef struct { uint32_t addr; } ip4_addr_t;
+typedef struct { ip4_addr_t ip; ip4_addr_t netmask; ip4_addr_t gw; } tcpip_adapter_ip_info_t;
+typedef enum {TCPIP_ADAPTER_IF_STA=0, TCPIP_ADAPTER_IF_AP} tcpip_adapter_if_t;
+typedef enum {TCPIP_ADAPTER_DNS_MAIN=0, TCPIP_ADAPTER_DNS_BACKUP} tcpip_adapter_dns_type_t;
+typedef struct { struct { union { ip4_addr_t ip4; } u_addr; uint8_t type; } ip; } tcpip_adapter_dns_info_t;
+esp_err_t tcpip_adapter_dhcpc_stop(tcpip_adapter_if_t); esp_err_t tcpip_adapter_dhcpc_start(tcpip_adapter_if_t);
+esp_err_t tcpip_adapter_set_ip_info(tcpip_adapter_if_t, const tcpip_adapter_ip_info_t*);
+esp_err_t tcpip_adapter_get_ip_info(tcpip_adapter_if_t, tcpip_adapter_ip_info_t*);
+esp_err_t tcpip_adapter_set_dns_info(tcpip_adapter_if_t, tcpip_adapter_dns_type_t, tcpip_adapter_dns_info_t*);
+esp_err_t tcpip_adapter_get_dns_info(tcpip_adapter_if_t, tcpip_adapter_dns_type_t, tcpip_adapter_dns_info_t*);
+struct netif; esp_err_t tcpip_adapter_get_netif(tcpip_adapter_if_t, void**);
@@ -0,0 +1 @@
+unsigned xthal_get_ccount(void);
@@ -0,0 +1,294 @@
+/**************************************************
+* HOST TEST: STORED NETWORK RETRIES NEXT TO THE PORTAL
+* (ESP32_WIFIMANAGER_backoff_t.apsta_retry_ms)
+*
+* THE STORED AP GOES AWAY, THE MANAGER GIVES UP AND
+* BRINGS UP THE SOFTAP PORTAL (WEBCONFIG), THEN THE
+* AP COMES BACK: ON ITS OLD CHANNEL, ON ANOTHER ONE,
+* AND WITH A CLIENT ON THE PORTAL. CHECKS WHICH
+* RETRIES WERE PINNED OR SCANNED, apsta_retries,
+* apsta_deferred AND apsta_recoveries, AND THAT THE
+* PORTAL IS TORN DOWN: BACK TO STA, PORT CLOSED, NO
+* MORE RETRIES
+*
+* THE CLOCK IS THE FAKE ONE, THE PORTAL TASK IS REAL
+* AND LISTENS ON LOOPBACK
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define APSTA_RETRY_MS          (15000)
+#define APSTA_STEP_MS           (50)
+#define APSTA_FAIL_MS           (120000)    //ENOUGH FOR EVERY BACKOFF ATTEMPT TO FAIL
+#define APSTA_CHANNEL           (6)
+#define APSTA_IP                (0x0A01A8C0)
+#define APSTA_HTTP_PORT         (18180)
+#define APSTA_DNS_PORT          (18153)
+
+//ONE SCRIPTED OUTAGE. TIMES COUNT FROM THE PORTAL COMING UP
+typedef struct
+{
+    const char* name;
+    uint8_t known;                      //CHANNEL THE AP WAS FIRST JOINED ON. 0 = NOT REPORTED
+    uint32_t back_ms;                   //AP BACK AFTER THIS
+    uint8_t channel;                    //AND ON THIS CHANNEL
+    uint32_t client_ms;                 //PORTAL CLIENT FROM 0 UNTIL THIS. 0 = NONE
+    uint32_t retries;                   //apsta_retries, THE LAST ONE JOINS
+    uint32_t deferred;                  //apsta_deferred
+    const char* attempts;               //'P'INNED / 'S'CANNED, IN ORDER
+}apsta_case_t;
+
+static const apsta_case_t s_cases[] = {
+    //FIRST RETRY IS PINNED TO THE OLD CHANNEL AND FINDS THE AP
+    {"back before the first retry", APSTA_CHANNEL, 5000, APSTA_CHANNEL, 0, 1, 0, "P"},
+    //PINNED AND SCANNED RETRIES ALTERNATE WHILE THE AP IS AWAY
+    {"back after a minute", APSTA_CHANNEL, 62000, APSTA_CHANNEL, 0, 5, 0, "PSPSP"},
+    //PINNED RETRIES MISS IT, THE NEXT SCAN FINDS IT
+    {"back on another channel", APSTA_CHANNEL, 20000, 11, 0, 2, 0, "PS"},
+    {"back late on another channel", APSTA_CHANNEL, 50000, 11, 0, 4, 0, "PSPS"},
+    //A SCAN WOULD MOVE THE AP UNDER THE CLIENT: PINNED ONLY
+    {"portal client, same channel", APSTA_CHANNEL, 40000, APSTA_CHANNEL, 600000, 3, 0, "PPP"},
+    //THE OLD CHANNEL NEVER WORKS. SCANS WAIT UNTIL THE CLIENT LEAVES
+    {"portal client, other channel", APSTA_CHANNEL, 20000, 11, 70000, 6, 0, "PPPPPS"},
+    //NO CHANNEL TO PIN TO: EVERY RETRY SCANS, NONE WHILE THE CLIENT IS ON
+    {"channel unknown", 0, 20000, 11, 0, 2, 0, "SS"},
+    {"channel unknown, portal client", 0, 20000, 11, 50000, 1, 3, "S"},
+};
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_t* s_wm;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+static bool s_ap_up;
+static uint8_t s_ap_channel;
+static uint32_t s_connects;
+static char s_attempts[32];
+static uint8_t s_attempt_len;
+static bool s_record;
+
+static void s_answer(void)
+{
+    //ANSWER EVERY NEW CONNECT: JOIN IF THE AP IS THERE AND THE ATTEMPT
+    //LOOKS ON ITS CHANNEL, ELSE NO AP FOUND
+
+    bool pinned;
+
+    if(s_radio.connects == s_connects)
+    {
+        return;
+    }
+    s_connects = s_radio.connects;
+    pinned = s_radio.sta.sta.channel != 0;
+    if(s_record && s_attempt_len < sizeof(s_attempts) - 1)
+    {
+        s_attempts[s_attempt_len++] = pinned ? 'P' : 'S';
+        s_attempts[s_attempt_len] = '\0';
+    }
+    if(s_ap_up && (!pinned || s_radio.sta.sta.channel == s_ap_channel))
+    {
+        fake_idf_radio_sta_connected(&s_radio, "home", s_bssid, s_ap_channel, WIFI_AUTH_WPA2_PSK);
+        fake_idf_radio_sta_got_ip(&s_radio, APSTA_IP);
+    }
+    else
+    {
+        fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_NO_AP_FOUND);
+    }
+}
+
+static void s_step(uint32_t ms)
+{
+    uint32_t t;
+
+    for(t = 0; t < ms; t += APSTA_STEP_MS)
+    {
+        fake_idf_advance_ms(APSTA_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+        s_answer();
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+    }
+}
+
+static void s_ap_client(bool join)
+{
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = join ? SYSTEM_EVENT_AP_STACONNECTED : SYSTEM_EVENT_AP_STADISCONNECTED;
+    fake_idf_radio_post_event(&s_radio, &evt);
+}
+
+static bool s_portal_open(void)
+{
+    //SOMETHING LISTENS ON THE PORTAL PORT
+
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    bool open;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(APSTA_HTTP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    open = connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    close(fd);
+    return open;
+}
+
+static bool s_portal_closed(void)
+{
+    //THE PORTAL TASK NOTICES A STOP WITHIN ONE ACCEPT TIMEOUT. GIVE IT 3S
+
+    uint32_t spins;
+
+    for(spins = 0; spins < 300; spins++)
+    {
+        if(!s_portal_open())
+        {
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static void s_create(uint8_t channel)
+{
+    //FRESH INSTANCE, CONNECTED ON channel SO THE CHANNEL IS REMEMBERED
+
+    esp32_wifimanager_backoff_t backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+
+    fake_idf_nvs_erase_all();
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_connects = 0;
+    s_ap_up = true;
+    s_ap_channel = channel;
+    s_attempt_len = 0;
+    s_attempts[0] = '\0';
+    s_record = false;
+
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    backoff.apsta_retry_ms = APSTA_RETRY_MS;
+    backoff.provision_window_ms = 0;
+    backoff.hold_down_ms = 0;
+    backoff.jitter_pct = 0;
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetPortalPorts(s_wm, APSTA_HTTP_PORT, APSTA_DNS_PORT);
+    ESP32_WIFIMANAGER_CTX_SetBackoff(s_wm, &backoff);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_WEBCONFIG,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+    s_step(2 * APSTA_STEP_MS);
+    CHECK(s_radio.associated);
+}
+
+static bool s_destroy(void)
+{
+    //PORTAL AND DNS TASKS MAY STILL BE WINDING DOWN. GIVE THEM 3S
+
+    uint32_t spins;
+
+    for(spins = 0; spins < 300; spins++)
+    {
+        if(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK)
+        {
+            s_wm = NULL;
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static void test_outage(const apsta_case_t* c)
+{
+    //AP GONE, PORTAL UP, AP BACK, PORTAL DOWN
+
+    esp32_wifimanager_stats_t stats;
+    uint32_t connects;
+    uint32_t t;
+
+    s_create(c->known);
+
+    //AP GOES AWAY. EVERY ATTEMPT FAILS UNTIL THE MANAGER FALLS BACK TO THE PORTAL
+    s_ap_up = false;
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_BEACON_TIMEOUT);
+    for(t = 0; t < APSTA_FAIL_MS && s_radio.mode != WIFI_MODE_APSTA; t += APSTA_STEP_MS)
+    {
+        s_step(APSTA_STEP_MS);
+    }
+    CHECK(s_radio.mode == WIFI_MODE_APSTA);
+    CHECK(s_radio.ap.ap.channel == (c->known != 0 ? c->known : ESP32_WIFIMANAGER_SOFTAP_CHANNEL));
+    CHECK(s_portal_open());
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.apsta_retries == 0 && stats.apsta_recoveries == 0);
+
+    //SCRIPTED OUTAGE
+    s_record = true;
+    if(c->client_ms != 0)
+    {
+        s_ap_client(true);
+    }
+    for(t = 0; t < 600000 && s_radio.mode == WIFI_MODE_APSTA; t += APSTA_STEP_MS)
+    {
+        if(t == c->back_ms)
+        {
+            s_ap_up = true;
+            s_ap_channel = c->channel;
+        }
+        if(c->client_ms != 0 && t == c->client_ms)
+        {
+            s_ap_client(false);
+        }
+        s_step(APSTA_STEP_MS);
+    }
+    s_record = false;
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    printf("test_apsta: %-30s %2u retries, %u deferred, %-8s joined after %u ms\n",
+           c->name,
+           (unsigned)stats.apsta_retries,
+           (unsigned)stats.apsta_deferred,
+           s_attempts,
+           (unsigned)t);
+    CHECK(stats.apsta_retries == c->retries);
+    CHECK(stats.apsta_deferred == c->deferred);
+    CHECK(stats.apsta_recoveries == 1);
+    CHECK(strcmp(s_attempts, c->attempts) == 0);
+    //JOINED ON THE LAST TIMER TICK, DEFERRED TICKS INCLUDED
+    CHECK(t == (c->retries + c->deferred) * APSTA_RETRY_MS + APSTA_STEP_MS);
+    CHECK(s_radio.associated);
+
+    //PORTAL TORN DOWN: STA ONLY, PORT CLOSED, RETRY TIMER STOPPED
+    CHECK(s_radio.mode == WIFI_MODE_STA);
+    CHECK(s_portal_closed());
+    CHECK(s_radio.sta.sta.bssid_set == false || s_radio.sta.sta.channel == c->channel);
+    connects = s_radio.connects;
+    s_step(4 * APSTA_RETRY_MS);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(s_radio.connects == connects);
+    CHECK(stats.apsta_retries == c->retries);
+    CHECK(stats.apsta_recoveries == 1);
+
+    CHECK(s_destroy());
+}
+
+int main(void)
+{
+    size_t i;
+
+    for(i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+    {
+        test_outage(&s_cases[i]);
+    }
+    return fake_idf_summary("test_apsta");
+}
@@ -0,0 +1,323 @@
+/**************************************************
+* HOST TEST: RECONNECT BACKOFF ACROSS A FLEET
+* (ESP32_WIFIMANAGER_backoff_t, backoff_next_ms)
+*
+* N INSTANCES ON THEIR OWN FAKE RADIOS LOSE THE SAME
+* AP AT THE SAME MOMENT (AP REBOOT) AND RETRY UNTIL IT
+* IS BACK. EVERY DRAW IS READ FROM last_backoff_ms AS
+* ITS CONNECT GOES OUT AND CHECKED AGAINST ITS LEVEL:
+* INITIAL x MULTIPLIER^LEVEL, CAPPED AT max_ms, +/-
+* JITTER, NEVER BELOW THE CONNECT CHECK FLOOR
+*
+* PER JITTER SETTING AND SEED: PEAK RETRIES THE AP
+* SEES IN ONE WINDOW, THE SPREAD OF DRAWS ACROSS THEIR
+* RANGE, THE CAP, AND THAT A JOIN RESETS THE LEVEL SO
+* THE NEXT OUTAGE STARTS AGAIN FROM initial_ms
+*
+* TASKS ARE OFF, SO EVERY STEP IS DETERMINISTIC
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FLEET_N                 (128)
+#define FLEET_STEP_MS           (100)
+#define FLEET_WINDOW_MS         (200)
+#define FLEET_DROP_MS           (10000)
+#define FLEET_OUTAGE_MS         (600000)
+#define FLEET_END_MS            (FLEET_DROP_MS + FLEET_OUTAGE_MS + 300000)
+#define FLEET_WINDOWS           (FLEET_END_MS / FLEET_WINDOW_MS)
+#define FLEET_MAX_MS            (30000)
+#define FLEET_BINS              (10)
+#define FLEET_CHI2_MAX          (27.88)     //9 DEGREES OF FREEDOM, p = 0.001
+#define FLEET_IP                (0x0A01A8C0)
+
+//ONE FLEET RUN
+typedef struct
+{
+    const char* name;
+    uint8_t jitter_pct;
+    uint32_t seed;
+    uint8_t peak_max;                   //RETRIES IN ONE WINDOW, AT MOST
+}fleet_case_t;
+
+static const fleet_case_t s_cases[] = {
+    //NO JITTER: EVERY DEVICE RETRIES IN THE SAME WINDOW, EVERY TIME
+    {"lockstep", 0, 1, FLEET_N},
+    //THE FIRST WAVE IS THE WORST: 20% OF 4000 MS ABOVE THE FLOOR IS ONLY 800 MS,
+    //ABOUT A QUARTER OF THE FLEET PER WINDOW. LATER WAVES SPREAD WIDER
+    {"jitter 20%", 20, 1, FLEET_N * 3 / 8},
+    {"jitter 20%", 20, 7, FLEET_N * 3 / 8},
+    {"jitter 20%", 20, 12345, FLEET_N * 3 / 8},
+    //2000 MS ABOVE THE FLOOR, ABOUT A TENTH PER WINDOW
+    {"jitter 50%", 50, 1, FLEET_N / 5},
+    {"jitter 50%", 50, 99, FLEET_N / 5},
+};
+
+//RESULTS OF ONE RUN
+typedef struct
+{
+    uint32_t draws;
+    uint32_t out_of_range;
+    uint32_t capped;                    //DRAWS AT THE max_ms LEVEL
+    uint32_t max_draw;
+    uint32_t bins[FLEET_BINS];          //WHERE IN ITS RANGE EACH DRAW FELL
+    double pos_sum;
+    uint16_t windows[FLEET_WINDOWS];    //CONNECTS PER WINDOW
+    uint32_t joined;
+    uint32_t rejoin_first_max;          //FIRST DRAW OF THE NEXT OUTAGE
+    uint32_t rejoin_first_min;
+}fleet_result_t;
+
+static fake_idf_wifi_t s_radio[FLEET_N];
+static esp32_wifimanager_t* s_wm[FLEET_N];
+static uint8_t s_level[FLEET_N];        //DRAWS SINCE THE LAST JOIN
+static uint32_t s_connects[FLEET_N];
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static fleet_result_t s_result;
+
+static uint32_t s_last_draw(uint8_t n)
+{
+    esp32_wifimanager_stats_t stats;
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm[n], &stats);
+    return stats.last_backoff_ms;
+}
+
+static void s_draw(uint8_t n, uint8_t jitter_pct)
+{
+    //CHECK THE DRAW JUST MADE BY INSTANCE n AGAINST ITS LEVEL
+
+    uint32_t draw = s_last_draw(n);
+    uint64_t nominal = 4000;
+    uint64_t spread;
+    uint64_t low;
+    uint64_t high;
+    uint8_t i;
+    uint8_t bin;
+
+    for(i = 0; i < s_level[n] && nominal < FLEET_MAX_MS; i++)
+    {
+        nominal *= 2;
+    }
+    if(nominal >= FLEET_MAX_MS)
+    {
+        nominal = FLEET_MAX_MS;
+        s_result.capped++;
+    }
+    spread = nominal * jitter_pct / 100;
+    low = nominal - spread;
+    if(low < ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS)
+    {
+        low = ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS;
+    }
+    high = nominal + spread;
+
+    s_level[n]++;
+    s_result.draws++;
+    if(draw > s_result.max_draw)
+    {
+        s_result.max_draw = draw;
+    }
+    if(draw < low || draw > high)
+    {
+        s_result.out_of_range++;
+        return;
+    }
+    if(high > low)
+    {
+        bin = (uint8_t)(((draw - low) * FLEET_BINS) / (high - low + 1));
+        s_result.bins[bin]++;
+        s_result.pos_sum += (double)(draw - low) / (double)(high - low);
+    }
+}
+
+static void s_drop(uint8_t n)
+{
+    //LINK LOST. ONE MAINITER TAKES THE EVENT, THE NEXT RUNS THE
+    //DISCONNECTED STATE, WHICH DRAWS THE FIRST DELAY
+
+    fake_idf_radio_sta_disconnected(&s_radio[n], WIFI_REASON_NO_AP_FOUND);
+    ESP32_WIFIMANAGER_CTX_Mainiter(s_wm[n]);
+    ESP32_WIFIMANAGER_CTX_Mainiter(s_wm[n]);
+}
+
+static void s_drop_all(uint8_t jitter_pct)
+{
+    //AP GONE FOR EVERYONE. THE DROP ITSELF DRAWS LEVEL 0
+
+    uint8_t n;
+
+    for(n = 0; n < FLEET_N; n++)
+    {
+        s_drop(n);
+        s_level[n] = 0;
+        s_draw(n, jitter_pct);
+    }
+}
+
+static void s_step(uint32_t t, bool ap_up, uint8_t jitter_pct, bool record)
+{
+    //ONE TICK FOR THE WHOLE FLEET. ANSWER EVERY CONNECT THAT WENT OUT
+
+    uint8_t n;
+
+    fake_idf_advance_ms(FLEET_STEP_MS);
+    for(n = 0; n < FLEET_N; n++)
+    {
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm[n]);
+        if(s_radio[n].connects == s_connects[n])
+        {
+            continue;
+        }
+        s_connects[n] = s_radio[n].connects;
+        if(record)
+        {
+            s_result.windows[t / FLEET_WINDOW_MS]++;
+            s_draw(n, jitter_pct);
+        }
+        if(ap_up)
+        {
+            fake_idf_radio_sta_connected(&s_radio[n], "home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+            fake_idf_radio_sta_got_ip(&s_radio[n], FLEET_IP);
+            if(record)
+            {
+                s_result.joined++;
+                s_level[n] = 0;
+            }
+        }
+        else
+        {
+            fake_idf_radio_sta_disconnected(&s_radio[n], WIFI_REASON_NO_AP_FOUND);
+        }
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm[n]);
+    }
+}
+
+static void test_fleet(const fleet_case_t* c)
+{
+    esp32_wifimanager_backoff_t backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+    uint32_t peak = 0;
+    double expect;
+    double chi2 = 0;
+    uint32_t draw;
+    uint32_t t;
+    uint32_t w;
+    uint8_t n;
+    uint8_t i;
+
+    memset(&s_result, 0, sizeof(s_result));
+    memset(s_radio, 0, sizeof(s_radio));
+    memset(s_connects, 0, sizeof(s_connects));
+    fake_idf_nvs_erase_all();
+    fake_idf_seed(c->seed);
+    backoff.max_ms = FLEET_MAX_MS;
+    backoff.jitter_pct = c->jitter_pct;
+    backoff.hold_down_ms = 0;
+    for(n = 0; n < FLEET_N; n++)
+    {
+        s_wm[n] = ESP32_WIFIMANAGER_CTX_Create();
+        ESP32_WIFIMANAGER_CTX_SetDriver(s_wm[n], &fake_idf_driver, &s_radio[n]);
+        ESP32_WIFIMANAGER_CTX_SetBackoff(s_wm[n], &backoff);
+        ESP32_WIFIMANAGER_CTX_SetParameters(s_wm[n],
+                                            ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                            ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                            &s_cred, 2, "test");
+        ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm[n], false);
+    }
+
+    //BOOT, ALL JOIN. THE AP REBOOTS, COMES BACK AFTER FLEET_OUTAGE_MS
+    for(t = 0; t < FLEET_DROP_MS; t += FLEET_STEP_MS)
+    {
+        s_step(t, true, c->jitter_pct, false);
+    }
+    s_drop_all(c->jitter_pct);
+    for(; t < FLEET_END_MS && s_result.joined < FLEET_N; t += FLEET_STEP_MS)
+    {
+        s_step(t, t >= FLEET_DROP_MS + FLEET_OUTAGE_MS, c->jitter_pct, true);
+    }
+    for(w = 0; w < FLEET_WINDOWS; w++)
+    {
+        if(s_result.windows[w] > peak)
+        {
+            peak = s_result.windows[w];
+        }
+    }
+
+    printf("test_backoff: %-10s seed %5u: %5u draws, peak %2u/%u per %u ms, max draw %5u, capped %4u,",
+           c->name, (unsigned)c->seed,
+           (unsigned)s_result.draws, (unsigned)peak, FLEET_N, FLEET_WINDOW_MS,
+           (unsigned)s_result.max_draw, (unsigned)s_result.capped);
+    if(c->jitter_pct != 0)
+    {
+        expect = (double)s_result.draws / FLEET_BINS;
+        for(i = 0; i < FLEET_BINS; i++)
+        {
+            chi2 += (s_result.bins[i] - expect) * (s_result.bins[i] - expect) / expect;
+        }
+        printf(" mean pos %.3f, chi2 %.1f, bins", s_result.pos_sum / s_result.draws, chi2);
+        for(i = 0; i < FLEET_BINS; i++)
+        {
+            printf(" %u", (unsigned)s_result.bins[i]);
+        }
+    }
+    printf("\n");
+
+    CHECK(s_result.joined == FLEET_N);
+    CHECK(s_result.out_of_range == 0);
+    CHECK(peak <= c->peak_max);
+    if(c->jitter_pct == 0)
+    {
+        CHECK(peak == FLEET_N);
+    }
+
+    //THE CAP: REACHED, AND NEVER EXCEEDED BEYOND ITS JITTER
+    CHECK(s_result.capped > s_result.draws / 2);
+    CHECK(s_result.max_draw <= FLEET_MAX_MS + FLEET_MAX_MS * c->jitter_pct / 100);
+
+    //DRAWS COVER THEIR RANGE EVENLY
+    if(c->jitter_pct != 0)
+    {
+        CHECK(chi2 < FLEET_CHI2_MAX);
+        CHECK(s_result.pos_sum / s_result.draws > 0.45 && s_result.pos_sum / s_result.draws < 0.55);
+    }
+
+    //JOINED DEVICES START THE NEXT OUTAGE FROM initial_ms AGAIN
+    s_result.rejoin_first_min = UINT32_MAX;
+    for(n = 0; n < FLEET_N; n++)
+    {
+        s_drop(n);
+        draw = s_last_draw(n);
+        if(draw > s_result.rejoin_first_max)
+        {
+            s_result.rejoin_first_max = draw;
+        }
+        if(draw < s_result.rejoin_first_min)
+        {
+            s_result.rejoin_first_min = draw;
+        }
+    }
+    CHECK(s_result.rejoin_first_min >= ESP32_WIFIMANAGER_WIFI_CONNECT_CHECK_MS);
+    CHECK(s_result.rejoin_first_max <= 4000 + 4000 * c->jitter_pct / 100);
+
+    for(n = 0; n < FLEET_N; n++)
+    {
+        CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm[n]) == ESP_OK);
+        s_wm[n] = NULL;
+    }
+}
+
+int main(void)
+{
+    size_t i;
+
+    fake_idf_tasks = false;
+    for(i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+    {
+        test_fleet(&s_cases[i]);
+    }
+    return fake_idf_summary("test_backoff");
+}
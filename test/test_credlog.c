@@ -0,0 +1,301 @@
+/**************************************************
+* HOST TEST: FLASH / EEPROM CREDENTIAL LOG
+* (ESP32_WIFIMANAGER_CREDLOG)
+*
+* ROUND TRIP, COALESCING, CRC CORRUPTION, PAGE
+* WRAPAROUND, A TORN PAGE SWITCH, THE BUILT IN SPI
+* FLASH OPS AND TWO LOGS OPEN SIDE BY SIDE
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER_CREDLOG.h"
+#include <stddef.h>
+#include <string.h>
+
+#define EEPROM_SIZE         (2048)
+#define EEPROM_RECORDS      (3)
+#define EEPROM_PAGE_SIZE    (sizeof(esp32_wifimanager_credlog_page_hdr_t) + \
+                                EEPROM_RECORDS * sizeof(esp32_wifimanager_credlog_record_t))
+#define EEPROM_PAGES        (3)
+
+//BYTE WRITABLE STORAGE. WRITES FAIL ONCE s_eeprom_writes_left RUNS OUT (-1 = NEVER)
+static uint8_t s_eeprom[EEPROM_SIZE];
+static int32_t s_eeprom_writes_left = -1;
+static esp32_wifimanager_credlog_t s_log;
+
+static esp_err_t s_eeprom_read(uint32_t addr, void* data, size_t len)
+{
+    if(addr + len > EEPROM_SIZE)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(data, &s_eeprom[addr], len);
+    return ESP_OK;
+}
+
+static esp_err_t s_eeprom_write(uint32_t addr, const void* data, size_t len)
+{
+    if(addr + len > EEPROM_SIZE || s_eeprom_writes_left == 0)
+    {
+        return ESP_FAIL;
+    }
+    if(s_eeprom_writes_left > 0)
+    {
+        s_eeprom_writes_left--;
+    }
+    memcpy(&s_eeprom[addr], data, len);
+    return ESP_OK;
+}
+
+static const esp32_wifimanager_storage_ops_t s_eeprom_ops = {
+    .read = s_eeprom_read,
+    .write = s_eeprom_write,
+    .erase = NULL,
+    .page_size = EEPROM_PAGE_SIZE
+};
+
+static void s_cred(uint32_t n, uint8_t* ssid, uint8_t* pwd)
+{
+    //DISTINCT CREDENTIALS PER n
+
+    memset(ssid, 0, ESP32_WIFIMANAGER_SSID_LEN);
+    memset(pwd, 0, ESP32_WIFIMANAGER_SSID_PWD_LEN);
+    snprintf((char*)ssid, ESP32_WIFIMANAGER_SSID_LEN, "net-%u", (unsigned)n);
+    snprintf((char*)pwd, ESP32_WIFIMANAGER_SSID_PWD_LEN, "secret-%u", (unsigned)n);
+}
+
+static bool s_reads(uint32_t n)
+{
+    //LOG REOPENED FROM STORAGE YIELDS CREDENTIALS n
+
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    uint8_t want_ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t want_pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+
+    s_cred(n, want_ssid, want_pwd);
+    return (ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK &&
+            ESP32_WIFIMANAGER_CREDLOG_Read(&s_log, ssid, pwd) == ESP_OK &&
+            memcmp(ssid, want_ssid, sizeof(ssid)) == 0 &&
+            memcmp(pwd, want_pwd, sizeof(pwd)) == 0);
+}
+
+static esp_err_t s_save(uint32_t n)
+{
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+
+    s_cred(n, ssid, pwd);
+    return ESP32_WIFIMANAGER_CREDLOG_Save(&s_log, ssid, pwd);
+}
+
+static void s_eeprom_blank(void)
+{
+    memset(s_eeprom, 0xFF, sizeof(s_eeprom));
+    s_eeprom_writes_left = -1;
+}
+
+static void test_open(void)
+{
+    //REGION CHECKS, EMPTY LOG
+
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+
+    s_eeprom_blank();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, NULL, 0, EEPROM_SIZE) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 100, 100) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGE_SIZE) == ESP_ERR_INVALID_SIZE);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Read(&s_log, ssid, pwd) == ESP_ERR_INVALID_STATE);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Read(&s_log, ssid, pwd) == ESP_ERR_NOT_FOUND);
+}
+
+static void test_round_trip(void)
+{
+    //SAVE, REOPEN, READ. SAME CREDENTIALS AGAIN WRITE NOTHING
+
+    esp32_wifimanager_credlog_stats_t before;
+    esp32_wifimanager_credlog_stats_t after;
+    uint8_t image[EEPROM_SIZE];
+
+    s_eeprom_blank();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK);
+    CHECK(s_save(1) == ESP_OK);
+    CHECK(s_save(2) == ESP_OK);
+    CHECK(s_reads(2));
+
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &before);
+    memcpy(image, s_eeprom, sizeof(image));
+    CHECK(s_save(2) == ESP_OK);
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &after);
+    CHECK(after.coalesced == before.coalesced + 1);
+    CHECK(after.appends == before.appends);
+    CHECK(memcmp(image, s_eeprom, sizeof(image)) == 0);
+}
+
+static void test_crc_corruption(void)
+{
+    //A FLIPPED BIT IN THE NEWEST RECORD: READ FALLS BACK TO THE ONE BEFORE
+
+    esp32_wifimanager_credlog_stats_t stats;
+    uint32_t newest = sizeof(esp32_wifimanager_credlog_page_hdr_t) +
+                        sizeof(esp32_wifimanager_credlog_record_t);
+
+    s_eeprom_blank();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK);
+    CHECK(s_save(1) == ESP_OK);
+    CHECK(s_save(2) == ESP_OK);
+
+    s_eeprom[newest + offsetof(esp32_wifimanager_credlog_record_t, pwd)] ^= 0x01;
+    CHECK(s_reads(1));
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &stats);
+    CHECK(stats.torn_records == 1);
+
+    //THE BAD SLOT IS NOT REUSED. NEXT SAVE GOES AFTER IT AND WINS
+    CHECK(s_save(3) == ESP_OK);
+    CHECK(s_reads(3));
+
+    //CORRUPT CRC FIELD ITSELF
+    newest += sizeof(esp32_wifimanager_credlog_record_t);
+    s_eeprom[newest + offsetof(esp32_wifimanager_credlog_record_t, crc)] ^= 0x80;
+    CHECK(s_reads(1));
+}
+
+static void test_wraparound(void)
+{
+    //MANY SAVES CYCLE THROUGH EVERY PAGE. NEWEST ALWAYS WINS, ERASES SPREAD EVENLY
+
+    esp32_wifimanager_credlog_stats_t before;
+    esp32_wifimanager_credlog_stats_t stats;
+    uint32_t saves = EEPROM_PAGES * EEPROM_RECORDS * 4 + 2;
+    uint32_t n;
+    bool all = true;
+
+    s_eeprom_blank();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK);
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &before);
+    for(n = 0; n < saves; n++)
+    {
+        all = all && (s_save(n) == ESP_OK);
+    }
+    CHECK(all);
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &stats);
+    CHECK(stats.appends - before.appends == saves);
+    CHECK(stats.erases - before.erases == (saves + EEPROM_RECORDS - 1) / EEPROM_RECORDS);
+
+    //EVERY REOPEN POINT ACROSS A WRAP
+    all = true;
+    for(; n < saves + EEPROM_PAGES * EEPROM_RECORDS + 1; n++)
+    {
+        all = all && (s_save(n) == ESP_OK) && s_reads(n);
+    }
+    CHECK(all);
+
+    //BOOT COST STAYS BOUNDED: PAGE HEADERS + BINARY SEARCH + ONE RECORD
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &stats);
+    CHECK(stats.boot_reads <= EEPROM_PAGES + 3 + 1);
+}
+
+static void test_torn_page_switch(void)
+{
+    //POWER LOST BETWEEN THE NEW PAGE'S FIRST RECORD AND ITS HEADER:
+    //THE OLD PAGE STAYS ACTIVE
+
+    uint32_t n;
+
+    s_eeprom_blank();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, &s_eeprom_ops, 0, EEPROM_PAGES * EEPROM_PAGE_SIZE) == ESP_OK);
+    for(n = 0; n < EEPROM_RECORDS; n++)
+    {
+        CHECK(s_save(n) == ESP_OK);
+    }
+
+    //ERASE FILL CHUNKS + THE RECORD, THEN THE HEADER WRITE FAILS
+    s_eeprom_writes_left = (EEPROM_PAGE_SIZE + 31) / 32 + 1;
+    CHECK(s_save(n) != ESP_OK);
+    s_eeprom_writes_left = -1;
+    CHECK(s_reads(n - 1));
+
+    //NEXT SAVE COMPLETES THE SWITCH
+    CHECK(s_save(n + 1) == ESP_OK);
+    CHECK(s_reads(n + 1));
+}
+
+static void test_spi_flash(void)
+{
+    //BUILT IN OPS ON THE FAKE NOR FLASH (4K SECTORS)
+
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    uint8_t want_ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t want_pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    const esp32_wifimanager_storage_ops_t* ops = ESP32_WIFIMANAGER_CREDLOG_SpiFlashOps();
+    uint32_t n;
+
+    fake_idf_flash_erase_all();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, ops, 0x1001, 0x3000) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, ops, 0x1000, 0x3000) == ESP_OK);
+    for(n = 0; n < 100; n++)
+    {
+        s_cred(n, ssid, pwd);
+        CHECK(ESP32_WIFIMANAGER_CREDLOG_Save(&s_log, ssid, pwd) == ESP_OK);
+    }
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, ops, 0x1000, 0x3000) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Read(&s_log, ssid, pwd) == ESP_OK);
+    s_cred(n - 1, want_ssid, want_pwd);
+    CHECK(memcmp(ssid, want_ssid, sizeof(ssid)) == 0 && memcmp(pwd, want_pwd, sizeof(pwd)) == 0);
+}
+
+static void test_two_logs(void)
+{
+    //TWO HANDLES ON DISJOINT FLASH REGIONS KEEP THEIR OWN TAIL, LATEST AND STATS
+
+    esp32_wifimanager_credlog_t other;
+    esp32_wifimanager_credlog_stats_t stats;
+    esp32_wifimanager_credlog_stats_t other_stats;
+    uint8_t ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    uint8_t want_ssid[ESP32_WIFIMANAGER_SSID_LEN];
+    uint8_t want_pwd[ESP32_WIFIMANAGER_SSID_PWD_LEN];
+    const esp32_wifimanager_storage_ops_t* ops = ESP32_WIFIMANAGER_CREDLOG_SpiFlashOps();
+    uint32_t n;
+
+    memset(&s_log, 0, sizeof(s_log));
+    memset(&other, 0, sizeof(other));
+    fake_idf_flash_erase_all();
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&s_log, ops, 0x1000, 0x3000) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Open(&other, ops, 0x3000, 0x5000) == ESP_OK);
+    for(n = 0; n < 5; n++)
+    {
+        s_cred(n, ssid, pwd);
+        CHECK(ESP32_WIFIMANAGER_CREDLOG_Save(&s_log, ssid, pwd) == ESP_OK);
+    }
+    s_cred(1000, ssid, pwd);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Save(&other, ssid, pwd) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Save(&other, ssid, pwd) == ESP_OK);
+
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&s_log, &stats);
+    ESP32_WIFIMANAGER_CREDLOG_GetStats(&other, &other_stats);
+    CHECK(stats.appends == 5 && stats.coalesced == 0);
+    CHECK(other_stats.appends == 1 && other_stats.coalesced == 1);
+
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Read(&s_log, ssid, pwd) == ESP_OK);
+    s_cred(4, want_ssid, want_pwd);
+    CHECK(memcmp(ssid, want_ssid, sizeof(ssid)) == 0 && memcmp(pwd, want_pwd, sizeof(pwd)) == 0);
+    CHECK(ESP32_WIFIMANAGER_CREDLOG_Read(&other, ssid, pwd) == ESP_OK);
+    s_cred(1000, want_ssid, want_pwd);
+    CHECK(memcmp(ssid, want_ssid, sizeof(ssid)) == 0 && memcmp(pwd, want_pwd, sizeof(pwd)) == 0);
+}
+
+int main(void)
+{
+    test_open();
+    test_round_trip();
+    test_crc_corruption();
+    test_wraparound();
+    test_torn_page_switch();
+    test_spi_flash();
+    test_two_logs();
+    return fake_idf_summary("test_credlog");
+}
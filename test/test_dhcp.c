@@ -0,0 +1,294 @@
+/**************************************************
+* HOST TEST: DHCP LEASE CACHE
+* (ESP32_WIFIMANAGER_DHCP_CACHE_STATIC)
+*
+* A LEASE SAVED ON ONE BOOT IS SET AS STATIC IP ON
+* THE NEXT. GOT_IP IS HELD UNTIL AN ARP PROBE SHOWS
+* THE GATEWAY ANSWERS AND NOBODY ELSE HAS THE ADDRESS,
+* ELSE THE LEASE IS DROPPED FOR A FULL DHCP. AT HALF
+* THE LEASE THE SERVER IS ASKED TO EXTEND IT IN PLACE
+* (INIT-REBOOT), THE ADDRESS STAYING UP MEANWHILE
+*
+* TASKS ARE OFF, SO NOTIFY IS DELIVERED FROM MAINITER
+* AND EVERY STEP IS DETERMINISTIC
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DHCP_STEP_MS            (50)
+#define DHCP_LEASE_S            (120)
+#define DHCP_IP                 (0x0A01A8C0)    //192.168.1.10
+#define DHCP_IP_NEW             (0x0B01A8C0)    //192.168.1.11
+#define DHCP_GW                 (0x0101A8C0)    //192.168.1.1
+#define DHCP_GW_OTHER           (0x0100A8C0)    //192.168.0.1
+#define DHCP_NETMASK            (0x00FFFFFF)
+#define DHCP_SEEN_MAX           (16)
+
+//ONE REJECTED PROBE
+typedef struct
+{
+    const char* name;
+    uint32_t hosts[FAKE_IDF_ARP_MAX];   //ADDRESSES THAT ANSWER ARP
+    uint8_t host_count;
+}dhcp_reject_case_t;
+
+static const dhcp_reject_case_t s_rejects[] = {
+    {"address taken", {DHCP_GW, DHCP_IP}, 2},
+    {"gateway silent", {0}, 0},
+    {"other network", {DHCP_GW_OTHER}, 1},
+};
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static char s_seen[DHCP_SEEN_MAX + 1];
+static uint8_t s_seen_len;
+static esp32_wifimanager_t* s_wm;
+
+static void s_notify_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //RECORD WHAT A SUBSCRIBER SEES AS ONE LETTER PER EVENT
+
+    static const char letters[ESP32_WIFIMANAGER_NOTIFY_MAX] = {'C', 'D', 'F', 'R', 'G', 'H'};
+
+    if(s_seen_len < DHCP_SEEN_MAX)
+    {
+        s_seen[s_seen_len++] = letters[notify->type];
+        s_seen[s_seen_len] = '\0';
+    }
+}
+
+static void s_step(uint32_t ms)
+{
+    uint32_t t;
+
+    for(t = 0; t < ms; t += DHCP_STEP_MS)
+    {
+        fake_idf_advance_ms(DHCP_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+    }
+}
+
+static void s_arp_hosts(const uint32_t* hosts, uint8_t count)
+{
+    memcpy(s_radio.arp_hosts, hosts, count * sizeof(uint32_t));
+    s_radio.arp_host_count = count;
+}
+
+static void s_link_up(uint32_t ip)
+{
+    //ASSOCIATE AND REPORT ip. THE DHCP SERVER HANDS OUT DHCP_GW / DHCP_LEASE_S
+
+    fake_idf_radio_sta_connected(&s_radio, "home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    s_radio.sta_ip.gw.addr = DHCP_GW;
+    s_radio.sta_ip.netmask.addr = DHCP_NETMASK;
+    s_radio.lease_s = DHCP_LEASE_S;
+    fake_idf_radio_sta_got_ip(&s_radio, ip);
+    s_step(2 * DHCP_STEP_MS);
+}
+
+static void s_boot(void)
+{
+    //NEW INSTANCE ON A RESET RADIO, SAME NVS. FIRST CONNECT ATTEMPT MADE
+
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_seen_len = 0;
+    s_seen[0] = '\0';
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetDhcpCacheMode(s_wm, ESP32_WIFIMANAGER_DHCP_CACHE_STATIC);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+    CHECK(ESP32_WIFIMANAGER_CTX_Subscribe(s_wm, s_notify_cb, NULL, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    s_step(2 * DHCP_STEP_MS);
+    CHECK(s_radio.connects == 1);
+}
+
+static void s_destroy(void)
+{
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK);
+    s_wm = NULL;
+}
+
+static void s_lease_saved(void)
+{
+    //ONE BOOT THROUGH THE DHCP CLIENT, LEAVING ITS LEASE IN NVS
+
+    esp32_wifimanager_stats_t stats;
+
+    fake_idf_nvs_erase_all();
+    s_boot();
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_cache_misses == 1 && stats.dhcp_cache_hits == 0);
+    s_link_up(DHCP_IP);
+    CHECK(strcmp(s_seen, "C") == 0);
+    s_destroy();
+}
+
+static void s_cached_boot(void)
+{
+    //REBOOT ONTO THE SAVED LEASE: STATIC IP, DHCP CLIENT OFF
+
+    esp32_wifimanager_stats_t stats;
+
+    s_boot();
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_cache_hits == 1);
+    CHECK(s_radio.sta_ip.ip.addr == DHCP_IP && s_radio.sta_ip.gw.addr == DHCP_GW);
+    CHECK(!s_radio.dhcpc_on);
+}
+
+static void test_hit(void)
+{
+    //PROBE PASSES: CONNECTED ONCE THE WINDOW IS OVER, LEASE KEPT
+
+    static const uint32_t gw[] = {DHCP_GW};
+    esp32_wifimanager_stats_t stats;
+
+    s_lease_saved();
+    s_cached_boot();
+    s_arp_hosts(gw, 1);
+    s_link_up(DHCP_IP);
+    CHECK(s_radio.arp_probes == 2);
+    CHECK(s_seen_len == 0);
+    s_step(ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS);
+    CHECK(strcmp(s_seen, "C") == 0);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_cache_rejected == 0);
+    CHECK(stats.connections == 1);
+    CHECK(s_radio.sta_ip.ip.addr == DHCP_IP && !s_radio.dhcpc_on);
+    s_destroy();
+}
+
+static void test_reject(void)
+{
+    //PROBE FAILS: LEASE DROPPED, FULL DHCP, THE NEW LEASE IS THE ONE CACHED
+
+    const dhcp_reject_case_t* c;
+    esp32_wifimanager_stats_t stats;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(s_rejects) / sizeof(s_rejects[0]); i++)
+    {
+        c = &s_rejects[i];
+        s_lease_saved();
+        s_cached_boot();
+        s_arp_hosts(c->hosts, c->host_count);
+        s_link_up(DHCP_IP);
+        s_step(ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+        CHECK(stats.dhcp_cache_rejected == 1);
+        CHECK(s_seen_len == 0);
+        CHECK(s_radio.dhcpc_on && s_radio.sta_ip.ip.addr == 0);
+
+        //DHCP CLIENT COMES BACK WITH ANOTHER ADDRESS
+        fake_idf_radio_sta_got_ip(&s_radio, DHCP_IP_NEW);
+        s_step(2 * DHCP_STEP_MS);
+        CHECK(strcmp(s_seen, "C") == 0);
+        printf("  %-16s rejected %u, then dhcp\n", c->name, stats.dhcp_cache_rejected);
+        s_destroy();
+
+        s_boot();
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+        CHECK(stats.dhcp_cache_hits == 1);
+        CHECK(s_radio.sta_ip.ip.addr == DHCP_IP_NEW);
+        s_destroy();
+    }
+}
+
+static void test_probe_link_lost(void)
+{
+    //LINK DROPS INSIDE THE PROBE WINDOW: PROBED AGAIN ON THE NEXT GOT_IP
+
+    static const uint32_t gw[] = {DHCP_GW};
+    esp32_wifimanager_stats_t stats;
+
+    s_lease_saved();
+    s_cached_boot();
+    s_arp_hosts(gw, 1);
+    s_link_up(DHCP_IP);
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_BEACON_TIMEOUT);
+    s_step(ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS);
+    CHECK(s_seen_len == 0);
+
+    s_link_up(DHCP_IP);
+    CHECK(s_radio.arp_probes == 4);
+    s_step(ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS);
+    CHECK(strcmp(s_seen, "C") == 0);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_cache_rejected == 0);
+    CHECK(!s_radio.dhcpc_on);
+    s_destroy();
+}
+
+static void s_renew_due(void)
+{
+    //CACHED BOOT, PROBE PASSED, THEN RUN TO HALF THE LEASE
+
+    static const uint32_t gw[] = {DHCP_GW};
+
+    s_lease_saved();
+    s_cached_boot();
+    s_arp_hosts(gw, 1);
+    s_link_up(DHCP_IP);
+    s_step(ESP32_WIFIMANAGER_DHCP_CACHE_PROBE_MS);
+    s_step(DHCP_LEASE_S / 2 * 1000 + 1000);
+
+    //INIT-REBOOT OUT. ADDRESS AND LINK STAY UP
+    CHECK(s_radio.renews == 1);
+    CHECK(s_radio.dhcpc_on);
+    CHECK(s_radio.sta_ip.ip.addr == DHCP_IP);
+    CHECK(strcmp(s_seen, "C") == 0);
+}
+
+static void test_renew(void)
+{
+    //SERVER ACKS: THE CLIENT TAKES THE LEASE OVER, NOTHING WAS TORN DOWN
+
+    esp32_wifimanager_stats_t stats;
+
+    s_renew_due();
+    s_radio.lease_s = DHCP_LEASE_S;
+    s_step(ESP32_WIFIMANAGER_DHCP_RENEW_WAIT_MS);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_renewed == 1 && stats.dhcp_renew_failed == 0);
+    CHECK(s_radio.sta_ip.ip.addr == DHCP_IP && s_radio.dhcpc_on);
+    CHECK(strcmp(s_seen, "C") == 0);
+
+    //FROM HERE THE CLIENT RENEWS BY ITSELF
+    s_step(DHCP_LEASE_S * 1000);
+    CHECK(s_radio.renews == 1);
+    s_destroy();
+}
+
+static void test_renew_no_ack(void)
+{
+    //NO ACK IN TIME: FULL DISCOVER AS THE LAST RESORT
+
+    esp32_wifimanager_stats_t stats;
+
+    s_renew_due();
+    s_step(ESP32_WIFIMANAGER_DHCP_RENEW_WAIT_MS);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.dhcp_renewed == 0 && stats.dhcp_renew_failed == 1);
+    CHECK(s_radio.dhcpc_on && s_radio.sta_ip.ip.addr == 0);
+    s_destroy();
+}
+
+int main(void)
+{
+    fake_idf_tasks = false;
+
+    test_hit();
+    test_reject();
+    test_probe_link_lost();
+    test_renew();
+    test_renew_no_ack();
+    return fake_idf_summary("test_dhcp");
+}
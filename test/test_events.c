@@ -0,0 +1,218 @@
+/**************************************************
+* HOST TEST: EVENT QUEUE AND CONNECTION TIMINGS
+* (ESP32_WIFIMANAGER_Mainiter, WIFI EVENT HANDLER)
+*
+* DRIVER EVENTS GO THROUGH THE REAL HANDLER INTO THE
+* MANAGER QUEUE. CHECKS ORDER, QUEUEING LAG, OVERFLOW
+* AND IDLE COST, THEN TIME TO IP / RECOVERY PER
+* CREDENTIAL SOURCE AGAINST THE FAKE CLOCK
+*
+* THE SCENARIOS RUN THE DEFAULT INSTANCE, WHICH HOLDS
+* THE ESP32 RADIO (fake_idf_wifi) FOR GOOD, SO EACH
+* ONE RUNS IN A FORKED CHILD
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+//MANAGER EVENT NUMBERS AS IN THE TRACE (esp32_wifimanager_evt_type_t)
+#define EVENTS_EVT_STA_START        (1)
+#define EVENTS_EVT_STA_CONNECTED    (2)
+#define EVENTS_EVT_STA_GOT_IP       (4)
+
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+
+static void s_start(esp32_wifimanager_credential_src_t src)
+{
+    ESP32_WIFIMANAGER_SetParameters(src, ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG, &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_SetPmkCache(false);
+}
+
+static void s_mainiter(uint32_t calls)
+{
+    //CLOCK STANDS STILL
+
+    uint32_t i;
+
+    for(i = 0; i < calls; i++)
+    {
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+}
+
+static uint16_t s_trace_evts(esp32_wifimanager_trace_record_t* evts, uint16_t max)
+{
+    //EVENT RECORDS ONLY, OLDEST FIRST
+
+    static esp32_wifimanager_trace_record_t records[ESP32_WIFIMANAGER_TRACE_LEN];
+    uint16_t count = ESP32_WIFIMANAGER_GetTrace(records, ESP32_WIFIMANAGER_TRACE_LEN);
+    uint16_t i;
+    uint16_t n = 0;
+
+    for(i = 0; i < count && n < max; i++)
+    {
+        if(records[i].kind == ESP32_WIFIMANAGER_TRACE_EVT)
+        {
+            evts[n++] = records[i];
+        }
+    }
+    return n;
+}
+
+static int s_queue(esp32_wifimanager_credential_src_t src, const char* name)
+{
+    //CHILD: ORDER, LAG, OVERFLOW, IDLE
+
+    esp32_wifimanager_trace_record_t evts[ESP32_WIFIMANAGER_TRACE_LEN];
+    esp32_wifimanager_stats_t before;
+    esp32_wifimanager_stats_t after;
+    uint16_t n0;
+    uint16_t n;
+    uint8_t i;
+    int status;
+
+    s_start(src);
+    s_mainiter(2);
+    CHECK(fake_idf_wifi.connects == 1);
+
+    //QUEUED WHILE THE MANAGER IS NOT RUNNING. HANDLED IN POST ORDER, LAG
+    //IS THE TIME EACH ONE WAITED
+    n0 = s_trace_evts(evts, ESP32_WIFIMANAGER_TRACE_LEN);
+    fake_idf_sta_connected("home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_advance_ms(10);
+    fake_idf_sta_got_ip(0x0101A8C0);
+    fake_idf_advance_ms(5);
+    s_mainiter(8);
+    n = s_trace_evts(evts, ESP32_WIFIMANAGER_TRACE_LEN);
+    CHECK(n == n0 + 2);
+    CHECK(evts[n0].type == EVENTS_EVT_STA_CONNECTED && evts[n0].lag_us == 15000);
+    CHECK(evts[n0 + 1].type == EVENTS_EVT_STA_GOT_IP && evts[n0 + 1].arg == 0x0101A8C0);
+    CHECK(evts[n0 + 1].lag_us == 5000);
+    ESP32_WIFIMANAGER_GetStats(&before);
+    CHECK(before.connections == 1);
+
+    //OVERFLOW. THE QUEUE KEEPS THE FIRST QUEUE_LEN, THE REST ARE COUNTED
+    for(i = 0; i < ESP32_WIFIMANAGER_EVT_QUEUE_LEN + 3; i++)
+    {
+        fake_idf_sta_start();
+    }
+    ESP32_WIFIMANAGER_GetStats(&after);
+    CHECK(after.evt_dropped - before.evt_dropped == 3);
+    s_mainiter(ESP32_WIFIMANAGER_EVT_QUEUE_LEN + 3);
+    n0 = n;
+    n = s_trace_evts(evts, ESP32_WIFIMANAGER_TRACE_LEN);
+    CHECK(n == n0 + ESP32_WIFIMANAGER_EVT_QUEUE_LEN);
+    CHECK(evts[n - 1].type == EVENTS_EVT_STA_START);
+
+    //IDLE WITH AN EMPTY QUEUE: A WAKEUP, NO STATE MACHINE STEP
+    ESP32_WIFIMANAGER_GetStats(&before);
+    s_mainiter(10);
+    ESP32_WIFIMANAGER_GetStats(&after);
+    CHECK(after.mainiter_ticks == before.mainiter_ticks);
+    CHECK(after.wakeups - before.wakeups == 10);
+    CHECK(after.state_transitions == before.state_transitions);
+
+    status = fake_idf_summary("test_events (queue)");
+    fflush(stdout);
+    return status;
+}
+
+static int s_time_to_ip(esp32_wifimanager_credential_src_t src, const char* name)
+{
+    //CHILD: BOOT -> GOT_IP AND STA_DISCONNECTED -> GOT_IP ON THE FAKE CLOCK
+
+    esp32_wifimanager_stats_t stats;
+    int64_t disc_us;
+    uint32_t connects;
+    uint32_t i;
+    int status;
+
+    if(src == ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL)
+    {
+        //IDF SAVED CONFIG
+        memcpy(fake_idf_wifi.sta.sta.ssid, "home", 5);
+        memcpy(fake_idf_wifi.sta.sta.password, "password", 9);
+        fake_idf_wifi.sta_flash = fake_idf_wifi.sta;
+    }
+
+    s_start(src);
+    s_mainiter(2);
+    CHECK(fake_idf_wifi.connects == 1);
+    fake_idf_advance_ms(1200);
+    fake_idf_sta_connected("home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_advance_ms(300);
+    fake_idf_sta_got_ip(0x0101A8C0);
+    s_mainiter(8);
+
+    ESP32_WIFIMANAGER_GetStats(&stats);
+    CHECK(stats.credential_src == src);
+    CHECK(stats.connections == 1);
+    CHECK(stats.boot_to_got_ip_us == 1500000);
+    CHECK(stats.last_conn_mainiter_ticks > 0);
+    CHECK(stats.last_conn_state_transitions > 0);
+    printf("test_events: %s boot->GOT_IP %lld us, %u ticks, %u transitions\n",
+            name,
+            (long long)stats.boot_to_got_ip_us,
+            (unsigned)stats.last_conn_mainiter_ticks,
+            (unsigned)stats.last_conn_state_transitions);
+
+    //LINK LOSS. RECOVERY RUNS FROM THE DISCONNECT BEING HANDLED TO GOT_IP
+    fake_idf_sta_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+    s_mainiter(4);
+    disc_us = fake_idf_now_us;
+    connects = fake_idf_wifi.connects;
+    for(i = 0; i < 600 && fake_idf_wifi.connects == connects; i++)
+    {
+        fake_idf_advance_ms(100);
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+    CHECK(fake_idf_wifi.connects == connects + 1);
+    fake_idf_advance_ms(200);
+    fake_idf_sta_connected("home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_sta_got_ip(0x0101A8C0);
+    s_mainiter(8);
+
+    ESP32_WIFIMANAGER_GetStats(&stats);
+    CHECK(stats.disconnections == 1 && stats.connections == 2 && stats.recoveries == 1);
+    CHECK(stats.last_recovery_us == fake_idf_now_us - disc_us);
+    CHECK(stats.boot_to_got_ip_us == 1500000);
+    printf("test_events: %s recovery %lld us, %u ticks, %u transitions\n",
+            name,
+            (long long)stats.last_recovery_us,
+            (unsigned)stats.last_conn_mainiter_ticks,
+            (unsigned)stats.last_conn_state_transitions);
+
+    status = fake_idf_summary("test_events (time to ip)");
+    fflush(stdout);
+    return status;
+}
+
+static void s_child(int (*fn)(esp32_wifimanager_credential_src_t, const char*),
+                    esp32_wifimanager_credential_src_t src,
+                    const char* name)
+{
+    //RUN fn IN ITS OWN PROCESS, PASS IF IT EXITS 0
+
+    int status;
+    pid_t pid;
+
+    fflush(stdout);
+    pid = fork();
+    if(pid == 0)
+    {
+        _exit(fn(src, name));
+    }
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main(void)
+{
+    s_child(s_queue, ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED, "queue");
+    s_child(s_time_to_ip, ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED, "HARDCODED");
+    s_child(s_time_to_ip, ESP32_WIFIMANAGER_CREDENTIAL_SRC_INTERNAL, "INTERNAL");
+    return fake_idf_summary("test_events");
+}
@@ -0,0 +1,274 @@
+/**************************************************
+* HOST TEST: LINK FLAP HOLD DOWN
+* (ESP32_WIFIMANAGER_backoff_t.hold_down_ms,
+*  DISCONNECT REASON CLASSES)
+*
+* SCRIPTED DISCONNECTED -> GOT_IP ON A FAKE RADIO,
+* PER REASON CLASS (TRANSIENT, AUTH, AP GONE) AND
+* OUTAGE SHORTER / LONGER THAN THE HOLD DOWN. CHECKS
+* THE NOTIFY EVENTS A SUBSCRIBER SEES AND THE FLAP
+* STATISTICS
+*
+* TASKS ARE OFF, SO NOTIFY IS DELIVERED FROM MAINITER
+* AND EVERY STEP IS DETERMINISTIC
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FLAP_HOLD_DOWN_MS       (5000)
+#define FLAP_STEP_MS            (50)
+#define FLAP_IP                 (0x0A01A8C0)
+#define FLAP_SEEN_MAX           (16)
+
+//ONE SCRIPTED OUTAGE
+typedef struct
+{
+    const char* name;
+    uint8_t reason;                     //wifi_err_reason_t OF THE DROP
+    uint8_t retry_reason;               //RETRY THAT FAILS HALF WAY DOWN. 0 = NONE
+    uint32_t down_ms;                   //DROP -> GOT_IP
+    esp32_wifimanager_disconnect_class_t class;
+    const char* seen;                   //NOTIFY EVENTS: 'D'ISCONNECTED, 'C'ONNECTED
+    uint32_t suppressed;
+    uint32_t expired;
+}flap_case_t;
+
+static const flap_case_t s_cases[] = {
+    //BLIP BACK WITHIN THE HOLD DOWN: NOBODY HEARS OF IT
+    {"transient short", WIFI_REASON_BEACON_TIMEOUT, 0, 1000,
+        ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT, "", 1, 0},
+    {"transient just below", WIFI_REASON_HANDSHAKE_TIMEOUT, 0, FLAP_HOLD_DOWN_MS - 2 * FLAP_STEP_MS,
+        ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT, "", 1, 0},
+    //HOLD DOWN RUNS OUT FIRST: REPORTED LATE, THEN THE RETURN
+    {"transient long", WIFI_REASON_BEACON_TIMEOUT, 0, 8000,
+        ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT, "DC", 0, 1},
+    //SILENT RETRY FINDS NO AP YET, BUT THE LINK IS BACK IN TIME
+    {"transient, retry no ap", WIFI_REASON_BEACON_TIMEOUT, WIFI_REASON_NO_AP_FOUND, 2000,
+        ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT, "", 1, 0},
+    //SILENT RETRY HAS ITS KEY REJECTED: REPORTED AT ONCE
+    {"transient, retry auth", WIFI_REASON_BEACON_TIMEOUT, WIFI_REASON_AUTH_FAIL, 2000,
+        ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT, "DC", 0, 0},
+    //NO HOLD DOWN FOR THE OTHER CLASSES, HOWEVER SHORT
+    {"auth short", WIFI_REASON_AUTH_FAIL, 0, 1000,
+        ESP32_WIFIMANAGER_DISCONNECT_AUTH, "DC", 0, 0},
+    {"auth long", WIFI_REASON_AUTH_FAIL, 0, 8000,
+        ESP32_WIFIMANAGER_DISCONNECT_AUTH, "DC", 0, 0},
+    {"ap gone short", WIFI_REASON_NO_AP_FOUND, 0, 1000,
+        ESP32_WIFIMANAGER_DISCONNECT_AP_GONE, "DC", 0, 0},
+    {"ap gone long", WIFI_REASON_ASSOC_LEAVE, 0, 8000,
+        ESP32_WIFIMANAGER_DISCONNECT_AP_GONE, "DC", 0, 0},
+};
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static char s_seen[FLAP_SEEN_MAX + 1];
+static uint8_t s_seen_len;
+
+static void s_notify_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //RECORD WHAT A SUBSCRIBER SEES AS ONE LETTER PER EVENT
+
+    static const char letters[ESP32_WIFIMANAGER_NOTIFY_MAX] = {'C', 'D', 'F', 'R', 'G', 'H'};
+
+    if(s_seen_len < FLAP_SEEN_MAX)
+    {
+        s_seen[s_seen_len++] = letters[notify->type];
+        s_seen[s_seen_len] = '\0';
+    }
+}
+
+static esp32_wifimanager_t* s_wm;
+
+static void s_step(uint32_t ms)
+{
+    uint32_t t;
+
+    for(t = 0; t < ms; t += FLAP_STEP_MS)
+    {
+        fake_idf_advance_ms(FLAP_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+    }
+}
+
+static void s_link_up(void)
+{
+    fake_idf_radio_sta_connected(&s_radio, "home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_radio_sta_got_ip(&s_radio, FLAP_IP);
+    s_step(2 * FLAP_STEP_MS);
+}
+
+static void s_create(void)
+{
+    //FRESH INSTANCE, UP AND CONNECTED, NOTHING SEEN YET
+
+    esp32_wifimanager_backoff_t backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_seen_len = 0;
+    s_seen[0] = '\0';
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    backoff.hold_down_ms = FLAP_HOLD_DOWN_MS;
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetBackoff(s_wm, &backoff);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+    CHECK(ESP32_WIFIMANAGER_CTX_Subscribe(s_wm, s_notify_cb, NULL, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    s_step(2 * FLAP_STEP_MS);
+    CHECK(s_radio.connects == 1);
+    s_link_up();
+    CHECK(strcmp(s_seen, "C") == 0);
+    s_seen_len = 0;
+    s_seen[0] = '\0';
+}
+
+static void s_destroy(void)
+{
+    ESP32_WIFIMANAGER_Unsubscribe(s_notify_cb, NULL);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK);
+    s_wm = NULL;
+}
+
+static void s_outage(uint8_t reason, uint8_t retry_reason, uint32_t down_ms)
+{
+    //DROP, OPTIONALLY FAIL ONE RETRY HALF WAY, COME BACK AFTER down_ms
+
+    uint32_t connects;
+
+    fake_idf_radio_sta_disconnected(&s_radio, reason);
+    if(retry_reason != 0)
+    {
+        connects = s_radio.connects;
+        s_step(down_ms / 2);
+        CHECK(s_radio.connects > connects);
+        fake_idf_radio_sta_disconnected(&s_radio, retry_reason);
+        s_step(down_ms - down_ms / 2);
+    }
+    else
+    {
+        s_step(down_ms);
+    }
+    s_link_up();
+}
+
+static void test_cases(void)
+{
+    //ONE FRESH INSTANCE PER CASE
+
+    esp32_wifimanager_stats_t stats;
+    const flap_case_t* c;
+    uint8_t i;
+    uint8_t k;
+
+    for(i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+    {
+        c = &s_cases[i];
+        s_create();
+        s_outage(c->reason, c->retry_reason, c->down_ms);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+
+        CHECK(strcmp(s_seen, c->seen) == 0);
+        CHECK(stats.flaps_suppressed == c->suppressed);
+        CHECK(stats.hold_down_expired == c->expired);
+        CHECK(stats.disconnections == 1);
+        for(k = 0; k < ESP32_WIFIMANAGER_DISCONNECT_CLASS_MAX; k++)
+        {
+            CHECK(stats.link_loss_class[k] == ((k == c->class) ? 1 : 0));
+        }
+        if(c->suppressed != 0)
+        {
+            //FROM THE MAINITER STEP THAT HANDLED THE DROP TO THE GOT_IP
+            CHECK(stats.last_flap_us == (int64_t)(c->down_ms - FLAP_STEP_MS) * 1000);
+            CHECK(stats.max_flap_us == stats.last_flap_us);
+        }
+        else
+        {
+            CHECK(stats.last_flap_us == 0 && stats.max_flap_us == 0);
+        }
+        printf("  %-24s seen \"%s\" suppressed %u expired %u\n",
+                c->name, s_seen, stats.flaps_suppressed, stats.hold_down_expired);
+        s_destroy();
+    }
+}
+
+static void test_repeated(void)
+{
+    //LAST / MAX FLAP OVER A SERIES. A LONG OUTAGE DOES NOT MOVE THEM
+
+    esp32_wifimanager_stats_t stats;
+
+    s_create();
+    s_outage(WIFI_REASON_BEACON_TIMEOUT, 0, 1000);
+    s_outage(WIFI_REASON_BEACON_TIMEOUT, 0, 3000);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.flaps_suppressed == 2);
+    CHECK(stats.last_flap_us == 2950000 && stats.max_flap_us == 2950000);
+
+    s_outage(WIFI_REASON_BEACON_TIMEOUT, 0, 500);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.flaps_suppressed == 3);
+    CHECK(stats.last_flap_us == 450000 && stats.max_flap_us == 2950000);
+    CHECK(s_seen_len == 0);
+
+    s_outage(WIFI_REASON_BEACON_TIMEOUT, 0, 6000);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.flaps_suppressed == 3 && stats.hold_down_expired == 1);
+    CHECK(stats.last_flap_us == 450000 && stats.max_flap_us == 2950000);
+    CHECK(stats.link_loss_class[ESP32_WIFIMANAGER_DISCONNECT_TRANSIENT] == 4);
+    CHECK(strcmp(s_seen, "DC") == 0);
+    s_destroy();
+}
+
+static void test_report_time(void)
+{
+    //A HELD BACK DROP IS REPORTED WHEN THE HOLD DOWN RUNS OUT, OTHERS AT ONCE
+
+    s_create();
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_BEACON_TIMEOUT);
+    s_step(FLAP_HOLD_DOWN_MS - FLAP_STEP_MS);
+    CHECK(s_seen_len == 0);
+    s_step(2 * FLAP_STEP_MS);
+    CHECK(strcmp(s_seen, "D") == 0);
+    s_link_up();
+    CHECK(strcmp(s_seen, "DC") == 0);
+    s_destroy();
+
+    s_create();
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_NO_AP_FOUND);
+    s_step(2 * FLAP_STEP_MS);
+    CHECK(strcmp(s_seen, "D") == 0);
+    s_destroy();
+}
+
+static void test_hold_down_off(void)
+{
+    //hold_down_ms = 0: EVERY TRANSIENT DROP IS REPORTED
+
+    esp32_wifimanager_backoff_t backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+    esp32_wifimanager_stats_t stats;
+
+    s_create();
+    backoff.hold_down_ms = 0;
+    ESP32_WIFIMANAGER_CTX_SetBackoff(s_wm, &backoff);
+    s_outage(WIFI_REASON_BEACON_TIMEOUT, 0, 1000);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(strcmp(s_seen, "DC") == 0);
+    CHECK(stats.flaps_suppressed == 0 && stats.hold_down_expired == 0);
+    s_destroy();
+}
+
+int main(void)
+{
+    fake_idf_tasks = false;
+    test_cases();
+    test_repeated();
+    test_report_time();
+    test_hold_down_off();
+    return fake_idf_summary("test_flap");
+}
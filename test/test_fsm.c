@@ -0,0 +1,261 @@
+/**************************************************
+* HOST TEST: STATE CORE (ESP32_WIFIMANAGER_FSM)
+*
+* TRANSITION TABLE, FIELD PACKING, AND A CAS
+* CONTENTION RUN: ONE THREAD PER FIELD OF THE WORD
+* PLUS ONE FEEDING ILLEGAL TRANSITIONS, AND THE LINK
+* FLAG WRITTEN FROM A SIGNAL HANDLER LIKE AN ISR. EACH
+* WRITER READS ITS OWN FIELD BACK AFTER EVERY UPDATE,
+* SO A LOST UPDATE SHOWS AS A MISMATCH
+*
+* THE RUN IS DONE ONCE ON ALL CPUS AND ONCE PINNED TO
+* ONE. THE HANDLER FIRES BETWEEN A LOAD AND ITS CAS ON
+* A SINGLE CORE TOO, SO RETRIES ARE ALWAYS EXPECTED
+**************************************************/
+
+#define _GNU_SOURCE
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER_FSM.h"
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define FSM_TEST_ROUNDS     (1000000)
+#define FSM_TEST_ISR_US     (20)
+
+static esp32_wifimanager_fsm_t s_fsm;
+static volatile bool s_go;
+static bool s_isr_busy;
+static bool s_isr_link;
+static uint32_t s_isr_count;
+static uint32_t s_isr_bad;
+
+static void s_wait_go(void)
+{
+    while(!__atomic_load_n(&s_go, __ATOMIC_ACQUIRE))
+    {
+    }
+}
+
+static void* s_state_writer(void* arg)
+{
+    //IDLE <-> CONNECTING. ONLY WRITER OF THE STATE BITS
+
+    uint32_t i;
+    uint32_t bad = 0;
+
+    s_wait_go();
+    for(i = 0; i < FSM_TEST_ROUNDS; i++)
+    {
+        bad += ESP32_WIFIMANAGER_FSM_Transition(&s_fsm, ESP32_WIFIMANAGER_STATE_CONNECTING) != ESP32_WIFIMANAGER_FSM_OK;
+        bad += ESP32_WIFIMANAGER_FSM_State(&s_fsm) != ESP32_WIFIMANAGER_STATE_CONNECTING;
+        bad += ESP32_WIFIMANAGER_FSM_Transition(&s_fsm, ESP32_WIFIMANAGER_STATE_IDLE) != ESP32_WIFIMANAGER_FSM_OK;
+        bad += ESP32_WIFIMANAGER_FSM_State(&s_fsm) != ESP32_WIFIMANAGER_STATE_IDLE;
+    }
+    *(uint32_t*)arg = bad;
+    return NULL;
+}
+
+static void s_link_isr(int sig)
+{
+    //LINK UP FLAG. ONLY WRITER OF BIT 8, RUNS ON WHICHEVER WRITER THE SIGNAL HITS
+
+    bool link;
+
+    if(__atomic_exchange_n(&s_isr_busy, true, __ATOMIC_ACQUIRE))
+    {
+        //ANOTHER CPU IS ALREADY IN THE HANDLER
+        return;
+    }
+    link = !__atomic_load_n(&s_isr_link, __ATOMIC_RELAXED);
+    ESP32_WIFIMANAGER_FSM_SetConnected(&s_fsm, link);
+    if(ESP32_WIFIMANAGER_FSM_Connected(&s_fsm) != link)
+    {
+        __atomic_fetch_add(&s_isr_bad, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&s_isr_link, link, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_isr_count, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_isr_busy, false, __ATOMIC_RELEASE);
+}
+
+static void* s_attempts_writer(void* arg)
+{
+    //ATTEMPT COUNT. ONLY WRITER OF BITS 16..23
+
+    uint32_t i;
+    uint32_t bad = 0;
+    uint8_t expect = 0;
+
+    s_wait_go();
+    for(i = 0; i < FSM_TEST_ROUNDS; i++)
+    {
+        if(expect == 200)
+        {
+            ESP32_WIFIMANAGER_FSM_AttemptsReset(&s_fsm);
+            expect = 0;
+        }
+        bad += ESP32_WIFIMANAGER_FSM_AttemptsInc(&s_fsm) != expect;
+        expect++;
+        bad += ESP32_WIFIMANAGER_FSM_Attempts(&s_fsm) != expect;
+    }
+    *(uint32_t*)arg = bad;
+    return NULL;
+}
+
+static void* s_illegal_writer(void* arg)
+{
+    //INITIALIZE IS NEVER A LEGAL TARGET. MUST NEVER CHANGE THE WORD
+
+    uint32_t i;
+    uint32_t bad = 0;
+
+    s_wait_go();
+    for(i = 0; i < FSM_TEST_ROUNDS; i++)
+    {
+        bad += ESP32_WIFIMANAGER_FSM_Transition(&s_fsm, ESP32_WIFIMANAGER_STATE_INITIALIZE) != ESP32_WIFIMANAGER_FSM_ILLEGAL;
+    }
+    *(uint32_t*)arg = bad;
+    return NULL;
+}
+
+static void test_table(void)
+{
+    //EVENTS ARE APPLIED IN IDLE ONLY, INITIALIZE ONLY THROUGH RESET
+
+    esp32_wifimanager_fsm_t fsm = {0};
+
+    CHECK(ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_INITIALIZE, ESP32_WIFIMANAGER_STATE_CONNECTING));
+    CHECK(ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_CONNECTING, ESP32_WIFIMANAGER_STATE_CONNECTION_FAILED));
+    CHECK(ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_IDLE, ESP32_WIFIMANAGER_STATE_DISCONNECTED));
+    CHECK(!ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_CONNECTED, ESP32_WIFIMANAGER_STATE_DISCONNECTED));
+    CHECK(!ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_IDLE, ESP32_WIFIMANAGER_STATE_INITIALIZE));
+    CHECK(!ESP32_WIFIMANAGER_FSM_IsLegal(ESP32_WIFIMANAGER_STATE_IDLE, (esp32_wifimanager_state_t)(ESP32_WIFIMANAGER_STATE_IDLE + 1)));
+
+    ESP32_WIFIMANAGER_FSM_Reset(&fsm, ESP32_WIFIMANAGER_STATE_INITIALIZE);
+    CHECK(ESP32_WIFIMANAGER_FSM_Transition(&fsm, ESP32_WIFIMANAGER_STATE_CONNECTED) == ESP32_WIFIMANAGER_FSM_ILLEGAL);
+    CHECK(ESP32_WIFIMANAGER_FSM_State(&fsm) == ESP32_WIFIMANAGER_STATE_INITIALIZE);
+    CHECK(fsm.illegal == 1);
+    CHECK(ESP32_WIFIMANAGER_FSM_Transition(&fsm, ESP32_WIFIMANAGER_STATE_CONNECTING) == ESP32_WIFIMANAGER_FSM_OK);
+    CHECK(ESP32_WIFIMANAGER_FSM_Transition(&fsm, ESP32_WIFIMANAGER_STATE_CONNECTING) == ESP32_WIFIMANAGER_FSM_SAME);
+    CHECK(fsm.illegal == 1);
+}
+
+static void test_packing(void)
+{
+    //FIELDS DO NOT DISTURB EACH OTHER. ATTEMPTS SATURATE, RESET CLEARS ALL
+
+    esp32_wifimanager_fsm_t fsm = {0};
+    uint32_t i;
+
+    ESP32_WIFIMANAGER_FSM_Reset(&fsm, ESP32_WIFIMANAGER_STATE_IDLE);
+    ESP32_WIFIMANAGER_FSM_SetConnected(&fsm, true);
+    for(i = 0; i < 300; i++)
+    {
+        ESP32_WIFIMANAGER_FSM_AttemptsInc(&fsm);
+    }
+    CHECK(ESP32_WIFIMANAGER_FSM_Attempts(&fsm) == 0xFF);
+    CHECK(ESP32_WIFIMANAGER_FSM_AttemptsInc(&fsm) == 0xFF);
+    CHECK(ESP32_WIFIMANAGER_FSM_Connected(&fsm));
+    CHECK(ESP32_WIFIMANAGER_FSM_State(&fsm) == ESP32_WIFIMANAGER_STATE_IDLE);
+
+    ESP32_WIFIMANAGER_FSM_AttemptsReset(&fsm);
+    CHECK(ESP32_WIFIMANAGER_FSM_Attempts(&fsm) == 0 && ESP32_WIFIMANAGER_FSM_Connected(&fsm));
+    ESP32_WIFIMANAGER_FSM_Reset(&fsm, ESP32_WIFIMANAGER_STATE_INITIALIZE);
+    CHECK(!ESP32_WIFIMANAGER_FSM_Connected(&fsm) && ESP32_WIFIMANAGER_FSM_Attempts(&fsm) == 0);
+}
+
+static void s_contention(bool one_core)
+{
+    //THREE WRITER THREADS AND THE LINK ISR ON ONE WORD
+
+    pthread_t threads[3];
+    void* (*fns[3])(void*) = {s_state_writer, s_attempts_writer, s_illegal_writer};
+    uint32_t bad[3] = {0};
+    struct itimerval timer = {{0, FSM_TEST_ISR_US}, {0, FSM_TEST_ISR_US}};
+    struct sigaction sa = {0};
+    cpu_set_t all;
+    cpu_set_t one;
+    sigset_t alrm;
+    uint8_t i;
+
+    ESP32_WIFIMANAGER_FSM_Reset(&s_fsm, ESP32_WIFIMANAGER_STATE_IDLE);
+    s_fsm.illegal = 0;
+    s_fsm.cas_retries = 0;
+    s_isr_link = false;
+    s_isr_count = 0;
+    s_isr_bad = 0;
+    __atomic_store_n(&s_go, false, __ATOMIC_RELEASE);
+
+    //THREADS INHERIT THE AFFINITY OF THE MAIN THREAD
+    CHECK(sched_getaffinity(0, sizeof(all), &all) == 0);
+    if(one_core)
+    {
+        CPU_ZERO(&one);
+        CPU_SET(sched_getcpu(), &one);
+        CHECK(sched_setaffinity(0, sizeof(one), &one) == 0);
+    }
+
+    sa.sa_handler = s_link_isr;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    CHECK(sigaction(SIGALRM, &sa, NULL) == 0);
+    for(i = 0; i < 3; i++)
+    {
+        CHECK(pthread_create(&threads[i], NULL, fns[i], &bad[i]) == 0);
+    }
+
+    //ONLY THE WRITERS TAKE THE SIGNAL, THE MAIN THREAD JUST WAITS
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alrm, NULL);
+    CHECK(setitimer(ITIMER_REAL, &timer, NULL) == 0);
+    __atomic_store_n(&s_go, true, __ATOMIC_RELEASE);
+    for(i = 0; i < 3; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_REAL, &timer, NULL);
+    signal(SIGALRM, SIG_IGN);
+    pthread_sigmask(SIG_UNBLOCK, &alrm, NULL);
+    sched_setaffinity(0, sizeof(all), &all);
+
+    CHECK(bad[0] == 0);
+    CHECK(bad[1] == 0);
+    CHECK(bad[2] == 0);
+    CHECK(s_isr_bad == 0);
+    CHECK(s_isr_count > 0);
+    CHECK(s_fsm.illegal == FSM_TEST_ROUNDS);
+    CHECK(ESP32_WIFIMANAGER_FSM_State(&s_fsm) == ESP32_WIFIMANAGER_STATE_IDLE);
+    CHECK(ESP32_WIFIMANAGER_FSM_Connected(&s_fsm) == s_isr_link);
+    CHECK(ESP32_WIFIMANAGER_FSM_Attempts(&s_fsm) == (FSM_TEST_ROUNDS - 1) % 200 + 1);
+
+    //RETRIES PROVE THE WRITERS ACTUALLY RACED
+    printf("test_fsm: %s, %u updates, %u from the isr, %u CAS retries\n",
+           one_core ? "one cpu" : "all cpus",
+           (unsigned)(FSM_TEST_ROUNDS * 4 + s_isr_count),
+           (unsigned)s_isr_count,
+           (unsigned)s_fsm.cas_retries);
+    CHECK(s_fsm.cas_retries > 0);
+}
+
+static void test_contention(void)
+{
+    s_contention(false);
+}
+
+static void test_one_core(void)
+{
+    s_contention(true);
+}
+
+int main(void)
+{
+    test_table();
+    test_packing();
+    test_contention();
+    test_one_core();
+    return fake_idf_summary("test_fsm");
+}
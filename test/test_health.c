@@ -0,0 +1,645 @@
+/**************************************************
+* HOST TEST: CONNECTIVITY HEALTH PROBE
+* (ESP32_WIFIMANAGER_HEALTH, ESP32_WIFIMANAGER_SetHealth)
+*
+* THE SOCKET CALLS OF THIS BINARY ARE A SCRIPTED
+* NETWORK: THE GATEWAY ANSWERS ECHO OR STAYS SILENT,
+* THE DNS SERVER ANSWERS WITH A GIVEN RCODE, IS
+* SILENT OR UNREACHABLE, A TCP CONNECT SUCCEEDS OR
+* IS REFUSED. ANSWERS ARE READY s_net.delay_ms OF
+* esp_timer_get_time() AFTER THE REQUEST
+*
+* FIRST HEALTH_Start / Poll ON THEIR OWN, THEN THE
+* MANAGER ON A FAKE RADIO: INTERVAL DOUBLING UP TO
+* max_interval_ms, THE suspect_interval_ms RE-CHECK,
+* fail_threshold AND THE DEAD UPLINK DETECTION TIME
+*
+* TASKS ARE OFF, SO NOTIFY IS DELIVERED FROM MAINITER
+* AND EVERY STEP IS DETERMINISTIC
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_HEALTH.h"
+#include "lwip/sockets.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+
+#define NET_FD_BASE             (900)
+#define NET_SOCK_MAX            (8)
+#define NET_RX_MAX              (2)
+#define NET_SILENT              (-1)    //DNS: NO ANSWER
+#define NET_UNREACHABLE         (-2)    //DNS: ICMP PORT UNREACHABLE
+
+#define HEALTH_STEP_MS          (10)
+#define HEALTH_GW               (0x0101A8C0)    //192.168.1.1
+#define HEALTH_DNS              (0x0201A8C0)    //192.168.1.2
+#define HEALTH_TCP_IP           (0x0301A8C0)    //192.168.1.3
+#define HEALTH_IP               (0x0A01A8C0)
+#define HEALTH_ALL              (ESP32_WIFIMANAGER_HEALTH_GATEWAY | \
+                                 ESP32_WIFIMANAGER_HEALTH_DNS |     \
+                                 ESP32_WIFIMANAGER_HEALTH_TCP)
+
+//ONE FAKE SOCKET. rx_len -1 = QUEUED ERROR
+typedef struct
+{
+    bool open;
+    int type;
+    uint8_t rx[NET_RX_MAX][ESP32_WIFIMANAGER_HEALTH_RX_LEN];
+    int rx_len[NET_RX_MAX];
+    uint8_t rx_count;
+    int64_t ready_us;
+}net_sock_t;
+
+//WHAT THE NETWORK DOES
+typedef struct
+{
+    bool gw_up;                 //GATEWAY ANSWERS ECHO
+    int dns_rcode;              //RCODE, NET_SILENT OR NET_UNREACHABLE
+    int tcp_err;                //SO_ERROR OF THE CONNECT
+    bool stray;                 //A FOREIGN REPLY ARRIVES FIRST
+    uint32_t delay_ms;
+}net_t;
+
+static net_sock_t s_socks[NET_SOCK_MAX];
+static net_t s_net;
+
+/* SCRIPTED NETWORK */
+
+static net_sock_t* s_net_sock(int fd)
+{
+    if(fd < NET_FD_BASE || fd >= NET_FD_BASE + NET_SOCK_MAX || !s_socks[fd - NET_FD_BASE].open)
+    {
+        return NULL;
+    }
+    return &s_socks[fd - NET_FD_BASE];
+}
+
+static void s_net_queue(net_sock_t* sock, const uint8_t* data, int len)
+{
+    if(sock->rx_count < NET_RX_MAX)
+    {
+        if(len > 0)
+        {
+            memcpy(sock->rx[sock->rx_count], data, len);
+        }
+        sock->rx_len[sock->rx_count++] = len;
+    }
+    sock->ready_us = fake_idf_now_us + (int64_t)s_net.delay_ms * 1000;
+}
+
+static void s_net_echo_reply(net_sock_t* sock, const uint8_t* echo, uint32_t src)
+{
+    //IP HEADER + ICMP ECHO REPLY
+
+    uint8_t pkt[20 + ESP32_WIFIMANAGER_HEALTH_ECHO_LEN];
+
+    memset(pkt, 0, sizeof(pkt));
+    pkt[0] = 0x45;
+    pkt[9] = IPPROTO_ICMP;
+    memcpy(&pkt[12], &src, sizeof(src));
+    memcpy(&pkt[20], echo, ESP32_WIFIMANAGER_HEALTH_ECHO_LEN);
+    pkt[20] = 0;
+    s_net_queue(sock, pkt, sizeof(pkt));
+}
+
+static void s_net_dns_reply(net_sock_t* sock, const uint8_t* query, size_t len, uint8_t id_xor)
+{
+    uint8_t pkt[ESP32_WIFIMANAGER_HEALTH_RX_LEN];
+
+    len = (len > sizeof(pkt)) ? sizeof(pkt) : len;
+    memcpy(pkt, query, len);
+    pkt[1] ^= id_xor;
+    pkt[2] = 0x81;
+    pkt[3] = 0x80 | (uint8_t)s_net.dns_rcode;
+    s_net_queue(sock, pkt, (int)len);
+}
+
+int socket(int domain, int type, int protocol)
+{
+    int i;
+
+    for(i = 0; i < NET_SOCK_MAX; i++)
+    {
+        if(!s_socks[i].open)
+        {
+            memset(&s_socks[i], 0, sizeof(net_sock_t));
+            s_socks[i].open = true;
+            s_socks[i].type = type;
+            return NET_FD_BASE + i;
+        }
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+int close(int fd)
+{
+    net_sock_t* sock = s_net_sock(fd);
+
+    if(sock == NULL)
+    {
+        return (int)syscall(SYS_close, fd);
+    }
+    sock->open = false;
+    return 0;
+}
+
+int fcntl(int fd, int cmd, ...)
+{
+    va_list ap;
+    long arg;
+
+    va_start(ap, cmd);
+    arg = va_arg(ap, long);
+    va_end(ap);
+    if(s_net_sock(fd) == NULL)
+    {
+        return (int)syscall(SYS_fcntl, fd, cmd, arg);
+    }
+    return 0;
+}
+
+int connect(int fd, const struct sockaddr* addr, socklen_t len)
+{
+    net_sock_t* sock = s_net_sock(fd);
+
+    if(sock == NULL)
+    {
+        errno = EBADF;
+        return -1;
+    }
+    if(sock->type != SOCK_STREAM)
+    {
+        return 0;
+    }
+    sock->ready_us = fake_idf_now_us + (int64_t)s_net.delay_ms * 1000;
+    errno = EINPROGRESS;
+    return -1;
+}
+
+ssize_t sendto(int fd, const void* buf, size_t len, int flags, const struct sockaddr* addr, socklen_t addr_len)
+{
+    //ICMP ECHO ON THE RAW SOCKET
+
+    net_sock_t* sock = s_net_sock(fd);
+    const struct sockaddr_in* to = (const struct sockaddr_in*)addr;
+
+    if(sock == NULL)
+    {
+        errno = EBADF;
+        return -1;
+    }
+    if(s_net.stray)
+    {
+        s_net_echo_reply(sock, buf, HEALTH_TCP_IP);
+    }
+    if(s_net.gw_up)
+    {
+        s_net_echo_reply(sock, buf, to->sin_addr.s_addr);
+    }
+    return (ssize_t)len;
+}
+
+ssize_t send(int fd, const void* buf, size_t len, int flags)
+{
+    //DNS QUERY ON THE CONNECTED UDP SOCKET
+
+    net_sock_t* sock = s_net_sock(fd);
+
+    if(sock == NULL)
+    {
+        errno = EBADF;
+        return -1;
+    }
+    if(s_net.stray)
+    {
+        s_net_dns_reply(sock, buf, len, 0x5A);
+    }
+    if(s_net.dns_rcode == NET_UNREACHABLE)
+    {
+        s_net_queue(sock, NULL, -1);
+    }
+    else if(s_net.dns_rcode != NET_SILENT)
+    {
+        s_net_dns_reply(sock, buf, len, 0);
+    }
+    return (ssize_t)len;
+}
+
+ssize_t recv(int fd, void* buf, size_t len, int flags)
+{
+    net_sock_t* sock = s_net_sock(fd);
+    int rx_len;
+
+    if(sock == NULL)
+    {
+        errno = EBADF;
+        return -1;
+    }
+    if(sock->rx_count == 0 || fake_idf_now_us < sock->ready_us)
+    {
+        errno = EWOULDBLOCK;
+        return -1;
+    }
+    rx_len = sock->rx_len[0];
+    if(rx_len > 0)
+    {
+        memcpy(buf, sock->rx[0], ((size_t)rx_len < len) ? (size_t)rx_len : len);
+    }
+    sock->rx_count--;
+    memmove(&sock->rx[0], &sock->rx[1], sizeof(sock->rx[0]) * sock->rx_count);
+    memmove(&sock->rx_len[0], &sock->rx_len[1], sizeof(sock->rx_len[0]) * sock->rx_count);
+    if(rx_len < 0)
+    {
+        errno = ECONNREFUSED;
+        return -1;
+    }
+    return ((size_t)rx_len < len) ? rx_len : (ssize_t)len;
+}
+
+ssize_t __recv_chk(int fd, void* buf, size_t len, size_t buf_len, int flags)
+{
+    //recv OF _FORTIFY_SOURCE BUILDS
+
+    return recv(fd, buf, len, flags);
+}
+
+int select(int nfds, fd_set* rfds, fd_set* wfds, fd_set* efds, struct timeval* tv)
+{
+    //NEVER WAITS. READABLE = ANSWER DUE, WRITABLE = TCP CONNECT DONE
+
+    net_sock_t* sock;
+    int ready = 0;
+    int fd;
+
+    for(fd = 0; fd < nfds; fd++)
+    {
+        sock = s_net_sock(fd);
+        if(rfds != NULL && FD_ISSET(fd, rfds))
+        {
+            if(sock != NULL && sock->rx_count > 0 && fake_idf_now_us >= sock->ready_us)
+            {
+                ready++;
+            }
+            else
+            {
+                FD_CLR(fd, rfds);
+            }
+        }
+        if(wfds != NULL && FD_ISSET(fd, wfds))
+        {
+            if(sock != NULL && sock->type == SOCK_STREAM && fake_idf_now_us >= sock->ready_us)
+            {
+                ready++;
+            }
+            else
+            {
+                FD_CLR(fd, wfds);
+            }
+        }
+    }
+    return ready;
+}
+
+int getsockopt(int fd, int level, int name, void* val, socklen_t* len)
+{
+    if(s_net_sock(fd) == NULL || level != SOL_SOCKET || name != SO_ERROR)
+    {
+        errno = EBADF;
+        return -1;
+    }
+    *(int*)val = s_net.tcp_err;
+    return 0;
+}
+
+static uint8_t s_net_open_count(void)
+{
+    uint8_t count = 0;
+    uint8_t i;
+
+    for(i = 0; i < NET_SOCK_MAX; i++)
+    {
+        count += s_socks[i].open ? 1 : 0;
+    }
+    return count;
+}
+
+/* ONE ROUND, HEALTH_Start / Poll */
+
+//ONE SCRIPTED ROUND
+typedef struct
+{
+    const char* name;
+    uint8_t checks;
+    uint32_t gw;
+    net_t net;
+    uint8_t failed;             //EXPECTED CHECK BITS
+    bool at_deadline;           //ROUND ENDS ON THE TIMEOUT, ELSE ON THE ANSWERS
+}round_case_t;
+
+static const round_case_t s_rounds[] = {
+    {"all answer", HEALTH_ALL, HEALTH_GW, {true, 0, 0, false, 30}, 0, false},
+    {"nxdomain is up", ESP32_WIFIMANAGER_HEALTH_DNS, HEALTH_GW, {true, 3, 0, false, 30}, 0, false},
+    {"stray replies", HEALTH_ALL, HEALTH_GW, {true, 0, 0, true, 30}, 0, false},
+    {"servfail", HEALTH_ALL, HEALTH_GW, {true, 2, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_DNS, false},
+    {"dns unreachable", HEALTH_ALL, HEALTH_GW, {true, NET_UNREACHABLE, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_DNS, false},
+    {"tcp refused", HEALTH_ALL, HEALTH_GW, {true, 0, ECONNREFUSED, false, 30}, ESP32_WIFIMANAGER_HEALTH_TCP, false},
+    {"gateway silent", HEALTH_ALL, HEALTH_GW, {false, 0, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_GATEWAY, true},
+    {"dns silent", HEALTH_ALL, HEALTH_GW, {true, NET_SILENT, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_DNS, true},
+    {"uplink dead", ESP32_WIFIMANAGER_HEALTH_GATEWAY | ESP32_WIFIMANAGER_HEALTH_DNS, HEALTH_GW,
+        {false, NET_SILENT, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_GATEWAY | ESP32_WIFIMANAGER_HEALTH_DNS, true},
+    {"no gateway", ESP32_WIFIMANAGER_HEALTH_GATEWAY, 0, {true, 0, 0, false, 30}, ESP32_WIFIMANAGER_HEALTH_GATEWAY, false},
+};
+
+static void test_rounds(void)
+{
+    esp32_wifimanager_health_t health = ESP32_WIFIMANAGER_HEALTH_DEFAULT();
+    esp32_wifimanager_health_probe_t probe;
+    const round_case_t* c;
+    int64_t start_us;
+    int64_t done_us;
+    uint8_t i;
+    uint8_t k;
+
+    health.tcp_ip = HEALTH_TCP_IP;
+    health.tcp_port = 80;
+    ESP32_WIFIMANAGER_HEALTH_Init(&probe);
+    for(i = 0; i < sizeof(s_rounds) / sizeof(s_rounds[0]); i++)
+    {
+        c = &s_rounds[i];
+        s_net = c->net;
+        health.checks = c->checks;
+        start_us = fake_idf_now_us;
+        ESP32_WIFIMANAGER_HEALTH_Start(&probe, &health, c->gw, HEALTH_DNS, 0x1234 + i, start_us);
+        while(!ESP32_WIFIMANAGER_HEALTH_Poll(&probe, fake_idf_now_us))
+        {
+            fake_idf_advance_ms(HEALTH_STEP_MS);
+        }
+        done_us = fake_idf_now_us - start_us;
+
+        CHECK(probe.failed == c->failed);
+        CHECK(!ESP32_WIFIMANAGER_HEALTH_Running(&probe));
+        CHECK(s_net_open_count() == 0);
+        if(c->at_deadline)
+        {
+            CHECK(done_us == (int64_t)health.timeout_ms * 1000);
+        }
+        else if(c->gw != 0)
+        {
+            CHECK(done_us == (int64_t)c->net.delay_ms * 1000);
+        }
+        else
+        {
+            CHECK(done_us == 0);
+        }
+        for(k = 0; k < ESP32_WIFIMANAGER_HEALTH_CHECK_MAX; k++)
+        {
+            if((c->checks & (1 << k)) && !(c->failed & (1 << k)))
+            {
+                CHECK(probe.rtt_us[k] == (int64_t)c->net.delay_ms * 1000);
+            }
+        }
+        printf("  %-16s failed 0x%02x after %u ms\n", c->name, probe.failed, (unsigned)(done_us / 1000));
+    }
+}
+
+/* MANAGER */
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static esp32_wifimanager_t* s_wm;
+static int64_t s_degraded_us;
+static int64_t s_healthy_us;
+static uint8_t s_degraded_checks;
+
+static void s_notify_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    if(notify->type == ESP32_WIFIMANAGER_NOTIFY_DEGRADED)
+    {
+        s_degraded_us = fake_idf_now_us;
+        s_degraded_checks = notify->health;
+    }
+    else if(notify->type == ESP32_WIFIMANAGER_NOTIFY_HEALTHY)
+    {
+        s_healthy_us = fake_idf_now_us;
+    }
+}
+
+static void s_step(uint32_t ms)
+{
+    uint32_t t;
+
+    for(t = 0; t < ms; t += HEALTH_STEP_MS)
+    {
+        fake_idf_advance_ms(HEALTH_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+    }
+}
+
+static uint32_t s_step_rounds(uint32_t rounds)
+{
+    //RUN UNTIL rounds MORE ROUNDS ARE OVER. RETURNS THE ms IT TOOK
+
+    esp32_wifimanager_stats_t stats;
+    int64_t start_us = fake_idf_now_us;
+    uint32_t want;
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    want = stats.health_rounds + rounds;
+    while(stats.health_rounds < want && fake_idf_now_us - start_us < 600000000LL)
+    {
+        s_step(HEALTH_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    }
+    return (uint32_t)((fake_idf_now_us - start_us) / 1000);
+}
+
+static void s_create(const esp32_wifimanager_health_t* health)
+{
+    //CONNECTED INSTANCE, FIRST ROUND NOT RUN YET
+
+    tcpip_adapter_dns_info_t dns;
+
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_degraded_us = 0;
+    s_healthy_us = 0;
+    s_degraded_checks = 0;
+    s_net = (net_t){true, 0, 0, false, 20};
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetHealth(s_wm, health);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+    CHECK(ESP32_WIFIMANAGER_CTX_Subscribe(s_wm, s_notify_cb, NULL, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    s_step(2 * HEALTH_STEP_MS);
+
+    memset(&dns, 0, sizeof(dns));
+    dns.ip.u_addr.ip4.addr = HEALTH_DNS;
+    s_radio.dns = dns;
+    s_radio.sta_ip.gw.addr = HEALTH_GW;
+    fake_idf_radio_sta_connected(&s_radio, "home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_radio_sta_got_ip(&s_radio, HEALTH_IP);
+    s_step(2 * HEALTH_STEP_MS);
+    CHECK(ESP32_WIFIMANAGER_CTX_GetHealth(s_wm) == ESP32_WIFIMANAGER_HEALTH_UNKNOWN);
+}
+
+static void s_destroy(void)
+{
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK);
+    CHECK(s_net_open_count() == 0);
+    s_wm = NULL;
+}
+
+static void test_interval(void)
+{
+    //QUIET LINK: BASE, THEN DOUBLING UP TO max_interval_ms AND STAYING THERE
+
+    esp32_wifimanager_health_t health = ESP32_WIFIMANAGER_HEALTH_DEFAULT();
+    esp32_wifimanager_stats_t stats;
+    uint32_t expect = health.interval_ms;
+    uint32_t took;
+    uint8_t i;
+
+    s_create(&health);
+    for(i = 0; i < 6; i++)
+    {
+        took = s_step_rounds(1);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+
+        //ROUND STARTS ONE INTERVAL AFTER THE LAST ONE ENDED, ANSWERS AT THE NEXT POLL
+        CHECK(took >= expect && took <= expect + ESP32_WIFIMANAGER_HEALTH_POLL_MS + HEALTH_STEP_MS);
+        expect = (expect * 2 > health.max_interval_ms) ? health.max_interval_ms : expect * 2;
+        CHECK(stats.health_interval_ms == expect);
+        CHECK(stats.health_failed_rounds == 0);
+        CHECK(stats.health_rtt_us[0] > 0 && stats.health_rtt_us[1] > 0);
+    }
+    CHECK(ESP32_WIFIMANAGER_CTX_GetHealth(s_wm) == ESP32_WIFIMANAGER_HEALTH_HEALTHY);
+    CHECK(stats.health_interval_ms == health.max_interval_ms);
+    s_destroy();
+}
+
+static void test_threshold(void)
+{
+    //UPLINK DIES RIGHT AFTER A ROUND AT max_interval_ms (WORST CASE)
+    //FAILED ROUNDS RE-CHECK AT suspect_interval_ms, DEGRADED AT fail_threshold
+
+    static const uint8_t thresholds[] = {1, 2, 3};
+    esp32_wifimanager_health_t health = ESP32_WIFIMANAGER_HEALTH_DEFAULT();
+    esp32_wifimanager_stats_t stats;
+    int64_t dead_us;
+    int64_t back_us;
+    uint32_t bound_ms;
+    uint32_t took;
+    uint8_t i;
+    uint8_t r;
+
+    for(i = 0; i < sizeof(thresholds); i++)
+    {
+        health.fail_threshold = thresholds[i];
+        s_create(&health);
+        s_step_rounds(3);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+        CHECK(stats.health_interval_ms == health.max_interval_ms);
+
+        dead_us = fake_idf_now_us;
+        s_net.gw_up = false;
+        s_net.dns_rcode = NET_SILENT;
+        for(r = 1; r <= health.fail_threshold; r++)
+        {
+            took = s_step_rounds(1);
+            ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+            CHECK(stats.health_failed_rounds == r);
+            CHECK(stats.health_interval_ms == health.interval_ms);
+
+            //FIRST FAILURE WAITS OUT THE LONG INTERVAL, THE REST ARE SUSPECT RE-CHECKS
+            CHECK(took >= ((r == 1) ? health.max_interval_ms : health.suspect_interval_ms) + health.timeout_ms);
+            CHECK(took <= ((r == 1) ? health.max_interval_ms : health.suspect_interval_ms) + health.timeout_ms +
+                            ESP32_WIFIMANAGER_HEALTH_POLL_MS + HEALTH_STEP_MS);
+            if(r < health.fail_threshold)
+            {
+                CHECK(s_degraded_us == 0);
+                CHECK(ESP32_WIFIMANAGER_CTX_GetHealth(s_wm) == ESP32_WIFIMANAGER_HEALTH_HEALTHY);
+            }
+        }
+        s_step(HEALTH_STEP_MS);
+        CHECK(s_degraded_us != 0);
+        CHECK(s_degraded_checks == (ESP32_WIFIMANAGER_HEALTH_GATEWAY | ESP32_WIFIMANAGER_HEALTH_DNS));
+        CHECK(ESP32_WIFIMANAGER_CTX_GetHealth(s_wm) == ESP32_WIFIMANAGER_HEALTH_DEGRADED);
+
+        //HEADER: ABOUT max_interval_ms + fail_threshold ROUNDS
+        bound_ms = health.max_interval_ms + health.fail_threshold * health.timeout_ms +
+                    (health.fail_threshold - 1) * health.suspect_interval_ms +
+                    health.fail_threshold * (ESP32_WIFIMANAGER_HEALTH_POLL_MS + HEALTH_STEP_MS);
+        CHECK(s_degraded_us - dead_us <= (int64_t)bound_ms * 1000);
+
+        //DEGRADED: NO MORE SUSPECT RE-CHECKS, BASE INTERVAL
+        took = s_step_rounds(1) + HEALTH_STEP_MS;
+        CHECK(took >= health.interval_ms + health.timeout_ms);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+        CHECK(stats.health_degraded == 1);
+
+        //UPLINK BACK: HEALTHY AT THE NEXT ROUND
+        back_us = fake_idf_now_us;
+        s_net.gw_up = true;
+        s_net.dns_rcode = 0;
+        s_step_rounds(1);
+        s_step(HEALTH_STEP_MS);
+        CHECK(s_healthy_us != 0);
+        CHECK(s_healthy_us - back_us <= (int64_t)(health.interval_ms + ESP32_WIFIMANAGER_HEALTH_POLL_MS + 2 * HEALTH_STEP_MS) * 1000);
+        CHECK(ESP32_WIFIMANAGER_CTX_GetHealth(s_wm) == ESP32_WIFIMANAGER_HEALTH_HEALTHY);
+        printf("  fail_threshold %u: degraded %u ms after the uplink died (bound %u ms), healthy %u ms after it came back\n",
+                health.fail_threshold,
+                (unsigned)((s_degraded_us - dead_us) / 1000),
+                bound_ms,
+                (unsigned)((s_healthy_us - back_us) / 1000));
+        s_destroy();
+    }
+}
+
+static void test_best_case(void)
+{
+    //UPLINK DIES JUST BEFORE A ROUND: fail_threshold ROUNDS, NO LONG WAIT
+
+    esp32_wifimanager_health_t health = ESP32_WIFIMANAGER_HEALTH_DEFAULT();
+    esp32_wifimanager_stats_t stats;
+    int64_t dead_us;
+    uint32_t bound_ms;
+
+    s_create(&health);
+    s_step_rounds(3);
+    s_step(health.max_interval_ms - HEALTH_STEP_MS);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.health_rounds == 3);
+    dead_us = fake_idf_now_us;
+    s_net.gw_up = false;
+    s_net.dns_rcode = NET_SILENT;
+    while(s_degraded_us == 0 && fake_idf_now_us - dead_us < 60000000LL)
+    {
+        s_step(HEALTH_STEP_MS);
+    }
+    bound_ms = health.fail_threshold * health.timeout_ms +
+                (health.fail_threshold - 1) * health.suspect_interval_ms +
+                health.fail_threshold * (ESP32_WIFIMANAGER_HEALTH_POLL_MS + HEALTH_STEP_MS) + HEALTH_STEP_MS;
+    CHECK(s_degraded_us != 0 && s_degraded_us - dead_us <= (int64_t)bound_ms * 1000);
+    printf("  best case: degraded %u ms after the uplink died (bound %u ms)\n",
+            (unsigned)((s_degraded_us - dead_us) / 1000), bound_ms);
+    s_destroy();
+}
+
+int main(void)
+{
+    fake_idf_tasks = false;
+
+    test_rounds();
+    test_interval();
+    test_threshold();
+    test_best_case();
+    return fake_idf_summary("test_health");
+}
@@ -0,0 +1,448 @@
+/**************************************************
+* HOST TEST: INSTANCES SIDE BY SIDE
+* (ESP32_WIFIMANAGER_CTX_*, ESP32_WIFIMANAGER_DRIVER)
+*
+* N INSTANCES, EACH ON ITS OWN FAKE RADIO THROUGH
+* fake_idf_driver, RUN IN ONE PROCESS. EVENTS ON ONE
+* RADIO MUST ONLY MOVE ITS OWN INSTANCE: STATE, STATS,
+* TIMERS, TRACE, SCAN CACHE AND NOTIFY SOURCE STAY
+* PER INSTANCE, AND THE ESP32 RADIO (fake_idf_wifi)
+* IS NEVER TOUCHED. NVS KEYS STAY IN THE INSTANCE'S
+* NAMESPACE
+*
+* THEN THE SAME INSTANCES ON MANAGER TASKS, DRIVEN
+* FROM ONE THREAD PER RADIO AT THE SAME TIME
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_NOTIFY.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define INSTANCES_N             (4)
+#define INSTANCES_CYCLES        (200)
+#define INSTANCES_IP(i)         (0x0A01A8C0 + ((uint32_t)(i) << 24))
+
+//MANAGER EVENT NUMBER AS IN THE TRACE (esp32_wifimanager_evt_type_t)
+#define INSTANCES_EVT_STA_DISCONNECTED  (3)
+
+typedef struct
+{
+    volatile uint32_t connected;
+    volatile uint32_t disconnected;
+    volatile uint32_t foreign;          //EVENTS OF ANOTHER INSTANCE
+    const esp32_wifimanager_t* wm;
+}instances_counter_t;
+
+typedef struct
+{
+    esp32_wifimanager_t* wm;
+    fake_idf_wifi_t* radio;
+    uint8_t index;
+}instances_worker_t;
+
+static fake_idf_wifi_t s_radio[INSTANCES_N];
+static esp32_wifimanager_t* s_wm[INSTANCES_N];
+static instances_counter_t s_counter[INSTANCES_N];
+static char s_ssid[INSTANCES_N][8];
+static esp32_wifimanager_credential_hardcoded_t s_cred[INSTANCES_N];
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+static void s_count_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    instances_counter_t* counter = (instances_counter_t*)arg;
+
+    if(notify->source != counter->wm)
+    {
+        __atomic_add_fetch(&counter->foreign, 1, __ATOMIC_RELAXED);
+    }
+    else if(notify->type == ESP32_WIFIMANAGER_NOTIFY_CONNECTED)
+    {
+        __atomic_add_fetch(&counter->connected, 1, __ATOMIC_RELAXED);
+    }
+    else if(notify->type == ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED)
+    {
+        __atomic_add_fetch(&counter->disconnected, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void s_mainiter_all(uint32_t calls)
+{
+    uint32_t i;
+    uint8_t n;
+
+    for(i = 0; i < calls; i++)
+    {
+        for(n = 0; n < INSTANCES_N; n++)
+        {
+            ESP32_WIFIMANAGER_CTX_Mainiter(s_wm[n]);
+        }
+    }
+}
+
+static uint32_t s_wait_count(volatile uint32_t* count, uint32_t want)
+{
+    //SUBSCRIBERS RUN ON THE NOTIFY TASK. GIVE IT UP TO 1S TO CATCH UP
+
+    uint32_t spins;
+
+    for(spins = 0; spins < 20000 && *count < want; spins++)
+    {
+        usleep(50);
+    }
+    return *count;
+}
+
+static uint32_t s_wait_connections(esp32_wifimanager_t* wm, uint32_t want)
+{
+    //THE MANAGER'S OWN COUNT. UNLIKE NOTIFY IT CANNOT DROP
+
+    esp32_wifimanager_stats_t stats;
+    uint32_t spins;
+
+    for(spins = 0; spins < 20000; spins++)
+    {
+        ESP32_WIFIMANAGER_CTX_GetStats(wm, &stats);
+        if(stats.connections >= want)
+        {
+            break;
+        }
+        usleep(50);
+    }
+    return stats.connections;
+}
+
+static uint16_t s_trace_count(esp32_wifimanager_t* wm, uint8_t type)
+{
+    //EVENT RECORDS OF ONE TYPE IN wm'S TRACE
+
+    static esp32_wifimanager_trace_record_t records[ESP32_WIFIMANAGER_TRACE_LEN];
+    uint16_t count = ESP32_WIFIMANAGER_CTX_GetTrace(wm, records, ESP32_WIFIMANAGER_TRACE_LEN);
+    uint16_t i;
+    uint16_t n = 0;
+
+    for(i = 0; i < count; i++)
+    {
+        if(records[i].kind == ESP32_WIFIMANAGER_TRACE_EVT && records[i].type == type)
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+static esp32_wifimanager_t* s_create(uint8_t n)
+{
+    //INSTANCE n ON RADIO n, SSID "net<n>", OWN PORTAL PORTS, OWN SUBSCRIPTION
+
+    esp32_wifimanager_t* wm = ESP32_WIFIMANAGER_CTX_Create();
+
+    snprintf(s_ssid[n], sizeof(s_ssid[n]), "net%u", n);
+    s_cred[n].ssid_name = s_ssid[n];
+    s_cred[n].ssid_pwd = "password";
+    memset(&s_counter[n], 0, sizeof(s_counter[n]));
+    s_counter[n].wm = wm;
+
+    CHECK(ESP32_WIFIMANAGER_CTX_SetDriver(wm, &fake_idf_driver, &s_radio[n]) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetPortalPorts(wm, 18080 + n, 18053 + n) == ESP_OK);
+    ESP32_WIFIMANAGER_CTX_SetParameters(wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred[n], 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(wm, false);
+    ESP32_WIFIMANAGER_CTX_SetTrace(wm, true);
+    CHECK(ESP32_WIFIMANAGER_CTX_Subscribe(wm, s_count_cb, &s_counter[n],
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_CONNECTED) |
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED)) == ESP_OK);
+    return wm;
+}
+
+static void s_destroy_all(void)
+{
+    uint8_t n;
+
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        ESP32_WIFIMANAGER_Unsubscribe(s_count_cb, &s_counter[n]);
+        CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm[n]) == ESP_OK);
+        CHECK(s_radio[n].owner == NULL);
+        s_wm[n] = NULL;
+    }
+}
+
+static void test_bind(void)
+{
+    //ONE INSTANCE PER RADIO. DESTROY HANDS THE RADIO ON
+
+    esp32_wifimanager_t* first;
+    esp32_wifimanager_t* second;
+    fake_idf_wifi_t radio;
+
+    memset(&radio, 0, sizeof(radio));
+    first = ESP32_WIFIMANAGER_CTX_Create();
+    second = ESP32_WIFIMANAGER_CTX_Create();
+    s_cred[0].ssid_name = "net0";
+    s_cred[0].ssid_pwd = "password";
+
+    ESP32_WIFIMANAGER_CTX_SetDriver(first, &fake_idf_driver, &radio);
+    ESP32_WIFIMANAGER_CTX_SetDriver(second, &fake_idf_driver, &radio);
+    ESP32_WIFIMANAGER_CTX_SetParameters(first,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred[0], 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetParameters(second,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred[0], 2, "test");
+    CHECK(radio.owner == first);
+    CHECK(ESP32_WIFIMANAGER_CTX_StartTask(second, 5) == ESP_ERR_INVALID_STATE);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetDriver(first, NULL, NULL) == ESP_ERR_INVALID_STATE);
+
+    ESP32_WIFIMANAGER_CTX_Mainiter(first);
+    ESP32_WIFIMANAGER_CTX_Mainiter(first);
+    CHECK(radio.up && radio.connects == 1);
+
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(first) == ESP_OK);
+    CHECK(radio.owner == NULL);
+    ESP32_WIFIMANAGER_CTX_SetParameters(second,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred[0], 2, "test");
+    CHECK(radio.owner == second);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(second) == ESP_OK);
+    CHECK(fake_idf_wifi.connects == 0 && !fake_idf_wifi.up);
+}
+
+static void test_namespace(void)
+{
+    //EACH INSTANCE KEEPS ITS NVS KEYS IN ITS OWN NAMESPACE
+
+    esp32_wifimanager_t* writer = ESP32_WIFIMANAGER_CTX_Create();
+    esp32_wifimanager_t* same = ESP32_WIFIMANAGER_CTX_Create();
+    esp32_wifimanager_t* other = ESP32_WIFIMANAGER_CTX_Create();
+    esp32_wifimanager_t* plain = ESP32_WIFIMANAGER_CTX_Create();
+    fake_idf_wifi_t radio;
+
+    fake_idf_nvs_erase_all();
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(writer, "wm0") == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(same, "wm0") == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(other, "wm1") == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(other, "") == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(other, "sixteen-chars-xx") == ESP_ERR_INVALID_ARG);
+
+    CHECK(ESP32_WIFIMANAGER_CTX_AddCredential(writer, "only0", "password") == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_RemoveCredential(other, "only0") == ESP_ERR_NOT_FOUND);
+    CHECK(ESP32_WIFIMANAGER_CTX_RemoveCredential(plain, "only0") == ESP_ERR_NOT_FOUND);
+    CHECK(ESP32_WIFIMANAGER_CTX_RemoveCredential(same, "only0") == ESP_OK);
+
+    //A BOUND INSTANCE HAS ALREADY READ ITS NAMESPACE
+    memset(&radio, 0, sizeof(radio));
+    s_cred[0].ssid_name = "net0";
+    s_cred[0].ssid_pwd = "password";
+    ESP32_WIFIMANAGER_CTX_SetDriver(plain, &fake_idf_driver, &radio);
+    ESP32_WIFIMANAGER_CTX_SetParameters(plain,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred[0], 2, "test");
+    CHECK(ESP32_WIFIMANAGER_CTX_SetNamespace(plain, "wm2") == ESP_ERR_INVALID_STATE);
+
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(writer) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(same) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(other) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(plain) == ESP_OK);
+    fake_idf_nvs_erase_all();
+}
+
+static void test_side_by_side(void)
+{
+    //POLLED INSTANCES. EVERY STEP IS CHECKED ON ALL OF THEM
+
+    esp32_wifimanager_stats_t stats[INSTANCES_N];
+    const esp32_wifimanager_scan_entry_t* results[4];
+    uint32_t connects[INSTANCES_N];
+    uint16_t disc_traced[INSTANCES_N];
+    uint8_t n;
+
+    memset(s_radio, 0, sizeof(s_radio));
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        s_wm[n] = s_create(n);
+        CHECK(s_radio[n].owner == s_wm[n]);
+    }
+    //ONLY INSTANCE 2 REFRESHES ITS SCAN CACHE
+    ESP32_WIFIMANAGER_CTX_SetScanRefresh(s_wm[2], ESP32_WIFIMANAGER_SCAN_REFRESH_MIN_MS);
+
+    //EACH INSTANCE BRINGS UP AND CONNECTS ITS OWN RADIO, TO ITS OWN SSID
+    s_mainiter_all(2);
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        CHECK(s_radio[n].up && s_radio[n].started);
+        CHECK(s_radio[n].connects == 1);
+        CHECK(strcmp((char*)s_radio[n].sta.sta.ssid, s_ssid[n]) == 0);
+    }
+    CHECK(fake_idf_wifi.connects == 0 && !fake_idf_wifi.started);
+
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        fake_idf_radio_sta_connected(&s_radio[n], s_ssid[n], s_bssid, 1 + n, WIFI_AUTH_WPA2_PSK);
+        fake_idf_radio_sta_got_ip(&s_radio[n], INSTANCES_IP(n));
+    }
+    s_mainiter_all(8);
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm[n], &stats[n]);
+        CHECK(stats[n].connections == 1 && stats[n].disconnections == 0);
+        CHECK(s_wait_count(&s_counter[n].connected, 1) == 1 && s_counter[n].foreign == 0);
+    }
+
+    //SCAN RESULTS OF RADIO 2 LAND IN INSTANCE 2'S CACHE ONLY
+    fake_idf_advance_ms(ESP32_WIFIMANAGER_SCAN_REFRESH_MIN_MS + 10);
+    s_mainiter_all(4);
+    CHECK(s_radio[2].scans == 1);
+    memcpy(s_radio[2].scan_records[0].ssid, "seen", 5);
+    memcpy(s_radio[2].scan_records[0].bssid, s_bssid, 6);
+    s_radio[2].scan_records[0].primary = 6;
+    s_radio[2].scan_records[0].rssi = -50;
+    s_radio[2].scan_count = 1;
+    fake_idf_radio_scan_done(&s_radio[2]);
+    s_mainiter_all(4);
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        CHECK(ESP32_WIFIMANAGER_CTX_GetScanResults(s_wm[n], results, 4) == ((n == 2) ? 1 : 0));
+        CHECK(n == 2 || s_radio[n].scans == 0);
+    }
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        connects[n] = s_radio[n].connects;
+        disc_traced[n] = s_trace_count(s_wm[n], INSTANCES_EVT_STA_DISCONNECTED);
+    }
+
+    //LINK LOSS ON RADIO 1 ONLY (AP GONE, NOT HELD DOWN)
+    fake_idf_radio_sta_disconnected(&s_radio[1], WIFI_REASON_NO_AP_FOUND);
+    s_mainiter_all(8);
+    s_wait_count(&s_counter[1].disconnected, 1);
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm[n], &stats[n]);
+        CHECK(stats[n].disconnections == ((n == 1) ? 1 : 0));
+        CHECK(s_counter[n].disconnected == ((n == 1) ? 1 : 0));
+        CHECK(s_trace_count(s_wm[n], INSTANCES_EVT_STA_DISCONNECTED) == disc_traced[n] + ((n == 1) ? 1 : 0));
+        CHECK(s_counter[n].foreign == 0);
+    }
+
+    //ONLY INSTANCE 1'S RECONNECT TIMER FIRES, ON ITS OWN RADIO
+    fake_idf_advance_ms(60000);
+    s_mainiter_all(8);
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        if(n == 1)
+        {
+            CHECK(s_radio[n].connects > connects[n]);
+        }
+        else
+        {
+            CHECK(s_radio[n].connects == connects[n]);
+            CHECK(s_radio[n].associated);
+        }
+    }
+    fake_idf_radio_sta_connected(&s_radio[1], s_ssid[1], s_bssid, 2, WIFI_AUTH_WPA2_PSK);
+    fake_idf_radio_sta_got_ip(&s_radio[1], INSTANCES_IP(1));
+    s_mainiter_all(8);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm[1], &stats[1]);
+    CHECK(stats[1].connections == 2 && s_wait_count(&s_counter[1].connected, 2) == 2);
+
+    CHECK(fake_idf_wifi.connects == 0 && fake_idf_wifi.scans == 0);
+
+    s_destroy_all();
+}
+
+static void* s_worker(void* pArg)
+{
+    //ONE RADIO: DROP AND RESTORE THE LINK, WAIT FOR THE MANAGER TASK EACH TIME
+
+    instances_worker_t* worker = (instances_worker_t*)pArg;
+    uint32_t cycle;
+
+    for(cycle = 0; cycle < INSTANCES_CYCLES; cycle++)
+    {
+        fake_idf_radio_sta_disconnected(worker->radio, WIFI_REASON_NO_AP_FOUND);
+        fake_idf_radio_sta_connected(worker->radio, s_ssid[worker->index], s_bssid, 1, WIFI_AUTH_WPA2_PSK);
+        fake_idf_radio_sta_got_ip(worker->radio, INSTANCES_IP(worker->index));
+        s_wait_connections(worker->wm, cycle + 2);
+    }
+    return NULL;
+}
+
+static void test_tasks(void)
+{
+    //ONE MANAGER TASK PER INSTANCE, ONE DRIVER THREAD PER RADIO
+
+    pthread_t threads[INSTANCES_N];
+    instances_worker_t workers[INSTANCES_N];
+    esp32_wifimanager_stats_t stats;
+    esp32_wifimanager_notify_stats_t notify_stats;
+    uint32_t connected;
+    uint32_t spins;
+    uint8_t n;
+
+    memset(s_radio, 0, sizeof(s_radio));
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        s_wm[n] = s_create(n);
+        CHECK(ESP32_WIFIMANAGER_CTX_StartTask(s_wm[n], 5) == ESP_OK);
+    }
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        for(spins = 0; spins < 20000 && s_radio[n].connects == 0; spins++)
+        {
+            usleep(50);
+        }
+        fake_idf_radio_sta_connected(&s_radio[n], s_ssid[n], s_bssid, 1, WIFI_AUTH_WPA2_PSK);
+        fake_idf_radio_sta_got_ip(&s_radio[n], INSTANCES_IP(n));
+        s_wait_connections(s_wm[n], 1);
+    }
+
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        workers[n].wm = s_wm[n];
+        workers[n].radio = &s_radio[n];
+        workers[n].index = n;
+        pthread_create(&threads[n], NULL, s_worker, &workers[n]);
+    }
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        pthread_join(threads[n], NULL);
+    }
+
+    //EVERY INSTANCE SAW EXACTLY ITS OWN CYCLES. ALL 4 SHARE THE NOTIFY RING,
+    //SO A CONNECTED NOTIFY MAY BE DROPPED, BUT THEN IT IS COUNTED
+    for(n = 0; n < INSTANCES_N; n++)
+    {
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm[n], &stats);
+        CHECK(stats.connections == INSTANCES_CYCLES + 1);
+        CHECK(stats.disconnections == INSTANCES_CYCLES);
+        CHECK(stats.evt_dropped == 0);
+        connected = s_wait_count(&s_counter[n].connected, INSTANCES_CYCLES + 1);
+        ESP32_WIFIMANAGER_NOTIFY_GetStats(&notify_stats);
+        CHECK(connected <= INSTANCES_CYCLES + 1);
+        CHECK(connected + notify_stats.dropped >= INSTANCES_CYCLES + 1);
+        CHECK(s_counter[n].foreign == 0);
+    }
+    CHECK(fake_idf_wifi.connects == 0);
+
+    //A RUNNING MANAGER TASK KEEPS ITS INSTANCE
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm[0]) == ESP_ERR_INVALID_STATE);
+}
+
+int main(void)
+{
+    ESP32_WIFIMANAGER_NOTIFY_Start();
+    test_bind();
+    test_namespace();
+    test_side_by_side();
+    test_tasks();
+    return fake_idf_summary("test_instances");
+}
@@ -0,0 +1,501 @@
+/**************************************************
+* HOST TEST: SUBSCRIBER NOTIFICATIONS AND INSTANCES
+* (ESP32_WIFIMANAGER_NOTIFY, ESP32_WIFIMANAGER_CTX_*)
+*
+* THE NOTIFY TASK IS A REAL THREAD. UNSUBSCRIBE AND
+* CTX_Destroy ARE RACED AGAINST CALLBACKS IN FLIGHT:
+* NO CALLBACK MAY RUN ONCE EITHER HAS RETURNED.
+* SEVERAL PRODUCERS POST AT ONCE: EVERY EVENT IS
+* EITHER DELIVERED ONCE, IN seq ORDER, OR COUNTED
+* AS DROPPED, AND SOURCE FILTERS HOLD
+*
+* DISPATCH LATENCY (POST -> LAST SUBSCRIBER RETURNED)
+* IS MEASURED ON THE HOST CLOCK FOR 1..16 SUBSCRIBERS,
+* FIRST DRAINED BY THE POSTER (BEFORE NOTIFY_Start),
+* THEN BY THE NOTIFY TASK (WAKE UP INCLUDED)
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_NOTIFY.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define NOTIFY_TEST_ROUNDS      (300)
+#define NOTIFY_TEST_PRODUCERS   (4)
+#define NOTIFY_TEST_POSTS       (20000)
+#define NOTIFY_LATENCY_POSTS    (2000)  //PER SUBSCRIBER COUNT AND MODE
+
+typedef struct
+{
+    volatile bool alive;        //CLEARED ONCE UNSUBSCRIBE RETURNS
+    volatile bool entered;
+    volatile bool inside;
+    volatile uint32_t calls;
+}subscriber_ctx_t;
+
+typedef struct
+{
+    uint32_t delivered[NOTIFY_TEST_PRODUCERS];
+    uint32_t last_seq;
+    uint32_t out_of_order;
+    uint32_t wrong_source;
+    const void* only;           //SOURCE FILTER UNDER TEST, NULL = ANY
+}counter_ctx_t;
+
+static volatile uint32_t s_late_calls;
+static uint8_t s_sources[NOTIFY_TEST_PRODUCERS];
+static volatile uint32_t s_user_cb_inside;
+static volatile uint32_t s_user_cb_done;
+static uint8_t s_latency_index[ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS];
+static uint32_t s_latency_calls;
+static uint32_t s_latency_misordered;
+static int64_t s_latency_done_ns;
+static uint32_t s_latency_inline[ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS][3];
+
+static void s_slow_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //LONG ENOUGH TO BE CAUGHT IN FLIGHT
+
+    subscriber_ctx_t* ctx = (subscriber_ctx_t*)arg;
+
+    if(!ctx->alive)
+    {
+        __atomic_add_fetch(&s_late_calls, 1, __ATOMIC_RELAXED);
+    }
+    ctx->inside = true;
+    ctx->entered = true;
+    usleep(200);
+    ctx->calls++;
+    ctx->inside = false;
+}
+
+static void s_self_unsubscribe_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //UNSUBSCRIBING FROM INSIDE THE CALLBACK MUST NOT WAIT FOR ITSELF
+
+    subscriber_ctx_t* ctx = (subscriber_ctx_t*)arg;
+
+    ctx->calls++;
+    ESP32_WIFIMANAGER_Unsubscribe(s_self_unsubscribe_cb, arg);
+    ctx->entered = true;
+}
+
+static void s_noop_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+}
+
+static void s_count_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //PER SOURCE DELIVERY COUNT. seq MUST GROW (ONE CONSUMER, RING ORDER)
+
+    counter_ctx_t* ctx = (counter_ctx_t*)arg;
+    const uint8_t* source = (const uint8_t*)notify->source;
+
+    if(notify->seq <= ctx->last_seq)
+    {
+        ctx->out_of_order++;
+    }
+    ctx->last_seq = notify->seq;
+    if(ctx->only != NULL && notify->source != ctx->only)
+    {
+        ctx->wrong_source++;
+    }
+    if(source >= s_sources && source < s_sources + NOTIFY_TEST_PRODUCERS)
+    {
+        ctx->delivered[source - s_sources]++;
+    }
+}
+
+static void* s_producer(void* arg)
+{
+    //POST AS FAST AS POSSIBLE AS ONE INSTANCE
+
+    uint32_t i;
+
+    for(i = 0; i < NOTIFY_TEST_POSTS; i++)
+    {
+        esp32_wifimanager_notify_t notify;
+
+        memset(&notify, 0, sizeof(notify));
+        notify.type = ESP32_WIFIMANAGER_NOTIFY_CONNECTED;
+        notify.source = (esp32_wifimanager_t*)arg;
+        ESP32_WIFIMANAGER_NOTIFY_Post(&notify);
+        if((i & 63) == 0)
+        {
+            usleep(1);
+        }
+    }
+    return NULL;
+}
+
+static void s_user_cb(char** data, bool connected)
+{
+    //LEGACY CB OF A NON RUNNING INSTANCE
+
+    s_user_cb_inside = 1;
+    usleep(2000);
+    s_user_cb_inside = 0;
+    s_user_cb_done++;
+}
+
+static void s_post(esp32_wifimanager_notify_type_t type, void* source)
+{
+    esp32_wifimanager_notify_t notify;
+
+    memset(&notify, 0, sizeof(notify));
+    notify.type = type;
+    notify.source = source;
+    ESP32_WIFIMANAGER_NOTIFY_Post(&notify);
+}
+
+static bool s_wait(volatile bool* flag)
+{
+    int i;
+
+    for(i = 0; i < 2000 && !*flag; i++)
+    {
+        usleep(100);
+    }
+    return *flag;
+}
+
+static int64_t s_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void s_latency_cb(const esp32_wifimanager_notify_t* notify, void* arg)
+{
+    //SUBSCRIBERS ARE CALLED IN TABLE ORDER. THE LAST ONE STAMPS THE END
+
+    uint8_t index = *(const uint8_t*)arg;
+    uint32_t calls = __atomic_load_n(&s_latency_calls, __ATOMIC_RELAXED);
+
+    if(index != calls)
+    {
+        s_latency_misordered++;
+    }
+    __atomic_store_n(&s_latency_done_ns, s_now_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&s_latency_calls, calls + 1, __ATOMIC_RELEASE);
+}
+
+static int s_cmp_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void s_latency_run(uint8_t subscribers, uint32_t result[3])
+{
+    //NOTIFY_LATENCY_POSTS POSTS, ONE AT A TIME, WITH subscribers SUBSCRIBED
+    //result: p50, p99, MAX IN ns FROM THE POST CALL TO THE LAST SUBSCRIBER RETURNING
+
+    static uint32_t ns[NOTIFY_LATENCY_POSTS];
+    esp32_wifimanager_notify_stats_t stats;
+    uint32_t run;
+    uint8_t i;
+    bool ok = true;
+    int64_t start;
+
+    for(i = 0; i < subscribers; i++)
+    {
+        s_latency_index[i] = i;
+        ok = ok && ESP32_WIFIMANAGER_Subscribe(s_latency_cb, &s_latency_index[i], ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK;
+    }
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&stats);
+    CHECK(ok && stats.subscribers == subscribers);
+
+    s_latency_misordered = 0;
+    for(run = 0; run < NOTIFY_LATENCY_POSTS && ok; run++)
+    {
+        __atomic_store_n(&s_latency_calls, 0, __ATOMIC_RELAXED);
+        start = s_now_ns();
+        s_post(ESP32_WIFIMANAGER_NOTIFY_CONNECTED, NULL);
+        while(__atomic_load_n(&s_latency_calls, __ATOMIC_ACQUIRE) < subscribers)
+        {
+            sched_yield();
+        }
+        ns[run] = (uint32_t)(__atomic_load_n(&s_latency_done_ns, __ATOMIC_RELAXED) - start);
+    }
+    //THE TASK MAY STILL BE WALKING THE REST OF THE TABLE
+    usleep(1000);
+    CHECK(s_latency_calls == subscribers);
+    CHECK(s_latency_misordered == 0);
+
+    ok = true;
+    for(i = 0; i < subscribers; i++)
+    {
+        ok = ok && ESP32_WIFIMANAGER_Unsubscribe(s_latency_cb, &s_latency_index[i]) == ESP_OK;
+    }
+    CHECK(ok);
+
+    qsort(ns, NOTIFY_LATENCY_POSTS, sizeof(ns[0]), s_cmp_u32);
+    result[0] = ns[NOTIFY_LATENCY_POSTS / 2];
+    result[1] = ns[NOTIFY_LATENCY_POSTS * 99 / 100];
+    result[2] = ns[NOTIFY_LATENCY_POSTS - 1];
+}
+
+static void test_table(void)
+{
+    //ARGUMENTS, MASK UPDATE, TABLE FULL
+
+    subscriber_ctx_t ctx[ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS + 1];
+    esp32_wifimanager_notify_stats_t stats;
+    uint8_t i;
+    bool ok = true;
+
+    CHECK(ESP32_WIFIMANAGER_Subscribe(NULL, NULL, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_Subscribe(s_noop_cb, NULL, 1u << 31) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_Unsubscribe(s_noop_cb, NULL) == ESP_ERR_NOT_FOUND);
+
+    for(i = 0; i < ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; i++)
+    {
+        ok = ok && ESP32_WIFIMANAGER_Subscribe(s_noop_cb, &ctx[i], ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK;
+    }
+    CHECK(ok);
+    CHECK(ESP32_WIFIMANAGER_Subscribe(s_noop_cb, &ctx[i], ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_ERR_NO_MEM);
+    CHECK(ESP32_WIFIMANAGER_Subscribe(s_noop_cb, &ctx[0], ESP32_WIFIMANAGER_NOTIFY_MASK(ESP32_WIFIMANAGER_NOTIFY_ROAMED)) == ESP_OK);
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&stats);
+    CHECK(stats.subscribers == ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS);
+
+    ok = true;
+    for(i = 0; i < ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; i++)
+    {
+        ok = ok && ESP32_WIFIMANAGER_Unsubscribe(s_noop_cb, &ctx[i]) == ESP_OK;
+    }
+    CHECK(ok);
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&stats);
+    CHECK(stats.subscribers == 0);
+}
+
+static void test_unsubscribe_race(void)
+{
+    //UNSUBSCRIBE BEFORE, DURING AND AFTER THE CALL. ONCE IT RETURNS THE CALLBACK
+    //IS NOT RUNNING AND NEVER RUNS AGAIN, SO ITS CONTEXT CAN BE FREED AT ONCE
+
+    subscriber_ctx_t* ctx;
+    uint32_t round;
+    uint32_t caught = 0;
+    uint32_t still_inside = 0;
+
+    for(round = 0; round < NOTIFY_TEST_ROUNDS; round++)
+    {
+        ctx = calloc(1, sizeof(subscriber_ctx_t));
+        ctx->alive = true;
+        CHECK(ESP32_WIFIMANAGER_Subscribe(s_slow_cb, ctx, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+        s_post(ESP32_WIFIMANAGER_NOTIFY_CONNECTED, NULL);
+        s_post(ESP32_WIFIMANAGER_NOTIFY_DISCONNECTED, NULL);
+
+        switch(round % 3)
+        {
+            case 0:
+                //MOST LIKELY BEFORE THE TASK GETS TO IT
+                break;
+
+            case 1:
+                //IN FLIGHT
+                s_wait(&ctx->entered);
+                break;
+
+            default:
+                usleep((round * 37) % 400);
+                break;
+        }
+
+        caught += ctx->inside;
+        CHECK(ESP32_WIFIMANAGER_Unsubscribe(s_slow_cb, ctx) == ESP_OK);
+        still_inside += ctx->inside;
+        ctx->alive = false;
+        //GIVE A WRONGLY DELIVERED CALL THE CHANCE TO SHOW UP
+        usleep(300);
+        free(ctx);
+    }
+
+    CHECK(still_inside == 0);
+    CHECK(s_late_calls == 0);
+    CHECK(caught > 0);
+}
+
+static void test_self_unsubscribe(void)
+{
+    subscriber_ctx_t ctx;
+
+    memset(&ctx, 0, sizeof(ctx));
+    CHECK(ESP32_WIFIMANAGER_Subscribe(s_self_unsubscribe_cb, &ctx, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    s_post(ESP32_WIFIMANAGER_NOTIFY_CONNECTED, NULL);
+    CHECK(s_wait(&ctx.entered));
+    s_post(ESP32_WIFIMANAGER_NOTIFY_CONNECTED, NULL);
+    usleep(2000);
+    CHECK(ctx.calls == 1);
+}
+
+static void test_multi_producer(void)
+{
+    //INSTANCES POSTING FROM THEIR OWN TASKS AT ONCE. NOTHING IS LOST UNCOUNTED,
+    //NOTHING IS DELIVERED TWICE, AND A SOURCE FILTERED SUBSCRIBER SEES ONLY ITS INSTANCE
+
+    pthread_t threads[NOTIFY_TEST_PRODUCERS];
+    counter_ctx_t all;
+    counter_ctx_t one;
+    esp32_wifimanager_notify_stats_t before;
+    esp32_wifimanager_notify_stats_t after;
+    uint32_t delivered = 0;
+    uint32_t others = 0;
+    uint8_t i;
+
+    memset(&all, 0, sizeof(all));
+    memset(&one, 0, sizeof(one));
+    one.only = &s_sources[1];
+    CHECK(ESP32_WIFIMANAGER_Subscribe(s_count_cb, &all, ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_CTX_Subscribe((esp32_wifimanager_t*)&s_sources[1], s_count_cb, &one,
+                                            ESP32_WIFIMANAGER_NOTIFY_MASK_ALL) == ESP_OK);
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&before);
+
+    for(i = 0; i < NOTIFY_TEST_PRODUCERS; i++)
+    {
+        pthread_create(&threads[i], NULL, s_producer, &s_sources[i]);
+    }
+    for(i = 0; i < NOTIFY_TEST_PRODUCERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    //LET THE NOTIFY TASK EMPTY THE RING
+    usleep(20000);
+
+    ESP32_WIFIMANAGER_NOTIFY_GetStats(&after);
+    for(i = 0; i < NOTIFY_TEST_PRODUCERS; i++)
+    {
+        delivered += all.delivered[i];
+        CHECK(all.delivered[i] > 0);
+        if(i != 1)
+        {
+            others += one.delivered[i];
+        }
+    }
+    CHECK(after.posted - before.posted == NOTIFY_TEST_PRODUCERS * NOTIFY_TEST_POSTS);
+    CHECK(delivered + (after.dropped - before.dropped) == NOTIFY_TEST_PRODUCERS * NOTIFY_TEST_POSTS);
+    CHECK(all.out_of_order == 0 && one.out_of_order == 0);
+    CHECK(one.wrong_source == 0 && others == 0);
+    CHECK(one.delivered[1] == all.delivered[1]);
+    printf("test_notify: %u producers x %u posts, %u delivered, %u dropped (ring %u)\n",
+            NOTIFY_TEST_PRODUCERS, NOTIFY_TEST_POSTS, delivered, after.dropped - before.dropped,
+            ESP32_WIFIMANAGER_NOTIFY_RING_LEN);
+
+    CHECK(ESP32_WIFIMANAGER_Unsubscribe(s_count_cb, &all) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_Unsubscribe(s_count_cb, &one) == ESP_OK);
+}
+
+static void test_latency_inline(void)
+{
+    //BEFORE NOTIFY_Start: POST DRAINS THE RING ITSELF, SO THIS IS THE DISPATCH ALONE
+
+    uint8_t n;
+
+    fake_idf_realtime = true;
+    for(n = 1; n <= ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; n++)
+    {
+        s_latency_run(n, s_latency_inline[n - 1]);
+    }
+    fake_idf_realtime = false;
+}
+
+static void test_latency_task(void)
+{
+    //THE SAME THROUGH THE NOTIFY TASK, WHICH ADDS ONE WAKE UP PER POST
+
+    uint32_t task[3];
+    uint8_t n;
+
+    fake_idf_realtime = true;
+    printf("test_notify: dispatch latency, post -> last subscriber returned (ns)\n");
+    printf("  %11s %26s %26s\n", "subscribers", "drained by poster", "notify task");
+    printf("  %11s %8s %8s %8s %8s %8s %8s\n", "", "p50", "p99", "max", "p50", "p99", "max");
+    for(n = 1; n <= ESP32_WIFIMANAGER_NOTIFY_MAX_SUBSCRIBERS; n++)
+    {
+        s_latency_run(n, task);
+        printf("  %11u %8u %8u %8u %8u %8u %8u\n", n,
+                s_latency_inline[n - 1][0], s_latency_inline[n - 1][1], s_latency_inline[n - 1][2],
+                task[0], task[1], task[2]);
+    }
+    fake_idf_realtime = false;
+}
+
+static void test_shared_radio(void)
+{
+    //FIRST SetParameters BINDS THE ESP32 RADIO. ANOTHER INSTANCE ON IT IS REFUSED
+
+    esp32_wifimanager_t* def = ESP32_WIFIMANAGER_CTX_Default();
+    esp32_wifimanager_t* other = ESP32_WIFIMANAGER_CTX_Create();
+    esp32_wifimanager_credential_hardcoded_t cred = {.ssid_name = "home", .ssid_pwd = "password"};
+    esp32_wifimanager_trace_record_t record;
+    esp32_wifimanager_stats_t stats;
+    bool in_flight;
+
+    CHECK(other != NULL);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(NULL) == ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(def) == ESP_ERR_INVALID_ARG);
+
+    //NEITHER STARTED YET
+    CHECK(ESP32_WIFIMANAGER_CTX_StartTask(def, 5) == ESP_ERR_INVALID_STATE);
+
+    ESP32_WIFIMANAGER_SetParameters(ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                    ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                    &cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetParameters(other,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &cred, 2, "test");
+
+    //REFUSED INSTANCE NEVER RUNS: NO TASK, NO REPLAY, MAINITER DOES NOTHING
+    memset(&record, 0, sizeof(record));
+    CHECK(ESP32_WIFIMANAGER_CTX_StartTask(other, 5) == ESP_ERR_INVALID_STATE);
+    CHECK(ESP32_WIFIMANAGER_CTX_Replay(other, &record, 1, fake_idf_set_time) == ESP_ERR_INVALID_STATE);
+    ESP32_WIFIMANAGER_CTX_Mainiter(other);
+    ESP32_WIFIMANAGER_CTX_GetStats(other, &stats);
+    CHECK(stats.wakeups == 0 && stats.mainiter_ticks == 0);
+    CHECK(fake_idf_wifi.connects == 0);
+
+    //THE DEFAULT INSTANCE IS NEVER FREED
+    ESP32_WIFIMANAGER_Mainiter();
+    ESP32_WIFIMANAGER_Mainiter();
+    CHECK(fake_idf_wifi.connects == 1);
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(def) == ESP_ERR_INVALID_ARG);
+
+    //DESTROY WAITS FOR THE LEGACY CB OF THAT INSTANCE IF IT IS RUNNING
+    ESP32_WIFIMANAGER_CTX_SetUserCbFunction(other, s_user_cb);
+    s_post(ESP32_WIFIMANAGER_NOTIFY_CONNECTED, other);
+    while(!s_user_cb_inside && s_user_cb_done == 0)
+    {
+        usleep(50);
+    }
+    in_flight = s_user_cb_inside;
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(other) == ESP_OK);
+    CHECK(s_user_cb_done == 1 && !s_user_cb_inside);
+    if(!in_flight)
+    {
+        printf("test_notify: legacy cb finished before Destroy, wait not exercised\n");
+    }
+}
+
+int main(void)
+{
+    test_latency_inline();
+    ESP32_WIFIMANAGER_NOTIFY_Start();
+    test_table();
+    test_unsubscribe_race();
+    test_self_unsubscribe();
+    test_multi_producer();
+    test_latency_task();
+    test_shared_radio();
+    return fake_idf_summary("test_notify");
+}
@@ -0,0 +1,185 @@
+/**************************************************
+* HOST TEST: PROVISIONING PAYLOAD PARSER
+* (ESP32_WIFIMANAGER_PARSER)
+*
+* EVERY INPUT IS FED AT EVERY CHUNK SIZE FROM ONE
+* BYTE TO THE WHOLE PAYLOAD AND MUST GIVE THE SAME
+* RESULT
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER_PARSER.h"
+#include <string.h>
+
+static esp32_wifimanager_parser_status_t s_parse_chunked(esp32_wifimanager_parser_format_t format,
+                                                        const uint8_t* data,
+                                                        size_t len,
+                                                        size_t chunk,
+                                                        esp32_wifimanager_provision_data_t* out)
+{
+    esp32_wifimanager_parser_t parser;
+    size_t pos;
+    size_t n;
+
+    ESP32_WIFIMANAGER_PARSER_Init(&parser, format, out);
+    for(pos = 0; pos < len; pos += n)
+    {
+        n = (len - pos < chunk) ? (len - pos) : chunk;
+        ESP32_WIFIMANAGER_PARSER_Feed(&parser, data + pos, n);
+    }
+    return ESP32_WIFIMANAGER_PARSER_Finish(&parser);
+}
+
+static esp32_wifimanager_parser_status_t s_parse(esp32_wifimanager_parser_format_t format,
+                                                const uint8_t* data,
+                                                size_t len,
+                                                esp32_wifimanager_provision_data_t* out)
+{
+    //WHOLE PAYLOAD RESULT IN out. FALSE CHECK IF ANY CHUNKING DISAGREES
+
+    esp32_wifimanager_provision_data_t other;
+    esp32_wifimanager_parser_status_t status;
+    size_t chunk;
+    bool same = true;
+
+    status = s_parse_chunked(format, data, len, (len == 0) ? 1 : len, out);
+    for(chunk = 1; chunk < len; chunk++)
+    {
+        same = same &&
+                s_parse_chunked(format, data, len, chunk, &other) == status &&
+                memcmp(&other, out, sizeof(other)) == 0;
+    }
+    CHECK(same);
+    return status;
+}
+
+static esp32_wifimanager_parser_status_t s_form(const char* text, esp32_wifimanager_provision_data_t* out)
+{
+    return s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_FORM, (const uint8_t*)text, strlen(text), out);
+}
+
+static void test_form(void)
+{
+    //URL ENCODED FORM AS POSTED BY THE PORTAL
+
+    esp32_wifimanager_provision_data_t out;
+    char text[256];
+
+    CHECK(s_form("ssid=home&pwd=secret123", &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strcmp(out.ssid, "home") == 0 && strcmp(out.pwd, "secret123") == 0);
+
+    //DECODING: + IS SPACE, %xx IN EITHER CASE, LITERAL %26 IS NOT A SEPARATOR
+    CHECK(s_form("ssid=My+Net%21&pwd=a%26b%3dc%2B&f1=x&f4=%e2%82%ac", &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strcmp(out.ssid, "My Net!") == 0);
+    CHECK(strcmp(out.pwd, "a&b=c+") == 0);
+    CHECK(strcmp(out.custom[1], "x") == 0 && out.custom[0][0] == 0);
+    CHECK(strcmp(out.custom[4], "\xe2\x82\xac") == 0);
+
+    //UNKNOWN / OVERLONG KEYS AND OUT OF RANGE FIELDS ARE SKIPPED, LAST KEY WINS
+    CHECK(s_form("submit=Save&ssid=a&f9=z&password=p&ssid=b&&flag&pwd=", &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strcmp(out.ssid, "b") == 0 && out.pwd[0] == 0);
+
+    //BAD ESCAPE, CUT OFF ESCAPE, MISSING SSID
+    CHECK(s_form("ssid=a%zz", &out) == ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX);
+    CHECK(s_form("ssid=a%2", &out) == ESP32_WIFIMANAGER_PARSER_ERR_INCOMPLETE);
+    CHECK(s_form("pwd=secret123", &out) == ESP32_WIFIMANAGER_PARSER_ERR_NO_SSID);
+    CHECK(s_form("", &out) == ESP32_WIFIMANAGER_PARSER_ERR_NO_SSID);
+
+    //LONGEST FITTING SSID, THEN ONE MORE (ENCODED) BYTE
+    memset(text, 0, sizeof(text));
+    strcpy(text, "ssid=");
+    memset(text + 5, 's', ESP32_WIFIMANAGER_SSID_LEN);
+    CHECK(s_form(text, &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strlen(out.ssid) == ESP32_WIFIMANAGER_SSID_LEN);
+    strcat(text, "%41");
+    CHECK(s_form(text, &out) == ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW);
+}
+
+static void test_tlv(void)
+{
+    //BINARY TLV (BLE / SMARTCONFIG STYLE)
+
+    esp32_wifimanager_provision_data_t out;
+    uint8_t buf[400];
+    size_t len;
+    static const uint8_t ok[] = {
+        0x01, 4, 'h', 'o', 'm', 'e',
+        0x7F, 3, 0xAA, 0xBB, 0xCC,              //UNKNOWN, SKIPPED
+        0x02, 6, 'p', 'a', '&', '=', 0x00, 'x', //BINARY SAFE, NOT DECODED
+        0x12, 0,                                //EMPTY CUSTOM FIELD 2
+        0x13, 2, 'o', 'k'
+    };
+    static const uint8_t no_ssid[] = {0x02, 2, 'p', 'w'};
+    static const uint8_t cut_len[] = {0x01, 4, 'h', 'o', 'm', 'e', 0x02};
+    static const uint8_t cut_value[] = {0x01, 4, 'h', 'o'};
+
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, ok, sizeof(ok), &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strcmp(out.ssid, "home") == 0);
+    CHECK(memcmp(out.pwd, "pa&=\0x", 6) == 0);
+    CHECK(out.custom[2][0] == 0 && strcmp(out.custom[3], "ok") == 0);
+
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, no_ssid, sizeof(no_ssid), &out) ==
+            ESP32_WIFIMANAGER_PARSER_ERR_NO_SSID);
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, cut_len, sizeof(cut_len), &out) ==
+            ESP32_WIFIMANAGER_PARSER_ERR_INCOMPLETE);
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, cut_value, sizeof(cut_value), &out) ==
+            ESP32_WIFIMANAGER_PARSER_ERR_INCOMPLETE);
+
+    //LENGTH BYTE LARGER THAN THE FIELD IS REFUSED BEFORE ANY VALUE BYTE
+    len = 0;
+    buf[len++] = ESP32_WIFIMANAGER_PARSER_TLV_PWD;
+    buf[len++] = ESP32_WIFIMANAGER_SSID_PWD_LEN + 1;
+    memset(&buf[len], 'p', ESP32_WIFIMANAGER_SSID_PWD_LEN + 1);
+    len += ESP32_WIFIMANAGER_SSID_PWD_LEN + 1;
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, buf, len, &out) == ESP32_WIFIMANAGER_PARSER_ERR_OVERFLOW);
+
+    //FULL LENGTH PASSWORD FITS. AN UNKNOWN TYPE MAY BE UP TO 255 LONG
+    buf[1] = ESP32_WIFIMANAGER_SSID_PWD_LEN;
+    len = 2 + ESP32_WIFIMANAGER_SSID_PWD_LEN;
+    buf[len++] = 0x20;
+    buf[len++] = 255;
+    memset(&buf[len], 0xFF, 255);
+    len += 255;
+    buf[len++] = ESP32_WIFIMANAGER_PARSER_TLV_SSID;
+    buf[len++] = 1;
+    buf[len++] = 's';
+    CHECK(s_parse(ESP32_WIFIMANAGER_PARSER_FORMAT_TLV, buf, len, &out) == ESP32_WIFIMANAGER_PARSER_OK);
+    CHECK(strlen(out.pwd) == ESP32_WIFIMANAGER_SSID_PWD_LEN && strcmp(out.ssid, "s") == 0);
+}
+
+static void test_error_is_sticky(void)
+{
+    //INPUT AFTER AN ERROR IS IGNORED
+
+    esp32_wifimanager_parser_t parser;
+    esp32_wifimanager_provision_data_t out;
+
+    ESP32_WIFIMANAGER_PARSER_Init(&parser, ESP32_WIFIMANAGER_PARSER_FORMAT_FORM, &out);
+    CHECK(ESP32_WIFIMANAGER_PARSER_Feed(&parser, (const uint8_t*)"ssid=%g", 7) == ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX);
+    CHECK(ESP32_WIFIMANAGER_PARSER_Feed(&parser, (const uint8_t*)"&ssid=ok", 8) == ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX);
+    CHECK(ESP32_WIFIMANAGER_PARSER_Finish(&parser) == ESP32_WIFIMANAGER_PARSER_ERR_SYNTAX);
+    CHECK(out.ssid[0] == 0);
+}
+
+static void test_copy_string(void)
+{
+    //REFUSED, NOT TRUNCATED
+
+    char dst[5] = "keep";
+
+    CHECK(!ESP32_WIFIMANAGER_PARSER_CopyString(dst, sizeof(dst), "12345"));
+    CHECK(strcmp(dst, "keep") == 0);
+    CHECK(ESP32_WIFIMANAGER_PARSER_CopyString(dst, sizeof(dst), "1234"));
+    CHECK(strcmp(dst, "1234") == 0);
+    CHECK(!ESP32_WIFIMANAGER_PARSER_CopyString(dst, sizeof(dst), NULL));
+    CHECK(!ESP32_WIFIMANAGER_PARSER_CopyString(dst, 0, ""));
+}
+
+int main(void)
+{
+    test_form();
+    test_tlv();
+    test_error_is_sticky();
+    test_copy_string();
+    return fake_idf_summary("test_parser");
+}
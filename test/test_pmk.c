@@ -0,0 +1,293 @@
+/**************************************************
+* HOST TEST: WPA2 PMK CACHE (ESP32_WIFIMANAGER_PMK)
+*
+* PBKDF2 KNOWN ANSWERS FROM IEEE 802.11i-2004 H.4,
+* CACHE KEYING / REPLACEMENT, THE BACKGROUND JOBS AND
+* THE MANAGER KEEPING THE PMK OUT OF THE DRIVER FLASH
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_PMK.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static volatile int s_done_calls;
+static esp32_wifimanager_pmk_job_t s_job;
+
+static void s_hex(const uint8_t* pmk, char* out)
+{
+    ESP32_WIFIMANAGER_PMK_ToHex(pmk, (uint8_t*)out);
+    out[2 * ESP32_WIFIMANAGER_PMK_LEN] = 0;
+}
+
+static void s_done_cb(void* arg)
+{
+    __atomic_add_fetch(&s_done_calls, 1, __ATOMIC_RELAXED);
+    *(int*)arg = 1;
+}
+
+static esp_err_t s_take(esp32_wifimanager_pmk_job_t* job, uint8_t* pmk, int64_t* us)
+{
+    //WAIT FOR THE JOB TASK (REAL THREAD)
+
+    esp_err_t err;
+    int spins;
+
+    for(spins = 0; spins < 1000; spins++)
+    {
+        err = ESP32_WIFIMANAGER_PMK_DeriveTake(job, pmk, us);
+        if(err != ESP_ERR_INVALID_STATE)
+        {
+            return err;
+        }
+        vTaskDelay(1);
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+static void test_known_answers(void)
+{
+    //IEEE 802.11i-2004 H.4.2 TEST VECTORS
+
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    char hex[2 * ESP32_WIFIMANAGER_PMK_LEN + 1];
+
+    CHECK(ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"IEEE", 4,
+                                        (const uint8_t*)"password", 8, pmk) == ESP_OK);
+    s_hex(pmk, hex);
+    CHECK(strcmp(hex, "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e") == 0);
+
+    CHECK(ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"ThisIsASSID", 11,
+                                        (const uint8_t*)"ThisIsAPassword", 15, pmk) == ESP_OK);
+    s_hex(pmk, hex);
+    CHECK(strcmp(hex, "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af") == 0);
+}
+
+static void test_is_passphrase(void)
+{
+    //8..63 CHARACTERS ONLY. 64 IS A RAW PSK, 0 IS OPEN
+
+    uint8_t pwd[64];
+
+    memset(pwd, 0, sizeof(pwd));
+    CHECK(!ESP32_WIFIMANAGER_PMK_IsPassphrase(pwd, sizeof(pwd)));
+    memcpy(pwd, "1234567", 7);
+    CHECK(!ESP32_WIFIMANAGER_PMK_IsPassphrase(pwd, sizeof(pwd)));
+    pwd[7] = '8';
+    CHECK(ESP32_WIFIMANAGER_PMK_IsPassphrase(pwd, sizeof(pwd)));
+    memset(pwd, 'a', 63);
+    CHECK(ESP32_WIFIMANAGER_PMK_IsPassphrase(pwd, sizeof(pwd)));
+    memset(pwd, 'a', 64);
+    CHECK(!ESP32_WIFIMANAGER_PMK_IsPassphrase(pwd, sizeof(pwd)));
+}
+
+static void test_cache(void)
+{
+    //TAG KEYING, SAME SSID REPLACEMENT, LRU EVICTION
+
+    esp32_wifimanager_pmk_cache_t cache;
+    uint8_t tag[ESP32_WIFIMANAGER_PMK_CACHE_SIZE + 1][ESP32_WIFIMANAGER_PMK_TAG_LEN];
+    uint8_t other[ESP32_WIFIMANAGER_PMK_TAG_LEN];
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    uint8_t out[ESP32_WIFIMANAGER_PMK_LEN];
+    char ssid[8];
+    uint8_t i;
+
+    memset(&cache, 0, sizeof(cache));
+
+    //SSID LENGTH IS PART OF THE TAG, SO ("ab", "c...") != ("a", "bc...")
+    ESP32_WIFIMANAGER_PMK_Tag((const uint8_t*)"ab", 2, (const uint8_t*)"cdefghij", 8, tag[0]);
+    ESP32_WIFIMANAGER_PMK_Tag((const uint8_t*)"a", 1, (const uint8_t*)"bcdefghij", 9, other);
+    CHECK(memcmp(tag[0], other, sizeof(other)) != 0);
+
+    for(i = 0; i <= ESP32_WIFIMANAGER_PMK_CACHE_SIZE; i++)
+    {
+        snprintf(ssid, sizeof(ssid), "net%u", i);
+        ESP32_WIFIMANAGER_PMK_Tag((const uint8_t*)ssid, strlen(ssid), (const uint8_t*)"password", 8, tag[i]);
+    }
+
+    //FILL THE CACHE, TOUCH ENTRY 0, ADD ONE MORE: ENTRY 1 (LRU) GOES
+    for(i = 0; i < ESP32_WIFIMANAGER_PMK_CACHE_SIZE; i++)
+    {
+        memset(pmk, i + 1, sizeof(pmk));
+        ESP32_WIFIMANAGER_PMK_Insert(&cache, tag[i], 100 + i, pmk);
+    }
+    CHECK(ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[0], out) && out[0] == 1);
+    memset(pmk, 0xEE, sizeof(pmk));
+    ESP32_WIFIMANAGER_PMK_Insert(&cache, tag[ESP32_WIFIMANAGER_PMK_CACHE_SIZE], 200, pmk);
+    CHECK(ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[0], out));
+    CHECK(!ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[1], out));
+    CHECK(ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[ESP32_WIFIMANAGER_PMK_CACHE_SIZE], out) && out[0] == 0xEE);
+
+    //NEW PASSPHRASE FOR A CACHED SSID REPLACES ITS ENTRY
+    ESP32_WIFIMANAGER_PMK_Tag((const uint8_t*)"net2", 4, (const uint8_t*)"changed!", 8, other);
+    CHECK(!ESP32_WIFIMANAGER_PMK_Lookup(&cache, other, out));
+    memset(pmk, 0x22, sizeof(pmk));
+    ESP32_WIFIMANAGER_PMK_Insert(&cache, other, 102, pmk);
+    CHECK(ESP32_WIFIMANAGER_PMK_Lookup(&cache, other, out) && out[0] == 0x22);
+    CHECK(!ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[2], out));
+    CHECK(ESP32_WIFIMANAGER_PMK_Lookup(&cache, tag[3], out));
+}
+
+static void test_background_job(void)
+{
+    //SAME KEY AS THE SYNCHRONOUS PATH, ONE JOB AT A TIME, DONE CALLED ONCE
+
+    uint8_t expect[ESP32_WIFIMANAGER_PMK_LEN];
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    uint8_t long_ssid[ESP32_WIFIMANAGER_SSID_LEN + 1];
+    int64_t us = -1;
+    int flag = 0;
+
+    ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"IEEE", 4, (const uint8_t*)"password", 8, expect);
+
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveTake(&s_job, pmk, &us) == ESP_ERR_INVALID_STATE);
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, (const uint8_t*)"IEEE", 4,
+                                            (const uint8_t*)"password", 8,
+                                            s_done_cb, &flag) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, (const uint8_t*)"IEEE", 4,
+                                            (const uint8_t*)"password", 8,
+                                            s_done_cb, &flag) == ESP_ERR_INVALID_STATE);
+    CHECK(s_take(&s_job, pmk, &us) == ESP_OK);
+    CHECK(memcmp(pmk, expect, sizeof(pmk)) == 0);
+    CHECK(us >= 0);
+    CHECK(flag == 1 && s_done_calls == 1);
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveTake(&s_job, pmk, &us) == ESP_ERR_INVALID_STATE);
+
+    //OVERSIZED INPUT IS REFUSED, NOT TRUNCATED
+    memset(long_ssid, 'x', sizeof(long_ssid));
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, long_ssid, sizeof(long_ssid),
+                                            (const uint8_t*)"password", 8,
+                                            NULL, NULL) == ESP_ERR_INVALID_ARG);
+
+    //NO TASK: THE JOB SLOT IS FREED AGAIN
+    fake_idf_tasks = false;
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, (const uint8_t*)"IEEE", 4,
+                                            (const uint8_t*)"password", 8,
+                                            NULL, NULL) == ESP_ERR_NO_MEM);
+    fake_idf_tasks = true;
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, (const uint8_t*)"IEEE", 4,
+                                            (const uint8_t*)"password", 8,
+                                            NULL, NULL) == ESP_OK);
+    CHECK(s_take(&s_job, pmk, &us) == ESP_OK);
+    CHECK(memcmp(pmk, expect, sizeof(pmk)) == 0);
+}
+
+static void test_parallel_jobs(void)
+{
+    //TWO OWNERS DERIVE AT THE SAME TIME, EACH GETS ITS OWN KEY
+
+    esp32_wifimanager_pmk_job_t other;
+    uint8_t expect[2][ESP32_WIFIMANAGER_PMK_LEN];
+    uint8_t pmk[ESP32_WIFIMANAGER_PMK_LEN];
+    int64_t us;
+
+    memset(&other, 0, sizeof(other));
+    ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"IEEE", 4, (const uint8_t*)"password", 8, expect[0]);
+    ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"ThisIsASSID", 11,
+                                    (const uint8_t*)"ThisIsAPassword", 15, expect[1]);
+
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&s_job, (const uint8_t*)"IEEE", 4,
+                                            (const uint8_t*)"password", 8,
+                                            NULL, NULL) == ESP_OK);
+    CHECK(ESP32_WIFIMANAGER_PMK_DeriveStart(&other, (const uint8_t*)"ThisIsASSID", 11,
+                                            (const uint8_t*)"ThisIsAPassword", 15,
+                                            NULL, NULL) == ESP_OK);
+    CHECK(s_take(&other, pmk, &us) == ESP_OK);
+    CHECK(memcmp(pmk, expect[1], sizeof(pmk)) == 0);
+    CHECK(s_take(&s_job, pmk, &us) == ESP_OK);
+    CHECK(memcmp(pmk, expect[0], sizeof(pmk)) == 0);
+}
+
+static void s_reconnect(void)
+{
+    //DROP THE LINK, RUN THE MANAGER UNTIL IT STARTS THE NEXT CONNECT
+
+    uint32_t connects = fake_idf_wifi.connects;
+    int i;
+
+    fake_idf_sta_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+    for(i = 0; i < 600 && fake_idf_wifi.connects == connects; i++)
+    {
+        fake_idf_advance_ms(100);
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+}
+
+static void s_link_up(void)
+{
+    //ASSOCIATED WITH A WPA2-PSK AP, GOT AN ADDRESS
+
+    static const uint8_t bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+    int i;
+
+    fake_idf_sta_connected("IEEE", bssid, 6, WIFI_AUTH_WPA2_PSK);
+    fake_idf_sta_got_ip(0x0101A8C0);
+    for(i = 0; i < 8; i++)
+    {
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+}
+
+static void test_manager_ram_only(void)
+{
+    //HARDCODED SOURCE KEEPS THE IDF FLASH STORAGE. THE PMK MAY ONLY REACH
+    //THE DRIVER'S RAM COPY, FLASH KEEPS THE PASSPHRASE
+
+    esp32_wifimanager_credential_hardcoded_t cred = {.ssid_name = "IEEE", .ssid_pwd = "password"};
+    esp32_wifimanager_stats_t stats;
+    char hex[2 * ESP32_WIFIMANAGER_PMK_LEN + 1];
+    uint8_t expect[ESP32_WIFIMANAGER_PMK_LEN];
+    int i;
+
+    ESP32_WIFIMANAGER_PMK_Derive((const uint8_t*)"IEEE", 4, (const uint8_t*)"password", 8, expect);
+    s_hex(expect, hex);
+
+    ESP32_WIFIMANAGER_SetParameters(ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                    ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                    &cred, 2, "test");
+    ESP32_WIFIMANAGER_SetPmkCache(true);
+    for(i = 0; i < 8; i++)
+    {
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+    CHECK(fake_idf_wifi.connects == 1);
+    s_link_up();
+
+    //AUTHMODE NOW KNOWN. THIS CONNECT STILL USES THE PASSPHRASE AND STARTS THE JOB
+    s_reconnect();
+    CHECK(memcmp(fake_idf_wifi.sta.sta.password, "password", 9) == 0);
+    for(i = 0; i < 1000; i++)
+    {
+        ESP32_WIFIMANAGER_Mainiter();
+        ESP32_WIFIMANAGER_GetStats(&stats);
+        if(stats.pmk_derived != 0)
+        {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    CHECK(stats.pmk_derived == 1);
+    s_link_up();
+
+    //CACHE HIT. DRIVER RAM GETS THE PMK, FLASH NEVER DOES
+    s_reconnect();
+    ESP32_WIFIMANAGER_GetStats(&stats);
+    CHECK(stats.pmk_hits == 1);
+    CHECK(memcmp(fake_idf_wifi.sta.sta.password, hex, 2 * ESP32_WIFIMANAGER_PMK_LEN) == 0);
+    CHECK(memcmp(fake_idf_wifi.sta_flash.sta.password, "password", 9) == 0);
+    CHECK(fake_idf_wifi.storage == WIFI_STORAGE_FLASH);
+}
+
+int main(void)
+{
+    test_known_answers();
+    test_is_passphrase();
+    test_cache();
+    test_background_job();
+    test_parallel_jobs();
+    test_manager_ram_only();
+    return fake_idf_summary("test_pmk");
+}
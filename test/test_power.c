@@ -0,0 +1,315 @@
+/**************************************************
+* HOST TEST: POWER POLICY (ESP32_WIFIMANAGER_POWER)
+*
+* THE MODEL: DUTY CYCLE, AVERAGE POWER AND LISTEN
+* INTERVAL PER POLICY, DTIM AND LISTEN SETTING. THE
+* LEVEL PICKED FOR ACTIVITY HINTS AND WEAK LINKS
+*
+* THEN A MANAGER ON A FAKE RADIO, SCRIPTED THROUGH
+* IDLE, AN ACTIVITY HINT, A WEAK SIGNAL AND A LINK
+* DROP: CHECKS THE MODEM SLEEP TYPE THE DRIVER IS
+* GIVEN, THE TIME AND ENERGY BOOKED PER LEVEL, AND
+* THAT THE REPORTED AVERAGE MATCHES THE ENERGY. LAST,
+* ONE CONNECTED HOUR PER POLICY
+*
+* TASKS ARE OFF, SO EVERY STEP IS DETERMINISTIC
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_POWER.h"
+#include <stdio.h>
+#include <string.h>
+
+#define POWER_STEP_MS           (100)
+#define POWER_IP                (0x0A01A8C0)
+#define POWER_STRONG            (-60)
+#define POWER_WEAK              (-85)
+#define POWER_HOUR_MS           (3600000)
+#define POWER_US_PER_HOUR       (3600000000LL)
+
+//ONE MODEL POINT
+typedef struct
+{
+    esp32_wifimanager_power_policy_t policy;
+    uint8_t dtim_period;
+    uint8_t listen_interval;
+    uint8_t listen;                     //ESP32_WIFIMANAGER_POWER_ListenInterval
+    uint16_t duty_permille;
+    uint32_t avg_mw;
+}power_model_case_t;
+
+static const power_model_case_t s_model_cases[] = {
+    //ALWAYS ON: ACTIVE CURRENT
+    {ESP32_WIFIMANAGER_POWER_PERFORMANCE, 1, 3, 3, 1000, 330},
+    {ESP32_WIFIMANAGER_POWER_PERFORMANCE, 3, 10, 12, 1000, 330},
+    //EVERY DTIM BEACON: 4 MS OF 102.4
+    {ESP32_WIFIMANAGER_POWER_BALANCED, 1, 3, 3, 39, 76},
+    {ESP32_WIFIMANAGER_POWER_BALANCED, 0, 0, 1, 39, 76},
+    {ESP32_WIFIMANAGER_POWER_BALANCED, 3, 10, 12, 13, 69},
+    //EVERY LISTEN INTERVAL, WHOLE DTIMS
+    {ESP32_WIFIMANAGER_POWER_MAX_SAVE, 1, 3, 3, 13, 69},
+    {ESP32_WIFIMANAGER_POWER_MAX_SAVE, 1, 1, 1, 39, 76},
+    {ESP32_WIFIMANAGER_POWER_MAX_SAVE, 3, 10, 12, 3, 66},
+    {ESP32_WIFIMANAGER_POWER_MAX_SAVE, 2, 255, 254, 0, 66},
+    {ESP32_WIFIMANAGER_POWER_MAX_SAVE, 0, 0, 1, 39, 76},
+};
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_t* s_wm;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static uint32_t s_connects;
+static wifi_ps_type_t s_ps;
+static char s_seen[16];
+static uint8_t s_seen_len;
+
+static void test_model(void)
+{
+    //DUTY, POWER AND LISTEN INTERVAL FOR EACH SETTING
+
+    esp32_wifimanager_power_t power = ESP32_WIFIMANAGER_POWER_DEFAULT();
+    const power_model_case_t* c;
+    size_t i;
+
+    for(i = 0; i < sizeof(s_model_cases) / sizeof(s_model_cases[0]); i++)
+    {
+        c = &s_model_cases[i];
+        power.dtim_period = c->dtim_period;
+        power.listen_interval = c->listen_interval;
+        CHECK(ESP32_WIFIMANAGER_POWER_ListenInterval(&power) == c->listen);
+        CHECK(ESP32_WIFIMANAGER_POWER_DutyPermille(&power, c->policy) == c->duty_permille);
+        CHECK(ESP32_WIFIMANAGER_POWER_AvgMw(c->duty_permille) == c->avg_mw);
+        CHECK(ESP32_WIFIMANAGER_PowerEstimate(&power, c->policy) == c->avg_mw);
+    }
+
+    //THE ENDS OF THE SCALE, AND THE DEFAULTS
+    CHECK(ESP32_WIFIMANAGER_POWER_AvgMw(0) == ESP32_WIFIMANAGER_POWER_SLEEP_MA * ESP32_WIFIMANAGER_POWER_SUPPLY_MV / 1000);
+    CHECK(ESP32_WIFIMANAGER_POWER_AvgMw(1000) == ESP32_WIFIMANAGER_POWER_ACTIVE_MA * ESP32_WIFIMANAGER_POWER_SUPPLY_MV / 1000);
+    CHECK(ESP32_WIFIMANAGER_PowerEstimate(NULL, ESP32_WIFIMANAGER_POWER_BALANCED) == 76);
+
+    CHECK(ESP32_WIFIMANAGER_POWER_PsType(ESP32_WIFIMANAGER_POWER_PERFORMANCE) == WIFI_PS_NONE);
+    CHECK(ESP32_WIFIMANAGER_POWER_PsType(ESP32_WIFIMANAGER_POWER_BALANCED) == WIFI_PS_MIN_MODEM);
+    CHECK(ESP32_WIFIMANAGER_POWER_PsType(ESP32_WIFIMANAGER_POWER_MAX_SAVE) == WIFI_PS_MAX_MODEM);
+}
+
+static void test_effective(void)
+{
+    //BUSY WINS, A WEAK LINK STEPS BACK ONE LEVEL, UNKNOWN RSSI DOES NOT
+
+    esp32_wifimanager_power_t power = ESP32_WIFIMANAGER_POWER_DEFAULT();
+
+    power.policy = ESP32_WIFIMANAGER_POWER_MAX_SAVE;
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, 0, false) == ESP32_WIFIMANAGER_POWER_MAX_SAVE);
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, POWER_STRONG * 16, false) == ESP32_WIFIMANAGER_POWER_MAX_SAVE);
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, -78 * 16, false) == ESP32_WIFIMANAGER_POWER_MAX_SAVE);
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, -78 * 16 - 1, false) == ESP32_WIFIMANAGER_POWER_BALANCED);
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, POWER_STRONG * 16, true) == ESP32_WIFIMANAGER_POWER_PERFORMANCE);
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, POWER_WEAK * 16, true) == ESP32_WIFIMANAGER_POWER_PERFORMANCE);
+
+    power.policy = ESP32_WIFIMANAGER_POWER_BALANCED;
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, POWER_WEAK * 16, false) == ESP32_WIFIMANAGER_POWER_PERFORMANCE);
+    power.policy = ESP32_WIFIMANAGER_POWER_PERFORMANCE;
+    CHECK(ESP32_WIFIMANAGER_POWER_Effective(&power, POWER_WEAK * 16, false) == ESP32_WIFIMANAGER_POWER_PERFORMANCE);
+}
+
+static void s_step(uint32_t ms)
+{
+    //RUN THE MANAGER, JOIN ON EVERY CONNECT, RECORD EVERY MODEM SLEEP CHANGE
+    //AS 'P'ERFORMANCE, 'B'ALANCED, 'M'AX SAVE
+
+    uint32_t t;
+
+    for(t = 0; t < ms; t += POWER_STEP_MS)
+    {
+        fake_idf_advance_ms(POWER_STEP_MS);
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+        if(s_radio.connects != s_connects)
+        {
+            s_connects = s_radio.connects;
+            fake_idf_radio_sta_connected(&s_radio, "home", s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+            fake_idf_radio_sta_got_ip(&s_radio, POWER_IP);
+        }
+        ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+        if(s_radio.ps != s_ps && s_seen_len < sizeof(s_seen) - 1)
+        {
+            s_ps = s_radio.ps;
+            s_seen[s_seen_len++] = (s_ps == WIFI_PS_MAX_MODEM) ? 'M' :
+                                    (s_ps == WIFI_PS_MIN_MODEM) ? 'B' : 'P';
+            s_seen[s_seen_len] = '\0';
+        }
+    }
+}
+
+static void s_create(esp32_wifimanager_power_policy_t policy)
+{
+    //FRESH INSTANCE WITH A POWER POLICY, STRONG SIGNAL, NOT STARTED YET
+
+    esp32_wifimanager_power_t power = ESP32_WIFIMANAGER_POWER_DEFAULT();
+
+    fake_idf_nvs_erase_all();
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_radio.rssi = POWER_STRONG;
+    s_connects = 0;
+    s_ps = s_radio.ps;
+    s_seen_len = 0;
+    s_seen[0] = '\0';
+
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    power.policy = policy;
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetPower(s_wm, &power);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+}
+
+static double s_energy_mwh(const esp32_wifimanager_stats_t* stats, esp32_wifimanager_power_policy_t level)
+{
+    //TIME AT A LEVEL x THE MODEL'S POWER FOR IT
+
+    esp32_wifimanager_power_t power = ESP32_WIFIMANAGER_POWER_DEFAULT();
+
+    return (double)stats->power_level_us[level] * ESP32_WIFIMANAGER_PowerEstimate(&power, level) / POWER_US_PER_HOUR;
+}
+
+static void s_energy_check(const esp32_wifimanager_stats_t* stats, const char* name)
+{
+    //PRINT TIME AND ENERGY PER LEVEL. THE REPORTED AVERAGE IS THE ENERGY OVER THE TIME
+
+    static const char* levels[ESP32_WIFIMANAGER_POWER_MAX] = {"performance", "balanced", "max save"};
+    int64_t total_us = 0;
+    double total_mwh = 0;
+    uint8_t i;
+
+    for(i = 0; i < ESP32_WIFIMANAGER_POWER_MAX; i++)
+    {
+        total_us += stats->power_level_us[i];
+        total_mwh += s_energy_mwh(stats, (esp32_wifimanager_power_policy_t)i);
+        printf("test_power: %-12s %-12s %9.1f s %8.3f mWh\n",
+               name, levels[i],
+               stats->power_level_us[i] / 1e6,
+               s_energy_mwh(stats, (esp32_wifimanager_power_policy_t)i));
+    }
+    printf("test_power: %-12s total        %9.1f s %8.3f mWh, duty %u/1000, avg %u mW, %u switches\n",
+           name, total_us / 1e6, total_mwh,
+           (unsigned)stats->radio_duty_permille,
+           (unsigned)stats->power_avg_mw,
+           (unsigned)stats->power_switches);
+
+    //THE AVERAGE COMES FROM THE POOLED DUTY, SO IT ONLY DIFFERS BY ROUNDING
+    CHECK(total_us > 0);
+    CHECK(stats->power_avg_mw + 1 >= total_mwh * POWER_US_PER_HOUR / total_us &&
+            stats->power_avg_mw <= total_mwh * POWER_US_PER_HOUR / total_us + 1);
+}
+
+static void test_switching(void)
+{
+    //MAX SAVE POLICY THROUGH A HINT, A WEAK SPELL AND A DROP
+
+    esp32_wifimanager_stats_t stats;
+    esp32_wifimanager_stats_t before;
+
+    s_create(ESP32_WIFIMANAGER_POWER_MAX_SAVE);
+
+    //CONNECTED AND IDLE: MAX SAVE
+    s_step(60000);
+    CHECK(s_radio.associated);
+    CHECK(s_radio.ps == WIFI_PS_MAX_MODEM);
+    CHECK(strcmp(s_seen, "M") == 0);
+
+    //APP BUSY FOR 20 S: NO MODEM SLEEP AT ONCE, BACK AT THE FIRST CHECK AFTER IT
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &before);
+    ESP32_WIFIMANAGER_CTX_PowerHint(s_wm, 20000);
+    s_step(POWER_STEP_MS);
+    CHECK(s_radio.ps == WIFI_PS_NONE);
+    s_step(20000);
+    CHECK(s_radio.ps == WIFI_PS_NONE || s_radio.ps == WIFI_PS_MAX_MODEM);
+    s_step(5000);
+    CHECK(s_radio.ps == WIFI_PS_MAX_MODEM);
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.power_level_us[ESP32_WIFIMANAGER_POWER_PERFORMANCE] -
+            before.power_level_us[ESP32_WIFIMANAGER_POWER_PERFORMANCE] >= 20000000LL);
+    CHECK(stats.power_level_us[ESP32_WIFIMANAGER_POWER_PERFORMANCE] -
+            before.power_level_us[ESP32_WIFIMANAGER_POWER_PERFORMANCE] <= 25000000LL + POWER_STEP_MS * 1000);
+
+    //WEAK SIGNAL: ONE LEVEL BACK ONCE THE SMOOTHED RSSI IS BELOW weak_rssi,
+    //FORWARD AGAIN ONCE IT RECOVERS
+    s_radio.rssi = POWER_WEAK;
+    s_step(60000);
+    CHECK(s_radio.ps == WIFI_PS_MIN_MODEM);
+    s_radio.rssi = POWER_STRONG;
+    s_step(60000);
+    CHECK(s_radio.ps == WIFI_PS_MAX_MODEM);
+
+    //LINK DOWN COUNTS AS PERFORMANCE, THE REJOIN GOES BACK TO MAX SAVE
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &before);
+    s_connects = UINT32_MAX;
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_BEACON_TIMEOUT);
+    s_step(POWER_STEP_MS);
+    CHECK(s_radio.ps == WIFI_PS_NONE);
+    s_connects = s_radio.connects;
+    s_step(30000);
+    CHECK(s_radio.associated);
+    CHECK(s_radio.ps == WIFI_PS_MAX_MODEM);
+    CHECK(strcmp(s_seen, "MPMBMPM") == 0);
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.power_switches == before.power_switches + 2);
+    CHECK(stats.power_level_us[ESP32_WIFIMANAGER_POWER_BALANCED] > 0);
+    CHECK(stats.power_level_us[ESP32_WIFIMANAGER_POWER_MAX_SAVE] > stats.power_level_us[ESP32_WIFIMANAGER_POWER_BALANCED]);
+    s_energy_check(&stats, "switching");
+
+    CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK);
+    s_wm = NULL;
+}
+
+static void test_policies(void)
+{
+    //ONE CONNECTED HOUR PER POLICY. ENERGY IS THE MODEL'S mW x 1 H,
+    //LESS SAVING POLICIES COST MORE
+
+    static const char* names[ESP32_WIFIMANAGER_POWER_MAX] = {"performance", "balanced", "max save"};
+    esp32_wifimanager_power_t power = ESP32_WIFIMANAGER_POWER_DEFAULT();
+    esp32_wifimanager_stats_t stats;
+    double mwh[ESP32_WIFIMANAGER_POWER_MAX];
+    uint8_t policy;
+    uint8_t i;
+
+    for(policy = 0; policy < ESP32_WIFIMANAGER_POWER_MAX; policy++)
+    {
+        s_create((esp32_wifimanager_power_policy_t)policy);
+        s_step(POWER_HOUR_MS);
+        ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+        s_energy_check(&stats, names[policy]);
+
+        mwh[policy] = 0;
+        for(i = 0; i < ESP32_WIFIMANAGER_POWER_MAX; i++)
+        {
+            mwh[policy] += s_energy_mwh(&stats, (esp32_wifimanager_power_policy_t)i);
+        }
+        CHECK(stats.power_level_us[policy] > (int64_t)POWER_HOUR_MS * 1000 - 1000000);
+        CHECK(mwh[policy] <= ESP32_WIFIMANAGER_PowerEstimate(&power, (esp32_wifimanager_power_policy_t)policy) + 1.0);
+        CHECK(mwh[policy] >= ESP32_WIFIMANAGER_PowerEstimate(&power, (esp32_wifimanager_power_policy_t)policy) - 1.0);
+        CHECK(stats.power_avg_mw == ESP32_WIFIMANAGER_PowerEstimate(&power, (esp32_wifimanager_power_policy_t)policy) ||
+                stats.power_avg_mw + 1 == ESP32_WIFIMANAGER_PowerEstimate(&power, (esp32_wifimanager_power_policy_t)policy) ||
+                stats.power_avg_mw == ESP32_WIFIMANAGER_PowerEstimate(&power, (esp32_wifimanager_power_policy_t)policy) + 1);
+
+        CHECK(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK);
+        s_wm = NULL;
+    }
+    CHECK(mwh[ESP32_WIFIMANAGER_POWER_PERFORMANCE] > mwh[ESP32_WIFIMANAGER_POWER_BALANCED]);
+    CHECK(mwh[ESP32_WIFIMANAGER_POWER_BALANCED] > mwh[ESP32_WIFIMANAGER_POWER_MAX_SAVE]);
+}
+
+int main(void)
+{
+    fake_idf_tasks = false;
+    test_model();
+    test_effective();
+    test_switching();
+    test_policies();
+    return fake_idf_summary("test_power");
+}
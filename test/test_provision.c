@@ -0,0 +1,485 @@
+/**************************************************
+* HOST TEST: TIME TO PROVISION PER CONFIG MODE
+* (ESP32_WIFIMANAGER_ProvisionPercentile)
+*
+* THE STORED NETWORK GOES AWAY, THE MANAGER STARTS
+* PROVISIONING AND A SIMULATED USER HANDS OVER A NEW
+* ONE, OVER AND OVER. AN APP USER'S PHONE BROADCASTS
+* ESPTOUCH: IT NEEDS THE RADIO SNIFFING TO FIND THE
+* CHANNEL AND THEN THE CREDENTIALS, AND STARTS OVER
+* WHEN SNIFFING STOPS. A PORTAL USER JOINS THE SOFTAP
+* WHEN IT IS UP, FILLS IN THE FORM AND POSTS IT
+*
+* SMARTCONFIG HAS APP USERS, WEBCONFIG PORTAL USERS,
+* SMARTCONFIG_WEBCONFIG A MIX. EVERY MODE SEES THE SAME
+* DRAWS, SO THE TIME SLICED MODE CAN ONLY BE SLOWER
+* FOR ANY ONE USER. PRINTS MEDIAN AND p95 PER MODE
+* FROM THE STATS SAMPLE RING
+*
+* THE CLOCK IS THE FAKE ONE, THE PORTAL TASK IS REAL
+* AND LISTENS ON LOOPBACK
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define PROV_TRIALS             (40)        //MORE THAN THE RING, SO IT WRAPS
+#define PROV_STEP_MS            (100)
+#define PROV_FAIL_MS            (120000)    //ENOUGH FOR EVERY BACKOFF ATTEMPT TO FAIL
+#define PROV_GIVE_UP_MS         (600000)
+#define PROV_IP                 (0x0A01A8C0)
+#define PROV_PHONE_IP           (0x6401A8C0)
+#define PROV_HTTP_PORT          (18280)
+#define PROV_DNS_PORT           (18253)
+#define PROV_SEED               (20240611)
+
+//ONE USER. TIMES IN STEPS OF PROV_STEP_MS
+typedef struct
+{
+    bool app;                           //ESPTOUCH, ELSE THE PORTAL (SMARTCONFIG_WEBCONFIG ONLY)
+    uint32_t arrive;                    //AFTER PROVISIONING STARTS
+    uint32_t find;                      //SNIFFING TO LOCK ON THE PHONE'S CHANNEL
+    uint32_t get;                       //LOCKED, TO THE CREDENTIALS
+    uint32_t form;                      //ON THE SOFTAP, TO THE POST
+}prov_user_t;
+
+static const struct
+{
+    const char* name;
+    esp32_wifimanager_config_mode_t mode;
+}s_modes[] = {
+    {"smartconfig", ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG},
+    {"webconfig", ESP32_WIFIMANAGER_CONFIG_WEBCONFIG},
+    {"combined", ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG},
+};
+
+#define PROV_MODES              (sizeof(s_modes) / sizeof(s_modes[0]))
+
+static fake_idf_wifi_t s_radio;
+static esp32_wifimanager_t* s_wm;
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+static const uint8_t s_bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+static prov_user_t s_users[PROV_TRIALS];
+static uint32_t s_ms[PROV_MODES][PROV_TRIALS];
+static char s_good[ESP32_WIFIMANAGER_SSID_LEN + 1];
+static uint32_t s_connects;
+static uint32_t s_rand;
+
+static uint32_t s_draw(uint32_t lo, uint32_t hi)
+{
+    //UNIFORM lo .. hi (xorshift32)
+
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return lo + s_rand % (hi - lo + 1);
+}
+
+static void s_answer(void)
+{
+    //ANSWER EVERY NEW CONNECT: JOIN IF IT IS FOR THE NETWORK THAT IS THERE
+
+    if(s_radio.connects == s_connects)
+    {
+        return;
+    }
+    s_connects = s_radio.connects;
+    if(s_good[0] != 0 && strncmp((char*)s_radio.sta.sta.ssid, s_good, ESP32_WIFIMANAGER_SSID_LEN) == 0)
+    {
+        fake_idf_radio_sta_connected(&s_radio, s_good, s_bssid, 6, WIFI_AUTH_WPA2_PSK);
+        fake_idf_radio_sta_got_ip(&s_radio, PROV_IP);
+    }
+    else
+    {
+        fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_NO_AP_FOUND);
+    }
+}
+
+static void s_step(void)
+{
+    fake_idf_advance_ms(PROV_STEP_MS);
+    ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+    s_answer();
+    ESP32_WIFIMANAGER_CTX_Mainiter(s_wm);
+}
+
+static void s_ap_client(bool join)
+{
+    system_event_t evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.event_id = join ? SYSTEM_EVENT_AP_STACONNECTED : SYSTEM_EVENT_AP_STADISCONNECTED;
+    fake_idf_radio_post_event(&s_radio, &evt);
+}
+
+static bool s_post(const char* ssid)
+{
+    //SUBMIT THE PORTAL FORM. READING TO EOF MEANS THE PORTAL HAS HANDED IT ON
+
+    struct sockaddr_in addr;
+    char body[64];
+    char req[256];
+    char rsp[512];
+    size_t len = 0;
+    ssize_t n;
+    int fd;
+
+    snprintf(body, sizeof(body), "ssid=%s&pwd=password", ssid);
+    snprintf(req, sizeof(req),
+                "POST /config HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                "Content-Length: %u\r\n\r\n%s",
+                (unsigned)strlen(body), body);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PROV_HTTP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        send(fd, req, strlen(req), 0) != (ssize_t)strlen(req))
+    {
+        close(fd);
+        return false;
+    }
+    while(len < sizeof(rsp) - 1 && (n = recv(fd, rsp + len, sizeof(rsp) - 1 - len, 0)) > 0)
+    {
+        len += n;
+    }
+    close(fd);
+    rsp[len] = 0;
+    return strncmp(rsp, "HTTP/1.1 200 OK", 15) == 0;
+}
+
+static uint32_t s_provision_starts(void)
+{
+    esp32_wifimanager_latency_t latency;
+
+    ESP32_WIFIMANAGER_CTX_GetLatency(s_wm, &latency);
+    return latency.phase_count[ESP32_WIFIMANAGER_PHASE_PROVISION_START];
+}
+
+static bool s_destroy(void)
+{
+    //PORTAL AND DNS TASKS MAY STILL BE WINDING DOWN. GIVE THEM 3S
+
+    uint32_t spins;
+
+    for(spins = 0; spins < 300; spins++)
+    {
+        if(ESP32_WIFIMANAGER_CTX_Destroy(s_wm) == ESP_OK)
+        {
+            s_wm = NULL;
+            return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+static int s_cmp_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void test_percentile(void)
+{
+    //NEAREST RANK OVER WHAT IS IN THE RING, OLDEST OVERWRITTEN
+
+    esp32_wifimanager_stats_t stats;
+    uint32_t i;
+
+    memset(&stats, 0, sizeof(stats));
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 50) == 0);
+
+    stats.provision_ms[0] = 30;
+    stats.provision_ms[1] = 10;
+    stats.provision_ms[2] = 20;
+    stats.provision_samples = 3;
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 0) == 10);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 50) == 20);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 95) == 30);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 200) == 30);
+
+    //100 SAMPLES 1..100, THE RING HOLDS 69..100
+    for(i = 1; i <= 100; i++)
+    {
+        stats.provision_ms[stats.provision_samples % ESP32_WIFIMANAGER_PROVISION_SAMPLES] = i;
+        stats.provision_samples++;
+    }
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 0) == 101 - ESP32_WIFIMANAGER_PROVISION_SAMPLES);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 50) == 100 - ESP32_WIFIMANAGER_PROVISION_SAMPLES / 2);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 100) == 100);
+}
+
+static void s_create(esp32_wifimanager_config_mode_t mode)
+{
+    //FRESH INSTANCE ON "home", PROVISIONING NEVER TIMES OUT
+
+    esp32_wifimanager_backoff_t backoff = ESP32_WIFIMANAGER_BACKOFF_DEFAULT();
+
+    fake_idf_nvs_erase_all();
+    memset(&s_radio, 0, sizeof(s_radio));
+    s_connects = 0;
+    strcpy(s_good, "home");
+
+    s_wm = ESP32_WIFIMANAGER_CTX_Create();
+    backoff.apsta_retry_ms = 0;
+    backoff.provision_window_ms = 0;
+    backoff.hold_down_ms = 0;
+    backoff.jitter_pct = 0;
+    ESP32_WIFIMANAGER_CTX_SetDriver(s_wm, &fake_idf_driver, &s_radio);
+    ESP32_WIFIMANAGER_CTX_SetPortalPorts(s_wm, PROV_HTTP_PORT, PROV_DNS_PORT);
+    ESP32_WIFIMANAGER_CTX_SetBackoff(s_wm, &backoff);
+    ESP32_WIFIMANAGER_CTX_SetParameters(s_wm,
+                                        ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                        mode,
+                                        &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_CTX_SetPmkCache(s_wm, false);
+    s_step();
+    s_step();
+    CHECK(s_radio.associated);
+}
+
+static bool s_trial(const prov_user_t* u, bool app, uint32_t n, uint32_t* ms)
+{
+    //NETWORK GONE, WAIT FOR PROVISIONING, LET THE USER HAND OVER net<n>,
+    //WAIT FOR THE JOIN. ms = THE PROVISIONING TIME THE STATS RECORDED
+
+    esp32_wifimanager_stats_t stats;
+    wifi_config_t config;
+    uint32_t starts = s_provision_starts();
+    uint32_t t;
+    uint32_t sniff = 0;
+    uint32_t form = 0;
+    bool locked = false;
+    bool joined = false;
+    bool done = false;
+    char ssid[ESP32_WIFIMANAGER_SSID_LEN + 1];
+
+    snprintf(ssid, sizeof(ssid), "net%u", (unsigned)n);
+    s_good[0] = 0;
+    fake_idf_radio_sta_disconnected(&s_radio, WIFI_REASON_BEACON_TIMEOUT);
+    for(t = 0; t < PROV_FAIL_MS && s_provision_starts() == starts; t += PROV_STEP_MS)
+    {
+        s_step();
+    }
+    if(s_provision_starts() == starts)
+    {
+        return false;
+    }
+
+    //THE USER, ONE STEP AT A TIME FROM THE START
+    for(t = 1; t * PROV_STEP_MS < PROV_GIVE_UP_MS && !done; t++)
+    {
+        s_step();
+        if(t < u->arrive)
+        {
+            continue;
+        }
+        if(app)
+        {
+            //THE PHONE BROADCASTS UNTIL IT HAS BEEN HEARD. LOCK AND PROGRESS
+            //ARE LOST WHENEVER THE RADIO STOPS SNIFFING
+            if(!s_radio.smartconfig)
+            {
+                sniff = 0;
+                locked = false;
+                continue;
+            }
+            if(sniff == 0)
+            {
+                fake_idf_radio_smartconfig(&s_radio, SC_STATUS_FIND_CHANNEL, NULL);
+            }
+            sniff++;
+            if(!locked && sniff >= u->find)
+            {
+                locked = true;
+                fake_idf_radio_smartconfig(&s_radio, SC_STATUS_GETTING_SSID_PSWD, NULL);
+            }
+            if(sniff >= u->find + u->get)
+            {
+                memset(&config, 0, sizeof(config));
+                strcpy((char*)config.sta.ssid, ssid);
+                strcpy((char*)config.sta.password, "password");
+                strcpy(s_good, ssid);
+                fake_idf_radio_smartconfig(&s_radio, SC_STATUS_LINK, &config);
+                done = true;
+            }
+        }
+        else
+        {
+            //THE PHONE SEES THE SOFTAP ONLY WHILE IT IS UP. THE FORM SURVIVES
+            //THE AP GOING AWAY, THE ASSOCIATION DOES NOT
+            if(s_radio.mode == WIFI_MODE_STA)
+            {
+                if(joined)
+                {
+                    s_ap_client(false);
+                    joined = false;
+                }
+                continue;
+            }
+            if(!joined)
+            {
+                s_ap_client(true);
+                joined = true;
+            }
+            form++;
+            if(form >= u->form)
+            {
+                strcpy(s_good, ssid);
+                CHECK(s_post(ssid));
+                s_ap_client(false);
+                done = true;
+            }
+        }
+    }
+    if(!done)
+    {
+        return false;
+    }
+
+    //THE MANAGER TAKES THE CREDENTIALS IN THE SAME STEP AND JOINS
+    for(t = 0; t < PROV_FAIL_MS && !s_radio.associated; t += PROV_STEP_MS)
+    {
+        s_step();
+    }
+    if(app)
+    {
+        uint32_t phone = PROV_PHONE_IP;
+
+        fake_idf_radio_smartconfig(&s_radio, SC_STATUS_LINK_OVER, &phone);
+    }
+    s_step();
+    CHECK(s_radio.associated);
+    CHECK(strcmp((char*)s_radio.sta.sta.ssid, ssid) == 0);
+    //BOTH METHODS TORN DOWN (SMARTCONFIG ALONE NEVER CHANGES THE MODE)
+    CHECK(!s_radio.smartconfig);
+    CHECK(s_radio.mode != WIFI_MODE_APSTA && s_radio.mode != WIFI_MODE_AP);
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    CHECK(stats.provision_samples == n + 1);
+    *ms = (uint32_t)(stats.last_provision_us / 1000);
+    CHECK(stats.provision_ms[n % ESP32_WIFIMANAGER_PROVISION_SAMPLES] == *ms);
+    return true;
+}
+
+static void test_mode(uint8_t m)
+{
+    //PROV_TRIALS USERS, THEN THE PERCENTILES FROM THE RING AGAINST OUR OWN
+
+    esp32_wifimanager_stats_t stats;
+    uint32_t sorted[ESP32_WIFIMANAGER_PROVISION_SAMPLES];
+    uint32_t apps = 0;
+    uint32_t n;
+    bool app;
+
+    s_create(s_modes[m].mode);
+    for(n = 0; n < PROV_TRIALS; n++)
+    {
+        app = (s_modes[m].mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG) ||
+                (s_modes[m].mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG && s_users[n].app);
+        apps += app ? 1 : 0;
+        if(!s_trial(&s_users[n], app, n, &s_ms[m][n]))
+        {
+            CHECK(false);
+            printf("test_provision: %s, user %u never got through\n", s_modes[m].name, (unsigned)n);
+            break;
+        }
+    }
+
+    ESP32_WIFIMANAGER_CTX_GetStats(s_wm, &stats);
+    memcpy(sorted, &s_ms[m][PROV_TRIALS - ESP32_WIFIMANAGER_PROVISION_SAMPLES], sizeof(sorted));
+    qsort(sorted, ESP32_WIFIMANAGER_PROVISION_SAMPLES, sizeof(sorted[0]), s_cmp_u32);
+    printf("test_provision: %-12s median %6u ms, p95 %6u ms, max %6u ms (last %u), "
+           "%u smartconfig, %u webconfig, %u slices\n",
+           s_modes[m].name,
+           (unsigned)ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 50),
+           (unsigned)ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 95),
+           (unsigned)ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 100),
+           (unsigned)ESP32_WIFIMANAGER_PROVISION_SAMPLES,
+           (unsigned)stats.provisioned_smartconfig,
+           (unsigned)stats.provisioned_webconfig,
+           (unsigned)stats.provision_slices);
+
+    CHECK(stats.provision_samples == PROV_TRIALS);
+    CHECK(stats.provisioned_smartconfig == apps);
+    CHECK(stats.provisioned_webconfig == PROV_TRIALS - apps);
+    CHECK(stats.provision_late_dropped == 0);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 50) == sorted[ESP32_WIFIMANAGER_PROVISION_SAMPLES / 2 - 1]);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 95) ==
+            sorted[(95 * ESP32_WIFIMANAGER_PROVISION_SAMPLES + 99) / 100 - 1]);
+    CHECK(ESP32_WIFIMANAGER_ProvisionPercentile(&stats, 100) == sorted[ESP32_WIFIMANAGER_PROVISION_SAMPLES - 1]);
+    CHECK((s_modes[m].mode == ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG_WEBCONFIG) == (stats.provision_slices > 0));
+
+    CHECK(s_destroy());
+}
+
+static void test_compare(void)
+{
+    //ONE METHOD ALONE IS AS FAST AS THE USER. TIME SLICING CAN ONLY ADD TO IT
+
+    uint32_t n;
+    uint32_t sc_extra = 0;
+    uint32_t web_extra = 0;
+    uint32_t apps = 0;
+
+    for(n = 0; n < PROV_TRIALS; n++)
+    {
+        const prov_user_t* u = &s_users[n];
+
+        CHECK(s_ms[0][n] == (u->arrive + u->find + u->get) * PROV_STEP_MS);
+        CHECK(s_ms[1][n] == (u->arrive + u->form) * PROV_STEP_MS);
+        CHECK(s_ms[2][n] >= s_ms[u->app ? 0 : 1][n]);
+        if(u->app)
+        {
+            sc_extra += s_ms[2][n] - s_ms[0][n];
+            apps++;
+        }
+        else
+        {
+            web_extra += s_ms[2][n] - s_ms[1][n];
+        }
+    }
+    printf("test_provision: combined adds %u ms per app user, %u ms per portal user on average\n",
+           (unsigned)(sc_extra / apps),
+           (unsigned)(web_extra / (PROV_TRIALS - apps)));
+    CHECK(apps > 0 && apps < PROV_TRIALS);
+    CHECK(sc_extra > 0 && web_extra > 0);
+}
+
+int main(void)
+{
+    uint32_t n;
+    uint8_t m;
+
+    //THE SAME USERS IN EVERY MODE: NOTICE THE DEVICE WANTS SETTING UP, THEN
+    //ESPTOUCH LOCKS IN 1-6 S AND DELIVERS IN 3-10 S, A FORM TAKES 20-60 S
+    s_rand = PROV_SEED;
+    for(n = 0; n < PROV_TRIALS; n++)
+    {
+        s_users[n].app = s_draw(0, 1) != 0;
+        s_users[n].arrive = s_draw(50, 600);
+        s_users[n].find = s_draw(10, 60);
+        s_users[n].get = s_draw(30, 100);
+        s_users[n].form = s_draw(200, 600);
+    }
+
+    test_percentile();
+    for(m = 0; m < PROV_MODES; m++)
+    {
+        test_mode(m);
+    }
+    test_compare();
+    return fake_idf_summary("test_provision");
+}
@@ -0,0 +1,263 @@
+/**************************************************
+* HOST TEST: INPUT TRACE AND REPLAY
+* (ESP32_WIFIMANAGER_TRACE, ESP32_WIFIMANAGER_CTX_Replay)
+*
+* AN INSTANCE HOLDS THE ESP32 RADIO (fake_idf_wifi)
+* UNTIL IT IS DESTROYED, SO A FORKED CHILD RUNS THE
+* LIVE SCENARIO AND SENDS BACK ITS
+* TRACE AND STATS. THE PARENT REPLAYS THE TRACE ON A
+* FRESH INSTANCE WITH A DIFFERENT RANDOM SEQUENCE AND
+* MUST END UP WITH THE SAME COUNTERS
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "esp_system.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+typedef struct
+{
+    esp32_wifimanager_stats_t stats;
+    uint32_t driver_connects;
+    uint16_t count;
+    esp32_wifimanager_trace_record_t records[ESP32_WIFIMANAGER_TRACE_LEN];
+}replay_capture_t;
+
+static esp32_wifimanager_credential_hardcoded_t s_cred = {.ssid_name = "home", .ssid_pwd = "password"};
+
+static void s_start(void)
+{
+    ESP32_WIFIMANAGER_SetParameters(ESP32_WIFIMANAGER_CREDENTIAL_SRC_HARDCODED,
+                                    ESP32_WIFIMANAGER_CONFIG_SMARTCONFIG,
+                                    &s_cred, 2, "test");
+    ESP32_WIFIMANAGER_SetPmkCache(false);
+}
+
+static void s_run(uint32_t steps)
+{
+    //MAINITER WITH THE CLOCK MOVING
+
+    uint32_t i;
+
+    for(i = 0; i < steps; i++)
+    {
+        fake_idf_advance_ms(100);
+        ESP32_WIFIMANAGER_Mainiter();
+    }
+}
+
+static void s_until_connect(void)
+{
+    //RUN UNTIL THE MANAGER STARTS THE NEXT CONNECT
+
+    uint32_t connects = fake_idf_wifi.connects;
+    uint32_t i;
+
+    for(i = 0; i < 600 && fake_idf_wifi.connects == connects; i++)
+    {
+        s_run(1);
+    }
+}
+
+static void s_link_up(void)
+{
+    static const uint8_t bssid[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+    fake_idf_sta_connected("home", bssid, 6, WIFI_AUTH_WPA2_PSK);
+    s_run(2);
+    fake_idf_sta_got_ip(0x0101A8C0);
+    s_run(8);
+}
+
+static void s_record(replay_capture_t* capture)
+{
+    //LIVE SCENARIO: BOOT, A FAILED FIRST ATTEMPT, LINK UP, TWO LINK LOSSES
+    //(THE FAILED ATTEMPT IS NOT A LINK LOSS)
+
+    s_start();
+    s_run(2);
+    fake_idf_sta_start();
+    s_run(2);
+    fake_idf_sta_disconnected(WIFI_REASON_NO_AP_FOUND);
+    s_until_connect();
+    s_link_up();
+
+    fake_idf_sta_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+    s_until_connect();
+    s_link_up();
+
+    fake_idf_sta_disconnected(WIFI_REASON_AUTH_EXPIRE);
+    s_until_connect();
+    s_link_up();
+
+    ESP32_WIFIMANAGER_GetStats(&capture->stats);
+    capture->driver_connects = fake_idf_wifi.connects;
+    capture->count = ESP32_WIFIMANAGER_GetTrace(capture->records, ESP32_WIFIMANAGER_TRACE_LEN);
+}
+
+static bool s_io(int fd, void* buf, size_t len, bool out)
+{
+    uint8_t* p = (uint8_t*)buf;
+    ssize_t n;
+
+    while(len > 0)
+    {
+        n = out ? write(fd, p, len) : read(fd, p, len);
+        if(n <= 0)
+        {
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool s_capture(replay_capture_t* capture)
+{
+    //RECORD IN A CHILD PROCESS
+
+    int fds[2];
+    int status;
+    pid_t pid;
+    bool ok;
+
+    if(pipe(fds) != 0)
+    {
+        return false;
+    }
+    fflush(stdout);
+    pid = fork();
+    if(pid == 0)
+    {
+        close(fds[0]);
+        s_record(capture);
+        _exit(s_io(fds[1], capture, sizeof(replay_capture_t), true) ? 0 : 1);
+    }
+    close(fds[1]);
+    ok = pid > 0 && s_io(fds[0], capture, sizeof(replay_capture_t), false);
+    close(fds[0]);
+    ok = pid > 0 && waitpid(pid, &status, 0) == pid && ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return ok;
+}
+
+static uint16_t s_count_kind(const replay_capture_t* capture, esp32_wifimanager_trace_kind_t kind)
+{
+    uint16_t i;
+    uint16_t n = 0;
+
+    for(i = 0; i < capture->count; i++)
+    {
+        n += capture->records[i].kind == kind;
+    }
+    return n;
+}
+
+static int s_replay_diverged(const replay_capture_t* capture)
+{
+    //CHILD: REPLAY WITH EVERY RECORDED JITTER DRAW REMOVED
+
+    esp32_wifimanager_trace_record_t* records = malloc(capture->count * sizeof(esp32_wifimanager_trace_record_t));
+    esp32_wifimanager_stats_t stats;
+    uint16_t i;
+    uint16_t n = 0;
+    int status;
+
+    for(i = 0; i < capture->count; i++)
+    {
+        if(capture->records[i].kind != ESP32_WIFIMANAGER_TRACE_RANDOM)
+        {
+            records[n++] = capture->records[i];
+        }
+    }
+    s_start();
+    CHECK(ESP32_WIFIMANAGER_CTX_Replay(ESP32_WIFIMANAGER_CTX_Default(), records, n, fake_idf_set_time) == ESP_OK);
+    ESP32_WIFIMANAGER_GetStats(&stats);
+    CHECK(stats.replay_diverged == s_count_kind(capture, ESP32_WIFIMANAGER_TRACE_RANDOM));
+    free(records);
+    status = fake_idf_summary("test_replay (diverged)");
+    fflush(stdout);
+    return status;
+}
+
+static void test_trace(const replay_capture_t* capture)
+{
+    //EVERY PROCESSED EVENT AND JITTER DRAW IS IN THE RING, OLDEST FIRST
+
+    uint16_t i;
+    bool ordered = true;
+
+    CHECK(capture->count > 0 && capture->count < ESP32_WIFIMANAGER_TRACE_LEN);
+    CHECK(capture->stats.connections == 3);
+    CHECK(capture->stats.disconnections == 2);
+    CHECK(capture->stats.replay_diverged == 0);
+    CHECK(s_count_kind(capture, ESP32_WIFIMANAGER_TRACE_RANDOM) > 0);
+    CHECK(s_count_kind(capture, ESP32_WIFIMANAGER_TRACE_EVT) >= 10);
+    for(i = 1; i < capture->count; i++)
+    {
+        ordered = ordered && capture->records[i].ts_us >= capture->records[i - 1].ts_us;
+    }
+    CHECK(ordered);
+}
+
+static void test_diverged(const replay_capture_t* capture)
+{
+    int status;
+    pid_t pid;
+
+    fflush(stdout);
+    pid = fork();
+
+    if(pid == 0)
+    {
+        _exit(s_replay_diverged(capture));
+    }
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void test_replay(const replay_capture_t* capture)
+{
+    //SAME TRACE, SAME COUNTERS. LIVE esp_random() DRAWS ARE MOVED ON SO ONLY
+    //THE RECORDED VALUES CAN GIVE THE SAME BACKOFF
+
+    esp32_wifimanager_trace_record_t record;
+    esp32_wifimanager_stats_t stats;
+    uint8_t i;
+
+    for(i = 0; i < 7; i++)
+    {
+        esp_random();
+    }
+
+    memset(&record, 0, sizeof(record));
+    CHECK(ESP32_WIFIMANAGER_CTX_Replay(ESP32_WIFIMANAGER_CTX_Default(), &record, 1, fake_idf_set_time) ==
+            ESP_ERR_INVALID_STATE);
+    s_start();
+    CHECK(ESP32_WIFIMANAGER_CTX_Replay(ESP32_WIFIMANAGER_CTX_Default(), NULL, 1, fake_idf_set_time) ==
+            ESP_ERR_INVALID_ARG);
+    CHECK(ESP32_WIFIMANAGER_CTX_Replay(ESP32_WIFIMANAGER_CTX_Default(), capture->records, capture->count,
+                                        fake_idf_set_time) == ESP_OK);
+
+    ESP32_WIFIMANAGER_GetStats(&stats);
+    CHECK(stats.replay_diverged == 0);
+    CHECK(stats.connections == capture->stats.connections);
+    CHECK(stats.disconnections == capture->stats.disconnections);
+    CHECK(stats.state_transitions == capture->stats.state_transitions);
+    CHECK(stats.reconnect_attempts == capture->stats.reconnect_attempts);
+    CHECK(stats.last_backoff_ms == capture->stats.last_backoff_ms);
+    CHECK(fake_idf_wifi.connects == capture->driver_connects);
+}
+
+int main(void)
+{
+    static replay_capture_t capture;
+
+    CHECK(s_capture(&capture));
+    test_trace(&capture);
+    test_diverged(&capture);
+    test_replay(&capture);
+    return fake_idf_summary("test_replay");
+}
@@ -0,0 +1,280 @@
+/**************************************************
+* HOST TEST: ROAMING DECISIONS
+* (ESP32_WIFIMANAGER_ROAM)
+*
+* TABLES FOR EACH PURE FUNCTION: THE RSSI EWMA, THE
+* THRESHOLD AND RATE LIMIT OF ShouldScan, THE
+* CHANNEL MASK AND CANDIDATE SELECTION WITH ITS
+* HYSTERESIS. THEN HOW MANY CHECKS A DROP IN SIGNAL
+* TAKES TO START A ROAM SCAN
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_ROAM.h"
+#include <string.h>
+
+#define ROAM_AP_MAX             (6)
+#define ROAM_SCAN_US            (50000000LL)    //THIS ROAM SCAN STARTED HERE
+#define ROAM_STALE_US           (ROAM_SCAN_US - 1)
+#define ROAM_END                {NULL, 0, 0, 0, 0}
+
+//ONE SCAN CACHE ENTRY. bssid IS THE LAST BYTE, 0x01 IS THE CURRENT AP
+typedef struct
+{
+    const char* ssid;
+    uint8_t bssid;
+    uint8_t channel;
+    int8_t rssi;
+    int64_t seen_us;
+}roam_ap_t;
+
+typedef struct
+{
+    const char* name;
+    roam_ap_t aps[ROAM_AP_MAX];
+    uint16_t channels;          //EXPECTED MASK
+    int8_t cur_rssi;
+    uint8_t hysteresis_db;
+    int8_t pick;                //EXPECTED INDEX, -1 = STAY
+}roam_case_t;
+
+//INTERNAL VARIABLES
+static const uint8_t s_cur_bssid[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+static const char s_ssid_32[] = "abcdefghijklmnopqrstuvwxyz012345";
+
+static const roam_case_t s_cases[] =
+{
+    {"empty cache", {ROAM_END}, 0x0000, -80, 8, -1},
+    {"only the current ap", {{"home", 0x01, 6, -80, ROAM_SCAN_US}, ROAM_END}, 0x0000, -80, 8, -1},
+    {"other ssids only", {{"cafe", 0x02, 1, -40, ROAM_SCAN_US}, {"hom", 0x03, 11, -40, ROAM_SCAN_US}, {"homes", 0x04, 3, -40, ROAM_SCAN_US}, ROAM_END},
+        0x0000, -80, 8, -1},
+    {"one candidate", {{"home", 0x02, 11, -60, ROAM_SCAN_US}, {"home", 0x01, 6, -80, ROAM_SCAN_US}, ROAM_END}, 1 << 11, -80, 8, 0},
+
+    //HYSTERESIS: AT LEAST hysteresis_db STRONGER THAN THE CURRENT SAMPLE
+    {"exactly hysteresis", {{"home", 0x02, 1, -72, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -80, 8, 0},
+    {"one dB short", {{"home", 0x02, 1, -73, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -80, 8, -1},
+    {"hysteresis 0, equal", {{"home", 0x02, 1, -80, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -80, 0, 0},
+    {"hysteresis 0, weaker", {{"home", 0x02, 1, -81, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -80, 0, -1},
+    {"large hysteresis", {{"home", 0x02, 1, -20, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -90, 80, -1},
+    {"floor rssi", {{"home", 0x02, 1, -100, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -128, 28, 0},
+
+    //SELECTION: STRONGEST FRESH SAME SSID BSSID. STALE ONES SET THE MASK BUT ARE NOT PICKED
+    {"strongest wins", {{"home", 0x02, 1, -65, ROAM_SCAN_US}, {"home", 0x03, 6, -55, ROAM_SCAN_US}, {"home", 0x04, 11, -60, ROAM_SCAN_US}, ROAM_END},
+        (1 << 1) | (1 << 6) | (1 << 11), -80, 8, 1},
+    {"tie keeps first", {{"home", 0x02, 3, -60, ROAM_SCAN_US}, {"home", 0x03, 4, -60, ROAM_SCAN_US}, ROAM_END}, (1 << 3) | (1 << 4), -80, 8, 0},
+    {"stale strongest", {{"home", 0x02, 1, -40, ROAM_STALE_US}, {"home", 0x03, 6, -66, ROAM_SCAN_US}, ROAM_END}, (1 << 1) | (1 << 6), -80, 8, 1},
+    {"all stale", {{"home", 0x02, 1, -40, ROAM_STALE_US}, {"home", 0x03, 6, -40, 0}, ROAM_END}, (1 << 1) | (1 << 6), -80, 8, -1},
+    {"current ap strongest", {{"home", 0x01, 6, -30, ROAM_SCAN_US}, {"home", 0x02, 1, -70, ROAM_SCAN_US}, ROAM_END}, 1 << 1, -80, 8, 1},
+    {"other ssid strongest", {{"cafe", 0x02, 1, -30, ROAM_SCAN_US}, {"home", 0x03, 9, -70, ROAM_SCAN_US}, ROAM_END}, 1 << 9, -80, 8, 1},
+
+    //CHANNEL MASK: 1..13 ONLY, SHARED CHANNELS ONCE
+    {"channel 0 and 14", {{"home", 0x02, 0, -60, ROAM_SCAN_US}, {"home", 0x03, 14, -60, ROAM_SCAN_US}, {"home", 0x04, 13, -60, ROAM_SCAN_US}, ROAM_END},
+        1 << 13, -80, 8, 0},
+    {"same channel twice", {{"home", 0x02, 6, -60, ROAM_SCAN_US}, {"home", 0x03, 6, -62, ROAM_SCAN_US}, {"home", 0x01, 11, -80, ROAM_SCAN_US}, ROAM_END},
+        1 << 6, -80, 8, 0},
+    {"32 byte ssid", {{NULL, 0x02, 5, -60, ROAM_SCAN_US}, {"home", 0x03, 7, -50, ROAM_SCAN_US}, ROAM_END}, 1 << 7, -80, 8, 1},
+};
+
+static uint8_t s_aps(const roam_case_t* c,
+                        esp32_wifimanager_scan_entry_t* entries,
+                        const esp32_wifimanager_scan_entry_t** aps)
+{
+    //SCAN CACHE ENTRIES FOR c. A NULL ssid BEFORE THE END IS s_ssid_32 (NO NUL IN THE ENTRY)
+
+    uint8_t n;
+
+    for(n = 0; n < ROAM_AP_MAX && (c->aps[n].ssid != NULL || c->aps[n].bssid != 0); n++)
+    {
+        memset(&entries[n], 0, sizeof(entries[n]));
+        if(c->aps[n].ssid != NULL)
+        {
+            strcpy((char*)entries[n].ssid, c->aps[n].ssid);
+        }
+        else
+        {
+            memcpy(entries[n].ssid, s_ssid_32, ESP32_WIFIMANAGER_SSID_LEN);
+            entries[n].ssid[ESP32_WIFIMANAGER_SSID_LEN] = 'x';
+        }
+        memcpy(entries[n].bssid, s_cur_bssid, 6);
+        entries[n].bssid[5] = c->aps[n].bssid;
+        entries[n].channel = c->aps[n].channel;
+        entries[n].last_rssi = c->aps[n].rssi;
+        entries[n].rssi = c->aps[n].rssi;
+        entries[n].rssi_q4 = c->aps[n].rssi * 16;
+        entries[n].last_seen_us = c->aps[n].seen_us;
+        aps[n] = &entries[n];
+    }
+    return n;
+}
+
+static void test_smooth(void)
+{
+    //EWMA IN 1/16 dBm, 1/4 OF THE NEW SAMPLE. 0 = NO SAMPLE YET
+
+    static const struct
+    {
+        int16_t q4;
+        int8_t sample;
+        int16_t expect;
+    }cases[] =
+    {
+        {0, -70, -70 * 16},             //FIRST SAMPLE TAKEN AS IS
+        {0, -128, -128 * 16},
+        {-70 * 16, -70, -70 * 16},      //STEADY
+        {-60 * 16, -80, -65 * 16},      //A QUARTER OF THE STEP
+        {-80 * 16, -60, -75 * 16},
+        {-1000, -62, -998},             //8/16 dB OFF: MOVES 2/16
+        {-1000, -63, -1002},
+        {-995, -62, -995},              //3/16 OFF: TRUNCATED, STAYS
+        {-990, -62, -990},
+        {-128 * 16, -1, -1540},
+    };
+    uint8_t i;
+    bool ok = true;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        if(ESP32_WIFIMANAGER_ROAM_Smooth(cases[i].q4, cases[i].sample) != cases[i].expect)
+        {
+            printf("  smooth %d + %d = %d, expected %d\n", cases[i].q4, cases[i].sample,
+                    ESP32_WIFIMANAGER_ROAM_Smooth(cases[i].q4, cases[i].sample), cases[i].expect);
+            ok = false;
+        }
+    }
+    CHECK(ok);
+}
+
+static void test_should_scan(void)
+{
+    //BELOW THRESHOLD (STRICTLY) AND min_interval_ms SINCE THE LAST ROAM SCAN
+
+    static const struct
+    {
+        int16_t q4;
+        int64_t since_ms;       //-1 = NEVER SCANNED
+        bool expect;
+    }cases[] =
+    {
+        {0, -1, false},                 //NO SAMPLE
+        {-72 * 16, -1, false},          //AT THRESHOLD
+        {-72 * 16 - 1, -1, true},       //1/16 dB BELOW
+        {-71 * 16, -1, false},
+        {-90 * 16, -1, true},
+        {-90 * 16, 0, false},           //JUST SCANNED
+        {-90 * 16, 29999, false},
+        {-90 * 16, 30000, true},
+        {-60 * 16, 30000, false},       //STRONG, INTERVAL OVER
+    };
+    esp32_wifimanager_roam_t roam = (esp32_wifimanager_roam_t)ESP32_WIFIMANAGER_ROAM_DEFAULT();
+    int64_t now_us = 100000000LL;
+    int64_t last_us;
+    uint8_t i;
+    bool ok = true;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        last_us = (cases[i].since_ms < 0) ? 0 : now_us - cases[i].since_ms * 1000;
+        if(ESP32_WIFIMANAGER_ROAM_ShouldScan(&roam, cases[i].q4, now_us, last_us) != cases[i].expect)
+        {
+            printf("  should scan q4 %d since %lld ms: expected %u\n", cases[i].q4,
+                    (long long)cases[i].since_ms, cases[i].expect);
+            ok = false;
+        }
+    }
+    CHECK(ok);
+
+    //min_interval_ms 0: EVERY WEAK CHECK
+    roam.min_interval_ms = 0;
+    CHECK(ESP32_WIFIMANAGER_ROAM_ShouldScan(&roam, -90 * 16, now_us, now_us));
+}
+
+static void test_table(void)
+{
+    //CHANNEL MASK AND PICK FOR EVERY CASE. THE CALLER ROAMS TO aps[pick]
+
+    esp32_wifimanager_scan_entry_t entries[ROAM_AP_MAX];
+    const esp32_wifimanager_scan_entry_t* aps[ROAM_AP_MAX];
+    const roam_case_t* c;
+    uint16_t channels;
+    int8_t pick;
+    uint8_t count;
+    uint8_t i;
+    bool ok;
+
+    for(i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+    {
+        c = &s_cases[i];
+        count = s_aps(c, entries, aps);
+        channels = ESP32_WIFIMANAGER_ROAM_Channels(aps, count, (const uint8_t*)"home", s_cur_bssid);
+        pick = ESP32_WIFIMANAGER_ROAM_Pick(aps, count, (const uint8_t*)"home", s_cur_bssid,
+                                            c->cur_rssi, c->hysteresis_db, ROAM_SCAN_US);
+        ok = channels == c->channels && pick == c->pick;
+        CHECK(ok);
+        if(!ok)
+        {
+            printf("  case \"%s\": channels 0x%04x pick %d\n", c->name, channels, pick);
+        }
+    }
+
+    //THE 32 BYTE SSID IS COMPARED IN FULL, NOT TO ITS (MISSING) NUL
+    c = &s_cases[sizeof(s_cases) / sizeof(s_cases[0]) - 1];
+    count = s_aps(c, entries, aps);
+    CHECK(ESP32_WIFIMANAGER_ROAM_Channels(aps, count, (const uint8_t*)s_ssid_32, s_cur_bssid) == (1 << 5));
+}
+
+static void test_drop(void)
+{
+    //SIGNAL FALLS FROM -60 TO to_dbm AND STAYS. CHECKS (check_ms APART) UNTIL
+    //THE SMOOTHED RSSI CROSSES THE THRESHOLD. NONE IF IT NEVER DOES
+
+    static const struct
+    {
+        int8_t to_dbm;
+        uint8_t expect;         //0 = NEVER
+    }cases[] =
+    {
+        {-71, 0},
+        {-72, 0},               //CONVERGES ONTO THE THRESHOLD, NEVER BELOW
+        {-73, 10},
+        {-76, 5},
+        {-80, 4},
+        {-90, 2},
+        {-120, 1},
+    };
+    esp32_wifimanager_roam_t roam = (esp32_wifimanager_roam_t)ESP32_WIFIMANAGER_ROAM_DEFAULT();
+    int16_t q4;
+    uint8_t checks;
+    uint8_t i;
+    bool ok = true;
+
+    for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        q4 = ESP32_WIFIMANAGER_ROAM_Smooth(0, -60);
+        for(checks = 1; checks <= 50; checks++)
+        {
+            q4 = ESP32_WIFIMANAGER_ROAM_Smooth(q4, cases[i].to_dbm);
+            if(ESP32_WIFIMANAGER_ROAM_ShouldScan(&roam, q4, 1, 0))
+            {
+                break;
+            }
+        }
+        checks = (checks > 50) ? 0 : checks;
+        if(checks != cases[i].expect)
+        {
+            ok = false;
+        }
+        printf("  -60 -> %4d dBm: roam scan after %u checks (%u ms)\n", cases[i].to_dbm, checks,
+                (unsigned)(checks * roam.check_ms));
+    }
+    CHECK(ok);
+}
+
+int main(void)
+{
+    test_smooth();
+    test_should_scan();
+    test_table();
+    test_drop();
+    return fake_idf_summary("test_roam");
+}
@@ -0,0 +1,141 @@
+/**************************************************
+* HOST TEST: SOFTWARE TIMER WHEEL
+* (ESP32_WIFIMANAGER_TIMERWHEEL)
+*
+* EXPIRY, PERIODIC RE ARM, AND A TIMER STARTED AFTER
+* THE CONSUMER WAS BLOCKED WITHOUT ADVANCING THE WHEEL
+* (MANAGER TASK ASLEEP IN xQueueReceive). ITS DELAY
+* MUST COUNT FROM NOW, NOT FROM THE LAST ADVANCE.
+* TWO WHEELS RUN SIDE BY SIDE WITHOUT SEEING EACH
+* OTHER'S TIMERS
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER_TIMERWHEEL.h"
+#include <string.h>
+
+static esp32_wifimanager_timerwheel_t s_wheel;
+static uint32_t s_fired[4];
+
+static void s_cb(void* pArg)
+{
+    s_fired[(uintptr_t)pArg]++;
+}
+
+static void s_advance_until(uint32_t ms, uintptr_t idx)
+{
+    //STEP ONE TICK AT A TIME UNTIL TIMER idx FIRES OR ms PASSED
+
+    uint32_t waited;
+
+    for(waited = 0; waited < ms && s_fired[idx] == 0; waited += ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS)
+    {
+        fake_idf_advance_ms(ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS);
+        ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&s_wheel);
+    }
+}
+
+static void test_oneshot_periodic(void)
+{
+    esp32_wifimanager_timer_t a;
+    esp32_wifimanager_timer_t b;
+    int64_t start;
+
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&s_wheel, &a, s_cb, (void*)0);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&s_wheel, &b, s_cb, (void*)1);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&s_wheel);
+    start = fake_idf_now_us;
+
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&a, 500, false);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&b, 200, true);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&s_wheel) == 200);
+
+    s_advance_until(1000, 0);
+    CHECK(s_fired[0] == 1);
+    CHECK(fake_idf_now_us - start == 500000);
+    CHECK(s_fired[1] == 2);
+    CHECK(!ESP32_WIFIMANAGER_TIMERWHEEL_IsArmed(&a));
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_IsArmed(&b));
+
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&b);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&s_wheel) == ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER);
+}
+
+static void s_blocked(uint32_t block_ms)
+{
+    //A LONG TIMER KEEPS THE WHEEL ARMED, THE CONSUMER SLEEPS block_ms
+    //WITHOUT ADVANCING, THEN ARMS A 1 s TIMER
+
+    esp32_wifimanager_timer_t guard;
+    esp32_wifimanager_timer_t t;
+    int64_t armed_us;
+
+    s_fired[2] = 0;
+    s_fired[3] = 0;
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&s_wheel, &guard, s_cb, (void*)2);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&s_wheel, &t, s_cb, (void*)3);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&s_wheel);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&guard, 600000, false);
+
+    fake_idf_advance_ms(block_ms);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&t, 1000, false);
+    armed_us = fake_idf_now_us;
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&s_wheel) == 1000 ||
+            block_ms > ESP32_WIFIMANAGER_TIMERWHEEL_SLOTS * ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS);
+
+    //FIRST ADVANCE AFTER WAKING MUST NOT FIRE IT
+    fake_idf_advance_ms(ESP32_WIFIMANAGER_TIMERWHEEL_TICK_MS);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&s_wheel);
+    CHECK(s_fired[3] == 0);
+
+    s_advance_until(2000, 3);
+    CHECK(s_fired[3] == 1);
+    CHECK(fake_idf_now_us - armed_us == 1000000);
+    CHECK(s_fired[2] == 0);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Stop(&guard);
+}
+
+static void test_start_after_block(void)
+{
+    //SHORTER THAN ONE REVOLUTION, AND SEVERAL REVOLUTIONS
+
+    s_blocked(900);
+    s_blocked(2000);
+    s_blocked(30000);
+}
+
+static void test_two_wheels(void)
+{
+    //EACH WHEEL ONLY FIRES AND REPORTS ITS OWN TIMERS
+
+    esp32_wifimanager_timerwheel_t other;
+    esp32_wifimanager_timer_t a;
+    esp32_wifimanager_timer_t b;
+
+    memset(&other, 0, sizeof(other));
+    memset(s_fired, 0, sizeof(s_fired));
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&s_wheel, &a, s_cb, (void*)0);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Setup(&other, &b, s_cb, (void*)1);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&a, 100, false);
+    ESP32_WIFIMANAGER_TIMERWHEEL_Start(&b, 300, false);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&s_wheel) == 100);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&other) == 300);
+
+    //ONLY s_wheel IS ADVANCED. b IS DUE BUT MUST WAIT FOR ITS OWN WHEEL
+    fake_idf_advance_ms(400);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&s_wheel) == 1);
+    CHECK(s_fired[0] == 1 && s_fired[1] == 0);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&s_wheel) == ESP32_WIFIMANAGER_TIMERWHEEL_NO_TIMER);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_MsToNext(&other) == 0);
+    CHECK(ESP32_WIFIMANAGER_TIMERWHEEL_Advance(&other) == 1);
+    CHECK(s_fired[1] == 1);
+}
+
+int main(void)
+{
+    fake_idf_set_time(1000000);
+    test_oneshot_periodic();
+    test_start_after_block();
+    test_two_wheels();
+    return fake_idf_summary("test_timerwheel");
+}
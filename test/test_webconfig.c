@@ -0,0 +1,396 @@
+/**************************************************
+* HOST TEST: WEBCONFIG PORTAL UNDER LOAD
+* (ESP32_WIFIMANAGER_WEBCONFIG)
+*
+* THE PORTAL TASK SERVES REAL LOOPBACK TCP CLIENTS.
+* esp_timer_get_time FOLLOWS THE HOST CLOCK, SO TIME
+* TO FIRST BYTE IS MEASURED, NOT MODELLED
+*
+* FREE HEAP IS A MODEL OF LWIP'S SEND SIDE: BYTES THE
+* PORTAL HAS SENT THAT ITS CLIENT HAS NOT READ YET
+* (LWIP HOLDS THEM IN PBUFS UNTIL THEY ARE ACKED).
+* send / recv / accept / close OF THIS BINARY KEEP
+* THE COUNT AND PASS EVERYTHING THROUGH
+*
+* FIRST EACH KIND OF REQUEST ON ITS OWN, REPORTING
+* TTFB AND PEAK HEAP PER REQUEST, THEN SEVERAL
+* CLIENTS AT ONCE, REPORTING THROUGHPUT AND TTFB
+* PERCENTILES
+**************************************************/
+
+#include "fake_idf.h"
+#include "ESP32_WIFIMANAGER.h"
+#include "ESP32_WIFIMANAGER_WEBCONFIG.h"
+#include "ESP32_WIFIMANAGER_WEBCONFIG_PAGE.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define WEB_PORT_BASE           (18080)
+#define WEB_PORT_TRIES          (32)
+#define WEB_FD_MAX              (1024)
+#define WEB_HEAP_BASE           (100000)
+#define WEB_RUNS                (50)    //PER KIND, ONE CLIENT
+#define WEB_CLIENTS             (3)     //LISTEN BACKLOG IS 2, ANY MORE WAIT ON SYN RETRIES
+#define WEB_CLIENT_RUNS         (200)
+#define WEB_RSP_MAX             (2048)
+#define WEB_STOP_WAIT_MS        (3000)
+
+typedef struct
+{
+    const char* name;
+    const char* req;            //NULL = HEADER TOO LONG, BUILT BY THE TEST
+    const char* status;         //EXPECTED STATUS LINE
+    bool saved;                 //CALLBACK EXPECTED
+}web_case_t;
+
+typedef struct
+{
+    uint32_t n;
+    uint32_t ttfb_us[WEB_CLIENT_RUNS];
+    uint32_t bad;
+}web_client_t;
+
+//INTERNAL VARIABLES
+static esp32_wifimanager_webconfig_t s_web;
+static uint16_t s_port;
+static bool s_portal_fd[WEB_FD_MAX];
+static uint32_t s_saved;
+static char s_too_long[ESP32_WIFIMANAGER_WEBCONFIG_BUF_LEN];
+static const char s_fields[2][ESP32_WIFIMANAGER_CUSTOM_FIELD_NAME_LEN + 1] = {"mqtt", "token"};
+
+static const web_case_t s_cases[] =
+{
+    {"GET /",               "GET / HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n", "HTTP/1.1 200 OK", false},
+    {"GET /config",         "GET /config HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept: text/html\r\n\r\n", "HTTP/1.1 200 OK", false},
+    {"GET /fields",         "GET /fields HTTP/1.1\r\n\r\n", "HTTP/1.1 200 OK", false},
+    {"GET probe",           "GET /generate_204 HTTP/1.1\r\nHost: connectivitycheck.gstatic.com\r\n\r\n", "HTTP/1.1 302 Found", false},
+    {"POST form",           "POST /config HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\nContent-Length: 38\r\n\r\n"
+                            "ssid=home+net&pwd=secret%2B1&f1=abc123", "HTTP/1.1 200 OK", true},
+    {"POST tlv",            "POST /config HTTP/1.1\r\nContent-Type: application/octet-stream\r\nContent-Length: 16\r\n\r\n"
+                            "\x01\x04" "home" "\x02\x08" "secret+1", "HTTP/1.1 200 OK", true},
+    {"POST no ssid",        "POST /config HTTP/1.1\r\nContent-Length: 5\r\n\r\npwd=x", "HTTP/1.1 400 Bad Request", false},
+    {"POST too large",      "POST /config HTTP/1.1\r\nContent-Length: 5000\r\n\r\n", "HTTP/1.1 413 Payload Too Large", false},
+    {"POST elsewhere",      "POST /login HTTP/1.1\r\nContent-Length: 0\r\n\r\n", "HTTP/1.1 302 Found", false},
+    {"DELETE",              "DELETE /config HTTP/1.1\r\n\r\n", "HTTP/1.1 400 Bad Request", false},
+    {"header too long",     NULL, "HTTP/1.1 413 Payload Too Large", false},
+};
+
+/* LWIP SEND BUFFER MODEL */
+
+static void s_heap_add(int32_t n)
+{
+    __atomic_add_fetch(&fake_idf_heap_free, (uint32_t)n, __ATOMIC_RELAXED);
+}
+
+int accept(int fd, struct sockaddr* addr, socklen_t* len)
+{
+    int client_fd = (int)syscall(SYS_accept4, fd, addr, len, 0);
+
+    if(client_fd >= 0 && client_fd < WEB_FD_MAX)
+    {
+        __atomic_store_n(&s_portal_fd[client_fd], true, __ATOMIC_RELAXED);
+    }
+    return client_fd;
+}
+
+int close(int fd)
+{
+    if(fd >= 0 && fd < WEB_FD_MAX)
+    {
+        __atomic_store_n(&s_portal_fd[fd], false, __ATOMIC_RELAXED);
+    }
+    return (int)syscall(SYS_close, fd);
+}
+
+ssize_t send(int fd, const void* buf, size_t len, int flags)
+{
+    ssize_t n = syscall(SYS_sendto, fd, buf, len, flags, NULL, 0);
+
+    if(n > 0 && fd >= 0 && fd < WEB_FD_MAX && __atomic_load_n(&s_portal_fd[fd], __ATOMIC_RELAXED))
+    {
+        s_heap_add(-(int32_t)n);
+    }
+    return n;
+}
+
+ssize_t recv(int fd, void* buf, size_t len, int flags)
+{
+    ssize_t n = syscall(SYS_recvfrom, fd, buf, len, flags, NULL, NULL);
+
+    if(n > 0 && fd >= 0 && fd < WEB_FD_MAX && !__atomic_load_n(&s_portal_fd[fd], __ATOMIC_RELAXED))
+    {
+        s_heap_add((int32_t)n);
+    }
+    return n;
+}
+
+ssize_t __recv_chk(int fd, void* buf, size_t len, size_t buflen, int flags)
+{
+    //_FORTIFY_SOURCE BUILDS CALL THIS INSTEAD OF recv
+
+    return recv(fd, buf, len, flags);
+}
+
+/* CLIENT */
+
+static int64_t s_now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+static void s_saved_cb(const esp32_wifimanager_provision_data_t* result, void* arg)
+{
+    //PORTAL TASK. BOTH POST BODIES CARRY SSID home...
+
+    if(strncmp(result->ssid, "home", 4) == 0 && strncmp(result->pwd, "secret+1", 8) == 0)
+    {
+        __atomic_add_fetch(&s_saved, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static bool s_request(const web_case_t* c, uint32_t* ttfb_us, size_t* rsp_len)
+{
+    //ONE CONNECTION, ONE REQUEST, READ TO EOF. TTFB FROM connect TO THE FIRST BYTE
+
+    struct sockaddr_in addr;
+    char rsp[WEB_RSP_MAX + 1];
+    const char* req = (c->req != NULL) ? c->req : s_too_long;
+    size_t req_len = (c->req != NULL) ? strlen(c->req) : sizeof(s_too_long) - 1;
+    size_t len = 0;
+    int64_t start;
+    ssize_t n;
+    int fd;
+    bool ok;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+    {
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(s_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    start = s_now_us();
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        send(fd, req, req_len, 0) != (ssize_t)req_len)
+    {
+        close(fd);
+        return false;
+    }
+    *ttfb_us = 0;
+    while((n = recv(fd, rsp + len, WEB_RSP_MAX - len, 0)) > 0)
+    {
+        if(len == 0)
+        {
+            *ttfb_us = (uint32_t)(s_now_us() - start);
+        }
+        len += n;
+    }
+    close(fd);
+    rsp[len] = 0;
+    *rsp_len = len;
+
+    ok = n == 0 && strncmp(rsp, c->status, strlen(c->status)) == 0;
+    if(ok && c == &s_cases[0])
+    {
+        ok = len > sizeof(s_webconfig_page_gz) &&
+                memcmp(rsp + len - sizeof(s_webconfig_page_gz), s_webconfig_page_gz, sizeof(s_webconfig_page_gz)) == 0;
+    }
+    if(ok && c == &s_cases[2])
+    {
+        ok = strstr(rsp, "\r\n\r\n[\"mqtt\",\"token\"]") != NULL;
+    }
+    return ok;
+}
+
+static int s_cmp_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static uint32_t s_pct(uint32_t* v, uint32_t n, uint32_t pct)
+{
+    //pct-TH PERCENTILE, SORTS v
+
+    qsort(v, n, sizeof(v[0]), s_cmp_u32);
+    return v[(n * pct + 99) / 100 - 1];
+}
+
+static void s_start(void)
+{
+    //FIRST FREE PORT FROM WEB_PORT_BASE. DNS ON THE NEXT ONE (IT MAY FAIL, THE PORTAL DOES NOT CARE)
+
+    uint16_t i;
+    esp_err_t err = ESP_FAIL;
+
+    for(i = 0; i < WEB_PORT_TRIES && err != ESP_OK; i++)
+    {
+        s_port = WEB_PORT_BASE + 2 * i;
+        ESP32_WIFIMANAGER_WEBCONFIG_Init(&s_web, s_port, s_port + 1);
+        err = ESP32_WIFIMANAGER_WEBCONFIG_Start(&s_web, s_fields, 2, s_saved_cb, NULL);
+    }
+    CHECK(err == ESP_OK);
+}
+
+static void s_stop(void)
+{
+    uint32_t ms;
+
+    ESP32_WIFIMANAGER_WEBCONFIG_Stop(&s_web);
+    for(ms = 0; ms < WEB_STOP_WAIT_MS && (s_web.task != NULL || s_web.dns.task != NULL); ms += 10)
+    {
+        usleep(10000);
+    }
+    CHECK(s_web.task == NULL && s_web.dns.task == NULL);
+}
+
+static void test_sequential(void)
+{
+    //EACH KIND WEB_RUNS TIMES, ONE CLIENT. THE PORTAL HAS UPDATED ITS STATS
+    //BEFORE IT CLOSES, SO THEY ARE READ AFTER EOF
+
+    const web_case_t* c;
+    esp32_wifimanager_webconfig_stats_t stats;
+    uint32_t ttfb[WEB_RUNS];
+    uint32_t client_ttfb[WEB_RUNS];
+    uint32_t heap_max;
+    uint32_t saved;
+    uint32_t requests = 0;
+    uint32_t bad;
+    uint32_t run;
+    size_t rsp_len;
+    uint8_t i;
+
+    printf("  %-16s %10s %10s %12s %10s\n", "request", "ttfb p50", "ttfb max", "client p50", "peak heap");
+    for(i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++)
+    {
+        c = &s_cases[i];
+        saved = s_saved;
+        heap_max = 0;
+        bad = 0;
+        for(run = 0; run < WEB_RUNS; run++)
+        {
+            if(!s_request(c, &client_ttfb[run], &rsp_len))
+            {
+                bad++;
+                continue;
+            }
+            ESP32_WIFIMANAGER_WEBCONFIG_GetStats(&s_web, &stats);
+            ttfb[run] = stats.last_ttfb_us;
+            heap_max = (stats.last_heap > heap_max) ? stats.last_heap : heap_max;
+
+            //THE MODEL CANNOT HOLD MORE THAN THE REPLY, AND IT IS ALL READ BY NOW
+            bad += (stats.last_heap > rsp_len) ? 1 : 0;
+            bad += (fake_idf_heap_free != WEB_HEAP_BASE) ? 1 : 0;
+        }
+        requests += WEB_RUNS;
+        CHECK(bad == 0);
+        CHECK(s_saved - saved == (c->saved ? WEB_RUNS : 0));
+        if(bad != 0)
+        {
+            printf("  case \"%s\": %u bad\n", c->name, bad);
+            continue;
+        }
+        printf("  %-16s %7u us %7u us %9u us %8u B\n", c->name,
+                s_pct(ttfb, WEB_RUNS, 50), s_pct(ttfb, WEB_RUNS, 100),
+                s_pct(client_ttfb, WEB_RUNS, 50), heap_max);
+    }
+
+    ESP32_WIFIMANAGER_WEBCONFIG_GetStats(&s_web, &stats);
+    CHECK(stats.requests == requests);
+    CHECK(stats.heap_peak > 0 && stats.heap_peak <= WEB_RSP_MAX);
+    CHECK(stats.buf_peak > 0 && stats.buf_peak < ESP32_WIFIMANAGER_WEBCONFIG_BUF_LEN);
+}
+
+static void* s_client_task(void* arg)
+{
+    //WEB_CLIENT_RUNS REQUESTS, CYCLING THROUGH THE KINDS FROM A PER CLIENT OFFSET
+
+    web_client_t* client = arg;
+    size_t kinds = sizeof(s_cases) / sizeof(s_cases[0]);
+    size_t rsp_len;
+    uint32_t run;
+
+    for(run = 0; run < WEB_CLIENT_RUNS; run++)
+    {
+        if(s_request(&s_cases[(run + client->n) % kinds], &client->ttfb_us[run], &rsp_len))
+        {
+            continue;
+        }
+        client->bad++;
+        client->ttfb_us[run] = 0;
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    //WEB_CLIENTS AT ONCE. ONE CLIENT IS SERVED AT A TIME, SO CLIENT TTFB INCLUDES
+    //THE WAIT IN THE ACCEPT QUEUE. THE SERVER SIDE TTFB DOES NOT
+
+    static web_client_t clients[WEB_CLIENTS];
+    static uint32_t all[WEB_CLIENTS * WEB_CLIENT_RUNS];
+    esp32_wifimanager_webconfig_stats_t before;
+    esp32_wifimanager_webconfig_stats_t stats;
+    pthread_t threads[WEB_CLIENTS];
+    int64_t start;
+    int64_t took;
+    uint32_t bad = 0;
+    uint32_t n = 0;
+    uint32_t i;
+    uint32_t run;
+
+    ESP32_WIFIMANAGER_WEBCONFIG_GetStats(&s_web, &before);
+    start = s_now_us();
+    for(i = 0; i < WEB_CLIENTS; i++)
+    {
+        clients[i].n = i;
+        pthread_create(&threads[i], NULL, s_client_task, &clients[i]);
+    }
+    for(i = 0; i < WEB_CLIENTS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        bad += clients[i].bad;
+        for(run = 0; run < WEB_CLIENT_RUNS; run++)
+        {
+            all[n++] = clients[i].ttfb_us[run];
+        }
+    }
+    took = s_now_us() - start;
+
+    ESP32_WIFIMANAGER_WEBCONFIG_GetStats(&s_web, &stats);
+    CHECK(bad == 0);
+    CHECK(stats.requests - before.requests == WEB_CLIENTS * WEB_CLIENT_RUNS);
+    CHECK(fake_idf_heap_free == WEB_HEAP_BASE);
+    printf("  %u clients x %u requests: %lld requests/s, client ttfb p50 %u us p95 %u us max %u us\n",
+            WEB_CLIENTS, WEB_CLIENT_RUNS,
+            (long long)((int64_t)n * 1000000 / ((took > 0) ? took : 1)),
+            s_pct(all, n, 50), s_pct(all, n, 95), s_pct(all, n, 100));
+    printf("  server ttfb max %u us, peak heap %u B, request buffer peak %u B\n",
+            stats.max_ttfb_us, stats.heap_peak, stats.buf_peak);
+}
+
+int main(void)
+{
+    fake_idf_realtime = true;
+    fake_idf_heap_free = WEB_HEAP_BASE;
+    memset(s_too_long, 'x', sizeof(s_too_long) - 1);
+    memcpy(s_too_long, "GET / HTTP/1.1\r\nX-Pad: ", 23);
+
+    s_start();
+    test_sequential();
+    test_concurrent();
+    s_stop();
+    return fake_idf_summary("test_webconfig");
+}
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#
+# DECODE ESP32 WIFI-MANAGER BINARY LOG LINES (#WM...) BACK INTO TEXT
+# MESSAGE FORMATS ARE READ FROM ESP32_WIFIMANAGER_LOG.h AND ENUM NAMES
+# FROM include/ESP32_WIFIMANAGER.h, SO THE DECODER NEVER GOES OUT OF SYNC
+# OTHER CONSOLE LINES ARE PASSED THROUGH UNCHANGED
+#
+# USAGE : python3 tools/logdecode.py [CAPTURE_FILE]     (DEFAULT STDIN)
+#         idf.py monitor | python3 tools/logdecode.py
+#
+
+import os
+import re
+import string
+import sys
+
+here = os.path.dirname(os.path.abspath(__file__))
+log_h = os.path.join(here, "..", "ESP32_WIFIMANAGER_LOG.h")
+main_h = os.path.join(here, "..", "include", "ESP32_WIFIMANAGER.h")
+
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+RECORD = re.compile(r"#WM([0-9a-f]{8})([0-9a-f]{2})([0-9a-f]{4})([0-9a-f]{8})([0-9a-f]{8})")
+
+
+def load_formats():
+    with open(log_h) as f:
+        text = f.read()
+    return [m.group(2) for m in re.finditer(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', text)]
+
+
+def load_enums():
+    with open(main_h) as f:
+        text = f.read()
+    enums = {}
+    for m in re.finditer(r"typedef enum\s*\{(.*?)\}\s*(\w+);", text, re.S):
+        names = {}
+        value = 0
+        for line in m.group(1).split("\n"):
+            line = line.split("//")[0].strip().rstrip(",")
+            if not line:
+                continue
+            if "=" in line:
+                name, value = [x.strip() for x in line.split("=")]
+                value = int(value, 0)
+            else:
+                name = line
+            names[value] = name
+            value += 1
+        enums[m.group(2)] = names
+    return enums
+
+
+class ArgFormatter(string.Formatter):
+    def __init__(self, enums):
+        self.enums = enums
+
+    def format_field(self, value, spec):
+        if spec == "" or spec == "u":
+            return str(value)
+        if spec == "i":
+            return str(value - (1 << 32) if value & 0x80000000 else value)
+        if spec == "ip":
+            return ".".join(str((value >> s) & 0xFF) for s in (0, 8, 16, 24))
+        if spec == "mac":
+            return "..:" + ":".join("%02x" % ((value >> s) & 0xFF) for s in (24, 16, 8, 0))
+        if spec == "ssid":
+            return "ssid#%08x" % value
+        if spec in ("h0", "h1"):
+            return str((value >> (16 * int(spec[1]))) & 0xFFFF)
+        if re.fullmatch(r"s?b[0-3]", spec):
+            byte = (value >> (8 * int(spec[-1]))) & 0xFF
+            if spec[0] == "s" and byte & 0x80:
+                byte -= 0x100
+            return str(byte)
+        if spec.startswith("e:"):
+            return self.enums.get(spec[2:], {}).get(value, str(value))
+        return format(value, spec)
+
+
+def main():
+    formats = load_formats()
+    formatter = ArgFormatter(load_enums())
+    src = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+
+    for line in src:
+        m = RECORD.search(line)
+        if m is None:
+            sys.stdout.write(line)
+            continue
+        ts, level, msg_id, arg0, arg1 = [int(x, 16) for x in m.groups()]
+        if msg_id < len(formats):
+            text = formatter.format(formats[msg_id], arg0, arg1)
+        else:
+            text = "UNKNOWN ID %u (%08x %08x)" % (msg_id, arg0, arg1)
+        sys.stdout.write("%s (%10.3f) ESP32:WIFIMANAGER : %s\n" % (LEVELS.get(level, "?"), ts * 1.024 / 1000, text))
+
+
+if __name__ == "__main__":
+    main()
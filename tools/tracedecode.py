@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+#
+# DECODE ESP32 WIFI-MANAGER INPUT TRACE LINES (#WT..., SEE ESP32_WIFIMANAGER_DumpTrace)
+# EVENT NAMES ARE READ FROM THE EVENT ENUM IN ESP32_WIFIMANAGER.c
+# OPTIONALLY WRITES THE RECORDS AS PACKED LITTLE ENDIAN esp32_wifimanager_trace_record_t
+# FOR A HOST REPLAY (ESP32_WIFIMANAGER_CTX_Replay)
+#
+# USAGE : python3 tools/tracedecode.py [--bin OUT_FILE] [CAPTURE_FILE]     (DEFAULT STDIN)
+#         idf.py monitor | python3 tools/tracedecode.py --bin trace.bin
+#
+
+import os
+import re
+import struct
+import sys
+
+here = os.path.dirname(os.path.abspath(__file__))
+main_c = os.path.join(here, "..", "ESP32_WIFIMANAGER.c")
+
+KINDS = {0: "EVT", 1: "GPIO", 2: "RANDOM", 3: "RSSI", 4: "ARP"}
+RECORD = re.compile(r"#WT([0-9a-f]{8})([0-9a-f]{2})([0-9a-f]{2})([0-9a-f]{4})([0-9a-f]{8})")
+
+
+def load_events():
+    with open(main_c) as f:
+        text = f.read()
+    m = re.search(r"typedef enum\s*\{(.*?)\}\s*esp32_wifimanager_evt_type_t;", text, re.S)
+    names = {}
+    value = 0
+    for line in m.group(1).split("\n") if m else []:
+        line = line.split("//")[0].strip().rstrip(",")
+        if not line:
+            continue
+        if "=" in line:
+            name, value = [x.strip() for x in line.split("=")]
+            value = int(value, 0)
+        else:
+            name = line
+        names[value] = name.replace("ESP32_WIFIMANAGER_EVT_", "")
+        value += 1
+    return names
+
+
+def main():
+    args = sys.argv[1:]
+    out = None
+    if len(args) >= 2 and args[0] == "--bin":
+        out = open(args[1], "wb")
+        args = args[2:]
+    events = load_events()
+    src = open(args[0], errors="replace") if args else sys.stdin
+
+    for line in src:
+        m = RECORD.search(line)
+        if m is None:
+            continue
+        ts, kind, evt, lag, arg = [int(x, 16) for x in m.groups()]
+        if out is not None:
+            out.write(struct.pack("<IIBBH", ts, arg, kind, evt, lag))
+        if kind == 0:
+            text = "%-16s arg %u (lag %u us)" % (events.get(evt, str(evt)), arg, lag)
+        elif kind == 3:
+            text = "%d dBm" % (arg - 0x100 if arg & 0x80 else arg)
+        elif kind == 4:
+            text = "gateway %u, address taken %u" % (arg & 1, (arg >> 1) & 1)
+        else:
+            text = "%u" % arg
+        sys.stdout.write("%12.3f ms %-6s %s\n" % (ts / 1000.0, KINDS.get(kind, str(kind)), text))
+
+    if out is not None:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()